@@ -29,13 +29,17 @@ namespace V32
         void( *SetMultiplyColor )( V32::GPUColor ) = nullptr;
         void( *SetBlendingMode )( int ) = nullptr;
         void( *SelectTexture )( int ) = nullptr;
-        void( *LoadTexture )( int, void* ) = nullptr;
+        void( *LoadTexture )( int, void*, int, int ) = nullptr;
         void( *UnloadCartridgeTextures )() = nullptr;
         void( *UnloadBiosTexture )() = nullptr;
         
         // callbacks to the log library
         void( *LogLine )( const string& ) = nullptr;
         void( *ThrowException )( const string& ) = nullptr;
+        
+        // optional callbacks for cartridge loading
+        void( *PrepareTexture )( int, void*, int, int ) = nullptr;
+        void( *ReportLoadProgress )( int, int ) = nullptr;
     }
     
     
@@ -79,7 +79,9 @@ namespace V32
     
     
     // note that providing all these callbacks is required:
-    // the console will invoke them without any checks
+    // the console will invoke them without any checks;
+    // textures are loaded with their actual size in pixels
+    // (the area outside of it is taken as transparent)
     namespace Callbacks
     {
         // callbacks to the video library
@@ -88,13 +90,24 @@ namespace V32
         extern void( *SetMultiplyColor )( V32::GPUColor );
         extern void( *SetBlendingMode )( int );
         extern void( *SelectTexture )( int );
-        extern void( *LoadTexture )( int, void* );
+        extern void( *LoadTexture )( int, void*, int, int );
         extern void( *UnloadCartridgeTextures )();
         extern void( *UnloadBiosTexture )();
         
         // callbacks to the log library
         extern void( *LogLine )( const std::string& );
         extern void( *ThrowException )( const std::string& );
+        
+        // as an exception, these are optional; when set, each
+        // cartridge texture is passed to PrepareTexture before
+        // LoadTexture, but from worker threads and in any order,
+        // so that libraries can convert pixels in parallel (but
+        // LoadTexture must still work for unprepared textures)
+        extern void( *PrepareTexture )( int, void*, int, int );
+        
+        // receives the number of cartridge assets loaded so
+        // far and the total, from the loading thread
+        extern void( *ReportLoadProgress )( int, int );
     }
     
     
@@ -0,0 +1,120 @@
+// *****************************************************************************
+    // include console logic headers
+    #include "GPUCommandList.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+// *****************************************************************************
+
+
+namespace V32
+{
+    // =============================================================================
+    //      GPU COMMAND LIST: LIST HANDLING
+    // =============================================================================
+    
+    
+    void GPUCommandList::Clear()
+    {
+        // this keeps the allocated memory
+        Commands.clear();
+        Quads.clear();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    bool GPUCommandList::IsEmpty() const
+    {
+        return Commands.empty();
+    }
+    
+    
+    // =============================================================================
+    //      GPU COMMAND LIST: RECORDING
+    // =============================================================================
+    
+    
+    void GPUCommandList::AddClearScreen( GPUColor ClearColor )
+    {
+        GPUCommand NewCommand;
+        NewCommand.Type = GPUCommandTypes::ClearScreen;
+        NewCommand.Parameter.AsColor = ClearColor;
+        Commands.push_back( NewCommand );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPUCommandList::AddDrawQuad( const GPUQuad& Quad )
+    {
+        GPUCommand NewCommand;
+        NewCommand.Type = GPUCommandTypes::DrawQuad;
+        NewCommand.Parameter.AsInteger = Quads.size();
+        Commands.push_back( NewCommand );
+        Quads.push_back( Quad );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPUCommandList::AddSetMultiplyColor( GPUColor MultiplyColor )
+    {
+        GPUCommand NewCommand;
+        NewCommand.Type = GPUCommandTypes::SetMultiplyColor;
+        NewCommand.Parameter.AsColor = MultiplyColor;
+        Commands.push_back( NewCommand );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPUCommandList::AddSetBlendingMode( int BlendingMode )
+    {
+        GPUCommand NewCommand;
+        NewCommand.Type = GPUCommandTypes::SetBlendingMode;
+        NewCommand.Parameter.AsInteger = BlendingMode;
+        Commands.push_back( NewCommand );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPUCommandList::AddSelectTexture( int GPUTextureID )
+    {
+        GPUCommand NewCommand;
+        NewCommand.Type = GPUCommandTypes::SelectTexture;
+        NewCommand.Parameter.AsInteger = GPUTextureID;
+        Commands.push_back( NewCommand );
+    }
+    
+    
+    // =============================================================================
+    //      GPU COMMAND LIST: REPLAY
+    // =============================================================================
+    
+    
+    void GPUCommandList::Replay( GPUCommandReceiver& Receiver ) const
+    {
+        for( const GPUCommand& Command: Commands )
+        {
+            switch( Command.Type )
+            {
+                case GPUCommandTypes::ClearScreen:
+                    Receiver.ClearScreen( Command.Parameter.AsColor );
+                    break;
+                
+                case GPUCommandTypes::DrawQuad:
+                    Receiver.DrawQuad( Quads[ Command.Parameter.AsInteger ] );
+                    break;
+                
+                case GPUCommandTypes::SetMultiplyColor:
+                    Receiver.SetMultiplyColor( Command.Parameter.AsColor );
+                    break;
+                
+                case GPUCommandTypes::SetBlendingMode:
+                    Receiver.SetBlendingMode( Command.Parameter.AsInteger );
+                    break;
+                
+                case GPUCommandTypes::SelectTexture:
+                    Receiver.SelectTexture( Command.Parameter.AsInteger );
+                    break;
+            }
+        }
+    }
+}
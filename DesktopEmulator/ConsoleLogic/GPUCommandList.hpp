@@ -0,0 +1,101 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef GPUCOMMANDLIST_HPP
+    #define GPUCOMMANDLIST_HPP
+    
+    // include console logic headers
+    #include "ExternalInterfaces.hpp"
+    
+    // include C/C++ headers
+    #include <vector>         // [ C++ STL ] Vectors
+// *****************************************************************************
+
+
+namespace V32
+{
+    // =============================================================================
+    //      GPU COMMANDS
+    // =============================================================================
+    
+    
+    // one for each video callback that is used while
+    // running frames (textures are loaded separately)
+    enum class GPUCommandTypes: uint8_t
+    {
+        ClearScreen = 0,
+        DrawQuad,
+        SetMultiplyColor,
+        SetBlendingMode,
+        SelectTexture
+    };
+    
+    // -----------------------------------------------------------------------------
+    
+    // quads are not stored in the command itself,
+    // so that all other commands can be kept small
+    typedef struct
+    {
+        GPUCommandTypes Type;
+        V32Word Parameter;      // color, blending mode or texture ID
+    }
+    GPUCommand;
+    
+    
+    // =============================================================================
+    //      INTERFACE TO RECEIVE REPLAYED COMMANDS
+    // =============================================================================
+    
+    
+    class GPUCommandReceiver
+    {
+        public:
+        
+            virtual ~GPUCommandReceiver() {}
+            
+            virtual void ClearScreen( GPUColor ClearColor ) = 0;
+            virtual void DrawQuad( const GPUQuad& Quad ) = 0;
+            virtual void SetMultiplyColor( GPUColor MultiplyColor ) = 0;
+            virtual void SetBlendingMode( int BlendingMode ) = 0;
+            virtual void SelectTexture( int GPUTextureID ) = 0;
+    };
+    
+    
+    // =============================================================================
+    //      GPU COMMAND LIST
+    // =============================================================================
+    
+    
+    // records the video callbacks made by the console so that
+    // they can be executed later, and maybe in another thread;
+    // vectors are never shrunk, so reusing the same list for
+    // every frame will stop allocating memory after a while
+    class GPUCommandList
+    {
+        public:
+        
+            std::vector< GPUCommand > Commands;
+            std::vector< GPUQuad > Quads;
+        
+        public:
+        
+            // list handling
+            void Clear();
+            bool IsEmpty() const;
+            
+            // recording
+            void AddClearScreen( GPUColor ClearColor );
+            void AddDrawQuad( const GPUQuad& Quad );
+            void AddSetMultiplyColor( GPUColor MultiplyColor );
+            void AddSetBlendingMode( int BlendingMode );
+            void AddSelectTexture( int GPUTextureID );
+            
+            // sends all commands, in order, to the receiver
+            void Replay( GPUCommandReceiver& Receiver ) const;
+    };
+}
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
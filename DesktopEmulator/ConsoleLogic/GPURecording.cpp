@@ -0,0 +1,439 @@
+// *****************************************************************************
+    // include console logic headers
+    #include "GPURecording.hpp"
+    #include "ExternalInterfaces.hpp"
+    
+    // include C/C++ headers
+    #include <cstring>          // [ ANSI C ] Strings
+    
+    // declare used namespaces
+    using namespace std;
+// *****************************************************************************
+
+
+namespace V32
+{
+    // =============================================================================
+    //      AUXILIARY FUNCTIONS FOR ENCODING
+    // =============================================================================
+    
+    
+    // positions are compared as bits, so that decoding
+    // gives back exactly the same floats (even -0.0)
+    static bool SameFloat( float Value1, float Value2 )
+    {
+        return !memcmp( &Value1, &Value2, sizeof(float) );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // true when the quad is an unrotated rectangle, so
+    // that corners 1 and 2 can be taken from 0 and 3
+    static bool HasAlignedPositions( const GPUQuad& Quad )
+    {
+        const GPUPoint* V = Quad.Vertices;
+        
+        return SameFloat( V[ 1 ].x, V[ 3 ].x ) && SameFloat( V[ 1 ].y, V[ 0 ].y )
+            && SameFloat( V[ 2 ].x, V[ 0 ].x ) && SameFloat( V[ 2 ].y, V[ 3 ].y );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static bool HasAlignedTexture( const GPUQuad& Quad )
+    {
+        const GPUPoint* V = Quad.Vertices;
+        
+        return SameFloat( V[ 1 ].texture_x, V[ 3 ].texture_x ) && SameFloat( V[ 1 ].texture_y, V[ 0 ].texture_y )
+            && SameFloat( V[ 2 ].texture_x, V[ 0 ].texture_x ) && SameFloat( V[ 2 ].texture_y, V[ 3 ].texture_y );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static bool HasSameTexture( const GPUQuad& Quad1, const GPUQuad& Quad2 )
+    {
+        for( int i = 0; i < 4; i++ )
+        {
+            if( !SameFloat( Quad1.Vertices[ i ].texture_x, Quad2.Vertices[ i ].texture_x ) ) return false;
+            if( !SameFloat( Quad1.Vertices[ i ].texture_y, Quad2.Vertices[ i ].texture_y ) ) return false;
+        }
+        
+        return true;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static void AppendBytes( vector< uint8_t >& Bytes, const void* Data, unsigned Size )
+    {
+        const uint8_t* Data8 = (const uint8_t*)Data;
+        Bytes.insert( Bytes.end(), Data8, Data8 + Size );
+    }
+    
+    
+    // =============================================================================
+    //      AUXILIARY FUNCTIONS FOR DECODING
+    // =============================================================================
+    
+    
+    static void ExtractBytes( const vector< uint8_t >& Bytes, unsigned& Position, void* Data, unsigned Size )
+    {
+        if( Position + Size > Bytes.size() )
+          Callbacks::ThrowException( "GPU recording is corrupted (frame ends in mid-command)" );
+        
+        memcpy( Data, &Bytes[ Position ], Size );
+        Position += Size;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static float ExtractFloat( const vector< uint8_t >& Bytes, unsigned& Position )
+    {
+        float Value;
+        ExtractBytes( Bytes, Position, &Value, sizeof(float) );
+        return Value;
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING WRITER: INSTANCE HANDLING
+    // =============================================================================
+    
+    
+    GPURecordingWriter::GPURecordingWriter()
+    {
+        memset( &FileHeader, 0, sizeof(FileHeader) );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    GPURecordingWriter::~GPURecordingWriter()
+    {
+        Close();
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING WRITER: FILE HANDLING
+    // =============================================================================
+    
+    
+    void GPURecordingWriter::Open( const string& FilePath, const string& CartridgeTitle )
+    {
+        Close();
+        OpenOutputFile( OutputFile, FilePath, ios_base::binary );
+        
+        if( OutputFile.fail() )
+          Callbacks::ThrowException( "Cannot create GPU recording file" );
+        
+        // the frame count is only known when closing
+        memset( &FileHeader, 0, sizeof(FileHeader) );
+        memcpy( FileHeader.Signature, GPURecordingFormat::Signature, 8 );
+        FileHeader.Version = GPURecordingFormat::Version;
+        strncpy( FileHeader.CartridgeTitle, CartridgeTitle.c_str(), sizeof(FileHeader.CartridgeTitle) - 1 );
+        
+        OutputFile.write( (const char*)&FileHeader, sizeof(FileHeader) );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPURecordingWriter::Close()
+    {
+        if( !OutputFile.is_open() )
+          return;
+        
+        // now write the final header
+        OutputFile.seekp( 0 );
+        OutputFile.write( (const char*)&FileHeader, sizeof(FileHeader) );
+        OutputFile.close();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    bool GPURecordingWriter::IsOpen()
+    {
+        return OutputFile.is_open();
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING WRITER: FRAMES
+    // =============================================================================
+    
+    
+    void GPURecordingWriter::WriteFrame( const GPUCommandList& Frame )
+    {
+        FrameBytes.clear();
+        
+        // texture coordinates are only compared within
+        // a frame, so that each one can be decoded alone
+        const GPUQuad* PreviousQuad = nullptr;
+        
+        for( const GPUCommand& Command: Frame.Commands )
+        {
+            uint8_t CommandByte = (uint8_t)Command.Type;
+            
+            // commands other than quads have a single 4-byte parameter
+            if( Command.Type != GPUCommandTypes::DrawQuad )
+            {
+                FrameBytes.push_back( CommandByte );
+                AppendBytes( FrameBytes, &Command.Parameter, 4 );
+                continue;
+            }
+            
+            // for quads, choose the shortest form
+            const GPUQuad& Quad = Frame.Quads[ Command.Parameter.AsInteger ];
+            const GPUPoint* V = Quad.Vertices;
+            
+            bool PositionsAligned = HasAlignedPositions( Quad );
+            bool TextureRepeated = PreviousQuad && HasSameTexture( Quad, *PreviousQuad );
+            bool TextureAligned = !TextureRepeated && HasAlignedTexture( Quad );
+            
+            if( PositionsAligned ) CommandByte |= GPURecordingFormat::FlagPositionsAligned;
+            if( TextureAligned   ) CommandByte |= GPURecordingFormat::FlagTextureAligned;
+            if( TextureRepeated  ) CommandByte |= GPURecordingFormat::FlagTextureRepeated;
+            
+            FrameBytes.push_back( CommandByte );
+            
+            // vertex positions
+            for( int i = 0; i < 4; i++ )
+            {
+                if( PositionsAligned && (i == 1 || i == 2) )
+                  continue;
+                
+                AppendBytes( FrameBytes, &V[ i ].x, sizeof(float) );
+                AppendBytes( FrameBytes, &V[ i ].y, sizeof(float) );
+            }
+            
+            // texture coordinates
+            if( !TextureRepeated )
+              for( int i = 0; i < 4; i++ )
+              {
+                  if( TextureAligned && (i == 1 || i == 2) )
+                    continue;
+                  
+                  AppendBytes( FrameBytes, &V[ i ].texture_x, sizeof(float) );
+                  AppendBytes( FrameBytes, &V[ i ].texture_y, sizeof(float) );
+              }
+            
+            PreviousQuad = &Quad;
+        }
+        
+        // write frame size, then its contents
+        uint32_t FrameSize = FrameBytes.size();
+        OutputFile.write( (const char*)&FrameSize, sizeof(FrameSize) );
+        
+        if( FrameSize > 0 )
+          OutputFile.write( (const char*)&FrameBytes[ 0 ], FrameSize );
+        
+        if( OutputFile.fail() )
+          Callbacks::ThrowException( "Cannot write to GPU recording file" );
+        
+        FileHeader.NumberOfFrames++;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    int GPURecordingWriter::GetWrittenFrames()
+    {
+        return FileHeader.NumberOfFrames;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    uint64_t GPURecordingWriter::GetWrittenBytes()
+    {
+        if( !OutputFile.is_open() )
+          return 0;
+        
+        return (uint64_t)OutputFile.tellp();
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING READER: INSTANCE HANDLING
+    // =============================================================================
+    
+    
+    GPURecordingReader::GPURecordingReader()
+    {
+        memset( &FileHeader, 0, sizeof(FileHeader) );
+        ReadFrames = 0;
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING READER: FILE HANDLING
+    // =============================================================================
+    
+    
+    void GPURecordingReader::Open( const string& FilePath )
+    {
+        Close();
+        OpenInputFile( InputFile, FilePath, ios_base::binary );
+        
+        if( InputFile.fail() )
+          Callbacks::ThrowException( "Cannot open GPU recording file" );
+        
+        // read and check the header
+        InputFile.read( (char*)&FileHeader, sizeof(FileHeader) );
+        
+        if( InputFile.fail() )
+          Callbacks::ThrowException( "Incorrect GPU recording format (file is too small)" );
+        
+        if( strncmp( FileHeader.Signature, GPURecordingFormat::Signature, 8 ) )
+          Callbacks::ThrowException( "Incorrect GPU recording format (file does not have a valid signature)" );
+        
+        if( FileHeader.Version > GPURecordingFormat::Version )
+          Callbacks::ThrowException( "This GPU recording was made by a more recent version of Vircon32" );
+        
+        // ensure the title is terminated
+        FileHeader.CartridgeTitle[ sizeof(FileHeader.CartridgeTitle) - 1 ] = 0;
+        ReadFrames = 0;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void GPURecordingReader::Close()
+    {
+        if( InputFile.is_open() )
+          InputFile.close();
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING READER: RECORDING INFORMATION
+    // =============================================================================
+    
+    
+    int GPURecordingReader::GetNumberOfFrames()
+    {
+        return FileHeader.NumberOfFrames;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    string GPURecordingReader::GetCartridgeTitle()
+    {
+        return FileHeader.CartridgeTitle;
+    }
+    
+    
+    // =============================================================================
+    //      GPU RECORDING READER: FRAMES
+    // =============================================================================
+    
+    
+    bool GPURecordingReader::ReadFrame( GPUCommandList& Frame )
+    {
+        Frame.Clear();
+        
+        if( ReadFrames >= (int)FileHeader.NumberOfFrames )
+          return false;
+        
+        // read the whole frame first
+        uint32_t FrameSize = 0;
+        InputFile.read( (char*)&FrameSize, sizeof(FrameSize) );
+        FrameBytes.resize( FrameSize );
+        
+        if( FrameSize > 0 )
+          InputFile.read( (char*)&FrameBytes[ 0 ], FrameSize );
+        
+        if( InputFile.fail() )
+          Callbacks::ThrowException( "GPU recording is corrupted (file ends in mid-frame)" );
+        
+        // now decode its commands
+        unsigned Position = 0;
+        
+        while( Position < FrameSize )
+        {
+            uint8_t CommandByte = FrameBytes[ Position++ ];
+            GPUCommandTypes Type = (GPUCommandTypes)(CommandByte & GPURecordingFormat::TypeMask);
+            V32Word Parameter;
+            
+            switch( Type )
+            {
+                case GPUCommandTypes::ClearScreen:
+                    ExtractBytes( FrameBytes, Position, &Parameter, 4 );
+                    Frame.AddClearScreen( Parameter.AsColor );
+                    break;
+                
+                case GPUCommandTypes::SetMultiplyColor:
+                    ExtractBytes( FrameBytes, Position, &Parameter, 4 );
+                    Frame.AddSetMultiplyColor( Parameter.AsColor );
+                    break;
+                
+                case GPUCommandTypes::SetBlendingMode:
+                    ExtractBytes( FrameBytes, Position, &Parameter, 4 );
+                    Frame.AddSetBlendingMode( Parameter.AsInteger );
+                    break;
+                
+                case GPUCommandTypes::SelectTexture:
+                    ExtractBytes( FrameBytes, Position, &Parameter, 4 );
+                    Frame.AddSelectTexture( Parameter.AsInteger );
+                    break;
+                
+                case GPUCommandTypes::DrawQuad:
+                {
+                    GPUQuad Quad;
+                    GPUPoint* V = Quad.Vertices;
+                    
+                    // vertex positions
+                    if( CommandByte & GPURecordingFormat::FlagPositionsAligned )
+                    {
+                        V[ 0 ].x = ExtractFloat( FrameBytes, Position );
+                        V[ 0 ].y = ExtractFloat( FrameBytes, Position );
+                        V[ 3 ].x = ExtractFloat( FrameBytes, Position );
+                        V[ 3 ].y = ExtractFloat( FrameBytes, Position );
+                        V[ 1 ].x = V[ 3 ].x;  V[ 1 ].y = V[ 0 ].y;
+                        V[ 2 ].x = V[ 0 ].x;  V[ 2 ].y = V[ 3 ].y;
+                    }
+                    
+                    else for( int i = 0; i < 4; i++ )
+                    {
+                        V[ i ].x = ExtractFloat( FrameBytes, Position );
+                        V[ i ].y = ExtractFloat( FrameBytes, Position );
+                    }
+                    
+                    // texture coordinates
+                    if( CommandByte & GPURecordingFormat::FlagTextureRepeated )
+                    {
+                        if( Frame.Quads.empty() )
+                          Callbacks::ThrowException( "GPU recording is corrupted (first quad repeats texture coordinates)" );
+                        
+                        const GPUQuad& PreviousQuad = Frame.Quads.back();
+                        
+                        for( int i = 0; i < 4; i++ )
+                        {
+                            V[ i ].texture_x = PreviousQuad.Vertices[ i ].texture_x;
+                            V[ i ].texture_y = PreviousQuad.Vertices[ i ].texture_y;
+                        }
+                    }
+                    
+                    else if( CommandByte & GPURecordingFormat::FlagTextureAligned )
+                    {
+                        V[ 0 ].texture_x = ExtractFloat( FrameBytes, Position );
+                        V[ 0 ].texture_y = ExtractFloat( FrameBytes, Position );
+                        V[ 3 ].texture_x = ExtractFloat( FrameBytes, Position );
+                        V[ 3 ].texture_y = ExtractFloat( FrameBytes, Position );
+                        V[ 1 ].texture_x = V[ 3 ].texture_x;  V[ 1 ].texture_y = V[ 0 ].texture_y;
+                        V[ 2 ].texture_x = V[ 0 ].texture_x;  V[ 2 ].texture_y = V[ 3 ].texture_y;
+                    }
+                    
+                    else for( int i = 0; i < 4; i++ )
+                    {
+                        V[ i ].texture_x = ExtractFloat( FrameBytes, Position );
+                        V[ i ].texture_y = ExtractFloat( FrameBytes, Position );
+                    }
+                    
+                    Frame.AddDrawQuad( Quad );
+                    break;
+                }
+                
+                default:
+                    Callbacks::ThrowException( "GPU recording is corrupted (unknown command type)" );
+            }
+        }
+        
+        ReadFrames++;
+        return true;
+    }
+}
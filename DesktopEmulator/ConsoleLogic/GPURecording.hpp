@@ -0,0 +1,127 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef GPURECORDING_HPP
+    #define GPURECORDING_HPP
+    
+    // include console logic headers
+    #include "GPUCommandList.hpp"
+    
+    // include C/C++ headers
+    #include <string>         // [ C++ STL ] Strings
+    #include <vector>         // [ C++ STL ] Vectors
+    #include <fstream>        // [ C++ STL ] File streams
+// *****************************************************************************
+
+
+namespace V32
+{
+    // =============================================================================
+    //      FORMAT FOR GPU RECORDING FILES
+    // =============================================================================
+    
+    
+    // these files store the GPU commands of a sequence of frames,
+    // so that they can be drawn again without running the CPU;
+    // textures are not included (they come from the same ROMs)
+    namespace GPURecordingFormat
+    {
+        // expected file signature
+        const char Signature[]  = "V32-GREC";
+        
+        // current format version
+        const uint32_t Version = 1;
+        
+        // initial header; must be placed at the beginning
+        // of the file, and be a size of exactly 80 bytes
+        typedef struct
+        {
+            char Signature[ 8 ];        // no null termination! (always taken as 8 characters)
+            uint32_t Version;           // format version used to write the file
+            uint32_t NumberOfFrames;    // total frames that follow the header
+            char CartridgeTitle[ 64 ];  // null terminated; empty when only the BIOS ran
+        }
+        Header;
+        
+        // each frame is stored as a uint32 with its size in bytes,
+        // followed by its commands; every command starts with 1
+        // byte: its type in the low 3 bits, plus these flags
+        const uint8_t TypeMask                 = 0x07;
+        const uint8_t FlagPositionsAligned     = 0x08;   // only corners 0 and 3 are stored
+        const uint8_t FlagTextureAligned       = 0x10;   // same, for texture coordinates
+        const uint8_t FlagTextureRepeated      = 0x20;   // same texture coordinates as the previous quad
+    }
+    
+    
+    // =============================================================================
+    //      WRITING GPU RECORDINGS
+    // =============================================================================
+    
+    
+    class GPURecordingWriter
+    {
+        private:
+        
+            std::ofstream OutputFile;
+            GPURecordingFormat::Header FileHeader;
+            
+            // encoded frame, reused to avoid allocations
+            std::vector< uint8_t > FrameBytes;
+        
+        public:
+        
+            // instance handling
+            GPURecordingWriter();
+           ~GPURecordingWriter();
+            
+            // file handling
+            void Open( const std::string& FilePath, const std::string& CartridgeTitle );
+            void Close();
+            bool IsOpen();
+            
+            // frames are written as they are received
+            void WriteFrame( const GPUCommandList& Frame );
+            int GetWrittenFrames();
+            uint64_t GetWrittenBytes();
+    };
+    
+    
+    // =============================================================================
+    //      READING GPU RECORDINGS
+    // =============================================================================
+    
+    
+    class GPURecordingReader
+    {
+        private:
+        
+            std::ifstream InputFile;
+            GPURecordingFormat::Header FileHeader;
+            int ReadFrames;
+            
+            // encoded frame, reused to avoid allocations
+            std::vector< uint8_t > FrameBytes;
+        
+        public:
+        
+            // instance handling
+            GPURecordingReader();
+            
+            // file handling
+            void Open( const std::string& FilePath );
+            void Close();
+            
+            // recording information
+            int GetNumberOfFrames();
+            std::string GetCartridgeTitle();
+            
+            // replaces the contents of the given list;
+            // returns false when no frames are left
+            bool ReadFrame( GPUCommandList& Frame );
+    };
+}
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
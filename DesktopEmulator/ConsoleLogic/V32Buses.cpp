@@ -2,6 +2,12 @@
     // include console logic headers
     #include "V32Buses.hpp"
     #include "V32CPU.hpp"
+    
+    // include C/C++ headers
+    #include <cstring>          // [ ANSI C ] Strings
+    
+    // declare used namespaces
+    using namespace std;
 // *****************************************************************************
 
 
@@ -12,17 +18,78 @@ namespace V32
     // =============================================================================
     
     
+    V32Word* VirconMemoryInterface::GetReadableMemory( int32_t& NumberOfWords )
+    {
+        NumberOfWords = 0;
+        return nullptr;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    V32Word* VirconMemoryInterface::GetWritableMemory( int32_t& NumberOfWords )
+    {
+        NumberOfWords = 0;
+        return nullptr;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    uint8_t* VirconMemoryInterface::GetDirtyPages()
+    {
+        return nullptr;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
     V32MemoryBus::V32MemoryBus()
     {
         Master = nullptr;
         
         for( int i = 0; i < Constants::MemoryBusSlaves; i++ )
           Slaves[ i ] = nullptr;
+        
+        // nothing is mapped initially
+        WriteJournal = nullptr;
+        UpdateMappings();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryBus::UpdateMappings()
+    {
+        for( int i = 0; i < Constants::MemoryBusSlaves; i++ )
+        {
+            ReadableMemory[ i ] = WritableMemory[ i ] = nullptr;
+            ReadableWords[ i ] = WritableWords[ i ] = 0;
+            DirtyPages[ i ] = nullptr;
+            
+            if( !Slaves[ i ] )
+              continue;
+            
+            // ask the slave for its accessible contents
+            int32_t NumberOfWords = 0;
+            ReadableMemory[ i ] = Slaves[ i ]->GetReadableMemory( NumberOfWords );
+            ReadableWords[ i ] = (ReadableMemory[ i ]? NumberOfWords : 0);
+            
+            NumberOfWords = 0;
+            WritableMemory[ i ] = Slaves[ i ]->GetWritableMemory( NumberOfWords );
+            WritableWords[ i ] = (WritableMemory[ i ]? NumberOfWords : 0);
+            
+            // without dirty pages, writes can't be done directly;
+            // same when they have to be recorded in a journal
+            DirtyPages[ i ] = Slaves[ i ]->GetDirtyPages();
+            
+            if( !DirtyPages[ i ] || WriteJournal )
+            {
+                WritableMemory[ i ] = nullptr;
+                WritableWords[ i ] = 0;
+            }
+        }
     }
     
     // -----------------------------------------------------------------------------
     
-    void V32MemoryBus::ReadAddress( int32_t GlobalAddress, V32Word& Result )
+    void V32MemoryBus::ReadFromSlave( int32_t GlobalAddress, V32Word& Result )
     {
         // separate device ID and local address
         int32_t DeviceID = (GlobalAddress >> 28) & 3;
@@ -38,18 +105,71 @@ namespace V32
     
     // -----------------------------------------------------------------------------
     
-    void V32MemoryBus::WriteAddress( int32_t GlobalAddress, V32Word Value )
+    void V32MemoryBus::WriteToSlave( int32_t GlobalAddress, V32Word Value )
     {
         // separate device ID and local address
         int32_t DeviceID = (GlobalAddress >> 28) & 3;
         int32_t LocalAddress = GlobalAddress & 0x0FFFFFFF;
         
+        // when recording, keep the value to be replaced
+        V32Word PreviousValue;
+        bool Recorded = WriteJournal && Slaves[ DeviceID ]->ReadAddress( LocalAddress, PreviousValue );
+        
         // attempt to write on memory
         bool Success = Slaves[ DeviceID ]->WriteAddress( LocalAddress, Value );
         
         // raise a CPU error when it failed
         if( !Success )
           Master->RaiseHardwareError( CPUErrorCodes::InvalidMemoryWrite );
+        
+        if( Recorded )
+          WriteJournal->push_back( { GlobalAddress, PreviousValue } );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryBus::MarkDirtyWords( int32_t GlobalAddress, int32_t NumberOfWords )
+    {
+        // separate device ID and local address
+        int32_t DeviceID = (GlobalAddress >> 28) & 3;
+        int32_t LocalAddress = GlobalAddress & 0x0FFFFFFF;
+        
+        // mark all pages touched by the range
+        int32_t FirstPage = LocalAddress >> MemoryPageBits;
+        int32_t LastPage = (LocalAddress + NumberOfWords - 1) >> MemoryPageBits;
+        memset( &DirtyPages[ DeviceID ][ FirstPage ], 1, LastPage - FirstPage + 1 );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryBus::BeginWriteJournal( vector< MemoryWrite >& Journal )
+    {
+        // writes are only seen by the bus
+        // when they go through the slaves
+        WriteJournal = &Journal;
+        UpdateMappings();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryBus::EndWriteJournal()
+    {
+        WriteJournal = nullptr;
+        UpdateMappings();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryBus::UndoWrites( const vector< MemoryWrite >& Journal )
+    {
+        // restore values in reverse order, so that
+        // each address gets back its first value
+        for( int i = (int)Journal.size() - 1; i >= 0; i-- )
+        {
+            int32_t DeviceID = (Journal[ i ].GlobalAddress >> 28) & 3;
+            int32_t LocalAddress = Journal[ i ].GlobalAddress & 0x0FFFFFFF;
+            Slaves[ DeviceID ]->WriteAddress( LocalAddress, Journal[ i ].PreviousValue );
+        }
     }
     
     
@@ -6,6 +6,9 @@
     // include common Vircon32 headers
     #include "../VirconDefinitions/Constants.hpp"
     #include "../VirconDefinitions/DataStructures.hpp"
+    
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
 // *****************************************************************************
 
 
@@ -15,6 +18,11 @@ namespace V32
     // will use pointers to CPU as their master device
     class V32CPU;
     
+    // writable memories are tracked in pages of 1024
+    // words, to know which parts were modified
+    const int32_t MemoryPageBits = 10;
+    const int32_t MemoryPageWords = 1 << MemoryPageBits;
+    
     
     // =============================================================================
     //      INTER-DEVICE BUS FOR ADDRESSING R/W ON MEMORY
@@ -28,6 +36,25 @@ namespace V32
             // R/W methods
             virtual bool ReadAddress( int32_t LocalAddress, V32Word& Result ) = 0;
             virtual bool WriteAddress( int32_t LocalAddress, V32Word Value  ) = 0;
+            
+            // direct access to contents, for slaves where R/W methods
+            // have no side effects (by default there is no access)
+            virtual V32Word* GetReadableMemory( int32_t& NumberOfWords );
+            virtual V32Word* GetWritableMemory( int32_t& NumberOfWords );
+            
+            // one flag per page, to be set on every write; writable
+            // memory is only accessed directly if the slave has them
+            virtual uint8_t* GetDirtyPages();
+    };
+    
+    // -----------------------------------------------------------------------------
+    
+    // a write done through the bus, along with the
+    // previous contents so that it can be undone
+    struct MemoryWrite
+    {
+        int32_t GlobalAddress;
+        V32Word PreviousValue;
     };
     
     // -----------------------------------------------------------------------------
@@ -42,16 +69,77 @@ namespace V32
             // connected slaves
             VirconMemoryInterface* Slaves[ Constants::MemoryBusSlaves ];
             
+            // host memory mapped for each slave; any access outside
+            // of these ranges is done through the slave interface
+            V32Word* ReadableMemory[ Constants::MemoryBusSlaves ];
+            V32Word* WritableMemory[ Constants::MemoryBusSlaves ];
+            uint32_t ReadableWords[ Constants::MemoryBusSlaves ];
+            uint32_t WritableWords[ Constants::MemoryBusSlaves ];
+            uint8_t* DirtyPages[ Constants::MemoryBusSlaves ];
+            
+            // when not null, successful writes are recorded
+            // here; meanwhile no memory is written directly
+            std::vector< MemoryWrite >* WriteJournal;
+            
         public:
             
             // instance handling
             V32MemoryBus();
             
+            // needs to be called whenever slave memories
+            // are connected, disconnected or resized
+            void UpdateMappings();
+            
             // R/W methods
             void ReadAddress( int32_t GlobalAddress, V32Word& Result );
             void WriteAddress( int32_t GlobalAddress, V32Word Value );
+            
+            // access through slaves, used for invalid
+            // addresses or for writes with side effects
+            void ReadFromSlave( int32_t GlobalAddress, V32Word& Result );
+            void WriteToSlave( int32_t GlobalAddress, V32Word Value );
+            
+            // for writes done directly on writable memory
+            void MarkDirtyWords( int32_t GlobalAddress, int32_t NumberOfWords );
+            
+            // recording of writes, so that code can be run twice
+            void BeginWriteJournal( std::vector< MemoryWrite >& Journal );
+            void EndWriteJournal();
+            void UndoWrites( const std::vector< MemoryWrite >& Journal );
     };
     
+    // -----------------------------------------------------------------------------
+    
+    // the common case for R/W is defined here to be inlined
+    inline void V32MemoryBus::ReadAddress( int32_t GlobalAddress, V32Word& Result )
+    {
+        // separate device ID and local address
+        int32_t DeviceID = (GlobalAddress >> 28) & 3;
+        uint32_t LocalAddress = GlobalAddress & 0x0FFFFFFF;
+        
+        if( LocalAddress < ReadableWords[ DeviceID ] )
+          Result = ReadableMemory[ DeviceID ][ LocalAddress ];
+        else
+          ReadFromSlave( GlobalAddress, Result );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    inline void V32MemoryBus::WriteAddress( int32_t GlobalAddress, V32Word Value )
+    {
+        // separate device ID and local address
+        int32_t DeviceID = (GlobalAddress >> 28) & 3;
+        uint32_t LocalAddress = GlobalAddress & 0x0FFFFFFF;
+        
+        if( LocalAddress < WritableWords[ DeviceID ] )
+        {
+            WritableMemory[ DeviceID ][ LocalAddress ] = Value;
+            DirtyPages[ DeviceID ][ LocalAddress >> MemoryPageBits ] = 1;
+        }
+        else
+          WriteToSlave( GlobalAddress, Value );
+    }
+    
     
     // =============================================================================
     //      INTER-DEVICE BUS FOR ADDRESSING R/W ON CONTROL PORTS
@@ -10,6 +10,7 @@
     // include C/C++ headers
     #include <cstring>          // [ ANSI C ] Strings
     #include <stdexcept>        // [ C++ STL ] Exceptions
+    #include <algorithm>        // [ C++ STL ] Algorithms
     
     // declare used namespaces
     using namespace std;
@@ -23,10 +24,6 @@ namespace V32
     // =============================================================================
     
     
-    typedef void (*InstructionProcessor)( V32CPU&, CPUInstruction );
-    
-    // -----------------------------------------------------------------------------
-    
     // dispatch vector table for all 64 instructions
     const InstructionProcessor InstructionProcessorTable[] =
     {
@@ -112,6 +109,57 @@ namespace V32
     };
     
     
+    // =============================================================================
+    //      BASIC BLOCK DETECTION
+    // =============================================================================
+    
+    
+    // instructions that can change the instruction pointer,
+    // (either with jumps or by repeating themselves) or that
+    // can stop the CPU will always end a basic block
+    bool EndsBasicBlock( CPUInstruction Instruction )
+    {
+        switch( (InstructionOpCodes)Instruction.OpCode )
+        {
+            case InstructionOpCodes::HLT:
+            case InstructionOpCodes::WAIT:
+            case InstructionOpCodes::JMP:
+            case InstructionOpCodes::CALL:
+            case InstructionOpCodes::RET:
+            case InstructionOpCodes::JT:
+            case InstructionOpCodes::JF:
+            case InstructionOpCodes::MOVS:
+            case InstructionOpCodes::SETS:
+            case InstructionOpCodes::CMPS:
+              return true;
+            
+            default:
+              return false;
+        }
+    }
+    
+    
+    // -----------------------------------------------------------------------------
+    
+    // string instructions that can be run in bulk, along with
+    // their processors for that (null for all other cases)
+    BulkInstructionProcessor GetBulkProcessor( CPUInstruction Instruction )
+    {
+        // immediate values would break the
+        // normal repetition of the instruction
+        if( Instruction.UsesImmediate )
+          return nullptr;
+        
+        switch( (InstructionOpCodes)Instruction.OpCode )
+        {
+            case InstructionOpCodes::MOVS: return ProcessMOVSInBulk;
+            case InstructionOpCodes::SETS: return ProcessSETSInBulk;
+            case InstructionOpCodes::CMPS: return ProcessCMPSInBulk;
+            default: return nullptr;
+        }
+    }
+    
+    
     // =============================================================================
     //      CLASS: V32 CPU
     // =============================================================================
@@ -121,6 +169,13 @@ namespace V32
     {
         MemoryBus = nullptr;
         ControlBus = nullptr;
+        
+        // run program ROMs by blocks, unchecked
+        BlockExecution = true;
+        DifferentialCheckPeriod = 0;
+        BlocksSinceCheck = 0;
+        CheckedBlocks = 0;
+        BulkStringInstructions = true;
     }
     
     // -----------------------------------------------------------------------------
@@ -156,6 +211,130 @@ namespace V32
     // -----------------------------------------------------------------------------
     
     void V32CPU::RunNextCycle()
+    {
+        // when possible take the instruction already decoded
+        const PredecodedInstruction* Entry = FindPredecodedInstruction();
+        
+        if( Entry )
+          RunPredecodedInstruction( *Entry );
+        else
+          RunInstructionFromBus();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::RunCycles( int32_t& CycleCounter, int32_t CycleLimit )
+    {
+        while( CycleCounter < CycleLimit )
+        {
+            // end loop early when CPU is set to wait
+            if( Waiting || Halted )
+              return;
+            
+            // outside of program ROMs just run
+            // the instruction through the bus
+            const PredecodedInstruction* Entry = FindPredecodedInstruction();
+            
+            if( !Entry || !BlockExecution )
+            {
+                CycleCounter++;
+                RunNextCycle();
+                continue;
+            }
+            
+            // periodically check the block against the
+            // reference interpreter when requested; if
+            // it can't be checked, try with the next one
+            if( DifferentialCheckPeriod > 0 && ++BlocksSinceCheck >= DifferentialCheckPeriod )
+            {
+                if( CheckBlock( Entry, CycleCounter, CycleLimit ) )
+                  BlocksSinceCheck = 0;
+                
+                continue;
+            }
+            
+            RunBlock( Entry, CycleCounter, CycleLimit );
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::RunBlock( const PredecodedInstruction* Entry, int32_t& CycleCounter, int32_t CycleLimit )
+    {
+        // string instructions form blocks on their own;
+        // run as many of their iterations as we can
+        BulkInstructionProcessor BulkProcessor = GetBulkProcessor( Entry->Instruction );
+        
+        if( BulkProcessor && BulkStringInstructions )
+        {
+            // leave registers as if we had fetched it
+            Instruction = Entry->Instruction;
+            InstructionPointer.AsInteger++;
+            
+            int32_t BulkCycles = BulkProcessor( *this, Instruction, CycleLimit - CycleCounter );
+            
+            // when not possible, run a normal iteration
+            if( BulkCycles > 0 )
+              CycleCounter += BulkCycles;
+            
+            else
+            {
+                CycleCounter++;
+                Entry->Processor( *this, Instruction );
+            }
+            
+            return;
+        }
+        
+        // run the basic block that starts here, without
+        // going beyond the limit or looking up each step
+        int32_t BlockCycles = min( Entry->BlockLength, CycleLimit - CycleCounter );
+        
+        for( int32_t i = 0; i < BlockCycles; i++ )
+        {
+            CycleCounter++;
+            RunPredecodedInstruction( *Entry );
+            Entry += (Entry->Instruction.UsesImmediate? 2 : 1);
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    const PredecodedInstruction* V32CPU::FindPredecodedInstruction()
+    {
+        // use the same device mapping as the memory bus
+        int32_t DeviceID = (InstructionPointer.AsInteger >> 28) & 3;
+        uint32_t LocalAddress = InstructionPointer.AsInteger & 0x0FFFFFFF;
+        const vector< PredecodedInstruction >& Predecoded = PredecodedROMs[ DeviceID ];
+        
+        if( LocalAddress >= Predecoded.size() )
+          return nullptr;
+        
+        const PredecodedInstruction* Entry = &Predecoded[ LocalAddress ];
+        return (Entry->Processor? Entry : nullptr);
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::RunPredecodedInstruction( const PredecodedInstruction& Entry )
+    {
+        // leave registers as if we had fetched it
+        Instruction = Entry.Instruction;
+        InstructionPointer.AsInteger++;
+        
+        if( Instruction.UsesImmediate )
+        {
+            ImmediateValue = Entry.ImmediateValue;
+            InstructionPointer.AsInteger++;
+        }
+        
+        // run the instruction
+        Entry.Processor( *this, Instruction );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::RunInstructionFromBus()
     {
         // fetch next instruction
         MemoryBus->ReadAddress( InstructionPointer.AsInteger++, (V32Word&)Instruction );
@@ -176,6 +355,228 @@ namespace V32
     
     // -----------------------------------------------------------------------------
     
+    bool V32CPU::CheckBlock( const PredecodedInstruction* Entry, int32_t& CycleCounter, int32_t CycleLimit )
+    {
+        // ports have effects outside the CPU and memory
+        // that can't be undone, so blocks accessing them
+        // can't be run twice; just run them normally
+        int32_t BlockCycles = min( Entry->BlockLength, CycleLimit - CycleCounter );
+        const PredecodedInstruction* Step = Entry;
+        
+        for( int32_t i = 0; i < BlockCycles; i++ )
+        {
+            InstructionOpCodes OpCode = (InstructionOpCodes)Step->Instruction.OpCode;
+            
+            if( OpCode == InstructionOpCodes::IN || OpCode == InstructionOpCodes::OUT )
+            {
+                RunBlock( Entry, CycleCounter, CycleLimit );
+                return false;
+            }
+            
+            Step += (Step->Instruction.UsesImmediate? 2 : 1);
+        }
+        
+        // save the state before the block
+        // (all 16 registers are consecutive)
+        V32Word InitialRegisters[ 16 ];
+        memcpy( InitialRegisters, &Registers[ 0 ], sizeof(InitialRegisters) );
+        V32Word InitialPointer = InstructionPointer;
+        int32_t InitialCycleCounter = CycleCounter;
+        
+        // STEP 1: run the block as usual, recording all
+        // memory writes; a hardware error also ends it
+        vector< MemoryWrite > BlockWrites;
+        bool BlockFailed = false;
+        MemoryBus->BeginWriteJournal( BlockWrites );
+        
+        try
+        {
+            RunBlock( Entry, CycleCounter, CycleLimit );
+        }
+        catch( CPUException& CPUex )
+        {
+            BlockFailed = true;
+        }
+        catch( ... )
+        {
+            MemoryBus->EndWriteJournal();
+            throw;
+        }
+        
+        // keep all results of the block
+        V32Word BlockRegisters[ 16 ];
+        memcpy( BlockRegisters, &Registers[ 0 ], sizeof(BlockRegisters) );
+        V32Word BlockPointer = InstructionPointer;
+        int32_t BlockHalted = Halted;
+        int32_t BlockWaiting = Waiting;
+        int32_t BlockCycleCounter = CycleCounter;
+        
+        vector< V32Word > BlockWrittenValues( BlockWrites.size() );
+        
+        for( size_t i = 0; i < BlockWrites.size(); i++ )
+          MemoryBus->ReadAddress( BlockWrites[ i ].GlobalAddress, BlockWrittenValues[ i ] );
+        
+        // STEP 2: go back to the initial state
+        MemoryBus->UndoWrites( BlockWrites );
+        memcpy( &Registers[ 0 ], InitialRegisters, sizeof(InitialRegisters) );
+        InstructionPointer = InitialPointer;
+        CycleCounter = InitialCycleCounter;
+        Halted = false;
+        Waiting = false;
+        
+        // STEP 3: run the same cycles with the reference
+        // interpreter; its results are the ones kept
+        vector< MemoryWrite > ReferenceWrites;
+        bool ReferenceFailed = false;
+        MemoryBus->BeginWriteJournal( ReferenceWrites );
+        
+        try
+        {
+            while( CycleCounter < BlockCycleCounter && !Halted && !Waiting )
+            {
+                CycleCounter++;
+                RunInstructionFromBus();
+            }
+        }
+        catch( CPUException& CPUex )
+        {
+            ReferenceFailed = true;
+        }
+        catch( ... )
+        {
+            MemoryBus->EndWriteJournal();
+            throw;
+        }
+        
+        MemoryBus->EndWriteJournal();
+        CheckedBlocks++;
+        
+        // STEP 4: compare the full CPU state
+        bool Matches = (BlockFailed == ReferenceFailed)
+                    && !memcmp( BlockRegisters, &Registers[ 0 ], sizeof(BlockRegisters) )
+                    && BlockPointer.AsBinary == InstructionPointer.AsBinary
+                    && BlockHalted == Halted
+                    && BlockWaiting == Waiting
+                    && BlockCycleCounter == CycleCounter;
+        
+        // memory written by either run must hold the same
+        // values; addresses written by only one of them
+        // must still have their value before the block
+        for( size_t i = 0; i < ReferenceWrites.size(); i++ )
+        {
+            int32_t Address = ReferenceWrites[ i ].GlobalAddress;
+            V32Word Expected = ReferenceWrites[ i ].PreviousValue;
+            
+            for( size_t j = 0; j < i; j++ )
+              if( ReferenceWrites[ j ].GlobalAddress == Address )
+              {
+                  Expected = ReferenceWrites[ j ].PreviousValue;
+                  break;
+              }
+            
+            for( size_t j = 0; j < BlockWrites.size(); j++ )
+              if( BlockWrites[ j ].GlobalAddress == Address )
+                Expected = BlockWrittenValues[ j ];
+            
+            V32Word Current;
+            MemoryBus->ReadAddress( Address, Current );
+            
+            if( Current.AsBinary != Expected.AsBinary )
+              Matches = false;
+        }
+        
+        for( size_t i = 0; i < BlockWrites.size(); i++ )
+        {
+            V32Word Current;
+            MemoryBus->ReadAddress( BlockWrites[ i ].GlobalAddress, Current );
+            
+            if( Current.AsBinary != BlockWrittenValues[ i ].AsBinary )
+              Matches = false;
+        }
+        
+        // on any difference fall back to the interpreter
+        if( !Matches )
+        {
+            Callbacks::LogLine( "CPU block execution mismatch at address " + to_string( InitialPointer.AsInteger ) + ", block execution disabled" );
+            BlockExecution = false;
+        }
+        
+        // an error in the reference run still
+        // has to stop the loop, as it would do
+        if( ReferenceFailed )
+          throw CPUException();
+        
+        return true;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::PredecodeROM( int32_t DeviceID, const vector< V32Word >& ROMContents )
+    {
+        vector< PredecodedInstruction >& Predecoded = PredecodedROMs[ DeviceID ];
+        
+        // decode every word as if it was the start of an instruction
+        // (programs may jump anywhere, even into immediate values)
+        int32_t NumberOfWords = min( (int32_t)ROMContents.size(), MaximumPredecodedWords );
+        Predecoded.resize( NumberOfWords );
+        
+        for( int32_t Address = 0; Address < NumberOfWords; Address++ )
+        {
+            PredecodedInstruction& Entry = Predecoded[ Address ];
+            Entry.Instruction = ROMContents[ Address ].AsInstruction;
+            Entry.ImmediateValue.AsBinary = 0;
+            
+            // select the specific processor for this instruction
+            if( Entry.Instruction.OpCode == (int32_t)InstructionOpCodes::MOV )
+              Entry.Processor = MOVProcessorTable[ Entry.Instruction.AddressingMode ];
+            else
+              Entry.Processor = InstructionProcessorTable[ Entry.Instruction.OpCode ];
+            
+            // an immediate value beyond the ROM end needs to
+            // be fetched from the bus to raise the proper error
+            if( Entry.Instruction.UsesImmediate )
+            {
+                if( Address + 1 < (int32_t)ROMContents.size() )
+                  Entry.ImmediateValue = ROMContents[ Address + 1 ];
+                else
+                  Entry.Processor = nullptr;
+            }
+        }
+        
+        // now measure the basic block starting at each address;
+        // go backwards so that each one can extend the next
+        for( int32_t Address = NumberOfWords - 1; Address >= 0; Address-- )
+        {
+            PredecodedInstruction& Entry = Predecoded[ Address ];
+            Entry.BlockLength = 0;
+            
+            if( !Entry.Processor )
+              continue;
+            
+            // the block ends here with any instruction
+            // that can break sequential control flow
+            Entry.BlockLength = 1;
+            
+            if( EndsBasicBlock( Entry.Instruction ) )
+              continue;
+            
+            int32_t NextAddress = Address + (Entry.Instruction.UsesImmediate? 2 : 1);
+            
+            if( NextAddress < NumberOfWords )
+              Entry.BlockLength += Predecoded[ NextAddress ].BlockLength;
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32CPU::ClearPredecodedROM( int32_t DeviceID )
+    {
+        PredecodedROMs[ DeviceID ].clear();
+        PredecodedROMs[ DeviceID ].shrink_to_fit();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
     void V32CPU::RaiseHardwareError( CPUErrorCodes Code )
     {
         // use registers to pass values
@@ -8,11 +8,47 @@
     
     // include console logic headers
     #include "V32Buses.hpp"
+    
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
 // *****************************************************************************
 
 
 namespace V32
 {
+    // =============================================================================
+    //      PREDECODED INSTRUCTIONS
+    // =============================================================================
+    
+    
+    class V32CPU;
+    typedef void (*InstructionProcessor)( V32CPU&, CPUInstruction );
+    typedef int32_t (*BulkInstructionProcessor)( V32CPU&, CPUInstruction, int32_t );
+    
+    // -----------------------------------------------------------------------------
+    
+    // program ROMs cannot change while running, so their
+    // instructions can be decoded only once on connection;
+    // a null processor means the instruction at that address
+    // cannot be predecoded, so it will be fetched from the bus
+    struct PredecodedInstruction
+    {
+        InstructionProcessor Processor;
+        CPUInstruction Instruction;
+        V32Word ImmediateValue;
+        
+        // number of instructions in the basic
+        // block that begins at this address
+        int32_t BlockLength;
+    };
+    
+    // -----------------------------------------------------------------------------
+    
+    // limit for the words of each ROM that get predecoded
+    // (beyond this, instructions are just run from the bus)
+    const int32_t MaximumPredecodedWords = 4 * 1024 * 1024;
+    
+    
     // =============================================================================
     //      V32 CPU CLASS
     // =============================================================================
@@ -46,6 +82,22 @@ namespace V32
             V32MemoryBus* MemoryBus;
             V32ControlBus* ControlBus;
             
+            // decoded contents of connected program ROMs
+            // (indexed by their device ID in the memory bus)
+            std::vector< PredecodedInstruction > PredecodedROMs[ 4 ];
+            
+            // execution of program ROMs by basic blocks; when the
+            // period is not 0, 1 of every N blocks is run both ways
+            // and compared against the reference interpreter
+            bool BlockExecution;
+            int32_t DifferentialCheckPeriod;
+            int32_t BlocksSinceCheck;
+            int32_t CheckedBlocks;
+            
+            // when enabled, string instructions in program
+            // ROMs will run many iterations at once if possible
+            bool BulkStringInstructions;
+            
         public:
             
             // instance handling
@@ -55,6 +107,18 @@ namespace V32
             void Reset();
             void ChangeFrame();
             void RunNextCycle();
+            void RunCycles( int32_t& CycleCounter, int32_t CycleLimit );
+            
+            // instruction execution methods
+            const PredecodedInstruction* FindPredecodedInstruction();
+            void RunPredecodedInstruction( const PredecodedInstruction& Entry );
+            void RunInstructionFromBus();
+            void RunBlock( const PredecodedInstruction* Entry, int32_t& CycleCounter, int32_t CycleLimit );
+            bool CheckBlock( const PredecodedInstruction* Entry, int32_t& CycleCounter, int32_t CycleLimit );
+            
+            // instruction cache for program ROMs
+            void PredecodeROM( int32_t DeviceID, const std::vector< V32Word >& ROMContents );
+            void ClearPredecodedROM( int32_t DeviceID );
             
             // error handler
             void RaiseHardwareError( CPUErrorCodes Code );
@@ -145,6 +209,16 @@ namespace V32
     void ProcessMOVImmAddFromReg( V32CPU& CPU, CPUInstruction Instruction );
     void ProcessMOVRegAddFromReg( V32CPU& CPU, CPUInstruction Instruction );
     void ProcessMOVAddOffFromReg( V32CPU& CPU, CPUInstruction Instruction );
+    
+    
+    // =============================================================================
+    //      BULK PROCESSORS FOR STRING INSTRUCTIONS
+    // =============================================================================
+    
+    
+    int32_t ProcessMOVSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations );
+    int32_t ProcessSETSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations );
+    int32_t ProcessCMPSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations );
 }
 
 
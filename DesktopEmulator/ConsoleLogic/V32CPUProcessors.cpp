@@ -8,6 +8,8 @@
     
     // include C/C++ headers
     #include <cmath>            // [ ANSI C ] Mathematics
+    #include <cstring>          // [ ANSI C ] Strings
+    #include <algorithm>        // [ C++ STL ] Algorithms
     
     // declare used namespaces
     using namespace std;
@@ -54,6 +56,24 @@ namespace V32
           CPU.RaiseHardwareError( CPUErrorCodes::StackUnderflow );
     }
     
+    // -----------------------------------------------------------------------------
+    
+    // gives access to the host memory mapped by the bus at
+    // the given address, along with the consecutive words
+    // accessible from there (null if it is not mapped)
+    inline V32Word* GetMappedMemory( V32Word** MappedMemory, uint32_t* MappedWords, int32_t GlobalAddress, int32_t& AvailableWords )
+    {
+        int32_t DeviceID = (GlobalAddress >> 28) & 3;
+        uint32_t LocalAddress = GlobalAddress & 0x0FFFFFFF;
+        AvailableWords = 0;
+        
+        if( LocalAddress >= MappedWords[ DeviceID ] )
+          return nullptr;
+        
+        AvailableWords = MappedWords[ DeviceID ] - LocalAddress;
+        return &MappedMemory[ DeviceID ][ LocalAddress ];
+    }
+    
     
     // =============================================================================
     //      INSTRUCTION PROCESS FUNCTIONS FOR V32 CPU
@@ -944,6 +964,150 @@ namespace V32
     }
     
     
+    // =============================================================================
+    //      BULK PROCESSORS FOR STRING INSTRUCTIONS
+    // =============================================================================
+    
+    
+    // these run as many iterations as possible at once,
+    // but only when all of them would succeed; they leave
+    // the same state as running them one by one and return
+    // the iterations done, or 0 if they could not be done
+    int32_t ProcessMOVSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations )
+    {
+        int32_t& Counter = CPU.CountRegister.AsInteger;
+        V32MemoryBus* Bus = CPU.MemoryBus;
+        
+        // find the accessible host memory for both strings
+        int32_t SourceWords, DestinationWords;
+        V32Word* Source = GetMappedMemory( Bus->ReadableMemory, Bus->ReadableWords, CPU.SourceRegister.AsInteger, SourceWords );
+        V32Word* Destination = GetMappedMemory( Bus->WritableMemory, Bus->WritableWords, CPU.DestinationRegister.AsInteger, DestinationWords );
+        
+        // single iterations are left to the normal processor
+        int32_t Iterations = min( min( Counter, MaximumIterations ), min( SourceWords, DestinationWords ) );
+        
+        if( Iterations < 2 )
+          return 0;
+        
+        // when the destination starts within the source,
+        // words have to be copied one by one in order to
+        // replicate the pattern as the CPU would do it
+        if( Destination > Source && Destination < (Source + Iterations) )
+        {
+            for( int32_t i = 0; i < Iterations; i++ )
+              Destination[ i ] = Source[ i ];
+        }
+        
+        else memmove( Destination, Source, Iterations * sizeof(V32Word) );
+        
+        Bus->MarkDirtyWords( CPU.DestinationRegister.AsInteger, Iterations );
+        
+        // update registers as in the last iteration
+        CPU.SourceRegister.AsInteger += Iterations;
+        CPU.DestinationRegister.AsInteger += Iterations;
+        Counter -= Iterations;
+        
+        // restore PC if count not finished
+        if( Counter > 0 )
+          CPU.InstructionPointer.AsInteger--;
+        
+        return Iterations;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    int32_t ProcessSETSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations )
+    {
+        int32_t& Counter = CPU.CountRegister.AsInteger;
+        V32MemoryBus* Bus = CPU.MemoryBus;
+        
+        // find the accessible host memory for the string
+        int32_t DestinationWords;
+        V32Word* Destination = GetMappedMemory( Bus->WritableMemory, Bus->WritableWords, CPU.DestinationRegister.AsInteger, DestinationWords );
+        
+        // single iterations are left to the normal processor
+        int32_t Iterations = min( min( Counter, MaximumIterations ), DestinationWords );
+        
+        if( Iterations < 2 )
+          return 0;
+        
+        // set all words
+        V32Word Value = CPU.SourceRegister;
+        
+        for( int32_t i = 0; i < Iterations; i++ )
+          Destination[ i ] = Value;
+        
+        Bus->MarkDirtyWords( CPU.DestinationRegister.AsInteger, Iterations );
+        
+        // update registers as in the last iteration
+        CPU.DestinationRegister.AsInteger += Iterations;
+        Counter -= Iterations;
+        
+        // restore PC if count not finished
+        if( Counter > 0 )
+          CPU.InstructionPointer.AsInteger--;
+        
+        return Iterations;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    int32_t ProcessCMPSInBulk( V32CPU& CPU, CPUInstruction Instruction, int32_t MaximumIterations )
+    {
+        // results in CR, SR or DR would alter the comparison
+        // itself, so those cases are left to the normal processor
+        CPURegisters ResultRegisterName = (CPURegisters)Instruction.Register1;
+        
+        if( ResultRegisterName == CPURegisters::CountRegister
+        ||  ResultRegisterName == CPURegisters::SourceRegister
+        ||  ResultRegisterName == CPURegisters::DestinationRegister )
+          return 0;
+        
+        int32_t& Counter = CPU.CountRegister.AsInteger;
+        V32MemoryBus* Bus = CPU.MemoryBus;
+        
+        // find the accessible host memory for both strings
+        int32_t SourceWords, DestinationWords;
+        V32Word* Source = GetMappedMemory( Bus->ReadableMemory, Bus->ReadableWords, CPU.SourceRegister.AsInteger, SourceWords );
+        V32Word* Destination = GetMappedMemory( Bus->ReadableMemory, Bus->ReadableWords, CPU.DestinationRegister.AsInteger, DestinationWords );
+        
+        // single iterations are left to the normal processor
+        int32_t Iterations = min( min( Counter, MaximumIterations ), min( SourceWords, DestinationWords ) );
+        
+        if( Iterations < 2 )
+          return 0;
+        
+        // find the first difference, if any
+        int32_t EqualWords = 0;
+        
+        while( EqualWords < Iterations && Destination[ EqualWords ].AsBinary == Source[ EqualWords ].AsBinary )
+          EqualWords++;
+        
+        // equal words advance the strings as usual
+        CPU.SourceRegister.AsInteger += EqualWords;
+        CPU.DestinationRegister.AsInteger += EqualWords;
+        Counter -= EqualWords;
+        
+        // a difference ends the comparison there
+        V32Word* ResultRegister = &CPU.Registers[ Instruction.Register1 ];
+        
+        if( EqualWords < Iterations )
+        {
+            ResultRegister->AsInteger = Destination[ EqualWords ].AsInteger - Source[ EqualWords ].AsInteger;
+            return EqualWords + 1;
+        }
+        
+        // otherwise we only got to the iteration limit
+        ResultRegister->AsInteger = 0;
+        
+        // restore PC if count not finished
+        if( Counter > 0 )
+          CPU.InstructionPointer.AsInteger--;
+        
+        return Iterations;
+    }
+    
+    
     // =============================================================================
     //      MOV VARIANTS PROCESSORS
     // =============================================================================
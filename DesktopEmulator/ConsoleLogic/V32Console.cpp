@@ -10,6 +10,13 @@
     
     // include C/C++ headers
     #include <cstring>          // [ ANSI C ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <thread>           // [ C++ STL ] Threads
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <condition_variable>  // [ C++ STL ] Condition variables
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstdio>           // [ ANSI C ] Standard I/O
     
     // declare used namespaces
     using namespace std;
@@ -18,8 +25,182 @@
 
 namespace V32
 {
-    // buffer used to transmit textures from loaded ROM files to the video library
-    static GPUColor LoadedTexture[ Constants::GPUTextureSize ][ Constants::GPUTextureSize ];
+    // buffer used to transmit textures from loaded ROM files to the video
+    // library; it only holds the texture pixels, without expanding them
+    static vector< GPUColor > LoadedTexture;
+    
+    
+    // =============================================================================
+    //      CARTRIDGE LOADING HELPERS
+    // =============================================================================
+    
+    
+    // location of each asset in a cartridge file; all of
+    // them are found and checked before any one is loaded
+    struct CartridgeTexture
+    {
+        uint64_t FileOffset;
+        int Width, Height;
+        
+        // read from the file when it is about to be loaded
+        vector< GPUColor > Pixels;
+        bool ReadFailed;
+    };
+    
+    struct CartridgeSound
+    {
+        uint64_t FileOffset;
+        unsigned NumberOfSamples;
+    };
+    
+    // -----------------------------------------------------------------------------
+    
+    // textures are read from the file and prepared by the video
+    // library in a few worker threads; the loading thread still
+    // sends them to the library in order (libraries like OpenGL
+    // are not thread safe). Workers only go a few textures ahead
+    // so that prepared textures don't use too much memory
+    struct TextureWorkerPool
+    {
+        string FilePath;
+        vector< CartridgeTexture >* Textures;
+        vector< thread > Workers;
+        
+        // state shared with the workers
+        mutex PoolMutex;
+        condition_variable PoolCondition;
+        unsigned NextTexture;
+        unsigned LoadedTextures;
+        unsigned MaximumTexturesAhead;
+        vector< bool > TextureIsReady;
+        bool Cancelled;
+    };
+    
+    // -----------------------------------------------------------------------------
+    
+    static void RunTextureWorker( TextureWorkerPool* Pool )
+    {
+        // each worker reads the file on its own
+        ifstream InputFile;
+        OpenInputFile( InputFile, Pool->FilePath, ios_base::binary );
+        
+        unique_lock< mutex > Lock( Pool->PoolMutex );
+        unsigned NumberOfTextures = Pool->Textures->size();
+        
+        while( true )
+        {
+            Pool->PoolCondition.wait
+            (
+                Lock, [ Pool, NumberOfTextures ]{ return Pool->Cancelled || Pool->NextTexture >= NumberOfTextures
+                || Pool->NextTexture < Pool->LoadedTextures + Pool->MaximumTexturesAhead; }
+            );
+            
+            if( Pool->Cancelled || Pool->NextTexture >= NumberOfTextures )
+              return;
+            
+            // take the next texture in load order
+            unsigned TextureID = Pool->NextTexture++;
+            CartridgeTexture& Texture = (*Pool->Textures)[ TextureID ];
+            Lock.unlock();
+            
+            // read it from the file, and let the library prepare
+            // it if it can; on failure the library will do all
+            // the work when the texture is loaded
+            Texture.Pixels.resize( Texture.Width * Texture.Height );
+            InputFile.seekg( Texture.FileOffset, ios_base::beg );
+            InputFile.read( (char*)(&Texture.Pixels[ 0 ]), Texture.Pixels.size() * 4 );
+            bool ReadFailed = InputFile.fail();
+            
+            try
+            {
+                if( !ReadFailed && Callbacks::PrepareTexture )
+                  Callbacks::PrepareTexture( TextureID, &Texture.Pixels[ 0 ], Texture.Width, Texture.Height );
+            }
+            
+            catch( ... )
+            {}
+            
+            Lock.lock();
+            Texture.ReadFailed = ReadFailed;
+            Pool->TextureIsReady[ TextureID ] = true;
+            Pool->PoolCondition.notify_all();
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static void StartTextureWorkers( TextureWorkerPool& Pool, const string& FilePath, vector< CartridgeTexture >& Textures )
+    {
+        Pool.FilePath = FilePath;
+        Pool.Textures = &Textures;
+        Pool.NextTexture = 0;
+        Pool.LoadedTextures = 0;
+        Pool.TextureIsReady.assign( Textures.size(), false );
+        Pool.Cancelled = false;
+        
+        // leave one core for the loading thread
+        unsigned NumberOfWorkers = max( thread::hardware_concurrency(), 2u ) - 1;
+        NumberOfWorkers = min( NumberOfWorkers, (unsigned)Textures.size() );
+        Pool.MaximumTexturesAhead = 2 * NumberOfWorkers;
+        
+        for( unsigned i = 0; i < NumberOfWorkers; i++ )
+          Pool.Workers.push_back( thread( RunTextureWorker, &Pool ) );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static void WaitForTexture( TextureWorkerPool& Pool, unsigned TextureID )
+    {
+        unique_lock< mutex > Lock( Pool.PoolMutex );
+        Pool.PoolCondition.wait( Lock, [ &Pool, TextureID ]{ return Pool.TextureIsReady[ TextureID ]; } );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static void MarkTextureLoaded( TextureWorkerPool& Pool )
+    {
+        {
+            lock_guard< mutex > Lock( Pool.PoolMutex );
+            Pool.LoadedTextures++;
+        }
+        
+        Pool.PoolCondition.notify_all();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // also needed when loading is aborted, so
+    // that no worker is left accessing the file
+    static void FinishTextureWorkers( TextureWorkerPool& Pool )
+    {
+        {
+            lock_guard< mutex > Lock( Pool.PoolMutex );
+            Pool.Cancelled = true;
+        }
+        
+        Pool.PoolCondition.notify_all();
+        
+        for( thread& Worker: Pool.Workers )
+          Worker.join();
+        
+        Pool.Workers.clear();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static double GetElapsedMilliseconds( chrono::steady_clock::time_point StartTime )
+    {
+        return chrono::duration< double, milli >( chrono::steady_clock::now() - StartTime ).count();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    static string FormatMilliseconds( double Milliseconds )
+    {
+        char Text[ 32 ];
+        snprintf( Text, sizeof(Text), "%.1f ms", Milliseconds );
+        return Text;
+    }
     
     
     // =============================================================================
@@ -55,6 +236,7 @@ namespace V32
         
         // connect main RAM
         RAM.Connect( Constants::RAMSize );
+        MemoryBus.UpdateMappings();
         
         // set initial state
         PowerIsOn = false;
@@ -101,6 +283,7 @@ namespace V32
         {
             Callbacks::LogLine( "Console power OFF" );
             SPU.StopAllChannels();
+            FlushMemoryCard();
         }
     }
     
@@ -145,23 +328,26 @@ namespace V32
         // STEP 2: Run a frame's worth of cycles
         try
         {
-            for( int i = 0; i < Constants::CyclesPerFrame; i++ )
-            {
-                // end loop early when CPU is set to wait
-                if( CPU.Waiting || CPU.Halted )
-                  break;
-                
-                // only these components need to
-                // be notified of each CPU cycle
-                Timer.RunNextCycle();
-                CPU.RunNextCycle();
-            }
+            // (the timer is the only component that needs
+            // to be notified of each CPU cycle, so the CPU
+            // will update its counter when running cycles)
+            CPU.RunCycles( Timer.CycleCounter, Constants::CyclesPerFrame );
         }
         catch( CPUException& CPUex )
         {
             // do nothing: the only purpose of these exceptions
             // is to stop the loop without checking in every step
         }
+        catch( ... )
+        {
+            // SPU must not be in use after leaving
+            SPU.FinishMixing();
+            throw;
+        }
+        
+        // when the SPU mixes concurrently, ensure that
+        // this frame's sound is complete at frame end
+        SPU.FinishMixing();
         
         // after runnning the frame, update load info
         LastCPULoads[ 1 ] = LastCPULoads[ 0 ];
@@ -172,7 +358,7 @@ namespace V32
         LastGPULoads[ 0 ] = 100.0 * GPUUsedPixels / Constants::GPUPixelCapacityPerFrame;
         
         // STEP 3: save memory card to file when modified
-        if( MemoryCardController.PendingSave )
+        if( MemoryCardController.PendingSave && !MemoryCardController.HoldingChanges )
           SaveMemoryCard();
     }
     
@@ -328,6 +514,11 @@ namespace V32
         InputFile.read( (char*)(&LoadedBinary[ 0 ]), BinaryHeader.NumberOfWords * 4 );
         BiosProgramROM.Connect( &LoadedBinary[ 0 ], BinaryHeader.NumberOfWords );
         
+        MemoryBus.UpdateMappings();
+        
+        // decode the program in advance for the CPU
+        CPU.PredecodeROM( 1, BiosProgramROM.Memory );
+        
         // discard the temporary buffer
         LoadedBinary.clear();
         
@@ -352,16 +543,12 @@ namespace V32
         ||  !IsBetween( TextureHeader.TextureHeight, 1, Constants::GPUTextureSize ) )
           Callbacks::ThrowException( "BIOS texture does not have correct dimensions (from 1x1 up to 1024x1024 pixels)" );
         
-        // clear all texture pixels
-        memset( LoadedTexture, 0, sizeof(LoadedTexture) );
-        
-        // load the texture pixels line by line,
-        // in order to expand it to full size
-        for( unsigned y = 0; y < TextureHeader.TextureHeight; y++ )
-          InputFile.read( (char*)(LoadedTexture[ y ]), TextureHeader.TextureWidth * 4 );
+        // load all texture pixels at once
+        LoadedTexture.resize( TextureHeader.TextureWidth * TextureHeader.TextureHeight );
+        InputFile.read( (char*)(&LoadedTexture[ 0 ]), LoadedTexture.size() * 4 );
         
         // send bios texture to the video library
-        Callbacks::LoadTexture( -1, LoadedTexture );
+        Callbacks::LoadTexture( -1, &LoadedTexture[ 0 ], TextureHeader.TextureWidth, TextureHeader.TextureHeight );
         
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         // STEP 5: Load audio rom
@@ -413,6 +600,8 @@ namespace V32
         
         // release bios program ROM
         BiosProgramROM.Disconnect();
+        MemoryBus.UpdateMappings();
+        CPU.ClearPredecodedROM( 1 );
         BiosFileName = "";
         BiosTitle = "";
         BiosVersion = 0;
@@ -445,6 +634,7 @@ namespace V32
     
         // unload any previous cartridge
         UnloadCartridge();
+        auto StartTime = chrono::steady_clock::now();
         
         // open cartridge file
         ifstream InputFile;
@@ -457,9 +647,15 @@ namespace V32
         // STEP 1: Load global information
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         
+        // ensure that offsets within the file fit in 32 bits
+        uint64_t FileSize = InputFile.tellg();
+        
+        if( FileSize > 0xFFFFFFFFu )
+          Callbacks::ThrowException( "Incorrect V32 file format (file is too large)" );
+        
         // get size and ensure it is a multiple of 4
         // (otherwise file contents are wrong)
-        unsigned FileBytes = InputFile.tellg();
+        unsigned FileBytes = FileSize;
         
         if( (FileBytes % 4) != 0 )
           Callbacks::ThrowException( "Incorrect V32 file format (file size must be a multiple of 4)" );
@@ -511,120 +707,121 @@ namespace V32
           Callbacks::ThrowException( "Incorrect V32 file format (program ROM is not located after file header)" );
         
         // check for correct video rom location
-        uint32_t SizeAfterProgramROM = ROMHeader.ProgramROMLocation.StartOffset + ROMHeader.ProgramROMLocation.Length;
+        // (use 64 bits so that wrong lengths cannot overflow)
+        uint64_t SizeAfterProgramROM = (uint64_t)ROMHeader.ProgramROMLocation.StartOffset + ROMHeader.ProgramROMLocation.Length;
         
         if( ROMHeader.VideoROMLocation.StartOffset != SizeAfterProgramROM )
           Callbacks::ThrowException( "Incorrect V32 file format (video ROM is not located after program ROM)" );
         
         // check for correct audio rom location
-        uint32_t SizeAfterVideoROM = ROMHeader.VideoROMLocation.StartOffset + ROMHeader.VideoROMLocation.Length;
+        uint64_t SizeAfterVideoROM = (uint64_t)ROMHeader.VideoROMLocation.StartOffset + ROMHeader.VideoROMLocation.Length;
         
         if( ROMHeader.AudioROMLocation.StartOffset != SizeAfterVideoROM )
           Callbacks::ThrowException( "Incorrect V32 file format (audio ROM is not located after video ROM)" );
         
         // check for correct file size
-        uint32_t SizeAfterAudioROM = ROMHeader.AudioROMLocation.StartOffset + ROMHeader.AudioROMLocation.Length;
+        uint64_t SizeAfterAudioROM = (uint64_t)ROMHeader.AudioROMLocation.StartOffset + ROMHeader.AudioROMLocation.Length;
         
         if( FileBytes != SizeAfterAudioROM )
           Callbacks::ThrowException( "Incorrect V32 file format (file size does not match indicated ROM contents)" );
         
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        // STEP 3: Load program rom
+        // STEP 3: Build an index of all embedded files
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         
-        Callbacks::LogLine( "Loading cartridge program ROM" );
+        // only headers are read here, and every embedded
+        // file is checked to be within its ROM; this way all
+        // format errors are found before anything is loaded
+        uint64_t FileOffset = ROMHeader.ProgramROMLocation.StartOffset;
+        
+        // check the binary header
+        if( FileOffset + sizeof(BinaryFileFormat::Header) > SizeAfterProgramROM )
+          Callbacks::ThrowException( "Incorrect V32 file format (cartridge binary does not fit in program ROM)" );
         
-        // load a binary file signature
         BinaryFileFormat::Header BinaryHeader;
+        InputFile.seekg( FileOffset, ios_base::beg );
         InputFile.read( (char*)(&BinaryHeader), sizeof(BinaryFileFormat::Header) );
+        FileOffset += sizeof(BinaryFileFormat::Header);
         
         // check signature for embedded binary
         if( !CheckSignature( BinaryHeader.Signature, BinaryFileFormat::Signature ) )
           Callbacks::ThrowException( "Cartridge binary does not have a valid signature" );
         
-        Callbacks::LogLine( "-> Program ROM is " + to_string( BinaryHeader.NumberOfWords ) + " words" );
+        Callbacks::LogLine( "Program ROM is " + to_string( BinaryHeader.NumberOfWords ) + " words" );
         
         // check program rom size limitations
         if( !IsBetween( BinaryHeader.NumberOfWords, 1, Constants::MaximumCartridgeProgramROM ) )
           Callbacks::ThrowException( "Cartridge program ROM does not have a correct size (from 1 word up to 128M words)" );
         
-        // load the binary contents
-        vector< V32Word > LoadedBinary;
-        LoadedBinary.resize( BinaryHeader.NumberOfWords );
-        InputFile.read( (char*)(&LoadedBinary[ 0 ]), BinaryHeader.NumberOfWords * 4 );
-        CartridgeController.Connect( &LoadedBinary[ 0 ], BinaryHeader.NumberOfWords );
-        
-        // discard the temporary buffer
-        LoadedBinary.clear();
+        if( FileOffset + BinaryHeader.NumberOfWords * 4ull > SizeAfterProgramROM )
+          Callbacks::ThrowException( "Incorrect V32 file format (cartridge binary does not fit in program ROM)" );
         
-        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        // STEP 4: Load video rom
-        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        uint64_t BinaryOffset = FileOffset;
         
-        Callbacks::LogLine( "Loading cartridge video ROM" );
+        // check all texture headers
+        vector< CartridgeTexture > Textures( ROMHeader.NumberOfTextures );
+        uint64_t TotalTexturePixels = 0;
+        FileOffset = ROMHeader.VideoROMLocation.StartOffset;
         
-        // load all textures in sequence
         for( unsigned i = 0; i < ROMHeader.NumberOfTextures; i++ )
         {
-            // load a texture file signature
+            string TextureNumber = to_string( i );
+            
+            if( FileOffset + sizeof(TextureFileFormat::Header) > SizeAfterVideoROM )
+              Callbacks::ThrowException( "Incorrect V32 file format (cartridge texture " + TextureNumber + " does not fit in video ROM)" );
+            
             TextureFileFormat::Header TextureHeader;
+            InputFile.seekg( FileOffset, ios_base::beg );
             InputFile.read( (char*)(&TextureHeader), sizeof(TextureFileFormat::Header) );
+            FileOffset += sizeof(TextureFileFormat::Header);
             
             // check signature for embedded texture
             if( !CheckSignature( TextureHeader.Signature, TextureFileFormat::Signature ) )
-              Callbacks::ThrowException( "Cartridge texture does not have a valid signature" );
-            
-            // report texture size
-            Callbacks::LogLine( "-> Texture " + to_string( i ) + ": " + to_string( TextureHeader.TextureWidth )
-               + " x " + to_string( TextureHeader.TextureHeight ) + " pixels" );
+              Callbacks::ThrowException( "Cartridge texture " + TextureNumber + " does not have a valid signature" );
             
             // check texture size limitations
             if( !IsBetween( TextureHeader.TextureWidth , 1, Constants::GPUTextureSize )
             ||  !IsBetween( TextureHeader.TextureHeight, 1, Constants::GPUTextureSize ) )
-              Callbacks::ThrowException( "Cartridge texture does not have correct dimensions (1x1 up to 1024x1024 pixels)" );
+              Callbacks::ThrowException( "Cartridge texture " + TextureNumber + " does not have correct dimensions (1x1 up to 1024x1024 pixels)" );
             
-            // clear all texture pixels
-            memset( LoadedTexture, 0, sizeof(LoadedTexture) );
+            uint64_t TexturePixels = (uint64_t)TextureHeader.TextureWidth * TextureHeader.TextureHeight;
             
-            // load the texture pixels line by line,
-            // in order to expand it to full size
-            for( unsigned y = 0; y < TextureHeader.TextureHeight; y++ )
-              InputFile.read( (char*)(LoadedTexture[ y ]), TextureHeader.TextureWidth * 4 );
+            if( FileOffset + TexturePixels * 4 > SizeAfterVideoROM )
+              Callbacks::ThrowException( "Incorrect V32 file format (cartridge texture " + TextureNumber + " does not fit in video ROM)" );
             
-            // send this texture to the video library
-            Callbacks::LoadTexture( i, LoadedTexture );
+            Textures[ i ].FileOffset = FileOffset;
+            Textures[ i ].Width = TextureHeader.TextureWidth;
+            Textures[ i ].Height = TextureHeader.TextureHeight;
+            TotalTexturePixels += TexturePixels;
+            FileOffset += TexturePixels * 4;
         }
         
-        // now update GPU with the inserted textures
-        GPU.InsertCartridgeTextures( ROMHeader.NumberOfTextures );
+        Callbacks::LogLine( "Video ROM is " + to_string( TotalTexturePixels ) + " pixels" );
         
-        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        // STEP 5: Load audio rom
-        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        
-        Callbacks::LogLine( "Loading cartridge audio ROM" );
-        
-        // keep count of the total sound samples
+        // check all sound headers
+        vector< CartridgeSound > Sounds( ROMHeader.NumberOfSounds );
         uint32_t TotalSPUSamples = 0;
+        FileOffset = ROMHeader.AudioROMLocation.StartOffset;
         
-        // load all sounds in sequence
         for( unsigned i = 0; i < ROMHeader.NumberOfSounds; i++ )
         {
-            // load a sound file signature
+            string SoundNumber = to_string( i );
+            
+            if( FileOffset + sizeof(SoundFileFormat::Header) > SizeAfterAudioROM )
+              Callbacks::ThrowException( "Incorrect V32 file format (cartridge sound " + SoundNumber + " does not fit in audio ROM)" );
+            
             SoundFileFormat::Header SoundHeader;
+            InputFile.seekg( FileOffset, ios_base::beg );
             InputFile.read( (char*)(&SoundHeader), sizeof(SoundFileFormat::Header) );
+            FileOffset += sizeof(SoundFileFormat::Header);
             
             // check signature for embedded sound
             if( !CheckSignature( SoundHeader.Signature, SoundFileFormat::Signature ) )
-              Callbacks::ThrowException( "Cartridge sound does not have a valid signature" );
-            
-            // report sound length
-            Callbacks::LogLine( "-> Sound " + to_string( i ) + ": " + to_string( SoundHeader.SoundSamples )
-               + " samples (" + to_string( SoundHeader.SoundSamples/44100.0f ) + " seconds)" );
+              Callbacks::ThrowException( "Cartridge sound " + SoundNumber + " does not have a valid signature" );
             
             // check length limitations for this sound
             if( !IsBetween( SoundHeader.SoundSamples, 1, Constants::SPUMaximumCartridgeSamples ) )
-              Callbacks::ThrowException( "Cartridge sound does not have correct length (1 up to 256M samples)" );
+              Callbacks::ThrowException( "Cartridge sound " + SoundNumber + " does not have correct length (1 up to 256M samples)" );
             
             // check length limitations for the whole SPU
             TotalSPUSamples += SoundHeader.SoundSamples;
@@ -632,22 +829,132 @@ namespace V32
             if( TotalSPUSamples > (uint32_t)Constants::SPUMaximumCartridgeSamples )
               Callbacks::ThrowException( "Cartridge sounds contain too many total samples (Vircon SPU only allows up to 256M total samples)" );
             
+            if( FileOffset + SoundHeader.SoundSamples * 4ull > SizeAfterAudioROM )
+              Callbacks::ThrowException( "Incorrect V32 file format (cartridge sound " + SoundNumber + " does not fit in audio ROM)" );
+            
+            Sounds[ i ].FileOffset = FileOffset;
+            Sounds[ i ].NumberOfSamples = SoundHeader.SoundSamples;
+            FileOffset += SoundHeader.SoundSamples * 4ull;
+        }
+        
+        Callbacks::LogLine( "Audio ROM is " + to_string( TotalSPUSamples ) + " samples ("
+           + to_string( TotalSPUSamples/44100.0f ) + " seconds)" );
+        
+        double IndexTime = GetElapsedMilliseconds( StartTime );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // STEP 4: Load program rom
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        
+        // load the binary contents
+        vector< V32Word > LoadedBinary( BinaryHeader.NumberOfWords );
+        InputFile.seekg( BinaryOffset, ios_base::beg );
+        InputFile.read( (char*)(&LoadedBinary[ 0 ]), BinaryHeader.NumberOfWords * 4 );
+        
+        if( InputFile.fail() )
+          Callbacks::ThrowException( "Cannot read cartridge program ROM" );
+        
+        CartridgeController.Connect( &LoadedBinary[ 0 ], BinaryHeader.NumberOfWords );
+        MemoryBus.UpdateMappings();
+        
+        // discard the temporary buffer
+        vector< V32Word >().swap( LoadedBinary );
+        
+        // decode the program in advance for the CPU; this
+        // only affects the CPU so it can be done in parallel
+        // with the loading of textures and sounds
+        double PredecodeTime = 0;
+        
+        thread PredecodeThread
+        (
+            [ this, &PredecodeTime ]
+            {
+                auto PredecodeStartTime = chrono::steady_clock::now();
+                CPU.PredecodeROM( 2, CartridgeController.Memory );
+                PredecodeTime = GetElapsedMilliseconds( PredecodeStartTime );
+            }
+        );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // STEP 5: Load video rom
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        
+        auto TexturesStartTime = chrono::steady_clock::now();
+        int TotalAssets = ROMHeader.NumberOfTextures + ROMHeader.NumberOfSounds;
+        
+        TextureWorkerPool TextureWorkers;
+        
+        try
+        {
+            StartTextureWorkers( TextureWorkers, FilePath, Textures );
+            
+            // send textures to the video library in order,
+            // as soon as each one has been prepared
+            for( unsigned i = 0; i < ROMHeader.NumberOfTextures; i++ )
+            {
+                WaitForTexture( TextureWorkers, i );
+                
+                if( Textures[ i ].ReadFailed )
+                  Callbacks::ThrowException( "Cannot read cartridge texture " + to_string( i ) );
+                
+                Callbacks::LoadTexture( i, &Textures[ i ].Pixels[ 0 ], Textures[ i ].Width, Textures[ i ].Height );
+                MarkTextureLoaded( TextureWorkers );
+                
+                // discard its pixels once loaded
+                vector< GPUColor >().swap( Textures[ i ].Pixels );
+                
+                if( Callbacks::ReportLoadProgress )
+                  Callbacks::ReportLoadProgress( i + 1, TotalAssets );
+            }
+        }
+        
+        // don't leave any threads running
+        // with the cartridge being unloaded
+        catch( ... )
+        {
+            FinishTextureWorkers( TextureWorkers );
+            PredecodeThread.join();
+            throw;
+        }
+        
+        FinishTextureWorkers( TextureWorkers );
+        
+        // now update GPU with the inserted textures
+        GPU.InsertCartridgeTextures( ROMHeader.NumberOfTextures );
+        double TexturesTime = GetElapsedMilliseconds( TexturesStartTime );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // STEP 6: Load audio rom
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        
+        // load all sounds in sequence
+        for( unsigned i = 0; i < ROMHeader.NumberOfSounds; i++ )
+        {
             // load the sound samples
-            vector< SPUSample > LoadedSound;
-            LoadedSound.resize( SoundHeader.SoundSamples );
-            InputFile.read( (char*)(&LoadedSound[ 0 ]), SoundHeader.SoundSamples * 4 );
+            vector< SPUSample > LoadedSound( Sounds[ i ].NumberOfSamples );
+            InputFile.seekg( Sounds[ i ].FileOffset, ios_base::beg );
+            InputFile.read( (char*)(&LoadedSound[ 0 ]), Sounds[ i ].NumberOfSamples * 4 );
             
-            // create a new SPU sound and load data into it
-            SPU.LoadSound( SPU.CartridgeSounds[ i ], &LoadedSound[ 0 ], SoundHeader.SoundSamples );
+            if( InputFile.fail() )
+            {
+                PredecodeThread.join();
+                Callbacks::ThrowException( "Cannot read cartridge sound " + to_string( i ) );
+            }
             
-            // discard the temporary buffer
-            LoadedSound.clear();
+            // create a new SPU sound and load data into it
+            SPU.LoadSound( SPU.CartridgeSounds[ i ], &LoadedSound[ 0 ], Sounds[ i ].NumberOfSamples );
         }
         
         SPU.LoadedCartridgeSounds = ROMHeader.NumberOfSounds;
         
+        // wait for the program to be decoded
+        PredecodeThread.join();
+        
+        if( Callbacks::ReportLoadProgress )
+          Callbacks::ReportLoadProgress( TotalAssets, TotalAssets );
+        
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        // STEP 5: General Vircon setup
+        // STEP 7: General Vircon setup
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         
         // only when loading was successful:
@@ -667,6 +974,13 @@ namespace V32
         CartridgeController.CartridgeFileName = GetPathFileName( FilePath );
         Callbacks::LogLine( "FilePath = \"" + FilePath );
         Callbacks::LogLine( "CartridgeFileName = \"" + CartridgeController.CartridgeFileName );
+        
+        // report where loading time was spent
+        Callbacks::LogLine( "Cartridge load times: index " + FormatMilliseconds( IndexTime )
+           + ", textures " + FormatMilliseconds( TexturesTime )
+           + ", program predecode " + FormatMilliseconds( PredecodeTime ) + " (in parallel)"
+           + ", total " + FormatMilliseconds( GetElapsedMilliseconds( StartTime ) ) );
+        
         Callbacks::LogLine( "Finished loading cartridge" );
     }
     
@@ -680,6 +994,8 @@ namespace V32
         
         // release cartridge program ROM
         CartridgeController.Disconnect();
+        MemoryBus.UpdateMappings();
+        CPU.ClearPredecodedROM( 2 );
         CartridgeController.NumberOfTextures = 0;
         CartridgeController.NumberOfSounds = 0;
         CartridgeController.CartridgeFileName = "";
@@ -786,6 +1102,7 @@ namespace V32
         
         // connect the memory
         MemoryCardController.Connect( Constants::MemoryCardSize );
+        MemoryBus.UpdateMappings();
         
         // now load the whole memory card contents
         InputFile.read( (char*)(&MemoryCardController.Memory[ 0 ]), Constants::MemoryCardSize * 4 );
@@ -793,6 +1110,7 @@ namespace V32
         // do NOT close the file! leave it open until
         // card is unloaded or emulation is stopped,
         // so that it can be saved if card is modified
+        MemoryCardController.StartWriter();
         
         // save the file name
         MemoryCardController.CardFileName = GetPathFileName( FilePath );
@@ -807,15 +1125,22 @@ namespace V32
         if( !HasMemoryCard() ) return;
         Callbacks::LogLine( "Unloading memory card" );
         
-        // save the card if it was modified
-        if( MemoryCardController.PendingSave )
-          SaveMemoryCard();
+        // save the card if it was modified, and
+        // wait until all its pages are written
+        MemoryCardController.QueueModifiedPages();
+        MemoryCardController.StopWriter();
+        string WriteError = MemoryCardController.TakeWriteError();
         
         // remove the card memory
         MemoryCardController.Disconnect();
+        MemoryBus.UpdateMappings();
         
         // close the open file
         MemoryCardController.LinkedFile.close();
+        
+        if( !WriteError.empty() )
+          Callbacks::ThrowException( WriteError );
+        
         Callbacks::LogLine( "Finished unloading memory card" );
     }
     
@@ -826,19 +1151,48 @@ namespace V32
         // do nothing if a card is not loaded
         if( !HasMemoryCard() ) return;
         
-        // check the file
-        fstream& OutputFile = MemoryCardController.LinkedFile;
+        // report any earlier failed writes
+        string WriteError = MemoryCardController.TakeWriteError();
         
-        if( !OutputFile.is_open() || OutputFile.fail() )
-          Callbacks::ThrowException( "Cannot save memory card file" );
+        if( !WriteError.empty() )
+          Callbacks::ThrowException( WriteError );
         
-        // save the signature
-        OutputFile.seekp( ios_base::beg );
-        WriteSignature( OutputFile, MemoryCardFileFormat::Signature );
+        // modified pages are only queued here, and
+        // then get written by the card's own thread
+        MemoryCardController.QueueModifiedPages();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // ensures that the file has all changes made to
+    // the card so far (not just that they are queued)
+    void V32Console::FlushMemoryCard()
+    {
+        // do nothing if a card is not loaded
+        if( !HasMemoryCard() ) return;
         
-        // now save all contents
-        OutputFile.write( (char*)(&MemoryCardController.Memory[ 0 ]), Constants::MemoryCardSize * 4 );
-        MemoryCardController.PendingSave = false;
+        SaveMemoryCard();
+        MemoryCardController.FlushWrites();
+        
+        string WriteError = MemoryCardController.TakeWriteError();
+        
+        if( !WriteError.empty() )
+          Callbacks::ThrowException( WriteError );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // until discarded, changes to the card are not saved
+    void V32Console::HoldMemoryCardChanges()
+    {
+        MemoryCardController.HoldChanges();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32Console::DiscardMemoryCardChanges()
+    {
+        MemoryCardController.DiscardHeldChanges();
     }
     
     // -----------------------------------------------------------------------------
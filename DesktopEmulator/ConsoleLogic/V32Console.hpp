@@ -103,6 +103,9 @@ namespace V32
             void LoadMemoryCard( const std::string& FilePath );
             void UnloadMemoryCard();
             void SaveMemoryCard();
+            void FlushMemoryCard();
+            void HoldMemoryCardChanges();
+            void DiscardMemoryCardChanges();
             bool HasMemoryCard();
             bool WasMemoryCardModified();
             std::string GetMemoryCardFileName();
@@ -9,6 +9,7 @@
     
     // include C/C++ headers
     #include <cmath>            // [ ANSI C ] Mathematics
+    #include <cstring>          // [ ANSI C ] Strings
     
     // declare used namespaces
     using namespace std;
@@ -63,6 +64,8 @@ namespace V32
         
         // size the array
         CartridgeTextures.resize( Constants::GPUMaximumCartridgeTextures );
+        ModifiedTextures.resize( Constants::GPUMaximumCartridgeTextures + 1 );
+        MarkAllTexturesModified();
         
         // no cartridge loaded yet
         LoadedCartridgeTextures = 0;
@@ -99,6 +102,24 @@ namespace V32
     }
     
     
+    // =============================================================================
+    //      V32 GPU: TRACKING OF MODIFIED REGIONS
+    // =============================================================================
+    
+    
+    void V32GPU::MarkAllTexturesModified()
+    {
+        memset( ModifiedTextures.data(), 1, ModifiedTextures.size() );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32GPU::ClearModifiedTextures()
+    {
+        memset( ModifiedTextures.data(), 0, ModifiedTextures.size() );
+    }
+    
+    
     // =============================================================================
     //      V32 GPU: I/O BUS CONNECTION
     // =============================================================================
@@ -211,6 +232,8 @@ namespace V32
             BiosTexture.Regions[ j ].HotspotY = 0;
         }
         
+        MarkAllTexturesModified();
+        
         // initial screen clear to black
         Callbacks::ClearScreen( ClearColor );
     }
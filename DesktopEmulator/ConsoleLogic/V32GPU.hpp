@@ -86,6 +86,12 @@ namespace V32
             std::vector< GPUTexture > CartridgeTextures;    // do not use a plain array: it is too large to hold in stack
             unsigned LoadedCartridgeTextures;
             
+            // textures with regions modified since the flags were
+            // last cleared (the BIOS texture is at index 0, and
+            // then cartridge textures, so that SelectedTexture+1
+            // can be used as index)
+            std::vector< uint8_t > ModifiedTextures;
+            
             // accessors to active entities
             GPUTexture* PointedTexture;
             GPURegion*  PointedRegion;
@@ -121,6 +127,10 @@ namespace V32
             void InsertCartridgeTextures( uint32_t NumberOfCartridgeTextures );
             void RemoveCartridgeTextures();
             
+            // tracking of modified regions
+            void MarkAllTexturesModified();
+            void ClearModifiedTextures();
+            
             // connection to control bus
             virtual bool ReadPort( int32_t LocalPort, V32Word& Result );
             virtual bool WritePort( int32_t LocalPort, V32Word Value );
@@ -236,6 +236,7 @@ namespace V32
         // but they are clamped to texture limits
         Clamp( Value.AsInteger, 0, Constants::GPUTextureSize-1 );
         GPU.PointedRegion->MinX = Value.AsInteger;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
     
@@ -247,6 +248,7 @@ namespace V32
         // but they are clamped to texture limits
         Clamp( Value.AsInteger, 0, Constants::GPUTextureSize-1 );
         GPU.PointedRegion->MinY = Value.AsInteger;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
     
@@ -260,6 +262,7 @@ namespace V32
         Clamp( ValidX, 0, Constants::GPUTextureSize-1 );
         
         GPU.PointedRegion->MaxX = ValidX;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
     
@@ -271,6 +274,7 @@ namespace V32
         // but they are clamped to texture limits
         Clamp( Value.AsInteger, 0, Constants::GPUTextureSize-1 );
         GPU.PointedRegion->MaxY = Value.AsInteger;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
     
@@ -282,6 +286,7 @@ namespace V32
         // a certain range, then they get clamped
         Clamp( Value.AsInteger, -Constants::GPUTextureSize, (2*Constants::GPUTextureSize)-1 );
         GPU.PointedRegion->HotspotX = Value.AsInteger;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
     
@@ -292,6 +297,7 @@ namespace V32
         // out of texture values are valid
         Clamp( Value.AsInteger, -Constants::GPUTextureSize, (2*Constants::GPUTextureSize)-1 );
         GPU.PointedRegion->HotspotY = Value.AsInteger;
+        GPU.ModifiedTextures[ GPU.SelectedTexture + 1 ] = 1;
         return true;
     }
 }
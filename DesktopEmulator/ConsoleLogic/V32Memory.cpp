@@ -30,6 +30,9 @@ namespace V32
         Memory.resize( NumberOfWords );
         MemorySize = NumberOfWords;
         
+        // the last page may be incomplete
+        DirtyPages.resize( (NumberOfWords + MemoryPageWords - 1) >> MemoryPageBits );
+        
         // initially, set to zeroes
         ClearContents();
     }
@@ -39,6 +42,7 @@ namespace V32
     void V32RAM::Disconnect()
     {
         Memory.clear();
+        DirtyPages.clear();
         MemorySize = 0;
     }
     
@@ -47,6 +51,35 @@ namespace V32
     void V32RAM::ClearContents()
     {
         memset( &Memory[ 0 ], 0, Memory.size() * 4 );
+        MarkAllPagesDirty();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    int32_t V32RAM::GetNumberOfPages()
+    {
+        return DirtyPages.size();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    bool V32RAM::IsPageDirty( int32_t Page )
+    {
+        return DirtyPages[ Page ];
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32RAM::MarkAllPagesDirty()
+    {
+        memset( DirtyPages.data(), 1, DirtyPages.size() );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32RAM::ClearDirtyPages()
+    {
+        memset( DirtyPages.data(), 0, DirtyPages.size() );
     }
     
     // -----------------------------------------------------------------------------
@@ -72,9 +105,33 @@ namespace V32
         
         // write value
         Memory[ LocalAddress ] = Value;
+        DirtyPages[ LocalAddress >> MemoryPageBits ] = 1;
         return true;
     }
     
+    // -----------------------------------------------------------------------------
+    
+    V32Word* V32RAM::GetReadableMemory( int32_t& NumberOfWords )
+    {
+        NumberOfWords = MemorySize;
+        return (MemorySize > 0? &Memory[ 0 ] : nullptr);
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    V32Word* V32RAM::GetWritableMemory( int32_t& NumberOfWords )
+    {
+        NumberOfWords = MemorySize;
+        return (MemorySize > 0? &Memory[ 0 ] : nullptr);
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    uint8_t* V32RAM::GetDirtyPages()
+    {
+        return (MemorySize > 0? &DirtyPages[ 0 ] : nullptr);
+    }
+    
     
     // =============================================================================
     //      CLASS: V32 ROM
@@ -105,7 +162,8 @@ namespace V32
     
     void V32ROM::Disconnect()
     {
-        Memory.clear();
+        // release the memory, not just clear it
+        std::vector< V32Word >().swap( Memory );
         MemorySize = 0;
     }
     
@@ -129,4 +187,12 @@ namespace V32
         // ROM cannot be written to
         return false;
     }
+    
+    // -----------------------------------------------------------------------------
+    
+    V32Word* V32ROM::GetReadableMemory( int32_t& NumberOfWords )
+    {
+        NumberOfWords = MemorySize;
+        return (MemorySize > 0? &Memory[ 0 ] : nullptr);
+    }
 }
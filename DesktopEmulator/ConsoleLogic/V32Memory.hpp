@@ -25,6 +25,9 @@ namespace V32
             std::vector< V32Word > Memory;
             int32_t MemorySize;
             
+            // pages written since the flags were last cleared
+            std::vector< uint8_t > DirtyPages;
+            
         public:
             
             // instance handling
@@ -37,9 +40,18 @@ namespace V32
             // memory contents
             void ClearContents();
             
+            // tracking of modified pages
+            int32_t GetNumberOfPages();
+            bool IsPageDirty( int32_t Page );
+            void MarkAllPagesDirty();
+            void ClearDirtyPages();
+            
             // bus connection
             virtual bool ReadAddress( int32_t LocalAddress, V32Word& Result );
             virtual bool WriteAddress( int32_t LocalAddress, V32Word Value );
+            virtual V32Word* GetReadableMemory( int32_t& NumberOfWords );
+            virtual V32Word* GetWritableMemory( int32_t& NumberOfWords );
+            virtual uint8_t* GetDirtyPages();
     };
     
     
@@ -68,6 +80,7 @@ namespace V32
             // bus connection
             virtual bool ReadAddress( int32_t LocalAddress, V32Word& Result );
             virtual bool WriteAddress( int32_t LocalAddress, V32Word Value );
+            virtual V32Word* GetReadableMemory( int32_t& NumberOfWords );
     };
 }
 
@@ -1,9 +1,23 @@
 // *****************************************************************************
     // include console logic headers
     #include "V32MemoryCardController.hpp"
+    
+    // include C/C++ headers
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstring>          // [ ANSI C ] Strings
+    
+    // declare used namespaces
+    using namespace std;
 // *****************************************************************************
 
 
+// how long the writer thread waits for more modifications
+// before saving, so that games that save over many frames
+// are written once instead of in every one of those frames
+#define MEMORY_CARD_WRITE_DELAY_MILLISECONDS 200
+
+
 namespace V32
 {
     // =============================================================================
@@ -14,12 +28,21 @@ namespace V32
     V32MemoryCardController::V32MemoryCardController()
     {
         PendingSave = false;
+        HasQueuedPages = false;
+        WriterThreadActive = false;
+        WritingPages = false;
+        FlushRequested = false;
+        HoldingChanges = false;
+        HeldPendingSave = false;
     }
     
     // -----------------------------------------------------------------------------
     
     V32MemoryCardController::~V32MemoryCardController()
     {
+        // don't lose any queued pages
+        StopWriter();
+        
         // ensure we always close the file
         if( LinkedFile.is_open() )
           LinkedFile.close();
@@ -56,6 +79,20 @@ namespace V32
     
     bool V32MemoryCardController::WriteAddress( int32_t LocalAddress, V32Word Value )
     {
+        // keep the original page on its first change
+        if( HoldingChanges && LocalAddress >= 0 && LocalAddress < MemorySize )
+        {
+            int32_t Page = LocalAddress >> MemoryPageBits;
+            
+            if( !HeldPages[ Page ] )
+            {
+                int32_t FirstWord = Page * MemoryPageWords;
+                int32_t PageWords = min( MemoryPageWords, MemorySize - FirstWord );
+                memcpy( &HeldWords[ FirstWord ], &Memory[ FirstWord ], PageWords * sizeof(V32Word) );
+                HeldPages[ Page ] = 1;
+            }
+        }
+        
         // check that the normal RAM write is successful
         if( !V32RAM::WriteAddress( LocalAddress, Value ) )
           return false;
@@ -65,4 +102,244 @@ namespace V32
         
         return true;
     }
+    
+    // -----------------------------------------------------------------------------
+    
+    V32Word* V32MemoryCardController::GetWritableMemory( int32_t& NumberOfWords )
+    {
+        // writes need to go through WriteAddress
+        // so that saving to file is not missed
+        NumberOfWords = 0;
+        return nullptr;
+    }
+    
+    
+    // =============================================================================
+    //      V32 MEMORY CARD CONTROLLER: WRITE-BEHIND TO FILE
+    // =============================================================================
+    
+    
+    // Only pages marked as dirty in RAM are saved. The emulation
+    // thread just copies them to the queue, and the writer thread
+    // later writes each run of consecutive pages with a single
+    // seek and write, while the console continues running.
+    void V32MemoryCardController::StartWriter()
+    {
+        StopWriter();
+        
+        // the file already has the loaded contents
+        ClearDirtyPages();
+        PendingSave = false;
+        
+        QueuedWords.assign( MemorySize, V32Word() );
+        QueuedPages.assign( GetNumberOfPages(), 0 );
+        WrittenWords.assign( MemorySize, V32Word() );
+        HasQueuedPages = false;
+        WriteError.clear();
+        
+        WriterThreadActive = true;
+        WriterThread = thread( &V32MemoryCardController::WriterLoop, this );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryCardController::QueueModifiedPages()
+    {
+        if( !WriterThread.joinable() )
+          return;
+        
+        {
+            lock_guard< mutex > Lock( WriterMutex );
+            
+            for( int32_t Page = 0; Page < GetNumberOfPages(); Page++ )
+            {
+                if( !IsPageDirty( Page ) )
+                  continue;
+                
+                int32_t FirstWord = Page * MemoryPageWords;
+                int32_t PageWords = min( MemoryPageWords, MemorySize - FirstWord );
+                memcpy( &QueuedWords[ FirstWord ], &Memory[ FirstWord ], PageWords * sizeof(V32Word) );
+                
+                QueuedPages[ Page ] = 1;
+                HasQueuedPages = true;
+            }
+        }
+        
+        ClearDirtyPages();
+        PendingSave = false;
+        WriterCondition.notify_all();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // waits until all queued pages are written
+    void V32MemoryCardController::FlushWrites()
+    {
+        if( !WriterThread.joinable() )
+          return;
+        
+        unique_lock< mutex > Lock( WriterMutex );
+        FlushRequested = true;
+        WriterCondition.notify_all();
+        
+        WriterCondition.wait( Lock, [ this ]{ return !HasQueuedPages && !WritingPages; } );
+        FlushRequested = false;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // the thread writes all queued pages before it ends
+    void V32MemoryCardController::StopWriter()
+    {
+        if( !WriterThread.joinable() )
+          return;
+        
+        {
+            lock_guard< mutex > Lock( WriterMutex );
+            WriterThreadActive = false;
+        }
+        
+        WriterCondition.notify_all();
+        WriterThread.join();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryCardController::WriterLoop()
+    {
+        unique_lock< mutex > Lock( WriterMutex );
+        vector< uint8_t > Pages;
+        
+        while( true )
+        {
+            WriterCondition.wait( Lock, [ this ]{ return HasQueuedPages || !WriterThreadActive; } );
+            
+            // give time for more pages to be queued
+            WriterCondition.wait_for
+            (
+                Lock,
+                chrono::milliseconds( MEMORY_CARD_WRITE_DELAY_MILLISECONDS ),
+                [ this ]{ return FlushRequested || !WriterThreadActive; }
+            );
+            
+            if( HasQueuedPages )
+            {
+                // take the queued pages, so that new ones
+                // can be queued while these are written
+                Pages.swap( QueuedPages );
+                QueuedPages.assign( Pages.size(), 0 );
+                HasQueuedPages = false;
+                
+                for( int32_t Page = 0; Page < (int32_t)Pages.size(); Page++ )
+                  if( Pages[ Page ] )
+                  {
+                      int32_t FirstWord = Page * MemoryPageWords;
+                      int32_t PageWords = min( MemoryPageWords, MemorySize - FirstWord );
+                      memcpy( &WrittenWords[ FirstWord ], &QueuedWords[ FirstWord ], PageWords * sizeof(V32Word) );
+                  }
+                
+                WritingPages = true;
+                Lock.unlock();
+                WritePages( Pages );
+                Lock.lock();
+                
+                WritingPages = false;
+                WriterCondition.notify_all();
+            }
+            
+            if( !WriterThreadActive && !HasQueuedPages )
+              return;
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryCardController::WritePages( const vector< uint8_t >& Pages )
+    {
+        int32_t NumberOfPages = Pages.size();
+        int32_t Page = 0;
+        
+        while( Page < NumberOfPages )
+        {
+            if( !Pages[ Page ] )
+            {
+                Page++;
+                continue;
+            }
+            
+            // join consecutive pages in a single write
+            int32_t FirstPage = Page;
+            
+            while( Page < NumberOfPages && Pages[ Page ] )
+              Page++;
+            
+            int32_t FirstWord = FirstPage * MemoryPageWords;
+            int32_t EndWord = min( Page * MemoryPageWords, MemorySize );
+            
+            // contents start after the file signature
+            LinkedFile.seekp( 8 + FirstWord * sizeof(V32Word), ios_base::beg );
+            LinkedFile.write( (char*)(&WrittenWords[ FirstWord ]), (EndWord - FirstWord) * sizeof(V32Word) );
+        }
+        
+        LinkedFile.flush();
+        
+        if( LinkedFile.fail() )
+        {
+            lock_guard< mutex > Lock( WriterMutex );
+            WriteError = "Cannot save memory card file";
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // errors happen in the writer thread, so they
+    // are reported later from the emulation thread
+    string V32MemoryCardController::TakeWriteError()
+    {
+        lock_guard< mutex > Lock( WriterMutex );
+        string Error = WriteError;
+        WriteError.clear();
+        return Error;
+    }
+    
+    
+    // =============================================================================
+    //      V32 MEMORY CARD CONTROLLER: HELD CHANGES
+    // =============================================================================
+    
+    
+    // Memory card contents are not part of console states, so
+    // frames that will be undone hold their changes: they are
+    // not saved, and the card can be returned to how it was
+    void V32MemoryCardController::HoldChanges()
+    {
+        if( HoldingChanges || MemorySize == 0 )
+          return;
+        
+        HeldWords.resize( MemorySize );
+        HeldPages.assign( GetNumberOfPages(), 0 );
+        HeldPendingSave = PendingSave;
+        HoldingChanges = true;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32MemoryCardController::DiscardHeldChanges()
+    {
+        if( !HoldingChanges )
+          return;
+        
+        for( int32_t Page = 0; Page < (int32_t)HeldPages.size(); Page++ )
+          if( HeldPages[ Page ] )
+          {
+              int32_t FirstWord = Page * MemoryPageWords;
+              int32_t PageWords = min( MemoryPageWords, MemorySize - FirstWord );
+              memcpy( &Memory[ FirstWord ], &HeldWords[ FirstWord ], PageWords * sizeof(V32Word) );
+          }
+        
+        // restored pages stay marked as dirty, so at
+        // worst they are saved again with no changes
+        PendingSave = HeldPendingSave;
+        HoldingChanges = false;
+    }
 }
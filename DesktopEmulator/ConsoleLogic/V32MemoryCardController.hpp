@@ -10,6 +10,10 @@
     // include C/C++ headers
     #include <string>           // [ C++ STL ] Strings
     #include <fstream>          // [ C++ STL ] File streams
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <thread>           // [ C++ STL ] Threads
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <condition_variable>  // [ C++ STL ] Condition variables
 // *****************************************************************************
 
 
@@ -44,6 +48,30 @@ namespace V32
             std::fstream LinkedFile;
             bool PendingSave;
             
+            // modified pages waiting to be written; they are
+            // copied when queued, so the card can keep being
+            // modified while the writer thread saves them
+            std::vector< V32Word > QueuedWords;
+            std::vector< uint8_t > QueuedPages;
+            bool HasQueuedPages;
+            
+            // writer thread state
+            std::thread WriterThread;
+            std::mutex WriterMutex;
+            std::condition_variable WriterCondition;
+            std::vector< V32Word > WrittenWords;
+            bool WriterThreadActive;
+            bool WritingPages;
+            bool FlushRequested;
+            std::string WriteError;
+            
+            // while changes are held, the original contents of
+            // each modified page are kept so they can be restored
+            bool HoldingChanges;
+            bool HeldPendingSave;
+            std::vector< V32Word > HeldWords;
+            std::vector< uint8_t > HeldPages;
+            
             // displayed file name for GUI
             std::string CardFileName;
             
@@ -59,6 +87,20 @@ namespace V32
             
             // connection to memory bus (overriden)
             virtual bool WriteAddress( int32_t LocalAddress, V32Word Value );
+            virtual V32Word* GetWritableMemory( int32_t& NumberOfWords );
+            
+            // saving to file in the writer thread
+            void StartWriter();
+            void QueueModifiedPages();
+            void FlushWrites();
+            void StopWriter();
+            void WriterLoop();
+            void WritePages( const std::vector< uint8_t >& Pages );
+            std::string TakeWriteError();
+            
+            // changes that can be undone
+            void HoldChanges();
+            void DiscardHeldChanges();
     };
 }
 
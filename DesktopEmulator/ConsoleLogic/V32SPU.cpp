@@ -1,10 +1,20 @@
 // *****************************************************************************
     // include console logic headers
     #include "V32SPU.hpp"
+    #include "AuxiliaryFunctions.hpp"
     
     // include C/C++ headers
     #include <cstring>          // [ ANSI C ] Strings
     #include <cmath>            // [ ANSI C ] Math
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    
+    // include SIMD intrinsics when available
+    #if defined( __SSE2__ )
+      #include <emmintrin.h>    // [ SSE2 ] Intrinsics
+    #endif
+    
+    // declare used namespaces
+    using namespace std;
 // *****************************************************************************
 
 
@@ -52,6 +62,12 @@ namespace V32
         
         // no cartridge loaded yet
         LoadedCartridgeSounds = 0;
+        
+        // mix in the calling thread by default;
+        // the mixing thread is only created if needed
+        ConcurrentMixing = false;
+        MixingPending = false;
+        MixingThreadActive = false;
     }
     
     // -----------------------------------------------------------------------------
@@ -60,6 +76,18 @@ namespace V32
     {
         // don't release any sounds
         // (this is done at console destructor)
+        
+        // stop the mixing thread, if any
+        if( MixingThread.joinable() )
+        {
+            {
+                lock_guard< mutex > Lock( MixingMutex );
+                MixingThreadActive = false;
+            }
+            
+            MixingCondition.notify_all();
+            MixingThread.join();
+        }
     }
     
     
@@ -87,7 +115,8 @@ namespace V32
     
     void V32SPU::UnloadSound( SPUSound& TargetSound )
     {
-        TargetSound.Samples.clear();
+        // release the memory, not just clear it
+        vector< SPUSample >().swap( TargetSound.Samples );
         TargetSound.Length = 0;
     }
     
@@ -103,6 +132,12 @@ namespace V32
         if( LocalPort > SPU_LastPort )
           return false;
         
+        // channel state and position are updated by
+        // mixing, so the current frame's must be done
+        if( LocalPort == (int32_t)SPU_LocalPorts::ChannelState
+        ||  LocalPort == (int32_t)SPU_LocalPorts::ChannelPosition )
+          FinishMixing();
+        
         // command port is write-only
         if( LocalPort == (int32_t)SPU_LocalPorts::Command )
           return false;
@@ -149,6 +184,10 @@ namespace V32
         if( LocalPort > SPU_LastPort )
           return false;
         
+        // writes can change anything used in mixing, so
+        // they must wait until the current frame is mixed
+        FinishMixing();
+        
         // redirect to the needed specific writer
         return SPUPortWriterTable[ LocalPort ]( *this, Value );
     }
@@ -162,7 +201,10 @@ namespace V32
     void V32SPU::ChangeFrame()
     {
         // generate sound for next frame
-        UpdateOutputBuffer();
+        if( ConcurrentMixing )
+          StartMixing();
+        else
+          UpdateOutputBuffer();
     }
     
     // -----------------------------------------------------------------------------
@@ -305,63 +347,202 @@ namespace V32
     
     // -----------------------------------------------------------------------------
     
-    void V32SPU::UpdateOutputBuffer()
+    // mixes a run of consecutive samples into the stereo sums;
+    // each value is multiplied, added and truncated with floats,
+    // same as the mixer did for every single sample
+    static void MixConsecutiveSamples( const SPUSample* Samples, int NumberOfSamples, float Volume, int32_t* MixedValues )
     {
-        // assign the next sequence number to the buffer
-        OutputBuffer.SequenceNumber++;
+        const int16_t* InputValues = (const int16_t*)Samples;
+        int NumberOfValues = NumberOfSamples * 2;
+        int i = 0;
+        
+        // mix 4 stereo samples at a time
+        #if defined( __SSE2__ )
+          __m128 Volumes = _mm_set1_ps( Volume );
+          
+          for( ; i + 8 <= NumberOfValues; i += 8 )
+          {
+              // extend the 8 input values to 32 bits
+              __m128i Input16 = _mm_loadu_si128( (const __m128i*)(InputValues + i) );
+              __m128i InputLow  = _mm_srai_epi32( _mm_unpacklo_epi16( Input16, Input16 ), 16 );
+              __m128i InputHigh = _mm_srai_epi32( _mm_unpackhi_epi16( Input16, Input16 ), 16 );
+              
+              __m128i* Output = (__m128i*)(MixedValues + i);
+              __m128 MixedLow  = _mm_add_ps( _mm_cvtepi32_ps( _mm_loadu_si128( Output     ) ), _mm_mul_ps( Volumes, _mm_cvtepi32_ps( InputLow  ) ) );
+              __m128 MixedHigh = _mm_add_ps( _mm_cvtepi32_ps( _mm_loadu_si128( Output + 1 ) ), _mm_mul_ps( Volumes, _mm_cvtepi32_ps( InputHigh ) ) );
+              _mm_storeu_si128( Output,     _mm_cvttps_epi32( MixedLow  ) );
+              _mm_storeu_si128( Output + 1, _mm_cvttps_epi32( MixedHigh ) );
+          }
+        #endif
+        
+        // mix any remaining values one by one
+        for( ; i < NumberOfValues; i++ )
+          MixedValues[ i ] = MixedValues[ i ] + Volume * InputValues[ i ];
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    // adds the whole frame of a playing channel to the mixed values;
+    // samples are processed in runs up to the next loop or end
+    // boundary, so that those checks are not done for each sample
+    void V32SPU::MixChannel( SPUChannel& Channel, int32_t* MixedValues )
+    {
+        SPUSound* ChannelSound = GetChannelSound( &Channel );
+        float TotalVolume = GlobalVolume * Channel.Volume;
+        int32_t LastSample = ChannelSound->Length - 1;
         
-        // determine the value for each sample in the buffer
-        for( int s = 0; s < Constants::SPUSamplesPerFrame; s++ )
+        // a sound with no samples cannot be played
+        if( LastSample < 0 )
         {
-            // use a local variable for speed
-            SPUSample ThisSample = {0,0};
+            StopChannel( Channel );
+            return;
+        }
+        
+        int s = 0;
+        
+        while( s < Constants::SPUSamplesPerFrame )
+        {
+            // cannot perform loop with a bad loop configuration!
+            // (otherwise, fmod may throw an exception)
+            int32_t LoopStart = ChannelSound->LoopStart;
+            int32_t LoopEnd   = ChannelSound->LoopEnd;
+            bool LoopApplies = Channel.LoopEnabled && LoopEnd > LoopStart && Channel.Position <= LoopEnd;
+            
+            // all positions up to the boundary need no checks
+            int32_t Boundary = (LoopApplies? min( LoopEnd, LastSample ) : LastSample);
             
-            // generate sound for all channels
-            for( int c = 0; c < Constants::SPUSoundChannels; c++ )
+            // at normal speed from a whole position, the
+            // samples until the boundary are consecutive
+            if( Channel.Speed == 1.0f && Channel.Position == floor( Channel.Position ) )
             {
-                // process only playing channels
-                SPUChannel* ThisChannel = &Channels[ c ];
-                
-                if( ThisChannel->State != IOPortValues::SPUChannelState_Playing )
-                  continue;
+                int32_t FirstSample = (int32_t)Channel.Position;
+                int RunLength = min( Constants::SPUSamplesPerFrame - s, Boundary - FirstSample + 1 );
                 
-                // pick sample at this position
-                SPUSound* ChannelSound = GetChannelSound( ThisChannel );
-                SPUSample PickedSample = ChannelSound->Samples[ (int)ThisChannel->Position ];
-                
-                // mix the sample
-                float TotalVolume = GlobalVolume * ThisChannel->Volume;
-                ThisSample.LeftSample  += TotalVolume * PickedSample.LeftSample;
-                ThisSample.RightSample += TotalVolume * PickedSample.RightSample;
-                
-                // advance at current speed
-                double PreviousPosition = ThisChannel->Position;
-                ThisChannel->Position += ThisChannel->Speed;
-                
-                // if loop is enabled, check for loop boundary
-                if( ThisChannel->LoopEnabled )
-                {
-                    int32_t LoopStart = ChannelSound->LoopStart;
-                    int32_t LoopEnd   = ChannelSound->LoopEnd;
-                    
-                    // cannot perform loop with a bad loop configuration!
-                    // (otherwise, fmod may throw an exception)
-                    if( LoopEnd > LoopStart )
-                      if( PreviousPosition <= LoopEnd && ThisChannel->Position > LoopEnd )
-                      {
-                          // don't just go back to start: for high playback speeds we
-                          // may have overshot the end position, so compensate the excess
-                          double PartialAdvance = fmod( ThisChannel->Position - LoopStart, LoopEnd - LoopStart );
-                          ThisChannel->Position = LoopStart + PartialAdvance;
-                      }
-                }
+                MixConsecutiveSamples( &ChannelSound->Samples[ FirstSample ], RunLength, TotalVolume, &MixedValues[ 2 * s ] );
+                Channel.Position += RunLength;
+                s += RunLength;
+            }
+            
+            // otherwise advance one sample at a time
+            else do
+            {
+                SPUSample PickedSample = ChannelSound->Samples[ (int)Channel.Position ];
+                MixedValues[ 2 * s     ] = MixedValues[ 2 * s     ] + TotalVolume * PickedSample.LeftSample;
+                MixedValues[ 2 * s + 1 ] = MixedValues[ 2 * s + 1 ] + TotalVolume * PickedSample.RightSample;
                 
-                // if the sound ends, stop the channel
-                if( ThisChannel->Position > (ChannelSound->Length - 1) )
-                  StopChannel( *ThisChannel );
+                Channel.Position += Channel.Speed;
+                s++;
+            }
+            while( s < Constants::SPUSamplesPerFrame && Channel.Position <= Boundary );
+            
+            // the run may also end with the frame
+            if( Channel.Position <= Boundary )
+              continue;
+            
+            // don't just go back to start: for high playback speeds we
+            // may have overshot the end position, so compensate the excess
+            if( LoopApplies && Channel.Position > LoopEnd )
+            {
+                double PartialAdvance = fmod( Channel.Position - LoopStart, LoopEnd - LoopStart );
+                Channel.Position = LoopStart + PartialAdvance;
             }
             
-            OutputBuffer.Samples[ s ] = ThisSample;
+            // if the sound ends, stop the channel
+            if( Channel.Position > LastSample )
+            {
+                StopChannel( Channel );
+                return;
+            }
+        }
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32SPU::UpdateOutputBuffer()
+    {
+        // assign the next sequence number to the buffer
+        OutputBuffer.SequenceNumber++;
+        
+        // mix one channel at a time; sums are kept
+        // with 32 bits, and limited only at the end
+        int32_t MixedValues[ Constants::SPUSamplesPerFrame * 2 ] = { 0 };
+        
+        for( SPUChannel& C: Channels )
+          if( C.State == IOPortValues::SPUChannelState_Playing )
+            MixChannel( C, MixedValues );
+        
+        // saturate the sums to the range of output samples
+        int16_t* OutputValues = (int16_t*)OutputBuffer.Samples;
+        
+        for( int i = 0; i < Constants::SPUSamplesPerFrame * 2; i++ )
+        {
+            int32_t Value = MixedValues[ i ];
+            Clamp( Value, -32768, 32767 );
+            OutputValues[ i ] = Value;
+        }
+    }
+    
+    
+    // =============================================================================
+    //      V32 SPU: CONCURRENT MIXING
+    // =============================================================================
+    
+    
+    // Mixing only depends on the state of channels and sounds,
+    // and it only changes channel positions and states. So it
+    // can run alongside the CPU as long as the CPU does not
+    // access that state: SPU port writes and reads of channel
+    // state or position wait for mixing to finish first. This
+    // makes the result the same as mixing in the frame change.
+    void V32SPU::StartMixing()
+    {
+        // create the thread on first use
+        if( !MixingThread.joinable() )
+        {
+            MixingThreadActive = true;
+            MixingThread = thread( &V32SPU::MixingLoop, this );
+        }
+        
+        {
+            lock_guard< mutex > Lock( MixingMutex );
+            MixingPending = true;
+        }
+        
+        MixingCondition.notify_all();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32SPU::FinishMixing()
+    {
+        // nothing to wait for if mixing was never concurrent
+        if( !MixingThread.joinable() )
+          return;
+        
+        unique_lock< mutex > Lock( MixingMutex );
+        MixingCondition.wait( Lock, [ this ]{ return !MixingPending; } );
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void V32SPU::MixingLoop()
+    {
+        unique_lock< mutex > Lock( MixingMutex );
+        
+        while( true )
+        {
+            MixingCondition.wait( Lock, [ this ]{ return MixingPending || !MixingThreadActive; } );
+            
+            if( !MixingThreadActive )
+              return;
+            
+            // other threads only wait for the result
+            Lock.unlock();
+            UpdateOutputBuffer();
+            Lock.lock();
+            
+            MixingPending = false;
+            MixingCondition.notify_all();
         }
     }
 }
@@ -12,6 +12,9 @@
     
     // include C/C++ headers
     #include <vector>           // [ C++ STL ] Vectors
+    #include <thread>           // [ C++ STL ] Threads
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <condition_variable>  // [ C++ STL ] Condition variables
 // *****************************************************************************
 
 
@@ -113,6 +116,17 @@ namespace V32
             // sound buffer configuration
             SPUOutputBuffer OutputBuffer;
             
+            // when enabled, each frame's sound is mixed in a
+            // separate thread while the CPU runs that frame
+            bool ConcurrentMixing;
+            
+            // mixing thread state
+            std::thread MixingThread;
+            std::mutex MixingMutex;
+            std::condition_variable MixingCondition;
+            bool MixingPending;
+            bool MixingThreadActive;
+            
         public:
             
             // instance handling
@@ -141,7 +155,13 @@ namespace V32
             
             // generate output sound
             SPUSound* GetChannelSound( SPUChannel* Channel );
+            void MixChannel( SPUChannel& Channel, int32_t* MixedValues );
             void UpdateOutputBuffer();
+            
+            // concurrent mixing
+            void StartMixing();
+            void FinishMixing();
+            void MixingLoop();
     };
     
     
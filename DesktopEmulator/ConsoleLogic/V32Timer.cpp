@@ -69,13 +69,6 @@ namespace V32
     
     // -----------------------------------------------------------------------------
     
-    void V32Timer::RunNextCycle()
-    {
-        CycleCounter++;
-    }
-    
-    // -----------------------------------------------------------------------------
-    
     void V32Timer::ChangeFrame()
     {
         CycleCounter = 0;
@@ -52,7 +52,7 @@ namespace V32
             virtual bool WritePort( int32_t LocalPort, V32Word Value );
             
             // general operation
-            void RunNextCycle();
+            // (the CPU advances the cycle counter itself)
             void ChangeFrame();
             void Reset();
     };
@@ -0,0 +1,278 @@
+// *****************************************************************************
+    // include infrastructure headers
+    #include "BlockCompression.hpp"
+    
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstring>          // [ ANSI C ] Strings
+    
+    // declare used namespaces
+    using namespace std;
+// *****************************************************************************
+
+
+// =============================================================================
+//      LIMITS OF THE BLOCK FORMAT
+// =============================================================================
+
+
+// matches are at least 4 bytes long and can
+// refer up to 64KB back from their position
+const size_t MinimumMatch = 4;
+const size_t MaximumOffset = 65535;
+
+// the last 5 bytes are always literals, and the
+// last match must begin 12 bytes before the end
+const size_t LastLiterals = 5;
+const size_t LastMatchDistance = 12;
+
+// positions are found by hashing 4 bytes
+const int HashBits = 16;
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+static inline uint32_t Read32( const uint8_t* Source )
+{
+    uint32_t Value;
+    memcpy( &Value, Source, 4 );
+    return Value;
+}
+
+// -----------------------------------------------------------------------------
+
+static inline uint64_t Read64( const uint8_t* Source )
+{
+    uint64_t Value;
+    memcpy( &Value, Source, 8 );
+    return Value;
+}
+
+// -----------------------------------------------------------------------------
+
+static inline uint32_t Hash( uint32_t Sequence )
+{
+    return (Sequence * 2654435761U) >> (32 - HashBits);
+}
+
+// -----------------------------------------------------------------------------
+
+// lengths of 15 or more continue in extra bytes
+static inline uint8_t* WriteExtraLength( uint8_t* Output, size_t Length )
+{
+    Length -= 15;
+    
+    while( Length >= 255 )
+    {
+        *(Output++) = 255;
+        Length -= 255;
+    }
+    
+    *(Output++) = Length;
+    return Output;
+}
+
+// -----------------------------------------------------------------------------
+
+static inline bool ReadExtraLength( const uint8_t*& Input, const uint8_t* InputEnd, size_t& Length )
+{
+    uint8_t Byte;
+    
+    do
+    {
+        if( Input >= InputEnd )
+          return false;
+        
+        Byte = *(Input++);
+        Length += Byte;
+    }
+    while( Byte == 255 );
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static uint8_t* WriteLiterals( uint8_t* Output, const uint8_t* Literals, size_t Length, uint8_t*& Token )
+{
+    Token = Output++;
+    
+    if( Length >= 15 )
+    {
+        *Token = 15 << 4;
+        Output = WriteExtraLength( Output, Length );
+    }
+    else
+      *Token = Length << 4;
+    
+    memcpy( Output, Literals, Length );
+    return Output + Length;
+}
+
+
+// =============================================================================
+//      BLOCK COMPRESSION
+// =============================================================================
+
+
+size_t GetMaximumCompressedSize( size_t InputSize )
+{
+    return InputSize + InputSize / 255 + 16;
+}
+
+// -----------------------------------------------------------------------------
+
+size_t CompressBlock( const uint8_t* Input, size_t InputSize, uint8_t* Output )
+{
+    uint8_t* OutputStart = Output;
+    uint8_t* Token;
+    size_t Position = 0;
+    size_t Anchor = 0;
+    
+    // smaller blocks can only have literals
+    if( InputSize > LastMatchDistance )
+    {
+        vector< uint32_t > HashTable( 1 << HashBits, 0 );
+        size_t MatchStartLimit = InputSize - LastMatchDistance;
+        size_t MatchEndLimit = InputSize - LastLiterals;
+        
+        while( Position < MatchStartLimit )
+        {
+            uint32_t Sequence = Read32( Input + Position );
+            uint32_t& Entry = HashTable[ Hash( Sequence ) ];
+            size_t Reference = Entry;
+            Entry = Position;
+            
+            // table entries may be outdated, so check
+            bool IsMatch = (Reference < Position)
+                        && (Position - Reference <= MaximumOffset)
+                        && (Read32( Input + Reference ) == Sequence);
+            
+            if( !IsMatch )
+            {
+                // advance faster when nothing is found
+                Position += 1 + ((Position - Anchor) >> 6);
+                continue;
+            }
+            
+            // extend the match as much as possible
+            size_t Length = MinimumMatch;
+            
+            while( Position + Length + 8 <= MatchEndLimit
+            &&     Read64( Input + Position + Length ) == Read64( Input + Reference + Length ) )
+              Length += 8;
+            
+            while( Position + Length < MatchEndLimit
+            &&     Input[ Position + Length ] == Input[ Reference + Length ] )
+              Length++;
+            
+            // write the sequence
+            Output = WriteLiterals( Output, Input + Anchor, Position - Anchor, Token );
+            
+            size_t Offset = Position - Reference;
+            *(Output++) = Offset & 0xFF;
+            *(Output++) = Offset >> 8;
+            
+            if( Length - MinimumMatch >= 15 )
+            {
+                *Token |= 15;
+                Output = WriteExtraLength( Output, Length - MinimumMatch );
+            }
+            else
+              *Token |= (Length - MinimumMatch);
+            
+            Position += Length;
+            Anchor = Position;
+        }
+    }
+    
+    // the last sequence has only literals
+    Output = WriteLiterals( Output, Input + Anchor, InputSize - Anchor, Token );
+    return Output - OutputStart;
+}
+
+
+// =============================================================================
+//      BLOCK DECOMPRESSION
+// =============================================================================
+
+
+bool DecompressBlock( const uint8_t* Input, size_t InputSize, uint8_t* Output, size_t OutputSize )
+{
+    const uint8_t* InputEnd = Input + InputSize;
+    size_t Position = 0;
+    
+    while( Input < InputEnd )
+    {
+        uint8_t Token = *(Input++);
+        
+        // copy literals
+        size_t LiteralLength = Token >> 4;
+        
+        if( LiteralLength == 15 )
+          if( !ReadExtraLength( Input, InputEnd, LiteralLength ) )
+            return false;
+        
+        if( LiteralLength > (size_t)(InputEnd - Input) || LiteralLength > OutputSize - Position )
+          return false;
+        
+        memcpy( Output + Position, Input, LiteralLength );
+        Input += LiteralLength;
+        Position += LiteralLength;
+        
+        // the last sequence has no match
+        if( Input == InputEnd )
+          break;
+        
+        // read the match
+        if( InputEnd - Input < 2 )
+          return false;
+        
+        size_t Offset = Input[ 0 ] | (Input[ 1 ] << 8);
+        Input += 2;
+        
+        if( Offset == 0 || Offset > Position )
+          return false;
+        
+        size_t Length = Token & 15;
+        
+        if( Length == 15 )
+          if( !ReadExtraLength( Input, InputEnd, Length ) )
+            return false;
+        
+        Length += MinimumMatch;
+        
+        if( Length > OutputSize - Position )
+          return false;
+        
+        // copy the match; when it overlaps with itself
+        // it repeats the last bytes, so first copy them
+        // once and then keep doubling the copied part
+        uint8_t* Destination = Output + Position;
+        const uint8_t* Source = Destination - Offset;
+        
+        if( Offset >= Length )
+          memcpy( Destination, Source, Length );
+        
+        else
+        {
+            memcpy( Destination, Source, Offset );
+            size_t Copied = Offset;
+            
+            while( Copied < Length )
+            {
+                size_t Block = min( Copied, Length - Copied );
+                memcpy( Destination + Copied, Destination, Block );
+                Copied += Block;
+            }
+        }
+        
+        Position += Length;
+    }
+    
+    return (Position == OutputSize);
+}
@@ -0,0 +1,35 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef BLOCKCOMPRESSION_HPP
+    #define BLOCKCOMPRESSION_HPP
+    
+    // include C/C++ headers
+    #include <cstdint>          // [ ANSI C ] Standard integers
+    #include <cstddef>          // [ ANSI C ] Standard definitions
+// *****************************************************************************
+
+
+// =============================================================================
+//      FAST COMPRESSION OF MEMORY BLOCKS
+// -----------------------------------------------------------------------------
+//      Blocks are encoded in the LZ4 block format: sequences of literal
+//      bytes followed by a match to previous data. This favors speed over
+//      compression ratio, and it is specially fast for runs of zeroes
+// =============================================================================
+
+
+// the output buffer for compression must have at least this size
+size_t GetMaximumCompressedSize( size_t InputSize );
+
+// returns the size of the compressed data
+size_t CompressBlock( const uint8_t* Input, size_t InputSize, uint8_t* Output );
+
+// fails if data is not valid or it does not produce exactly
+// the given size; output is never written beyond that size
+bool DecompressBlock( const uint8_t* Input, size_t InputSize, uint8_t* Output, size_t OutputSize );
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -0,0 +1,39 @@
+// *****************************************************************************
+    // include infrastructure headers
+    #include "Hashing.hpp"
+    
+    // include C/C++ headers
+    #include <sstream>          // [ C++ STL ] String streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    
+    // declare used namespaces
+    using namespace std;
+// *****************************************************************************
+
+
+// =============================================================================
+//      HASHING OF MEMORY BLOCKS
+// =============================================================================
+
+
+uint64_t HashBytes( const void* Data, size_t Bytes, uint64_t Hash )
+{
+    const uint8_t* Bytes8 = (const uint8_t*)Data;
+    
+    for( size_t i = 0; i < Bytes; i++ )
+    {
+        Hash ^= Bytes8[ i ];
+        Hash *= 0x100000001B3ull;
+    }
+    
+    return Hash;
+}
+
+// -----------------------------------------------------------------------------
+
+string HashToString( uint64_t Hash )
+{
+    ostringstream Result;
+    Result << hex << setw( 16 ) << setfill( '0' ) << Hash;
+    return Result.str();
+}
@@ -0,0 +1,32 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef HASHING_HPP
+    #define HASHING_HPP
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <cstdint>          // [ ANSI C ] Standard integers
+    #include <cstddef>          // [ ANSI C ] Standard definitions
+// *****************************************************************************
+
+
+// =============================================================================
+//      HASHING OF MEMORY BLOCKS
+// -----------------------------------------------------------------------------
+//      Hashes are FNV-1a, shared by all tools that compare their results
+//      between runs; they are not meant to be secure, only to detect changes
+// =============================================================================
+
+
+// the initial hash is the one for an empty block; to hash
+// several blocks, pass the hash of the previous ones
+uint64_t HashBytes( const void* Data, size_t Bytes, uint64_t Hash = 0xCBF29CE484222325ull );
+
+// hexadecimal, always with 16 digits
+std::string HashToString( uint64_t Hash );
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
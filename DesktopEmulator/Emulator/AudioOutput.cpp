@@ -14,6 +14,8 @@
     #include <stdexcept>        // [ C++ STL ] Exceptions
     #include <iostream>         // [ C++ STL ] I/O Streams
     #include <cstring>          // [ ANSI C ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <algorithm>        // [ C++ STL ] Algorithms
     
     // declare used namespaces
     using namespace std;
@@ -34,9 +36,18 @@ AudioOutput::AudioOutput()
     // initial state for playback
     memset( &AudioFormat, 0, sizeof(SDL_AudioSpec) );
     memset( &PlaybackBuffer, 0, sizeof(V32::SPUOutputBuffer) );
+    RateControl = false;
+    ReadPhase = 0;
+    AverageQueuedSamples = 0;
+    RateIntegral = 0;
     
     // set default configuration for sound buffers
-    LatencyFrames = 3;      // audio latency would be 3 * (1/60 s) = 50 ms
+    TargetLatency = DEFAULT_LATENCY_MILLISECONDS;
+    
+    // no playback yet
+    AverageLatency = 0;
+    PlaybackRate = 1;
+    Underruns = 0;
     
     // initial state for output volume control
     OutputVolume = 1.0;
@@ -68,8 +79,16 @@ void AudioOutput::Initialize()
     DesiredAudioFormat.freq = V32::Constants::SPUSamplingRate;
     DesiredAudioFormat.format = AUDIO_S16LSB;
     DesiredAudioFormat.channels = 2;           // stereo
-    DesiredAudioFormat.samples = 2048;         // must be power of 2
-    DesiredAudioFormat.callback = nullptr;     // we use push, not callback
+    DesiredAudioFormat.callback = DeviceCallback;
+    DesiredAudioFormat.userdata = this;
+    
+    // device buffers must be smaller than the ring's
+    // target, so that they don't add much latency
+    // (their size must be a power of 2)
+    DesiredAudioFormat.samples = 128;
+    
+    while( DesiredAudioFormat.samples < 2048 && DesiredAudioFormat.samples * 4 <= GetTargetSamples() )
+      DesiredAudioFormat.samples *= 2;
     
     // open audio device for playback
     AudioDeviceID = SDL_OpenAudioDevice
@@ -96,7 +115,8 @@ void AudioOutput::Terminate()
       return;
     
     // stop any currently playing sounds
-    ClearBufferQueue();
+    ReportTelemetry();
+    ClearRing();
     
     // close the audio device
     SDL_CloseAudioDevice( AudioDeviceID );
@@ -125,17 +145,71 @@ bool AudioOutput::IsDevicePlaying()
 // =============================================================================
 
 
-void AudioOutput::SetLatencyFrames( int NewLatencyFrames )
+void AudioOutput::SetTargetLatency( int Milliseconds )
+{
+    TargetLatency = Milliseconds;
+    Clamp( TargetLatency, MIN_LATENCY_MILLISECONDS, MAX_LATENCY_MILLISECONDS );
+}
+
+// -----------------------------------------------------------------------------
+
+int AudioOutput::GetTargetLatency()
+{
+    return TargetLatency;
+}
+
+// -----------------------------------------------------------------------------
+
+// should be enabled when frames are not clocked by audio
+void AudioOutput::SetRateControl( bool Enabled )
 {
-    Clamp( LatencyFrames, MIN_LATENCY_FRAMES, MAX_LATENCY_FRAMES );
-    LatencyFrames = NewLatencyFrames;
+    RateControl = Enabled;
 }
 
 // -----------------------------------------------------------------------------
 
-int AudioOutput::GetLatencyFrames()
+// true when the ring is below its target, so
+// audio clocked emulation must run a frame
+bool AudioOutput::NeedsMoreSamples()
 {
-    return LatencyFrames;
+    return (Ring.GetQueuedSamples() < GetTargetSamples());
+}
+
+
+// =============================================================================
+//      AUDIO OUTPUT: FILL LEVEL TELEMETRY
+// =============================================================================
+
+
+// latency of the ring buffer in milliseconds, averaged
+// over about half a second (device buffers not included)
+float AudioOutput::GetAverageLatency()
+{
+    return AverageLatency;
+}
+
+// -----------------------------------------------------------------------------
+
+// current ratio of playback speed to the normal rate
+float AudioOutput::GetPlaybackRate()
+{
+    return PlaybackRate;
+}
+
+// -----------------------------------------------------------------------------
+
+// times that the ring had fewer samples than needed
+int AudioOutput::GetUnderruns()
+{
+    return Underruns;
+}
+
+// -----------------------------------------------------------------------------
+
+void AudioOutput::ReportTelemetry()
+{
+    LOG( "Audio latency: average " + to_string( (int)GetAverageLatency() ) + " ms, target " + to_string( TargetLatency ) + " ms" );
+    LOG( "Audio playback rate: " + to_string( GetPlaybackRate() ) + ", underruns: " + to_string( GetUnderruns() ) );
 }
 
 
@@ -147,13 +221,13 @@ int AudioOutput::GetLatencyFrames()
 void AudioOutput::Reset()
 {
     // stop any currently playing sounds
-    ClearBufferQueue();
+    ClearRing();
     
     // reset the output buffer
     memset( PlaybackBuffer.Samples, 0, sizeof(PlaybackBuffer.Samples) );
     
     // reinitialize audio playback
-    InitializeBufferQueue();
+    InitializeRing();
     
     // do NOT reset output volume configuration!
 }
@@ -169,8 +243,14 @@ void AudioOutput::ChangeFrame()
     if( !IsDevicePlaying() )
       Play();
     
+    // when frames are not clocked by audio they can
+    // run faster than playback; in that case drop
+    // sound instead of letting the delay grow
+    if( Ring.GetQueuedSamples() >= GetTargetSamples() + 2 * Constants::SPUSamplesPerFrame )
+      return;
+    
     // use next frame's sound
-    QueueNextBuffer();
+    WriteNextFrame();
 }
 
 // -----------------------------------------------------------------------------
@@ -222,34 +302,49 @@ bool AudioOutput::IsMuted()
 
 
 // =============================================================================
-//      AUDIO OUTPUT: HANDLING PLAYBACK BUFFER QUEUE
+//      AUDIO OUTPUT: HANDLING THE RING BUFFER
 // =============================================================================
 
 
-void AudioOutput::ClearBufferQueue()
+void AudioOutput::ClearRing()
 {
     Pause();
-    SDL_ClearQueuedAudio( AudioDeviceID );
+    
+    // the device callback must not run meanwhile
+    SDL_LockAudioDevice( AudioDeviceID );
+    Ring.Clear();
+    ReadPhase = 0;
+    AverageQueuedSamples = 0;
+    RateIntegral = 0;
+    SDL_UnlockAudioDevice( AudioDeviceID );
 }
 
 // -----------------------------------------------------------------------------
 
-void AudioOutput::InitializeBufferQueue()
+void AudioOutput::InitializeRing()
 {
-    for( int i = 0; i < LatencyFrames; i++ )
-      if( !QueueNextBuffer() )
-        THROW( "Failed to initialize audio buffer queue: " + string( SDL_GetError() ) );
+    // start with silence up to the target, so
+    // that emulation has time to run a frame
+    vector< SPUSample > Silence( GetTargetSamples(), SPUSample{ 0, 0 } );
+    Ring.Write( &Silence[ 0 ], Silence.size() );
+    Underruns = 0;
     
     Play();
 }
 
 // -----------------------------------------------------------------------------
 
-// returns true on success
-bool AudioOutput::QueueNextBuffer()
+void AudioOutput::WriteNextFrame()
 {
-    // console sound output is ignored when muted
-    if( Mute ) return true;
+    // console sound output is ignored when muted, but
+    // silence is still written: the emulation thread
+    // uses the ring to know when to run frames
+    if( Mute )
+    {
+        memset( PlaybackBuffer.Samples, 0, sizeof(PlaybackBuffer.Samples) );
+        Ring.Write( PlaybackBuffer.Samples, Constants::SPUSamplesPerFrame );
+        return;
+    }
     
     // obtain sound output for the current frame
     Console.GetFrameSoundOutput( PlaybackBuffer );
@@ -270,6 +365,106 @@ bool AudioOutput::QueueNextBuffer()
         *(SingleSample++) *= QuadraticVolume;
     }
     
-    // queue it to play
-    return !SDL_QueueAudio( AudioDeviceID, PlaybackBuffer.Samples, sizeof(PlaybackBuffer.Samples) );
+    // leave it to be played
+    Ring.Write( PlaybackBuffer.Samples, Constants::SPUSamplesPerFrame );
+}
+
+// -----------------------------------------------------------------------------
+
+int AudioOutput::GetTargetSamples()
+{
+    return TargetLatency * Constants::SPUSamplingRate / 1000;
+}
+
+// -----------------------------------------------------------------------------
+
+// the target is the lowest fill level, right before
+// a frame is added; on average the ring has half a
+// frame more, which is what rate control aims for
+int AudioOutput::GetControlledSamples()
+{
+    return GetTargetSamples() + Constants::SPUSamplesPerFrame / 2;
+}
+
+
+// =============================================================================
+//      AUDIO OUTPUT: PLAYBACK FROM THE RING BUFFER
+// =============================================================================
+
+
+void SDLCALL AudioOutput::DeviceCallback( void* UserData, Uint8* Stream, int Length )
+{
+    AudioOutput* Output = (AudioOutput*)UserData;
+    Output->FillDeviceBuffer( (SPUSample*)Stream, Length / sizeof(SPUSample) );
+}
+
+// -----------------------------------------------------------------------------
+
+// runs in the audio device thread
+void AudioOutput::FillDeviceBuffer( SPUSample* Output, int NumberOfSamples )
+{
+    int QueuedSamples = Ring.GetQueuedSamples();
+    
+    // frames add many samples at once, so use
+    // a smoothed fill level (~0.5 s time constant)
+    double Smoothing = min( 1.0, NumberOfSamples / (0.5 * Constants::SPUSamplingRate) );
+    AverageQueuedSamples += (QueuedSamples - AverageQueuedSamples) * Smoothing;
+    AverageLatency = AverageQueuedSamples * 1000 / Constants::SPUSamplingRate;
+    
+    // play faster when above the target, and slower when below;
+    // the integral part removes any constant difference that
+    // is left when emulation and playback rates don't match
+    double Rate = 1;
+    
+    if( RateControl )
+    {
+        double Error = (AverageQueuedSamples - GetControlledSamples()) / GetControlledSamples();
+        double Seconds = (double)NumberOfSamples / Constants::SPUSamplingRate;
+        
+        RateIntegral += Error * Seconds * MAX_RATE_ADJUSTMENT / 5;
+        Clamp( RateIntegral, -MAX_RATE_ADJUSTMENT, MAX_RATE_ADJUSTMENT );
+        
+        double Adjustment = Error * MAX_RATE_ADJUSTMENT + RateIntegral;
+        Clamp( Adjustment, -MAX_RATE_ADJUSTMENT, MAX_RATE_ADJUSTMENT );
+        Rate = 1 + Adjustment;
+    }
+    
+    PlaybackRate = Rate;
+    
+    // resample with linear interpolation; samples
+    // are copied exactly when the rate is normal
+    int s = 0;
+    
+    for( ; s < NumberOfSamples; s++ )
+    {
+        int Index = (int)ReadPhase;
+        double Fraction = ReadPhase - Index;
+        
+        if( Index >= QueuedSamples || (Fraction > 0 && Index + 1 >= QueuedSamples) )
+          break;
+        
+        SPUSample Sample = Ring.Peek( Index );
+        
+        if( Fraction > 0 )
+        {
+            SPUSample NextSample = Ring.Peek( Index + 1 );
+            Sample.LeftSample  += (NextSample.LeftSample  - Sample.LeftSample ) * Fraction;
+            Sample.RightSample += (NextSample.RightSample - Sample.RightSample) * Fraction;
+        }
+        
+        Output[ s ] = Sample;
+        ReadPhase += Rate;
+    }
+    
+    // discard the samples that were passed
+    int PassedSamples = min( (int)ReadPhase, QueuedSamples );
+    Ring.Discard( PassedSamples );
+    ReadPhase -= PassedSamples;
+    
+    // when the ring runs out, complete with silence
+    if( s < NumberOfSamples )
+    {
+        memset( &Output[ s ], 0, (NumberOfSamples - s) * sizeof(SPUSample) );
+        Underruns++;
+    }
 }
@@ -6,8 +6,12 @@
     // include console logic headers
     #include "ConsoleLogic/ExternalInterfaces.hpp"
     
+    // include project headers
+    #include "AudioRing.hpp"
+    
     // include C/C++ headers
     #include <string>		    // [ C++ STL ] Strings
+    #include <atomic>           // [ C++ STL ] Atomic variables
     
     // include SDL2 headers
     #define SDL_MAIN_HANDLED
@@ -20,19 +24,22 @@
 // =============================================================================
 
 
-// Our sound system uses a 1-frame sound buffer that is
-// continuously re-filled and re-queued to prevent audio
-// output from ever running out of sound samples (which
-// would produce clicks, silences, or terminate audio).
-// An given number of frames (latency) will initially
-// be queued so that playback is able to adapt to some
-// variability in frame timing. Adding latency frames
-// will increase audio delay but will ensure that less
-// capable systems have enough time to update audio and
-// therefore prevent sound problems.
+// Sound from each emulated frame is written to a ring buffer,
+// and the audio device callback takes samples from it when
+// needed. Emulation tries to keep the ring filled up to a
+// target latency: a higher target adds audio delay, but it
+// gives less capable systems more time to run each frame
+// and therefore prevents sound problems (clicks, silences).
+// When frames are not clocked by audio, emulation and
+// playback rates can differ slightly; playback rate is
+// then adjusted (never more than 0.5%, which can't be
+// heard) to keep the ring near its target, without drift.
+
+#define MIN_LATENCY_MILLISECONDS       5
+#define MAX_LATENCY_MILLISECONDS     200
+#define DEFAULT_LATENCY_MILLISECONDS  20
 
-#define MIN_LATENCY_FRAMES     2
-#define MAX_LATENCY_FRAMES    12
+#define MAX_RATE_ADJUSTMENT  0.005
 
 
 // =============================================================================
@@ -48,8 +55,9 @@ class AudioOutput
         SDL_AudioSpec AudioFormat;
         SDL_AudioDeviceID AudioDeviceID;
         
-        // frame based playback
-        int LatencyFrames;
+        // samples waiting to be played
+        AudioRing Ring;
+        int TargetLatency;
         V32::SPUOutputBuffer PlaybackBuffer;
         
         // external volume control
@@ -58,14 +66,31 @@ class AudioOutput
         
     private:
         
+        // playback state, only used by the device callback
+        bool RateControl;
+        double ReadPhase;
+        double AverageQueuedSamples;
+        double RateIntegral;
+        
+        // telemetry, written by the device callback
+        std::atomic< float > AverageLatency;
+        std::atomic< float > PlaybackRate;
+        std::atomic< int > Underruns;
+        
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         // Internal auxiliary methods
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         
-        // handling playback buffer queue
-        void ClearBufferQueue();
-        void InitializeBufferQueue();
-        bool QueueNextBuffer();
+        // handling the ring buffer
+        void ClearRing();
+        void InitializeRing();
+        void WriteNextFrame();
+        int GetTargetSamples();
+        int GetControlledSamples();
+        
+        // playback from the ring buffer
+        static void SDLCALL DeviceCallback( void* UserData, Uint8* Stream, int Length );
+        void FillDeviceBuffer( V32::SPUSample* Output, int NumberOfSamples );
         
         // querying sound device state
         bool IsDeviceReady();
@@ -82,8 +107,16 @@ class AudioOutput
         void Terminate();
         
         // buffer configuration
-        void SetLatencyFrames( int NewLatencyFrames );
-        int GetLatencyFrames();
+        void SetTargetLatency( int Milliseconds );
+        int GetTargetLatency();
+        void SetRateControl( bool Enabled );
+        bool NeedsMoreSamples();
+        
+        // fill level telemetry
+        float GetAverageLatency();
+        float GetPlaybackRate();
+        int GetUnderruns();
+        void ReportTelemetry();
         
         // external general operation
         void Reset();
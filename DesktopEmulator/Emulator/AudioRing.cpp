@@ -0,0 +1,92 @@
+// *****************************************************************************
+    // include project headers
+    #include "AudioRing.hpp"
+    
+    // include C/C++ headers
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstring>          // [ ANSI C ] Strings
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUDIO RING: INSTANCE HANDLING
+// =============================================================================
+
+
+AudioRing::AudioRing()
+{
+    ReadPosition = 0;
+    WritePosition = 0;
+}
+
+
+// =============================================================================
+//      AUDIO RING: RING STATE
+// =============================================================================
+
+
+int AudioRing::GetQueuedSamples()
+{
+    return WritePosition.load( memory_order_acquire ) - ReadPosition.load( memory_order_acquire );
+}
+
+// -----------------------------------------------------------------------------
+
+int AudioRing::GetFreeSamples()
+{
+    return AUDIO_RING_SIZE - GetQueuedSamples();
+}
+
+
+// =============================================================================
+//      AUDIO RING: PRODUCER SIDE
+// =============================================================================
+
+
+int AudioRing::Write( const SPUSample* NewSamples, int NumberOfSamples )
+{
+    unsigned Position = WritePosition.load( memory_order_relaxed );
+    NumberOfSamples = min( NumberOfSamples, GetFreeSamples() );
+    
+    // copy in up to 2 parts, when the end is reached
+    unsigned FirstIndex = Position % AUDIO_RING_SIZE;
+    int FirstPart = min( NumberOfSamples, (int)(AUDIO_RING_SIZE - FirstIndex) );
+    memcpy( &Samples[ FirstIndex ], NewSamples, FirstPart * sizeof(SPUSample) );
+    memcpy( &Samples[ 0 ], NewSamples + FirstPart, (NumberOfSamples - FirstPart) * sizeof(SPUSample) );
+    
+    // release ordering makes the written
+    // samples visible to the consumer
+    WritePosition.store( Position + NumberOfSamples, memory_order_release );
+    return NumberOfSamples;
+}
+
+
+// =============================================================================
+//      AUDIO RING: CONSUMER SIDE
+// =============================================================================
+
+
+SPUSample AudioRing::Peek( int Offset )
+{
+    unsigned Position = ReadPosition.load( memory_order_relaxed );
+    return Samples[ (Position + Offset) % AUDIO_RING_SIZE ];
+}
+
+// -----------------------------------------------------------------------------
+
+void AudioRing::Discard( int NumberOfSamples )
+{
+    unsigned Position = ReadPosition.load( memory_order_relaxed );
+    ReadPosition.store( Position + NumberOfSamples, memory_order_release );
+}
+
+// -----------------------------------------------------------------------------
+
+void AudioRing::Clear()
+{
+    ReadPosition.store( WritePosition.load( memory_order_relaxed ), memory_order_release );
+}
@@ -0,0 +1,64 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef AUDIORING_HPP
+    #define AUDIORING_HPP
+    
+    // include common Vircon headers
+    #include "../VirconDefinitions/DataStructures.hpp"
+    
+    // include C/C++ headers
+    #include <atomic>         // [ C++ STL ] Atomic variables
+// *****************************************************************************
+
+
+// maximum number of stereo samples that can wait to
+// be played (~370 ms); must be a power of 2
+#define AUDIO_RING_SIZE 16384
+
+
+// =============================================================================
+//      RING BUFFER OF AUDIO SAMPLES
+// =============================================================================
+
+
+// passes sound samples from the emulation thread (the only
+// producer) to the audio device callback (the only consumer);
+// as in FrameQueue, no locks are needed because each position
+// is only written by one side
+class AudioRing
+{
+    private:
+    
+        V32::SPUSample Samples[ AUDIO_RING_SIZE ];
+        
+        // these only increase (and wrap around)
+        std::atomic< unsigned > ReadPosition;
+        std::atomic< unsigned > WritePosition;
+    
+    public:
+    
+        // instance handling
+        AudioRing();
+        
+        // ring state
+        int GetQueuedSamples();
+        int GetFreeSamples();
+        
+        // producer side: returns the number of samples
+        // that were written (the rest did not fit)
+        int Write( const V32::SPUSample* NewSamples, int NumberOfSamples );
+        
+        // consumer side: samples can be read at any offset
+        // within the queued ones, and then discarded
+        V32::SPUSample Peek( int Offset );
+        void Discard( int NumberOfSamples );
+        
+        // the consumer must not be running
+        void Clear();
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -17,6 +17,9 @@
     #include <iostream>         // [ C++ STL ] I/O Streams
     #include <climits>          // [ ANSI C ] Numeric limits
     #include <time.h>           // [ ANSI C ] Date and time
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <algorithm>        // [ C++ STL ] Algorithms
     
     // declare used namespaces
     using namespace std;
@@ -24,6 +27,57 @@
 // *****************************************************************************
 
 
+// =============================================================================
+//      REPLAY OF RECORDED FRAMES ON VIDEO OUTPUT
+// =============================================================================
+
+
+class VideoOutputReceiver: public GPUCommandReceiver
+{
+    public:
+    
+        void ClearScreen( GPUColor ClearColor )
+        {
+            Video.ClearScreen( ClearColor );
+        }
+        
+        // -----------------------------------------------------------------------------
+        
+        void DrawQuad( const GPUQuad& DrawnQuad )
+        {
+            Video.AddQuadToQueue( DrawnQuad );
+        }
+        
+        // -----------------------------------------------------------------------------
+        
+        void SetMultiplyColor( GPUColor NewMultiplyColor )
+        {
+            // this does not break quad groups, since
+            // the color is stored in each vertex
+            Video.SetMultiplyColor( NewMultiplyColor );
+        }
+        
+        // -----------------------------------------------------------------------------
+        
+        void SetBlendingMode( int NewBlendingMode )
+        {
+            // set blending mode only when needed, so that
+            // quad groups are not broken without need
+            if( NewBlendingMode != (int)Video.GetBlendingMode() )
+              Video.SetBlendingMode( (IOPortValues)NewBlendingMode );
+        }
+        
+        // -----------------------------------------------------------------------------
+        
+        void SelectTexture( int GPUTextureID )
+        {
+            // this does not break quad groups either,
+            // unless all texture slots are in use
+            Video.SelectTexture( GPUTextureID );
+        }
+};
+
+
 // =============================================================================
 //      CLASS: EMULATOR CONTROL
 // =============================================================================
@@ -33,6 +87,13 @@ EmulatorControl::EmulatorControl()
 {
     Paused = false;
     AutoCardHandling = true;
+    Rewinding = false;
+    ThreadActive = false;
+    RunAheadFrames = 0;
+    MeasuredFrames = 0;
+    TotalMilliseconds = MaximumMilliseconds = 0;
+    RunAheadLoads[ 0 ] = RunAheadLoads[ 1 ] = 0;
+    FramePacing = FramePacingModes::AudioClocked;
 }
 
 // -----------------------------------------------------------------------------
@@ -55,6 +116,7 @@ void EmulatorControl::Initialize()
     V32::Callbacks::SetMultiplyColor = CallbackFunctions::SetMultiplyColor;
     V32::Callbacks::SetBlendingMode = CallbackFunctions::SetBlendingMode;
     V32::Callbacks::SelectTexture = CallbackFunctions::SelectTexture;
+    V32::Callbacks::PrepareTexture = CallbackFunctions::PrepareTexture;
     V32::Callbacks::LoadTexture = CallbackFunctions::LoadTexture;
     V32::Callbacks::UnloadCartridgeTextures = CallbackFunctions::UnloadCartridgeTextures;
     V32::Callbacks::UnloadBiosTexture = CallbackFunctions::UnloadBiosTexture;
@@ -62,6 +124,11 @@ void EmulatorControl::Initialize()
     // set console's log callbacks
     V32::Callbacks::LogLine = CallbackFunctions::LogLine;
     V32::Callbacks::ThrowException = CallbackFunctions::ThrowException;
+    V32::Callbacks::ReportLoadProgress = CallbackFunctions::ReportLoadProgress;
+    
+    // with enough cores for the main and emulation threads
+    // and one more, mix sound while the CPU runs each frame
+    Console.SPU.ConcurrentMixing = (thread::hardware_concurrency() > 2);
     
     // obtain current time
     time_t CreationTime;
@@ -72,12 +139,27 @@ void EmulatorControl::Initialize()
     // (Careful! C gives year counting from 1900)
     Console.SetCurrentDate( CreationTimeInfo->tm_year + 1900, CreationTimeInfo->tm_yday );
     Console.SetCurrentTime( CreationTimeInfo->tm_hour, CreationTimeInfo->tm_min, CreationTimeInfo->tm_sec );
+    
+    // start running frames in the background
+    LOG( "Starting emulation thread" );
+    ThreadActive = true;
+    EmulationThread = thread( &EmulatorControl::EmulationLoop, this );
 }
 
 // -----------------------------------------------------------------------------
 
 void EmulatorControl::Terminate()
 {
+    // stop the emulation thread first, so
+    // that the console is no longer in use
+    ThreadActive = false;
+    
+    if( EmulationThread.joinable() )
+    {
+        LOG( "Stopping emulation thread" );
+        EmulationThread.join();
+    }
+    
     Console.SetPower( false );
     Audio.Terminate();
 }
@@ -129,11 +211,76 @@ bool EmulatorControl::IsCardHandlingAuto()
 
 // -----------------------------------------------------------------------------
 
+void EmulatorControl::SetRewindMemory( unsigned Megabytes )
+{
+    Rewind.SetMemoryBudget( Megabytes );
+    SetRewinding( Rewinding );
+}
+
+// -----------------------------------------------------------------------------
+
+unsigned EmulatorControl::GetRewindMemory()
+{
+    return Rewind.GetMemoryBudget();
+}
+
+// -----------------------------------------------------------------------------
+
+void EmulatorControl::SetRewinding( bool Active )
+{
+    Rewinding = Active && (Rewind.GetMemoryBudget() > 0);
+}
+
+// -----------------------------------------------------------------------------
+
+bool EmulatorControl::IsRewinding()
+{
+    return Rewinding;
+}
+
+// -----------------------------------------------------------------------------
+
+void EmulatorControl::SetRunAheadFrames( int Frames )
+{
+    RunAheadFrames = max( 0, min( Frames, MAX_RUN_AHEAD_FRAMES ) );
+    
+    // measurements start again
+    MeasuredFrames = 0;
+    TotalMilliseconds = MaximumMilliseconds = 0;
+    RunAheadLoads[ 0 ] = RunAheadLoads[ 1 ] = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+int EmulatorControl::GetRunAheadFrames()
+{
+    return RunAheadFrames;
+}
+
+// -----------------------------------------------------------------------------
+
+float EmulatorControl::GetRunAheadLoad()
+{
+    return RunAheadLoads[ 0 ];
+}
+
+// -----------------------------------------------------------------------------
+
+float EmulatorControl::GetMaximumRunAheadLoad()
+{
+    return RunAheadLoads[ 1 ];
+}
+
+// -----------------------------------------------------------------------------
+
 void EmulatorControl::SetPower( bool On )
 {
     Video.RenderToFramebuffer();
     Console.SetPower( On );
-
+    
+    // past frames may be from another cartridge
+    Rewind.Clear();
+    
     if( On ) Audio.Reset();
     else Audio.Pause();
 }
@@ -158,15 +305,227 @@ void EmulatorControl::Reset()
 
 // -----------------------------------------------------------------------------
 
+void EmulatorControl::SetFramePacing( FramePacingModes Mode )
+{
+    FramePacing = Mode;
+    
+    // audio clocked frames already follow playback rate
+    Audio.SetRateControl( Mode != FramePacingModes::AudioClocked );
+}
+
+// -----------------------------------------------------------------------------
+
+FramePacingModes EmulatorControl::GetFramePacing()
+{
+    return FramePacing;
+}
+
+// -----------------------------------------------------------------------------
+
+GPUCommandList& EmulatorControl::GetRecordingFrame()
+{
+    return Frames.GetRecordingFrame();
+}
+
+// -----------------------------------------------------------------------------
+
+// must be called from the main thread, with ConsoleMutex
+// locked; returns the number of frames that were drawn
+int EmulatorControl::DrawQueuedFrames()
+{
+    VideoOutputReceiver Receiver;
+    int DrawnFrames = 0;
+    
+    while( const GPUCommandList* Frame = Frames.GetOldestFrame() )
+    {
+        // redirect all rendering to emulator's display
+        if( DrawnFrames == 0 )
+        {
+            Video.RenderToFramebuffer();
+            Video.BeginFrame();
+        }
+        
+        Frame->Replay( Receiver );
+        Frames.PopOldestFrame();
+        DrawnFrames++;
+    }
+    
+    if( DrawnFrames > 0 )
+    {
+        // ensure that all queued quads are rendered
+        Video.RenderQuadQueue();
+        
+        // ensure that all GPU commands
+        // from these frames are drawn
+        glFlush();
+    }
+    
+    return DrawnFrames;
+}
+
+// -----------------------------------------------------------------------------
+
+// errors in the emulation thread are rethrown in
+// the main thread (with ConsoleMutex locked), so
+// that they are reported in the same way as before
+void EmulatorControl::CheckThreadErrors()
+{
+    if( ThreadError )
+      rethrow_exception( ThreadError );
+}
+
+
+// =============================================================================
+//      EMULATOR CONTROL: EMULATION THREAD
+// =============================================================================
+
+
+void EmulatorControl::EmulationLoop()
+{
+    while( ThreadActive )
+    {
+        bool FrameWasRun = false;
+        
+        try
+        {
+            lock_guard< mutex > ConsoleLock( ConsoleMutex );
+            
+            if( !ThreadError && Console.IsPowerOn() && !Paused && IsFrameDue() )
+            {
+                RunNextFrame();
+                FrameWasRun = true;
+            }
+        }
+        
+        catch( ... )
+        {
+            // stop running frames until the
+            // main thread reports the error
+            ThreadError = current_exception();
+        }
+        
+        // when idle, wait instead of retrying right away;
+        // after a frame, let the main thread take the lock
+        if( FrameWasRun ) this_thread::yield();
+        else SDL_Delay( 1 );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+bool EmulatorControl::IsFrameDue()
+{
+    // a new frame must have a free slot
+    if( Frames.IsFull() ) return false;
+    
+    switch( FramePacing )
+    {
+        // run while audio needs more samples
+        case FramePacingModes::AudioClocked:
+            return Audio.NeedsMoreSamples();
+        
+        // run after the last frame has been shown
+        case FramePacingModes::VsyncClocked:
+            return (Frames.GetQueuedFrames() == 0);
+        
+        // run as fast as possible
+        default:
+            return true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
 void EmulatorControl::RunNextFrame()
 {
+    auto StartTime = chrono::steady_clock::now();
+    
+    // when rewinding, each frame returns to an older
+    // state and runs from it only to draw its image
+    // (so these frames are not captured)
+    if( Rewinding )
+      Rewind.StepBack();
+    
     Console.RunNextFrame();
     Audio.ChangeFrame();
     
-    // ensure that all queued quads are rendered
-    Video.RenderQuadQueue();
+    bool FrameWasCaptured = (!Rewinding && Rewind.GetMemoryBudget() > 0);
+    
+    if( FrameWasCaptured )
+      Rewind.CaptureFrame();
+    
+    // run-ahead replaces the image that is shown
+    if( !Rewinding && RunAheadFrames > 0 )
+    {
+        RunFramesAhead( FrameWasCaptured );
+        MeasureRunAhead( chrono::duration< double, milli >( chrono::steady_clock::now() - StartTime ).count() );
+    }
+    
+    // the frame can now be drawn by the main thread
+    Frames.PushRecordedFrame();
+}
+
+// -----------------------------------------------------------------------------
+
+// Games often react to input a few frames after it is
+// read. To hide that latency, after each frame some more
+// are run with the same input, and only the last one is
+// shown; then the console returns to the first frame.
+// The frames ahead are not heard, and changes that they
+// make to the memory card are not kept.
+void EmulatorControl::RunFramesAhead( bool FrameWasCaptured )
+{
+    // rewind has just captured the state to return to;
+    // capturing it again in another snapshot would need
+    // a full copy, since only one of them is tracked
+    if( !FrameWasCaptured )
+      RunAheadSnapshot.Capture();
+    
+    GPUCommandList& RecordingFrame = Frames.GetRecordingFrame();
+    Console.HoldMemoryCardChanges();
+    
+    try
+    {
+        for( int i = 0; i < RunAheadFrames; i++ )
+        {
+            // keep only the last frame's image, but
+            // with the render state it starts from
+            RecordingFrame.Clear();
+            Callbacks::SelectTexture( Console.GPU.SelectedTexture );
+            Callbacks::SetMultiplyColor( Console.GPU.MultiplyColor );
+            Callbacks::SetBlendingMode( Console.GPU.ActiveBlending );
+            
+            Console.RunNextFrame();
+        }
+    }
+    catch( ... )
+    {
+        Console.DiscardMemoryCardChanges();
+        throw;
+    }
+    
+    if( FrameWasCaptured ) Rewind.RestoreLastFrame();
+    else RunAheadSnapshot.Restore();
+    
+    Console.DiscardMemoryCardChanges();
+}
+
+// -----------------------------------------------------------------------------
+
+void EmulatorControl::MeasureRunAhead( double Milliseconds )
+{
+    MeasuredFrames++;
+    TotalMilliseconds += Milliseconds;
+    MaximumMilliseconds = max( MaximumMilliseconds, Milliseconds );
+    
+    // publish the loads once per second
+    if( MeasuredFrames < Constants::FramesPerSecond )
+      return;
+    
+    double FrameMilliseconds = 1000.0 / Constants::FramesPerSecond;
+    RunAheadLoads[ 0 ] = 100.0 * TotalMilliseconds / MeasuredFrames / FrameMilliseconds;
+    RunAheadLoads[ 1 ] = 100.0 * MaximumMilliseconds / FrameMilliseconds;
     
-    // after running, ensure that all GPU
-    // commands run in the current frame are drawn
-    glFlush();   
+    MeasuredFrames = 0;
+    TotalMilliseconds = MaximumMilliseconds = 0;
 }
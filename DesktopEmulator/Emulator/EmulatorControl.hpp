@@ -3,23 +3,97 @@
     #ifndef EMULATORCONTROL_HPP
     #define EMULATORCONTROL_HPP
     
+    // include project headers
+    #include "FrameQueue.hpp"
+    #include "Rewind.hpp"
+    
+    // include C/C++ headers
+    #include <thread>           // [ C++ STL ] Threads
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <atomic>           // [ C++ STL ] Atomic variables
+    #include <exception>        // [ C++ STL ] Exceptions
+    
     // include SDL2 headers
     #define SDL_MAIN_HANDLED
     #include "SDL.h"            // [ SDL2 ] Main header
 // *****************************************************************************
 
 
+// =============================================================================
+//      FRAME PACING
+// =============================================================================
+
+
+// what decides when the emulation thread runs the next frame
+enum class FramePacingModes
+{
+    AudioClocked,   // keep the audio queue filled (default)
+    VsyncClocked,   // 1 frame for each frame shown on screen
+    Unlocked        // as fast as possible
+};
+
+
+// =============================================================================
+//      RUN-AHEAD
+// =============================================================================
+
+
+// more frames ahead would rarely be affordable,
+// and games seldom have more input latency
+#define MAX_RUN_AHEAD_FRAMES 4
+
+
 // =============================================================================
 //      CLASS FOR EMULATOR CENTRAL CONTROL
 // =============================================================================
 
 
+// the console runs in its own thread, and each frame's GPU
+// commands are recorded so that the main thread can draw them
+// later; the main thread must lock ConsoleMutex while it uses
+// the console, so that it is never accessed in mid-frame
 class EmulatorControl
 {
     private:
         
         bool Paused;
         bool AutoCardHandling;
+        
+        // past frames, to run them backwards
+        RewindBuffer Rewind;
+        bool Rewinding;
+        
+        // frames run after each one to show a later
+        // image, then undone by restoring the state
+        int RunAheadFrames;
+        IncrementalSnapshot RunAheadSnapshot;
+        
+        // time used to run each shown frame (including
+        // the frames ahead) during the last second
+        unsigned MeasuredFrames;
+        double TotalMilliseconds, MaximumMilliseconds;
+        float RunAheadLoads[ 2 ];
+        
+        // emulation thread
+        std::thread EmulationThread;
+        std::atomic< bool > ThreadActive;
+        std::exception_ptr ThreadError;
+        FramePacingModes FramePacing;
+        
+        // recorded frames waiting to be drawn
+        FrameQueue Frames;
+        
+        // internal functions
+        void EmulationLoop();
+        bool IsFrameDue();
+        void RunNextFrame();
+        void RunFramesAhead( bool FrameWasCaptured );
+        void MeasureRunAhead( double Milliseconds );
+        
+    public:
+        
+        // access to the console from other threads
+        std::mutex ConsoleMutex;
     
     public:
         
@@ -39,10 +113,30 @@ class EmulatorControl
         void SetCardHandling( bool Auto );
         bool IsCardHandlingAuto();
         
+        // a memory of 0 disables rewind
+        void SetRewindMemory( unsigned Megabytes );
+        unsigned GetRewindMemory();
+        void SetRewinding( bool Active );
+        bool IsRewinding();
+        
+        // 0 frames disables run-ahead; loads are the % of
+        // frame time needed to run each shown frame with
+        // its frames ahead (average and maximum)
+        void SetRunAheadFrames( int Frames );
+        int GetRunAheadFrames();
+        float GetRunAheadLoad();
+        float GetMaximumRunAheadLoad();
+        
         void SetPower( bool On );
         bool IsPowerOn();
         void Reset();
-        void RunNextFrame();
+        
+        // frame pipelining
+        void SetFramePacing( FramePacingModes Mode );
+        FramePacingModes GetFramePacing();
+        V32::GPUCommandList& GetRecordingFrame();
+        int DrawQueuedFrames();
+        void CheckThreadErrors();
 };
 
 
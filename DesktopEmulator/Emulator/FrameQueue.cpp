@@ -0,0 +1,89 @@
+// *****************************************************************************
+    // include project headers
+    #include "FrameQueue.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      FRAME QUEUE: INSTANCE HANDLING
+// =============================================================================
+
+
+FrameQueue::FrameQueue()
+{
+    ReadPosition = 0;
+    WritePosition = 0;
+}
+
+
+// =============================================================================
+//      FRAME QUEUE: QUEUE STATE
+// =============================================================================
+
+
+int FrameQueue::GetQueuedFrames()
+{
+    return WritePosition.load( memory_order_acquire ) - ReadPosition.load( memory_order_acquire );
+}
+
+// -----------------------------------------------------------------------------
+
+bool FrameQueue::IsFull()
+{
+    return (GetQueuedFrames() >= FRAME_QUEUE_SIZE);
+}
+
+
+// =============================================================================
+//      FRAME QUEUE: PRODUCER SIDE
+// =============================================================================
+
+
+GPUCommandList& FrameQueue::GetRecordingFrame()
+{
+    // the slot after the last queued frame is never
+    // being read, even when the queue is full
+    unsigned Position = WritePosition.load( memory_order_relaxed );
+    return Frames[ Position % (FRAME_QUEUE_SIZE + 1) ];
+}
+
+// -----------------------------------------------------------------------------
+
+void FrameQueue::PushRecordedFrame()
+{
+    // release ordering makes the recorded
+    // commands visible to the consumer
+    unsigned Position = WritePosition.load( memory_order_relaxed );
+    WritePosition.store( Position + 1, memory_order_release );
+    
+    // start recording on an empty frame
+    Frames[ (Position + 1) % (FRAME_QUEUE_SIZE + 1) ].Clear();
+}
+
+
+// =============================================================================
+//      FRAME QUEUE: CONSUMER SIDE
+// =============================================================================
+
+
+const GPUCommandList* FrameQueue::GetOldestFrame()
+{
+    unsigned Position = ReadPosition.load( memory_order_relaxed );
+    
+    if( Position == WritePosition.load( memory_order_acquire ) )
+      return nullptr;
+    
+    return &Frames[ Position % (FRAME_QUEUE_SIZE + 1) ];
+}
+
+// -----------------------------------------------------------------------------
+
+void FrameQueue::PopOldestFrame()
+{
+    unsigned Position = ReadPosition.load( memory_order_relaxed );
+    ReadPosition.store( Position + 1, memory_order_release );
+}
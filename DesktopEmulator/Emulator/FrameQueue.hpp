@@ -0,0 +1,62 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef FRAMEQUEUE_HPP
+    #define FRAMEQUEUE_HPP
+    
+    // include console logic headers
+    #include "ConsoleLogic/GPUCommandList.hpp"
+    
+    // include C/C++ headers
+    #include <atomic>         // [ C++ STL ] Atomic variables
+// *****************************************************************************
+
+
+// maximum number of emulated frames that can wait
+// to be drawn; the queue uses 1 more slot to record
+// (this total must be a power of 2)
+#define FRAME_QUEUE_SIZE 3
+
+
+// =============================================================================
+//      QUEUE OF EMULATED FRAMES
+// =============================================================================
+
+
+// passes recorded frames from the emulation thread (the only
+// producer) to the render thread (the only consumer); no locks
+// are needed because each position is only written by one side,
+// and a frame slot is not reused until it has been drawn
+class FrameQueue
+{
+    private:
+    
+        V32::GPUCommandList Frames[ FRAME_QUEUE_SIZE + 1 ];
+        
+        // these only increase (and wrap around)
+        std::atomic< unsigned > ReadPosition;
+        std::atomic< unsigned > WritePosition;
+    
+    public:
+    
+        // instance handling
+        FrameQueue();
+        
+        // queue state
+        int GetQueuedFrames();
+        bool IsFull();
+        
+        // producer side: commands are recorded in the
+        // next free frame, then it gets added to the queue
+        V32::GPUCommandList& GetRecordingFrame();
+        void PushRecordedFrame();
+        
+        // consumer side: returns null when empty
+        const V32::GPUCommandList* GetOldestFrame();
+        void PopOldestFrame();
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -590,6 +590,7 @@ void GUI_LoadCartridge( string CartridgePath )
             LastCartridgeDirectory = GetPathDirectory( CartridgePath );
             
             Console.LoadCartridge( CartridgePath );
+            Video.ReportTextureMemory();
             Emulator.SetPower( true );
             
             // fix to prevent GUI from drawing
@@ -611,6 +612,9 @@ void GUI_LoadCartridge( string CartridgePath )
     
     catch( const exception& e )
     {
+        // remove any loading progress from the title
+        SDL_SetWindowTitle( Video.GetWindow(), "Vircon32: No cartridge" );
+        
         string Message = Texts( TextIDs::Errors_LoadCartridge_Label ) + string(e.what());
         DelayedMessageBox( SDL_MESSAGEBOX_ERROR, "Error", Message.c_str() );
     }
@@ -631,6 +635,7 @@ void GUI_ChangeCartridge( string CartridgePath )
             
             Console.UnloadCartridge();
             Console.LoadCartridge( CartridgePath );
+            Video.ReportTextureMemory();
             Emulator.SetPower( true );
             
             // fix to prevent GUI from drawing
@@ -652,6 +657,9 @@ void GUI_ChangeCartridge( string CartridgePath )
     
     catch( const exception& e )
     {
+        // remove any loading progress from the title
+        SDL_SetWindowTitle( Video.GetWindow(), "Vircon32: No cartridge" );
+        
         string Message = Texts( TextIDs::Errors_ChangeCartridge_Label ) + string(e.what());
         DelayedMessageBox( SDL_MESSAGEBOX_ERROR, "Error", Message.c_str() );
     }
@@ -1121,6 +1129,44 @@ void ProcessMenuOptions()
         ImGui::EndMenu();
     }
     
+    if( ImGui::BeginMenu( Texts(TextIDs::Options_FramePacing) ) )
+    {
+        FramePacingModes Pacing = Emulator.GetFramePacing();
+        
+        if( ImGui::MenuItem( Texts(TextIDs::Options_PacingAudio), nullptr, (Pacing == FramePacingModes::AudioClocked), true ) )
+          Emulator.SetFramePacing( FramePacingModes::AudioClocked );
+        
+        if( ImGui::MenuItem( Texts(TextIDs::Options_PacingVsync), nullptr, (Pacing == FramePacingModes::VsyncClocked), true ) )
+          Emulator.SetFramePacing( FramePacingModes::VsyncClocked );
+        
+        if( ImGui::MenuItem( Texts(TextIDs::Options_PacingUnlocked), nullptr, (Pacing == FramePacingModes::Unlocked), true ) )
+          Emulator.SetFramePacing( FramePacingModes::Unlocked );
+        
+        ImGui::EndMenu();
+    }
+    
+    if( ImGui::BeginMenu( Texts(TextIDs::Options_RunAhead) ) )
+    {
+        int RunAheadFrames = Emulator.GetRunAheadFrames();
+        
+        if( ImGui::MenuItem( Texts(TextIDs::Options_RunAheadOff), nullptr, (RunAheadFrames == 0), true ) )
+          Emulator.SetRunAheadFrames( 0 );
+        
+        if( ImGui::MenuItem( Texts(TextIDs::Options_RunAheadOneFrame), nullptr, (RunAheadFrames == 1), true ) )
+          Emulator.SetRunAheadFrames( 1 );
+        
+        for( int Frames = 2; Frames <= MAX_RUN_AHEAD_FRAMES; Frames++ )
+        {
+            char ItemText[ 50 ];
+            snprintf( ItemText, sizeof(ItemText), Texts(TextIDs::Options_RunAheadFrames), Frames );
+            
+            if( ImGui::MenuItem( ItemText, nullptr, (RunAheadFrames == Frames), true ) )
+              Emulator.SetRunAheadFrames( Frames );
+        }
+        
+        ImGui::EndMenu();
+    }
+    
     if( ImGui::BeginMenu( Texts(TextIDs::Options_Language) ) )
     {
         if( ImGui::MenuItem( Texts(TextIDs::Options_English), nullptr, (CurrentLanguage == &LanguageEnglish[0]), true ) )
@@ -1225,7 +1271,18 @@ void ProcessLabelCPU()
     {
         int CPULoad = Console.GetCPULoad();
         int GPULoad = Console.GetGPULoad();
-        ImGui::Text( "CPU %d%%, GPU %d%%", CPULoad, GPULoad );
+        
+        // with run-ahead, also show how much of each frame's
+        // time it takes, since over 100% frames are delayed
+        if( Emulator.GetRunAheadFrames() > 0 )
+        {
+            int RunAheadLoad = Emulator.GetRunAheadLoad();
+            int MaximumLoad = Emulator.GetMaximumRunAheadLoad();
+            ImGui::Text( "CPU %d%%, GPU %d%%, run-ahead %d%% (max %d%%)", CPULoad, GPULoad, RunAheadLoad, MaximumLoad );
+        }
+        
+        else
+          ImGui::Text( "CPU %d%%, GPU %d%%", CPULoad, GPULoad );
     }
     
     ImGui::PopStyleVar();
@@ -1279,6 +1336,9 @@ void ShowEmulatorWindow()
     if( GUIMustBeDrawn() )
       Video.ClearScreen( GPUColor{ 0, 16, 32, 210 } );
     
+    // these quads must be drawn before the GUI
+    Video.RenderQuadQueue();
+    
     // now restore the console's render parameters
     Video.SetMultiplyColor( PreviousMultiplyColor );
     Video.SetBlendingMode( PreviousBlendingMode );
@@ -82,58 +82,57 @@ void InitializeGlobalVariables()
 
 namespace CallbackFunctions
 {
+    // GPU commands are recorded in the current frame,
+    // and the main thread will draw them later
     void ClearScreen( V32::GPUColor ClearColor )
     {
-        Video.ClearScreen( ClearColor );
+        Emulator.GetRecordingFrame().AddClearScreen( ClearColor );
     }
 
     // -----------------------------------------------------------------------------
 
     void DrawQuad( V32::GPUQuad& DrawnQuad )
     {
-        Video.AddQuadToQueue( DrawnQuad );
+        Emulator.GetRecordingFrame().AddDrawQuad( DrawnQuad );
     }
 
     // -----------------------------------------------------------------------------
 
     void SetMultiplyColor( V32::GPUColor NewMultiplyColor )
     {
-        // GPU colors are not directly comparable so use words
-        V32::V32Word New, Old;
-        New.AsColor = NewMultiplyColor;
-        Old.AsColor = Video.GetMultiplyColor();
-        
-        // set multiply color only when needed, so that
-        // quad groups are not broken without need
-        if( New.AsInteger != Old.AsInteger )
-          Video.SetMultiplyColor( NewMultiplyColor );
+        Emulator.GetRecordingFrame().AddSetMultiplyColor( NewMultiplyColor );
     }
 
     // -----------------------------------------------------------------------------
 
     void SetBlendingMode( int NewBlendingMode )
     {
-        // set blending mode only when needed, so that
-        // quad groups are not broken without need
-        if( NewBlendingMode != (int)Video.GetBlendingMode() )
-          Video.SetBlendingMode( (V32::IOPortValues)NewBlendingMode );
+        Emulator.GetRecordingFrame().AddSetBlendingMode( NewBlendingMode );
     }
 
     // -----------------------------------------------------------------------------
 
     void SelectTexture( int GPUTextureID )
     {
-        // select texture only when needed, so that
-        // quad groups are not broken without need
-        if( GPUTextureID != Video.GetSelectedTexture() )
-          Video.SelectTexture( GPUTextureID );
+        Emulator.GetRecordingFrame().AddSelectTexture( GPUTextureID );
     }
 
     // -----------------------------------------------------------------------------
 
-    void LoadTexture( int GPUTextureID, void* Pixels )
+    // while a cartridge loads, this is called from
+    // worker threads (it does not use OpenGL)
+    void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height )
     {
-        Video.LoadTexture( GPUTextureID, Pixels );
+        Video.PrepareTexture( GPUTextureID, Pixels, Width, Height );
+    }
+
+    // -----------------------------------------------------------------------------
+
+    // textures are only loaded and unloaded with
+    // the console powered off, from the main thread
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+    {
+        Video.LoadTexture( GPUTextureID, Pixels, Width, Height );
     }
 
     // -----------------------------------------------------------------------------
@@ -164,4 +163,24 @@ namespace CallbackFunctions
     {
         THROW( Message );
     }
+    
+    // -----------------------------------------------------------------------------
+
+    // cartridges are loaded from the main thread, so the
+    // window is not redrawn meanwhile: show the progress in
+    // its title, and take pending events so that the system
+    // does not consider the window to be unresponsive
+    void ReportLoadProgress( int LoadedAssets, int TotalAssets )
+    {
+        static int LastPercentage = -1;
+        int Percentage = (100 * LoadedAssets) / max( TotalAssets, 1 );
+        
+        if( Percentage == LastPercentage )
+          return;
+        
+        LastPercentage = (Percentage < 100? Percentage : -1);
+        string WindowTitle = "Vircon32: Loading cartridge (" + to_string( Percentage ) + "%)";
+        SDL_SetWindowTitle( Video.GetWindow(), WindowTitle.c_str() );
+        SDL_PumpEvents();
+    }
 }
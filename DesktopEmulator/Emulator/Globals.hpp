@@ -80,13 +80,17 @@ namespace CallbackFunctions
     void SetMultiplyColor( V32::GPUColor NewMultiplyColor );
     void SetBlendingMode( int NewBlendingMode );
     void SelectTexture( int GPUTextureID );
-    void LoadTexture( int GPUTextureID, void* Pixels );
+    void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height );
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height );
     void UnloadCartridgeTextures();
     void UnloadBiosTexture();
     
     // log functions callable by the console
     void LogLine( const std::string& Message );
     void ThrowException( const std::string& Message );
+    
+    // progress reports from the console
+    void ReportLoadProgress( int LoadedAssets, int TotalAssets );
 }
 
 
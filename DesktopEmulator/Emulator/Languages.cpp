@@ -124,6 +124,14 @@ string LanguageEnglish[] =
     "Manual (use card menu)",
     "English",
     "Spanish",
+    "Frame pacing",
+    "Audio clocked",
+    "Vsync clocked",
+    "Unlocked (fast forward)",
+    "Run-ahead",
+    "Disabled",
+    "1 frame",
+    "%d frames",
     "Quick guide",
     "Show Readme file",
     "About",
@@ -264,6 +272,14 @@ string LanguageSpanish[] =
     "Manual (usar men\u00FA)",
     "Ingl\u00E9s",
     "Espa\u00F1ol",
+    "Ritmo de frames",
+    "Sincronizado con audio",
+    "Sincronizado con vsync",
+    "Sin l\u00EDmite (avance r\u00E1pido)",
+    "Ejecuci\u00F3n adelantada",
+    "Desactivada",
+    "1 frame",
+    "%d frames",
     "Gu\u00EDa r\u00E1pida",
     "Ver archivo Readme",
     "Acerca de",
@@ -57,6 +57,14 @@ enum class TextIDs: int
     Options_CardsManual,
     Options_English,
     Options_Spanish,
+    Options_FramePacing,
+    Options_PacingAudio,
+    Options_PacingVsync,
+    Options_PacingUnlocked,
+    Options_RunAhead,
+    Options_RunAheadOff,
+    Options_RunAheadOneFrame,
+    Options_RunAheadFrames,
     Help_QuickGuide,
     Help_ShowReadme,
     Help_About,
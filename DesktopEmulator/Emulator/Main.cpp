@@ -15,12 +15,12 @@
     #include "Settings.hpp"
     #include "Globals.hpp"
     #include "Languages.hpp"
-    #include "StopWatch.hpp"
     #include "Texture.hpp"
     
     // include C/C++ headers
     #include <iostream>         // [ C++ STL ] I/O Streams
     #include <cstddef>          // [ ANSI C ] Standard definitions
+    #include <mutex>            // [ C++ STL ] Mutexes
     
     // include SDL2 headers
     #define SDL_MAIN_HANDLED
@@ -275,6 +275,9 @@ int main( int NumberOfArguments, char* Arguments[] )
         // turn on Vircon VM
         Emulator.Initialize();
         
+        // from now on the console is shared with the emulation thread
+        unique_lock< mutex > StartupLock( Emulator.ConsoleMutex );
+        
         // load the standard bios from the emulator's local bios folder
         Console.LoadBios( EmulatorFolder + "Bios" + PathSeparator + BiosFileName );
         
@@ -302,6 +305,8 @@ int main( int NumberOfArguments, char* Arguments[] )
             #endif
         }
         
+        StartupLock.unlock();
+        
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         
         // program state control
@@ -310,15 +315,11 @@ int main( int NumberOfArguments, char* Arguments[] )
         LOG( "---------------------------------------------------------------------" );
         GlobalLoopActive = true;
         bool WindowActive = true;
-        float PendingFrames = 1;
         
         // depending on focus changes we will wait for events or
         // just poll them and continue; this pointer controls that
         int (*EventProcessor)(SDL_Event *) = &SDL_PollEvent;
         
-        // timing control
-        StopWatch Watch;
-        
         // begin message loop
         while( GlobalLoopActive )
         {
@@ -327,6 +328,9 @@ int main( int NumberOfArguments, char* Arguments[] )
             
             while( EventProcessor( &Event ) )
             {
+                // the console must not be used in mid-frame
+                lock_guard< mutex > ConsoleLock( Emulator.ConsoleMutex );
+                
                 // - - - - - - - - - - - - - - - - - - - - - - -
                 // FIRST, PROCESS THE GLOBAL BEHAVIORS
                 // (THESE ALWAYS SHOULD TAKE PRIORITY)
@@ -353,6 +357,7 @@ int main( int NumberOfArguments, char* Arguments[] )
                         WindowActive = false;
                         MouseIsOnWindow = false;
                         EventProcessor = &SDL_WaitEvent;
+                        Emulator.SetRewinding( false );
                         Emulator.Pause();
                     }
                     
@@ -380,9 +385,6 @@ int main( int NumberOfArguments, char* Arguments[] )
                     
                     if( Event.window.event == SDL_WINDOWEVENT_LEAVE )
                       MouseIsOnWindow = false;
-                    
-                    // on any window event (such as lose focus) "stop time"
-                    Watch.GetStepTime();
                 }
                 
                 // respond to keys being pressed
@@ -403,6 +405,9 @@ int main( int NumberOfArguments, char* Arguments[] )
                     // Key F4 loads state from the current slot
                     if( Key == SDLK_F4 ) GUI_LoadState();
                     
+                    // Backspace key rewinds while held
+                    if( Key == SDLK_BACKSPACE ) Emulator.SetRewinding( true );
+                    
                     // when CTRL is pressed, process keyboard shortcuts
                     bool ControlIsPressed = (SDL_GetModState() & KMOD_CTRL);
                     
@@ -473,6 +478,13 @@ int main( int NumberOfArguments, char* Arguments[] )
                     }
                 }
                 
+                // respond to keys being released
+                if( Event.type == SDL_KEYUP )
+                {
+                    if( Event.key.keysym.sym == SDLK_BACKSPACE )
+                      Emulator.SetRewinding( false );
+                }
+                
                 // - - - - - - - - - - - - - - - - - - - - - - - - - -
                 // NOW, LET EMULATION REACT TO THIS MESSAGE
                 // (but while window is inactive, events will get ignored)
@@ -484,25 +496,18 @@ int main( int NumberOfArguments, char* Arguments[] )
             // update frame only when needed
             if( !WindowActive ) continue;
             
-            // redirect all rendering to emulator's display
-            Video.RenderToFramebuffer();
-            Video.BeginFrame();
-            
-            // measure cycle time
-            double TimeStep = Watch.GetStepTime();
+            // frames are run by the emulation thread;
+            // here we only draw the ones it recorded
+            unique_lock< mutex > ConsoleLock( Emulator.ConsoleMutex );
+            Emulator.CheckThreadErrors();
+            int DrawnFrames = Emulator.DrawQueuedFrames();
             
-            if( Emulator.IsPowerOn() && !Emulator.IsPaused() )
+            // while running, wait until there is a new frame
+            if( DrawnFrames == 0 && Emulator.IsPowerOn() && !Emulator.IsPaused() )
             {
-                // execute frames as needed
-                PendingFrames += TimeStep * 60.0;
-                if( PendingFrames < 0.9 ) continue;
-                
-                while( PendingFrames >= 0.9 )
-                {
-                    // run another frame
-                    Emulator.RunNextFrame();
-                    PendingFrames -= 1;
-                }
+                ConsoleLock.unlock();
+                SDL_Delay( 1 );
+                continue;
             }
             
             // - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -514,10 +519,14 @@ int main( int NumberOfArguments, char* Arguments[] )
             // (2) Render GUI (on full screen, only when needed)
             RenderGUI();
             
-            // (3) Show updates on screen
+            // (3) Show updates on screen; the emulation
+            // thread can run while we wait for vsync
+            ConsoleLock.unlock();
             SDL_GL_SwapWindow( Video.GetWindow() );
             
             // (4) Show message boxes when needed
+            // (this pauses emulation while shown)
+            ConsoleLock.lock();
             ShowDelayedMessageBox();
         }
         
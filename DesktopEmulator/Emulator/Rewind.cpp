@@ -0,0 +1,309 @@
+// *****************************************************************************
+    // include infrastructure headers
+    #include "DesktopInfrastructure/Logger.hpp"
+    
+    // include emulator headers
+    #include "Rewind.hpp"
+    
+    // include C/C++ headers
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstring>          // [ ANSI C ] Strings
+    #include <cstdio>           // [ ANSI C ] Standard I/O
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// how often telemetry is logged (10 seconds)
+#define REWIND_REPORT_FRAMES 600
+
+
+// =============================================================================
+//      REWIND BUFFER: INSTANCE HANDLING
+// =============================================================================
+
+
+RewindBuffer::RewindBuffer()
+{
+    PreviousState.reset( new ConsoleState );
+    ReportedCaptures = 0;
+    SetMemoryBudget( DEFAULT_REWIND_MEGABYTES );
+}
+
+
+// =============================================================================
+//      REWIND BUFFER: CONFIGURATION
+// =============================================================================
+
+
+void RewindBuffer::SetMemoryBudget( unsigned Megabytes )
+{
+    Clear();
+    
+    // release the previous ring before allocating
+    vector< uint32_t >().swap( RingWords );
+    RingWords.resize( (size_t)Megabytes * 1024 * 1024 / sizeof(uint32_t) );
+}
+
+// -----------------------------------------------------------------------------
+
+unsigned RewindBuffer::GetMemoryBudget()
+{
+    return RingWords.size() * sizeof(uint32_t) / (1024 * 1024);
+}
+
+
+// =============================================================================
+//      REWIND BUFFER: GENERAL OPERATION
+// =============================================================================
+
+
+void RewindBuffer::Clear()
+{
+    if( ReportedCaptures > 0 )
+      ReportTelemetry();
+    
+    // a new snapshot makes the next capture a full one
+    Snapshot.reset( new IncrementalSnapshot );
+    HasPreviousState = false;
+    Entries.clear();
+    
+    ReportedCaptures = 0;
+    TotalBytes = MaximumBytes = 0;
+    TotalMilliseconds = MaximumMilliseconds = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void RewindBuffer::CaptureFrame()
+{
+    auto StartTime = chrono::steady_clock::now();
+    Snapshot->Capture();
+    
+    // the first frame has nothing to compare with
+    if( !HasPreviousState )
+    {
+        const uint8_t* NewBytes = (const uint8_t*)Snapshot->GetState();
+        uint8_t* PreviousBytes = (uint8_t*)PreviousState.get();
+        
+        for( const StateRange& Range: Snapshot->CopiedRanges )
+          memcpy( PreviousBytes + Range.Offset, NewBytes + Range.Offset, Range.Size );
+        
+        HasPreviousState = true;
+        return;
+    }
+    
+    EncodeDelta();
+    StoreDelta();
+    
+    // update telemetry
+    double Bytes = EncodedDelta.size() * sizeof(uint32_t);
+    double Milliseconds = chrono::duration< double, milli >( chrono::steady_clock::now() - StartTime ).count();
+    
+    ReportedCaptures++;
+    TotalBytes += Bytes;
+    TotalMilliseconds += Milliseconds;
+    MaximumBytes = max( MaximumBytes, Bytes );
+    MaximumMilliseconds = max( MaximumMilliseconds, Milliseconds );
+    
+    if( ReportedCaptures >= REWIND_REPORT_FRAMES )
+      ReportTelemetry();
+}
+
+// -----------------------------------------------------------------------------
+
+// returns false when there are no older frames; in
+// that case the console goes back to the oldest one
+bool RewindBuffer::StepBack()
+{
+    if( !HasPreviousState )
+      return false;
+    
+    bool HasOlderFrame = !Entries.empty();
+    
+    if( HasOlderFrame )
+    {
+        DecodeDelta( &RingWords[ Entries.back().Start ] );
+        Entries.pop_back();
+    }
+    
+    Snapshot->Restore();
+    return HasOlderFrame;
+}
+
+// -----------------------------------------------------------------------------
+
+// returns the console to the last captured frame; this
+// is incremental, so it is cheap to do in every frame
+bool RewindBuffer::RestoreLastFrame()
+{
+    if( !HasPreviousState )
+      return false;
+    
+    Snapshot->Restore();
+    return true;
+}
+
+
+// =============================================================================
+//      REWIND BUFFER: DELTA ENCODING
+// -----------------------------------------------------------------------------
+//      A delta holds its number of ranges, and then for each range its
+//      offset and size (in words) followed by pairs of counts: first of
+//      unchanged words, then of changed words, each one of these last
+//      stored as the XOR of its new and previous values
+// =============================================================================
+
+
+void RewindBuffer::EncodeDelta()
+{
+    const uint8_t* NewBytes = (const uint8_t*)Snapshot->GetState();
+    uint8_t* PreviousBytes = (uint8_t*)PreviousState.get();
+    
+    EncodedDelta.clear();
+    EncodedDelta.push_back( Snapshot->CopiedRanges.size() );
+    
+    for( const StateRange& Range: Snapshot->CopiedRanges )
+    {
+        // all state fields are made of whole words
+        const uint32_t* NewWords = (const uint32_t*)(NewBytes + Range.Offset);
+        uint32_t* PreviousWords = (uint32_t*)(PreviousBytes + Range.Offset);
+        uint32_t RangeWords = Range.Size / sizeof(uint32_t);
+        
+        EncodedDelta.push_back( Range.Offset / sizeof(uint32_t) );
+        EncodedDelta.push_back( RangeWords );
+        
+        uint32_t Position = 0;
+        
+        while( Position < RangeWords )
+        {
+            uint32_t UnchangedStart = Position;
+            
+            while( Position < RangeWords && NewWords[ Position ] == PreviousWords[ Position ] )
+              Position++;
+            
+            uint32_t ChangedStart = Position;
+            
+            while( Position < RangeWords && NewWords[ Position ] != PreviousWords[ Position ] )
+              Position++;
+            
+            EncodedDelta.push_back( ChangedStart - UnchangedStart );
+            EncodedDelta.push_back( Position - ChangedStart );
+            
+            // the previous state becomes the new one
+            for( uint32_t i = ChangedStart; i < Position; i++ )
+            {
+                EncodedDelta.push_back( NewWords[ i ] ^ PreviousWords[ i ] );
+                PreviousWords[ i ] = NewWords[ i ];
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// applies a delta to the previous state, and passes
+// each of its ranges to the snapshot, so that both
+// hold the frame before the one they had
+void RewindBuffer::DecodeDelta( const uint32_t* Data )
+{
+    uint32_t* PreviousWords = (uint32_t*)PreviousState.get();
+    uint32_t NumberOfRanges = *(Data++);
+    
+    for( uint32_t RangeNumber = 0; RangeNumber < NumberOfRanges; RangeNumber++ )
+    {
+        uint32_t RangeOffset = *(Data++);
+        uint32_t RangeWords = *(Data++);
+        uint32_t* RangeStart = PreviousWords + RangeOffset;
+        uint32_t Position = 0;
+        
+        while( Position < RangeWords )
+        {
+            Position += *(Data++);
+            uint32_t ChangedWords = *(Data++);
+            
+            for( uint32_t i = 0; i < ChangedWords; i++ )
+              RangeStart[ Position++ ] ^= *(Data++);
+        }
+        
+        StateRange Range = { RangeOffset * (unsigned)sizeof(uint32_t), RangeWords * (unsigned)sizeof(uint32_t) };
+        Snapshot->WriteState( Range, RangeStart );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void RewindBuffer::StoreDelta()
+{
+    size_t Words = EncodedDelta.size();
+    
+    // a delta larger than the ring can't be stored,
+    // and older ones can't be reached without it
+    if( Words > RingWords.size() )
+    {
+        Entries.clear();
+        return;
+    }
+    
+    // continue after the newest delta
+    size_t Start = 0;
+    
+    if( !Entries.empty() )
+      Start = Entries.back().Start + Entries.back().Words;
+    
+    // when the end is reached, deltas placed after
+    // the newest one are the oldest: discard them
+    // and continue at the start of the ring
+    if( Start + Words > RingWords.size() )
+    {
+        while( !Entries.empty() && Entries.front().Start >= Start )
+          Entries.pop_front();
+        
+        Start = 0;
+    }
+    
+    // discard the oldest deltas that get overwritten
+    while( !Entries.empty() && Entries.front().Start < Start + Words
+    &&     Entries.front().Start + Entries.front().Words > Start )
+      Entries.pop_front();
+    
+    memcpy( &RingWords[ Start ], EncodedDelta.data(), Words * sizeof(uint32_t) );
+    Entries.push_back( { Start, Words } );
+}
+
+
+// =============================================================================
+//      REWIND BUFFER: TELEMETRY
+// =============================================================================
+
+
+unsigned RewindBuffer::GetStoredFrames()
+{
+    return Entries.size();
+}
+
+// -----------------------------------------------------------------------------
+
+void RewindBuffer::ReportTelemetry()
+{
+    char Line[ 200 ];
+    
+    if( ReportedCaptures > 0 )
+    {
+        snprintf( Line, sizeof(Line), "Rewind captures: %u frames, average %.1f KB (maximum %.1f KB), average %.2f ms (maximum %.2f ms)",
+                  ReportedCaptures, TotalBytes / ReportedCaptures / 1024, MaximumBytes / 1024,
+                  TotalMilliseconds / ReportedCaptures, MaximumMilliseconds );
+        LOG( Line );
+    }
+    
+    snprintf( Line, sizeof(Line), "Rewind buffer: %u frames stored (%.1f s) in %u MB",
+              GetStoredFrames(), (double)GetStoredFrames() / Constants::FramesPerSecond, GetMemoryBudget() );
+    LOG( Line );
+    
+    ReportedCaptures = 0;
+    TotalBytes = MaximumBytes = 0;
+    TotalMilliseconds = MaximumMilliseconds = 0;
+}
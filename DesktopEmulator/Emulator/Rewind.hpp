@@ -0,0 +1,91 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef REWIND_HPP
+    #define REWIND_HPP
+    
+    // include project headers
+    #include "Savestates.hpp"
+    
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <deque>            // [ C++ STL ] Double-ended queues
+    #include <memory>           // [ C++ STL ] Dynamic memory
+    #include <cstdint>          // [ ANSI C ] Standard integers
+// *****************************************************************************
+
+
+// default memory used to store past frames
+#define DEFAULT_REWIND_MEGABYTES 64
+
+
+// =============================================================================
+//      RING OF PAST CONSOLE STATES
+// =============================================================================
+
+
+// location of a stored frame within the ring
+typedef struct
+{
+    size_t Start;
+    size_t Words;
+}
+RewindEntry;
+
+// -----------------------------------------------------------------------------
+
+// keeps the console state of as many past frames as fit
+// in a fixed memory budget; each frame is stored as the
+// XOR delta that turns it into the previous frame, only
+// for the state ranges that the snapshot captured, and
+// compressed by encoding runs of zero words
+class RewindBuffer
+{
+    private:
+    
+        // state of the last frame, and a copy of it
+        // to find what changed in the next capture
+        std::unique_ptr< IncrementalSnapshot > Snapshot;
+        std::unique_ptr< ConsoleState > PreviousState;
+        bool HasPreviousState;
+        
+        // compressed deltas, oldest first; when the end
+        // of the ring is reached they continue at its start
+        std::vector< uint32_t > RingWords;
+        std::deque< RewindEntry > Entries;
+        std::vector< uint32_t > EncodedDelta;
+        
+        // telemetry since last report
+        unsigned ReportedCaptures;
+        double TotalBytes, MaximumBytes;
+        double TotalMilliseconds, MaximumMilliseconds;
+        
+        // internal functions
+        void EncodeDelta();
+        void DecodeDelta( const uint32_t* Data );
+        void StoreDelta();
+    
+    public:
+    
+        // instance handling
+        RewindBuffer();
+        
+        // configuration
+        void SetMemoryBudget( unsigned Megabytes );
+        unsigned GetMemoryBudget();
+        
+        // general operation
+        void Clear();
+        void CaptureFrame();
+        bool StepBack();
+        bool RestoreLastFrame();
+        
+        // telemetry
+        unsigned GetStoredFrames();
+        void ReportTelemetry();
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
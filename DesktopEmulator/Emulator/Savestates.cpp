@@ -1,6 +1,7 @@
 // *****************************************************************************
     // include infrastructure headers
     #include "DesktopInfrastructure/Logger.hpp"
+    #include "DesktopInfrastructure/BlockCompression.hpp"
     
     // include emulator headers
     #include "Savestates.hpp"
@@ -9,6 +10,10 @@
     
     // include C/C++ headers
     #include <memory>             // [ C++ STL ] Dynamic memory
+    #include <functional>         // [ C++ STL ] Functional
+    #include <thread>             // [ C++ STL ] Threads
+    #include <atomic>             // [ C++ STL ] Atomics
+    #include <algorithm>          // [ C++ STL ] Algorithms
     #include <string.h>           // [ ANSI C ] Strings
     
     // declare used namespaces
@@ -31,7 +36,7 @@ void SaveCPUState( CPUState& State )
 
 // -----------------------------------------------------------------------------
 
-void SaveGPUState( GPUState& State )
+unsigned SaveGPUState( GPUState& State, bool OnlyModified = false )
 {
     V32GPU& GPU = Console.GPU;
     
@@ -39,11 +44,23 @@ void SaveGPUState( GPUState& State )
     memcpy( State.Registers, &GPU.Command, sizeof(State.Registers) );
     
     // copy the BIOS texture
-    memcpy( &State.BiosTexture, &GPU.BiosTexture, sizeof(GPUTexture) );
+    unsigned CopiedTextures = 0;
+    
+    if( !OnlyModified || GPU.ModifiedTextures[ 0 ] )
+    {
+        memcpy( &State.BiosTexture, &GPU.BiosTexture, sizeof(GPUTexture) );
+        CopiedTextures++;
+    }
     
     // copy only the needed cartridge textures
-    unsigned TexturesSize = sizeof(GPUTexture) * GPU.LoadedCartridgeTextures;
-    memcpy( State.CartridgeTextures, &GPU.CartridgeTextures[ 0 ], TexturesSize );
+    for( unsigned TextureID = 0; TextureID < GPU.LoadedCartridgeTextures; TextureID++ )
+      if( !OnlyModified || GPU.ModifiedTextures[ TextureID + 1 ] )
+      {
+          memcpy( &State.CartridgeTextures[ TextureID ], &GPU.CartridgeTextures[ TextureID ], sizeof(GPUTexture) );
+          CopiedTextures++;
+      }
+    
+    return CopiedTextures;
 }
 
 // -----------------------------------------------------------------------------
@@ -83,14 +100,33 @@ void SaveGamepadControllerState( GamepadControllerState& State )
 
 // -----------------------------------------------------------------------------
 
-void SaveOtherConsoleState( OtherConsoleState& State )
+unsigned SaveOtherConsoleState( OtherConsoleState& State, bool OnlyModified = false )
 {
     // save state for minor chips
     memcpy( State.TimerRegisters, &Console.Timer.CurrentDate, sizeof(State.TimerRegisters) );
     State.RNGCurrentValue = Console.RNG.CurrentValue;
     
     // save the full RAM
-    memcpy( State.RAM, &Console.RAM.Memory[ 0 ], sizeof(State.RAM) );
+    V32RAM& RAM = Console.RAM;
+    
+    if( !OnlyModified )
+    {
+        memcpy( State.RAM, &RAM.Memory[ 0 ], sizeof(State.RAM) );
+        return RAM.GetNumberOfPages();
+    }
+    
+    // or just the pages written since last time
+    unsigned CopiedPages = 0;
+    
+    for( int32_t Page = 0; Page < RAM.GetNumberOfPages(); Page++ )
+      if( RAM.IsPageDirty( Page ) )
+      {
+          int32_t FirstWord = Page * MemoryPageWords;
+          memcpy( &State.RAM[ FirstWord ], &RAM.Memory[ FirstWord ], MemoryPageWords * sizeof(V32Word) );
+          CopiedPages++;
+      }
+    
+    return CopiedPages;
 }
 
 // -----------------------------------------------------------------------------
@@ -156,7 +192,7 @@ void LoadCPUState( const CPUState& State )
 
 // -----------------------------------------------------------------------------
 
-void LoadGPUState( const GPUState& State )
+unsigned LoadGPUState( const GPUState& State, bool OnlyModified = false )
 {
     V32GPU& GPU = Console.GPU;
     
@@ -164,11 +200,25 @@ void LoadGPUState( const GPUState& State )
     memcpy( &GPU.Command, State.Registers, sizeof(State.Registers) );
     
     // copy the BIOS texture
-    memcpy( &GPU.BiosTexture, &State.BiosTexture, sizeof(GPUTexture) );
+    unsigned CopiedTextures = 0;
+    
+    if( !OnlyModified || GPU.ModifiedTextures[ 0 ] )
+    {
+        memcpy( &GPU.BiosTexture, &State.BiosTexture, sizeof(GPUTexture) );
+        CopiedTextures++;
+    }
     
     // copy only the needed cartridge textures
-    unsigned TexturesSize = sizeof(GPUTexture) * GPU.LoadedCartridgeTextures;
-    memcpy( &GPU.CartridgeTextures[ 0 ], State.CartridgeTextures, TexturesSize );
+    for( unsigned TextureID = 0; TextureID < GPU.LoadedCartridgeTextures; TextureID++ )
+      if( !OnlyModified || GPU.ModifiedTextures[ TextureID + 1 ] )
+      {
+          memcpy( &GPU.CartridgeTextures[ TextureID ], &State.CartridgeTextures[ TextureID ], sizeof(GPUTexture) );
+          CopiedTextures++;
+      }
+    
+    // regions no longer match what was tracked
+    if( !OnlyModified )
+      GPU.MarkAllTexturesModified();
     
     // update GPU pointers for the loaded selections
     if( GPU.SelectedTexture == -1 )
@@ -184,14 +234,18 @@ void LoadGPUState( const GPUState& State )
         // (empty block instead of ";" to avoid warnings)
     }
     
-    // make the needed updates in video output
-    Video.SelectTexture( GPU.SelectedTexture );
-    Video.SetMultiplyColor( GPU.MultiplyColor );
-    Video.SetBlendingMode( (IOPortValues)GPU.ActiveBlending );
+    // make the needed updates in video output; these go
+    // through the callbacks so that they get recorded in
+    // order with the GPU commands of the next frame
+    Callbacks::SelectTexture( GPU.SelectedTexture );
+    Callbacks::SetMultiplyColor( GPU.MultiplyColor );
+    Callbacks::SetBlendingMode( GPU.ActiveBlending );
     
     // check for success
     if( glGetError() != GL_NO_ERROR )
       THROW( "There was an OpenGL error" );
+    
+    return CopiedTextures;
 }
 
 // -----------------------------------------------------------------------------
@@ -249,19 +303,40 @@ void LoadGamepadControllerState( const GamepadControllerState& State )
 
 // -----------------------------------------------------------------------------
 
-void LoadOtherConsoleState( const OtherConsoleState& State )
+unsigned LoadOtherConsoleState( const OtherConsoleState& State, bool OnlyModified = false )
 {
     // load state for minor chips
     memcpy( &Console.Timer.CurrentDate, State.TimerRegisters, sizeof(State.TimerRegisters) );
     Console.RNG.CurrentValue = State.RNGCurrentValue;
     
-    // load the full RAM
-    memcpy( &Console.RAM.Memory[ 0 ], State.RAM, sizeof(State.RAM) );
+    // load the full RAM; its contents
+    // no longer match what was tracked
+    V32RAM& RAM = Console.RAM;
+    
+    if( !OnlyModified )
+    {
+        memcpy( &RAM.Memory[ 0 ], State.RAM, sizeof(State.RAM) );
+        RAM.MarkAllPagesDirty();
+        return RAM.GetNumberOfPages();
+    }
+    
+    // or just rewrite the pages written since last time
+    unsigned CopiedPages = 0;
+    
+    for( int32_t Page = 0; Page < RAM.GetNumberOfPages(); Page++ )
+      if( RAM.IsPageDirty( Page ) )
+      {
+          int32_t FirstWord = Page * MemoryPageWords;
+          memcpy( &RAM.Memory[ FirstWord ], &State.RAM[ FirstWord ], MemoryPageWords * sizeof(V32Word) );
+          CopiedPages++;
+      }
+    
+    return CopiedPages;
 }
 
 // -----------------------------------------------------------------------------
 
-void LoadState( const ConsoleState* State )
+void CheckStateCompatibility( const ConsoleState* State )
 {
     // try to identify the game and BIOS and see if they
     // match current ones, to avoid loading incompatible states
@@ -274,6 +349,13 @@ void LoadState( const ConsoleState* State )
     
     if( memcmp( &State->Bios, &CurrentBios, sizeof(ROMInfo) ) )
       THROW( "Current BIOS is not the same one that was used when saving" );
+}
+
+// -----------------------------------------------------------------------------
+
+void LoadState( const ConsoleState* State )
+{
+    CheckStateCompatibility( State );
     
     // load console state
     LoadCPUState( State->CPU );
@@ -285,14 +367,235 @@ void LoadState( const ConsoleState* State )
 
 
 // =============================================================================
-//      RLE BUFFER COMPRESSION
+//      INCREMENTAL SNAPSHOTS
+// -----------------------------------------------------------------------------
+//      Modified RAM pages and texture regions are tracked for a single
+//      snapshot at a time: the last one captured or restored. Only that
+//      one can be updated incrementally, and any other will need a full
+//      copy (which then makes it the one being tracked)
+// =============================================================================
+
+
+IncrementalSnapshot* TrackedSnapshot = nullptr;
+
+// -----------------------------------------------------------------------------
+
+IncrementalSnapshot::IncrementalSnapshot()
+{
+    State.reset( new ConsoleState );
+    HasState = false;
+    CopiedRAMPages = 0;
+    CopiedTextures = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+IncrementalSnapshot::~IncrementalSnapshot()
+{
+    if( TrackedSnapshot == this )
+      TrackedSnapshot = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+
+void IncrementalSnapshot::Capture()
+{
+    // only the tracked snapshot can skip unmodified parts
+    bool OnlyModified = (HasState && TrackedSnapshot == this);
+    FindCopiedRanges( OnlyModified );
+    
+    // save info to identify the game and BIOS
+    SaveGameInfo( State->Game );
+    SaveBiosInfo( State->Bios );
+    
+    // save console state
+    SaveCPUState( State->CPU );
+    SaveSPUState( State->SPU );
+    SaveGamepadControllerState( State->GamepadController );
+    CopiedTextures = SaveGPUState( State->GPU, OnlyModified );
+    CopiedRAMPages = SaveOtherConsoleState( State->Others, OnlyModified );
+    
+    // from now on, track changes from this state
+    Console.RAM.ClearDirtyPages();
+    Console.GPU.ClearModifiedTextures();
+    TrackedSnapshot = this;
+    HasState = true;
+}
+
+// -----------------------------------------------------------------------------
+
+void IncrementalSnapshot::Restore()
+{
+    if( !HasState )
+      THROW( "No console state has been captured in the snapshot" );
+    
+    CheckStateCompatibility( State.get() );
+    
+    // only parts modified since the tracked snapshot
+    // can differ from it, so there is no need to
+    // rewrite any others
+    bool OnlyModified = (TrackedSnapshot == this);
+    
+    // load console state
+    LoadCPUState( State->CPU );
+    LoadSPUState( State->SPU );
+    LoadGamepadControllerState( State->GamepadController );
+    CopiedTextures = LoadGPUState( State->GPU, OnlyModified );
+    CopiedRAMPages = LoadOtherConsoleState( State->Others, OnlyModified );
+    
+    // console now matches this state again
+    Console.RAM.ClearDirtyPages();
+    Console.GPU.ClearModifiedTextures();
+    TrackedSnapshot = this;
+}
+
+// -----------------------------------------------------------------------------
+
+const ConsoleState* IncrementalSnapshot::GetState()
+{
+    return (HasState? State.get() : nullptr);
+}
+
+// -----------------------------------------------------------------------------
+
+void IncrementalSnapshot::WriteState( const StateRange& Range, const void* Source )
+{
+    if( !HasState )
+      THROW( "No console state has been captured in the snapshot" );
+    
+    if( Range.Offset + Range.Size > sizeof(ConsoleState) )
+      THROW( "Snapshot range is outside of the console state" );
+    
+    uint8_t* StateBytes = (uint8_t*)State.get();
+    memcpy( StateBytes + Range.Offset, Source, Range.Size );
+    
+    // only the tracked snapshot uses modification flags
+    if( TrackedSnapshot != this || Range.Size == 0 )
+      return;
+    
+    // flag the RAM pages within the range
+    unsigned RangeEnd = Range.Offset + Range.Size;
+    unsigned RAMStart = (uint8_t*)State->Others.RAM - StateBytes;
+    unsigned RAMEnd = RAMStart + sizeof(State->Others.RAM);
+    unsigned PageBytes = MemoryPageWords * sizeof(V32Word);
+    
+    if( Range.Offset < RAMEnd && RangeEnd > RAMStart )
+    {
+        unsigned FirstPage = (max( Range.Offset, RAMStart ) - RAMStart) / PageBytes;
+        unsigned LastPage = (min( RangeEnd, RAMEnd ) - 1 - RAMStart) / PageBytes;
+        
+        for( unsigned Page = FirstPage; Page <= LastPage; Page++ )
+          Console.RAM.DirtyPages[ Page ] = 1;
+    }
+    
+    // same for texture regions
+    unsigned TexturesStart = (uint8_t*)&State->GPU.BiosTexture - StateBytes;
+    unsigned TexturesEnd = TexturesStart + (1 + Console.GPU.LoadedCartridgeTextures) * sizeof(GPUTexture);
+    
+    if( Range.Offset < TexturesEnd && RangeEnd > TexturesStart )
+    {
+        unsigned FirstTexture = (max( Range.Offset, TexturesStart ) - TexturesStart) / sizeof(GPUTexture);
+        unsigned LastTexture = (min( RangeEnd, TexturesEnd ) - 1 - TexturesStart) / sizeof(GPUTexture);
+        
+        for( unsigned Texture = FirstTexture; Texture <= LastTexture; Texture++ )
+          Console.GPU.ModifiedTextures[ Texture ] = 1;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void IncrementalSnapshot::AddCopiedRange( const void* Start, unsigned Size )
+{
+    unsigned Offset = (const uint8_t*)Start - (const uint8_t*)State.get();
+    
+    // join consecutive ranges
+    if( !CopiedRanges.empty() )
+    {
+        StateRange& LastRange = CopiedRanges.back();
+        
+        if( LastRange.Offset + LastRange.Size == Offset )
+        {
+            LastRange.Size += Size;
+            return;
+        }
+    }
+    
+    CopiedRanges.push_back( { Offset, Size } );
+}
+
+// -----------------------------------------------------------------------------
+
+// must match what the save functions will copy
+void IncrementalSnapshot::FindCopiedRanges( bool OnlyModified )
+{
+    CopiedRanges.clear();
+    
+    // parts that are always copied
+    AddCopiedRange( &State->Game, sizeof(ROMInfo) );
+    AddCopiedRange( &State->Bios, sizeof(ROMInfo) );
+    AddCopiedRange( State->Others.TimerRegisters, sizeof(State->Others.TimerRegisters) );
+    AddCopiedRange( &State->Others.RNGCurrentValue, sizeof(State->Others.RNGCurrentValue) );
+    AddCopiedRange( &State->GamepadController, sizeof(GamepadControllerState) );
+    AddCopiedRange( &State->CPU, sizeof(CPUState) );
+    
+    // for the SPU, skip unused sounds
+    SPUState& SPU = State->SPU;
+    AddCopiedRange( &SPU, (uint8_t*)SPU.CartridgeSounds - (uint8_t*)&SPU );
+    AddCopiedRange( SPU.CartridgeSounds, Console.SPU.LoadedCartridgeSounds * sizeof(SPUSoundState) );
+    
+    // RAM pages
+    V32RAM& RAM = Console.RAM;
+    
+    for( int32_t Page = 0; Page < RAM.GetNumberOfPages(); Page++ )
+      if( !OnlyModified || RAM.IsPageDirty( Page ) )
+        AddCopiedRange( &State->Others.RAM[ Page * MemoryPageWords ], MemoryPageWords * sizeof(V32Word) );
+    
+    // GPU registers and textures
+    V32GPU& GPU = Console.GPU;
+    AddCopiedRange( State->GPU.Registers, sizeof(State->GPU.Registers) );
+    
+    if( !OnlyModified || GPU.ModifiedTextures[ 0 ] )
+      AddCopiedRange( &State->GPU.BiosTexture, sizeof(GPUTexture) );
+    
+    for( unsigned TextureID = 0; TextureID < GPU.LoadedCartridgeTextures; TextureID++ )
+      if( !OnlyModified || GPU.ModifiedTextures[ TextureID + 1 ] )
+        AddCopiedRange( &State->GPU.CartridgeTextures[ TextureID ], sizeof(GPUTexture) );
+}
+
+
+// =============================================================================
+//      SAVESTATE FILE FORMAT
 // -----------------------------------------------------------------------------
 //      The full size of a Vircon32 savestate is 16+ MB, however most of the
-//      RAM will typically be zeroes so we will store savestates on disk
-//      using a very simple RLE compression that should reduce size a lot
+//      RAM will typically be zeroes so files are compressed. The state is
+//      split in chunks that are compressed independently, so that several
+//      threads can work on them. Files have a header, then the compressed
+//      size of each chunk, and then the chunks. Older state files have no
+//      header and use a simple RLE compression, and they can still be loaded
 // =============================================================================
 
 
+// header at the start of state files
+typedef struct
+{
+    char Signature[ 8 ];
+    uint32_t Version;
+    uint32_t StateSize;
+    uint32_t ChunkSize;
+    uint32_t NumberOfChunks;
+}
+SavestateFileHeader;
+
+// identification of state files
+const char SavestateSignature[ 8 ] = { 'V','3','2','S','T','A','T','E' };
+const uint32_t SavestateVersion = 2;
+
+// large enough to compress well, but small
+// enough for all threads to share the work
+const uint32_t SavestateChunkSize = 1024 * 1024;
+
+// -----------------------------------------------------------------------------
+
 unsigned GetSavestateSize()
 {
     // savestates may be a different size for each
@@ -308,54 +611,154 @@ unsigned GetSavestateSize()
 
 // -----------------------------------------------------------------------------
 
-void SaveBufferToRLEFile( ofstream& OutputFile, const void* Buffer )
+// chunks are taken in order by the calling thread and some
+// worker threads until all are done; processing a chunk
+// must not throw, since workers have no way to report it
+void ProcessChunksInParallel( unsigned NumberOfChunks, const function< void( unsigned ) >& ProcessChunk )
+{
+    atomic< unsigned > NextChunk( 0 );
+    
+    auto ProcessRemainingChunks = [ & ]()
+    {
+        unsigned ChunkNumber;
+        
+        while( (ChunkNumber = NextChunk++) < NumberOfChunks )
+          ProcessChunk( ChunkNumber );
+    };
+    
+    // the calling thread counts as one of the workers
+    unsigned NumberOfWorkers = min( thread::hardware_concurrency(), NumberOfChunks );
+    vector< thread > Workers;
+    
+    for( unsigned i = 1; i < NumberOfWorkers; i++ )
+      Workers.push_back( thread( ProcessRemainingChunks ) );
+    
+    ProcessRemainingChunks();
+    
+    for( thread& Worker: Workers )
+      Worker.join();
+}
+
+
+// =============================================================================
+//      CHUNKED BUFFER COMPRESSION
+// =============================================================================
+
+
+void SaveBufferToFile( ofstream& OutputFile, const void* Buffer )
 {
     LOG( "Compressing state file" );
     
-    // determine buffer size
-    unsigned SavestateSize = GetSavestateSize();
-    unsigned CompressedSize = 0;
-    unsigned SavedSize = 0;
+    SavestateFileHeader Header;
+    memcpy( Header.Signature, SavestateSignature, sizeof(SavestateSignature) );
+    Header.Version = SavestateVersion;
+    Header.StateSize = GetSavestateSize();
+    Header.ChunkSize = SavestateChunkSize;
+    Header.NumberOfChunks = (Header.StateSize + SavestateChunkSize - 1) / SavestateChunkSize;
     
-    uint8_t QuantityByte = 0;
-    uint8_t* CurrentByteRead = (uint8_t*)Buffer;
-    uint8_t CurrentValue = *CurrentByteRead;
+    // compress all chunks
+    vector< vector< uint8_t > > Chunks( Header.NumberOfChunks );
+    vector< uint32_t > CompressedSizes( Header.NumberOfChunks );
     
-    while( CompressedSize < SavestateSize )
+    ProcessChunksInParallel( Header.NumberOfChunks, [ & ]( unsigned ChunkNumber )
     {
-        bool ValueRepeats = (*CurrentByteRead == CurrentValue);
+        uint32_t Offset = ChunkNumber * Header.ChunkSize;
+        uint32_t Size = min( Header.ChunkSize, Header.StateSize - Offset );
+        vector< uint8_t >& Chunk = Chunks[ ChunkNumber ];
         
-        if( ValueRepeats )
-        {
-            // add 1 to the current pair
-            QuantityByte++;
-        }
-        
-        if( !ValueRepeats || QuantityByte == 255 )
-        {
-            // output previous pair
-            OutputFile << QuantityByte;
-            OutputFile << CurrentValue;
-            SavedSize += QuantityByte;
-            
-            // restart for next pair
-            QuantityByte = (QuantityByte == 255? 0 : 1);
-            CurrentValue = *CurrentByteRead;
-        }
-        
-        CurrentByteRead++;
-        CompressedSize++;
+        Chunk.resize( GetMaximumCompressedSize( Size ) );
+        CompressedSizes[ ChunkNumber ] = CompressBlock( (const uint8_t*)Buffer + Offset, Size, Chunk.data() );
+    });
+    
+    // write the file
+    OutputFile.write( (const char*)&Header, sizeof(Header) );
+    OutputFile.write( (const char*)CompressedSizes.data(), Header.NumberOfChunks * sizeof(uint32_t) );
+    
+    for( unsigned ChunkNumber = 0; ChunkNumber < Header.NumberOfChunks; ChunkNumber++ )
+      OutputFile.write( (const char*)Chunks[ ChunkNumber ].data(), CompressedSizes[ ChunkNumber ] );
+    
+    if( !OutputFile.good() )
+      THROW( "Cannot write to output file" );
+}
+
+// -----------------------------------------------------------------------------
+
+// returns false if the file has no header, and
+// leaves it at the start to be read as RLE
+bool LoadBufferFromFile( ifstream& InputFile, void* Buffer )
+{
+    SavestateFileHeader Header;
+    InputFile.read( (char*)&Header, sizeof(Header) );
+    
+    if( !InputFile.good() || memcmp( Header.Signature, SavestateSignature, sizeof(SavestateSignature) ) )
+    {
+        InputFile.clear();
+        InputFile.seekg( 0 );
+        return false;
     }
     
-    // output last pair if needed
-    if( SavedSize < CompressedSize )
+    LOG( "Decompressing state file" );
+    
+    if( Header.Version != SavestateVersion )
+      THROW( "State file version is not supported" );
+    
+    // determine the actual savestate size for this game
+    if( Header.StateSize != GetSavestateSize() )
+      THROW( "Decompressed file size is not correct" );
+    
+    if( Header.ChunkSize == 0 || Header.NumberOfChunks != (Header.StateSize + Header.ChunkSize - 1) / Header.ChunkSize )
+      THROW( "Compressed file is corrupt" );
+    
+    // read the chunk sizes and find where each chunk starts
+    vector< uint32_t > CompressedSizes( Header.NumberOfChunks );
+    InputFile.read( (char*)CompressedSizes.data(), Header.NumberOfChunks * sizeof(uint32_t) );
+    
+    if( !InputFile.good() )
+      THROW( "Compressed file is corrupt" );
+    
+    vector< size_t > ChunkPositions( Header.NumberOfChunks );
+    size_t TotalCompressedSize = 0;
+    
+    for( unsigned ChunkNumber = 0; ChunkNumber < Header.NumberOfChunks; ChunkNumber++ )
     {
-        OutputFile << QuantityByte;
-        OutputFile << CurrentValue;
+        if( CompressedSizes[ ChunkNumber ] > GetMaximumCompressedSize( Header.ChunkSize ) )
+          THROW( "Compressed file is corrupt" );
+        
+        ChunkPositions[ ChunkNumber ] = TotalCompressedSize;
+        TotalCompressedSize += CompressedSizes[ ChunkNumber ];
     }
+    
+    // read all chunks
+    vector< uint8_t > CompressedData( TotalCompressedSize );
+    InputFile.read( (char*)CompressedData.data(), TotalCompressedSize );
+    
+    if( !InputFile.good() )
+      THROW( "Compressed file is corrupt" );
+    
+    // decompress them directly into the buffer
+    atomic< bool > ChunksAreValid( true );
+    
+    ProcessChunksInParallel( Header.NumberOfChunks, [ & ]( unsigned ChunkNumber )
+    {
+        uint32_t Offset = ChunkNumber * Header.ChunkSize;
+        uint32_t Size = min( Header.ChunkSize, Header.StateSize - Offset );
+        const uint8_t* Chunk = CompressedData.data() + ChunkPositions[ ChunkNumber ];
+        
+        if( !DecompressBlock( Chunk, CompressedSizes[ ChunkNumber ], (uint8_t*)Buffer + Offset, Size ) )
+          ChunksAreValid = false;
+    });
+    
+    if( !ChunksAreValid )
+      THROW( "Compressed file is corrupt" );
+    
+    return true;
 }
 
-// -----------------------------------------------------------------------------
+
+// =============================================================================
+//      RLE BUFFER DECOMPRESSION (OLDER STATE FILES)
+// =============================================================================
+
 
 void LoadBufferFromRLEFile( ifstream& InputFile, void* Buffer )
 {
@@ -397,6 +800,8 @@ void LoadBufferFromRLEFile( ifstream& InputFile, void* Buffer )
 }
 
 
+
+
 // =============================================================================
 //      LOAD/SAVE CONSOLE STATE TO A FILE
 // =============================================================================
@@ -418,7 +823,7 @@ void SaveState( const string& FileName )
       THROW( "Cannot open output file" );
     
     // save and compress the console state into that file
-    SaveBufferToRLEFile( OutputFile, StateBuffer.get() );
+    SaveBufferToFile( OutputFile, StateBuffer.get() );
     OutputFile.close();
 }
 
@@ -435,9 +840,12 @@ void LoadState( const string& FileName )
     if( !InputFile.good() )
       THROW( "Cannot open input file" );
     
-    // load and decompressed the console state from that file
+    // load and decompress the console state from that file
     unique_ptr< ConsoleState > StateBuffer( new ConsoleState );
-    LoadBufferFromRLEFile( InputFile, StateBuffer.get() );
+    
+    if( !LoadBufferFromFile( InputFile, StateBuffer.get() ) )
+      LoadBufferFromRLEFile( InputFile, StateBuffer.get() );
+    
     InputFile.close();
     
     // load the state from the buffer into the console
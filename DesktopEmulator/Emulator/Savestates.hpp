@@ -12,6 +12,8 @@
     
     // include C/C++ headers
     #include <string>         // [ C++ STL ] Strings
+    #include <memory>         // [ C++ STL ] Dynamic memory
+    #include <vector>         // [ C++ STL ] Vectors
 // *****************************************************************************
 
 
@@ -175,6 +177,69 @@ void SaveState( const std::string& FileName );
 void LoadState( const std::string& FileName );
 
 
+// =============================================================================
+//      INCREMENTAL SNAPSHOTS
+// =============================================================================
+
+
+// a part of a console state, in bytes from its start
+typedef struct
+{
+    unsigned Offset;
+    unsigned Size;
+}
+StateRange;
+
+// -----------------------------------------------------------------------------
+
+// a console state kept in memory, meant for frequent use;
+// after the first capture, capturing again or restoring
+// it only copies the RAM pages and texture regions that
+// were modified in between (other parts are small)
+class IncrementalSnapshot
+{
+    private:
+    
+        std::unique_ptr< ConsoleState > State;
+        bool HasState;
+        
+        // internal functions
+        void AddCopiedRange( const void* Start, unsigned Size );
+        void FindCopiedRanges( bool OnlyModified );
+    
+    public:
+    
+        // amounts copied in the last capture or restore
+        unsigned CopiedRAMPages;
+        unsigned CopiedTextures;
+        
+        // parts of the state copied in the last capture
+        std::vector< StateRange > CopiedRanges;
+        
+    public:
+    
+        // instance handling
+        IncrementalSnapshot();
+       ~IncrementalSnapshot();
+        
+        // the snapshot cannot be duplicated
+        IncrementalSnapshot( const IncrementalSnapshot& ) = delete;
+        IncrementalSnapshot& operator=( const IncrementalSnapshot& ) = delete;
+        
+        // load/save from the console
+        void Capture();
+        void Restore();
+        
+        // returns null until the first capture
+        const ConsoleState* GetState();
+        
+        // overwrites a part of the captured state; the console
+        // will consider that part as modified, so that the next
+        // restore will rewrite it
+        void WriteState( const StateRange& Range, const void* Source );
+};
+
+
 // *****************************************************************************
     // end include guard
     #endif
@@ -382,6 +382,16 @@ void SetDefaultSettings()
     // audio configuration
     Audio.SetMute( false );
     Audio.SetOutputVolume( 1.0 );
+    Audio.SetTargetLatency( DEFAULT_LATENCY_MILLISECONDS );
+    
+    // frames are paced by audio playback
+    Emulator.SetFramePacing( FramePacingModes::AudioClocked );
+    
+    // rewind is enabled
+    Emulator.SetRewindMemory( DEFAULT_REWIND_MEGABYTES );
+    
+    // run-ahead is disabled
+    Emulator.SetRunAheadFrames( 0 );
     
     // unloaded cartridge
     Console.UnloadCartridge();
@@ -498,12 +508,52 @@ void LoadSettings( const string& FilePath )
         Audio.SetMute( Mute );
         Audio.SetOutputVolume( Volume / 100.0 );
         
-        // load audio buffers settings
-        XMLElement* AudioBuffersElement = GetRequiredElement( SettingsRoot, "audio-buffers" );
-        int NumberOfBuffers = GetRequiredIntegerAttribute( AudioBuffersElement, "number" );
+        // load audio latency settings (optional; older
+        // versions had a number of frame buffers instead)
+        XMLElement* AudioLatencyElement = SettingsRoot->FirstChildElement( "audio-latency" );
+        
+        if( AudioLatencyElement )
+          Audio.SetTargetLatency( GetRequiredIntegerAttribute( AudioLatencyElement, "milliseconds" ) );
+        
+        // load frame pacing settings (optional)
+        XMLElement* FramePacingElement = SettingsRoot->FirstChildElement( "frame-pacing" );
+        
+        if( FramePacingElement )
+        {
+            string PacingMode = ToLowerCase( GetRequiredStringAttribute( FramePacingElement, "mode" ) );
+            
+            if( PacingMode == "audio" )
+              Emulator.SetFramePacing( FramePacingModes::AudioClocked );
+            
+            else if( PacingMode == "vsync" )
+              Emulator.SetFramePacing( FramePacingModes::VsyncClocked );
+            
+            else if( PacingMode == "unlocked" )
+              Emulator.SetFramePacing( FramePacingModes::Unlocked );
+            
+            else
+              THROW( "Frame pacing mode must be one of: 'audio', 'vsync' or 'unlocked'" );
+        }
         
-        // apply audio buffers settings
-        Audio.SetLatencyFrames( NumberOfBuffers );
+        // load rewind settings (optional)
+        XMLElement* RewindElement = SettingsRoot->FirstChildElement( "rewind" );
+        
+        if( RewindElement )
+        {
+            int RewindMegabytes = GetRequiredIntegerAttribute( RewindElement, "megabytes" );
+            Clamp( RewindMegabytes, 0, 1024 );
+            Emulator.SetRewindMemory( RewindMegabytes );
+        }
+        
+        // load run-ahead settings (optional)
+        XMLElement* RunAheadElement = SettingsRoot->FirstChildElement( "run-ahead" );
+        
+        if( RunAheadElement )
+        {
+            int RunAheadFrames = GetRequiredIntegerAttribute( RunAheadElement, "frames" );
+            Clamp( RunAheadFrames, 0, MAX_RUN_AHEAD_FRAMES );
+            Emulator.SetRunAheadFrames( RunAheadFrames );
+        }
         
         // configure gamepads
         for( int Gamepad = 0; Gamepad < Constants::GamepadPorts; Gamepad++ )
@@ -692,10 +742,31 @@ void SaveSettings( const string& FilePath )
         AudioElement->SetAttribute( "volume", (unsigned)(100.0 * Audio.GetOutputVolume()) );
         SettingsRoot->LinkEndChild( AudioElement );
         
-        // save audio buffers settings
-        XMLElement* AudioBuffersElement = CreatedDoc.NewElement( "audio-buffers" );
-        AudioBuffersElement->SetAttribute( "number", Audio.GetLatencyFrames() );
-        SettingsRoot->LinkEndChild( AudioBuffersElement );
+        // save audio latency settings
+        XMLElement* AudioLatencyElement = CreatedDoc.NewElement( "audio-latency" );
+        AudioLatencyElement->SetAttribute( "milliseconds", Audio.GetTargetLatency() );
+        SettingsRoot->LinkEndChild( AudioLatencyElement );
+        
+        // save frame pacing
+        XMLElement* FramePacingElement = CreatedDoc.NewElement( "frame-pacing" );
+        SettingsRoot->LinkEndChild( FramePacingElement );
+        
+        if( Emulator.GetFramePacing() == FramePacingModes::VsyncClocked )
+          FramePacingElement->SetAttribute( "mode", "vsync" );
+        else if( Emulator.GetFramePacing() == FramePacingModes::Unlocked )
+          FramePacingElement->SetAttribute( "mode", "unlocked" );
+        else
+          FramePacingElement->SetAttribute( "mode", "audio" );
+        
+        // save rewind settings
+        XMLElement* RewindElement = CreatedDoc.NewElement( "rewind" );
+        RewindElement->SetAttribute( "megabytes", Emulator.GetRewindMemory() );
+        SettingsRoot->LinkEndChild( RewindElement );
+        
+        // save run-ahead settings
+        XMLElement* RunAheadElement = CreatedDoc.NewElement( "run-ahead" );
+        RunAheadElement->SetAttribute( "frames", Emulator.GetRunAheadFrames() );
+        SettingsRoot->LinkEndChild( RunAheadElement );
         
         // save gamepad profiles
         for( int Gamepad = 0; Gamepad < Constants::GamepadPorts; Gamepad++ )
@@ -201,13 +201,6 @@ void Texture::Draw( int RenderXMin, int RenderYMin, int RenderXMax, int RenderYM
     if( !TextureID )
       return;
     
-    // we must render any pending quads before
-    // applying any new render configurations
-    Video.RenderQuadQueue();
-    
-    // select current texture
-    glBindTexture( GL_TEXTURE_2D, TextureID );
-    
     // calculate proportions of the image within the texture
     float XFactor = (float)ImageWidth/TextureWidth;
     float YFactor = (float)ImageHeight/TextureHeight;
@@ -224,11 +217,7 @@ void Texture::Draw( int RenderXMin, int RenderYMin, int RenderXMax, int RenderYM
         }
     };
     
-    // draw rectangle defined as a separate quad,
-    // since we use different render configuration
-    Video.AddQuadToQueue( DrawnQuad );
-    Video.RenderQuadQueue();
-    
-    // deselect texture
-    glBindTexture( GL_TEXTURE_2D, 0 );
+    // queue the quad using our own texture instead
+    // of the one selected by the console
+    Video.AddQuadToQueue( DrawnQuad, TextureID );
 }
@@ -9,6 +9,10 @@
     // include emulator headers
     #include "VideoOutput.hpp"
     
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    
     // declare used namespaces
     using namespace std;
     using namespace V32;
@@ -82,7 +86,11 @@ const string VertexShaderCode =
     "#version 100                                                                               \n"
     "                                                                                           \n"
     "attribute vec4 VertexInfo;                                                                 \n"
+    "attribute vec4 VertexColor;                                                                \n"
+    "attribute float VertexTextureSlot;                                                         \n"
     "varying highp vec2 TextureCoordinate;                                                      \n"
+    "varying mediump vec4 MultiplyColor;                                                        \n"
+    "varying mediump float TextureSlot;                                                         \n"
     "                                                                                           \n"
     "void main()                                                                                \n"
     "{                                                                                          \n"
@@ -101,19 +109,52 @@ const string VertexShaderCode =
     "    // (2) now texture coordinate is just provided as is to the fragment shader            \n"
     "    // (it is only needed here because fragment shaders cannot take inputs directly)       \n"
     "    TextureCoordinate = VertexInfo.zw;                                                     \n"
+    "                                                                                           \n"
+    "    // (3) same for the rest of render state stored in the vertex                          \n"
+    "    MultiplyColor = VertexColor;                                                           \n"
+    "    TextureSlot = VertexTextureSlot;                                                       \n"
     "}                                                                                          \n";
 
-const string FragmentShaderCode =
-    "#version 100                                                                    \n"
-    "                                                                                \n"
-    "uniform mediump vec4 MultiplyColor;                                             \n"
-    "uniform sampler2D TextureUnit;                                                  \n"
-    "varying highp vec2 TextureCoordinate;                                           \n"
-    "                                                                                \n"
-    "void main()                                                                     \n"
-    "{                                                                               \n"
-    "    gl_FragColor = MultiplyColor * texture2D( TextureUnit, TextureCoordinate ); \n"
-    "}                                                                               \n";
+// the fragment shader is built for a given number of texture
+// slots; GLSL 100 does not allow indexing samplers with a
+// variable, so the texture unit has to be chosen with ifs
+string FragmentShaderCode( int TextureSlots )
+{
+    string Code =
+        "#version 100                                                                    \n"
+        "                                                                                \n"
+        "varying highp vec2 TextureCoordinate;                                           \n"
+        "varying mediump vec4 MultiplyColor;                                             \n"
+        "varying mediump float TextureSlot;                                              \n";
+    
+    for( int i = 0; i < TextureSlots; i++ )
+      Code += "uniform sampler2D TextureUnit" + to_string( i ) + ";\n";
+    
+    Code +=
+        "                                                                                \n"
+        "void main()                                                                     \n"
+        "{                                                                               \n"
+        "    mediump vec4 TexelColor;                                                    \n";
+    
+    for( int i = 0; i < TextureSlots - 1; i++ )
+    {
+        Code += (i == 0? "    if" : "    else if");
+        Code += "( TextureSlot < " + to_string( i ) + ".5 )\n";
+        Code += "      TexelColor = texture2D( TextureUnit" + to_string( i ) + ", TextureCoordinate );\n";
+    }
+    
+    if( TextureSlots > 1 )
+      Code += "    else\n  ";
+    
+    Code += "    TexelColor = texture2D( TextureUnit" + to_string( TextureSlots - 1 ) + ", TextureCoordinate );\n";
+    
+    Code +=
+        "                                                                                \n"
+        "    gl_FragColor = MultiplyColor * TexelColor;                                  \n"
+        "}                                                                               \n";
+    
+    return Code;
+}
 
 
 // =============================================================================
@@ -142,13 +183,23 @@ VideoOutput::VideoOutput()
     // default values
     SelectedTexture = -1;
     QueuedQuads = 0;
+    RingOffset = 0;
+    UsedSlots = 0;
+    SelectedSlot = -1;
+    
+    // no statistics yet
+    DrawCalls = 0;
+    UploadedBytes = 0;
+    TotalDrawCalls = 0;
+    TotalUploadedBytes = 0;
+    TotalFrames = 0;
     
     // all texture IDs are initially 0
-    BiosTextureID = 0;
+    BiosTexture = ConsoleTexture{ 0, 1, 1, 0 };
     WhiteTextureID = 0;
     
     for( int i = 0; i < Constants::GPUMaximumCartridgeTextures; i++ )
-      CartridgeTextureIDs[ i ] = 0;
+      CartridgeTextures[ i ] = ConsoleTexture{ 0, 1, 1, 0 };
     
     // initialize vertex indices; they are organized
     // assuming each quad will be given as 4 vertices,
@@ -358,7 +409,7 @@ void VideoOutput::CreateFramebuffer()
 
 // -----------------------------------------------------------------------------
 
-bool VideoOutput::CompileShaderProgram()
+bool VideoOutput::CompileShaderProgram( int Variant )
 {
     GLuint VertexShaderID = 0;
     GLuint FragmentShaderID = 0;
@@ -395,7 +446,8 @@ bool VideoOutput::CompileShaderProgram()
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     // PART 2: Compile our fragment shader
     FragmentShaderID = glCreateShader( GL_FRAGMENT_SHADER );
-    const char *FragmentShaderPointer = FragmentShaderCode.c_str();
+    string FragmentShaderVariantCode = FragmentShaderCode( 1 << Variant );
+    const char *FragmentShaderPointer = FragmentShaderVariantCode.c_str();
     glShaderSource( FragmentShaderID, 1, &FragmentShaderPointer, nullptr );
     glCompileShader( FragmentShaderID );
     glGetShaderiv( FragmentShaderID, GL_COMPILE_STATUS, &Success );
@@ -421,9 +473,13 @@ bool VideoOutput::CompileShaderProgram()
     
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     // PART 3: Link our compiled shaders to form a GLSL program
-    ShaderProgramID = glCreateProgram();
+    // (all variants must place vertex attributes at the same positions)
+    GLuint ShaderProgramID = glCreateProgram();
     glAttachShader( ShaderProgramID, VertexShaderID );
     glAttachShader( ShaderProgramID, FragmentShaderID );
+    glBindAttribLocation( ShaderProgramID, VertexInfoLocation, "VertexInfo" );
+    glBindAttribLocation( ShaderProgramID, VertexColorLocation, "VertexColor" );
+    glBindAttribLocation( ShaderProgramID, TextureSlotLocation, "VertexTextureSlot" );
     glLinkProgram( ShaderProgramID );
     
     glGetProgramiv( ShaderProgramID, GL_LINK_STATUS, &Success );
@@ -452,6 +508,17 @@ bool VideoOutput::CompileShaderProgram()
     glDeleteShader( VertexShaderID );
     glDeleteShader( FragmentShaderID );
     
+    // tell the GPU which of its texture processors
+    // to use for each of the texture slots
+    glUseProgram( ShaderProgramID );
+    
+    for( int i = 0; i < (1 << Variant); i++ )
+    {
+        string UniformName = "TextureUnit" + to_string( i );
+        glUniform1i( glGetUniformLocation( ShaderProgramID, UniformName.c_str() ), i );
+    }
+    
+    ShaderProgramIDs[ Variant ] = ShaderProgramID;
     return true;
 }
 
@@ -462,21 +529,18 @@ void VideoOutput::InitRendering()
     LOG( "Initializing rendering" );
     ClearOpenGLErrors();
     
-    // compile our shader program
-    LOG( "Compiling GLSL shader program" );
+    // choose the position for all our input variables within the shader programs
+    VertexInfoLocation = 0;
+    VertexColorLocation = 1;
+    TextureSlotLocation = 2;
     
-    if( !CompileShaderProgram() )
-      THROW( "Cannot compile GLSL shader program" );
+    // compile our shader programs; each variant can
+    // use twice the texture slots of the previous one
+    LOG( "Compiling GLSL shader programs" );
     
-    // now we can enable our program
-    glUseProgram( ShaderProgramID );
-    
-    // find the position for all our input variables within the shader program
-    VertexInfoLocation = glGetAttribLocation( ShaderProgramID, "VertexInfo" );
-    
-    // find the position for all our input uniforms within the shader program
-    TextureUnitLocation = glGetUniformLocation( ShaderProgramID, "TextureUnit" );
-    MultiplyColorLocation = glGetUniformLocation( ShaderProgramID, "MultiplyColor" );
+    for( int i = 0; i < SHADER_VARIANTS; i++ )
+      if( !CompileShaderProgram( i ) )
+        THROW( "Cannot compile GLSL shader program" );
     
     // on a core OpenGL profile, we need this since
     // the default VAO is not valid!
@@ -503,29 +567,22 @@ void VideoOutput::InitRendering()
     // create a white texture to draw solid color
     CreateWhiteTexture();
     
-    // allocate memory for vertex info in the GPU
+    // allocate memory for vertex info in the GPU; its
+    // format is given on each render, since quad groups
+    // start at different positions within the buffer
     glBindBuffer( GL_ARRAY_BUFFER, VBOVertexInfo );
     
     glBufferData
     (
         GL_ARRAY_BUFFER,
-        sizeof( QuadVerticesInfo ),
-        QuadVerticesInfo,
+        QUAD_RING_SIZE * 4 * sizeof( QueuedVertex ),
+        nullptr,
         GL_STREAM_DRAW
     );
     
-    // define format for vertex info
-    glVertexAttribPointer
-    (
-        VertexInfoLocation, // location (0-based index) within the shader program
-        4,                  // 4 components per vertex (x,y,tex_x,tex_y)
-        GL_FLOAT,           // each component is of type GLfloat
-        GL_FALSE,           // do not normalize values (convert directly to fixed-point)
-        0,                  // no gap between values (adjacent in memory)
-        (void*)0            // starts at offset 0
-    );
-    
     glEnableVertexAttribArray( VertexInfoLocation );
+    glEnableVertexAttribArray( VertexColorLocation );
+    glEnableVertexAttribArray( TextureSlotLocation );
     
     // allocate memory for vertex indices in the GPU
     // (vertices are given as triangle strip pairs)
@@ -534,7 +591,7 @@ void VideoOutput::InitRendering()
     glBufferData
     (
         GL_ELEMENT_ARRAY_BUFFER,
-        QUAD_QUEUE_SIZE * 6 * sizeof( GLuint ),
+        sizeof( VertexIndices ),
         VertexIndices,
         GL_STATIC_DRAW
     );
@@ -585,23 +642,35 @@ void VideoOutput::CreateWhiteTexture()
 
 void VideoOutput::Destroy()
 {
+    // report average render statistics
+    if( TotalFrames > 0 )
+    {
+        LOG( "Average draw calls per frame: " + to_string( TotalDrawCalls / TotalFrames ) );
+        LOG( "Average bytes uploaded per frame: " + to_string( TotalUploadedBytes / TotalFrames ) );
+        TotalFrames = 0;
+    }
+    
     // release all textures
     if( OpenGLContext )
     {
-        UnloadTexture( BiosTextureID );
-        UnloadTexture( WhiteTextureID );
+        UnloadTexture( -1 );
+        glDeleteTextures( 1, &WhiteTextureID );
         
         for( int i = 0; i < Constants::GPUMaximumCartridgeTextures; i++ )
-          if( CartridgeTextureIDs[ i ] != 0 )
-            UnloadTexture( CartridgeTextureIDs[ i ] );
+          if( CartridgeTextures[ i ].ID != 0 )
+            UnloadTexture( i );
     }
     
     // destroy in reverse order
+    // (the destructor calls this again)
     if( OpenGLContext )
       SDL_GL_DeleteContext( OpenGLContext );
     
     if( Window )
       SDL_DestroyWindow( Window );
+    
+    OpenGLContext = nullptr;
+    Window = nullptr;
 }
 
 
@@ -693,6 +762,9 @@ float VideoOutput::GetRelativeWindowWidth()
 
 void VideoOutput::RenderToScreen()
 {
+    // queued quads belong to the previous target
+    RenderQuadQueue();
+    
     // select the actual screen as the render target
     glBindFramebuffer( GL_FRAMEBUFFER, 0 );
     
@@ -704,6 +776,9 @@ void VideoOutput::RenderToScreen()
 
 void VideoOutput::RenderToFramebuffer()
 {
+    // queued quads belong to the previous target
+    RenderQuadQueue();
+    
     // select framebuffer as the render target
     glBindFramebuffer( GL_FRAMEBUFFER, FramebufferID );
     
@@ -739,23 +814,15 @@ void VideoOutput::BeginFrame()
     glEnable( GL_BLEND );
     SelectTexture( SelectedTexture );
     SetBlendingMode( BlendingMode );
-    SetMultiplyColor( MultiplyColor );
-    
-    // tell the GPU which of its texture processors to use
-    glUniform1i( TextureUnitLocation, 0 );  // texture unit 0 is for decal textures
-    
-    // define storage and format for vertex info
-    glVertexAttribPointer
-    (
-        VertexInfoLocation, // location (0-based index) within the shader program
-        4,                  // 4 components per vertex (x,y,tex_x,tex_y)
-        GL_FLOAT,           // each component is of type GLfloat
-        GL_FALSE,           // do not normalize values (convert directly to fixed-point)
-        0,                  // no gap between values (adjacent in memory)
-        (void*)0            // starts at offset 0
-    );
     
     glEnableVertexAttribArray( VertexInfoLocation );
+    glEnableVertexAttribArray( VertexColorLocation );
+    glEnableVertexAttribArray( TextureSlotLocation );
+    
+    // start counting for the new frame
+    DrawCalls = 0;
+    UploadedBytes = 0;
+    TotalFrames++;
 }
 
 
@@ -766,21 +833,9 @@ void VideoOutput::BeginFrame()
 
 void VideoOutput::SetMultiplyColor( GPUColor NewMultiplyColor )
 {
-    // we must render any pending quads before
-    // applying any new render configurations
-    RenderQuadQueue();
-    
+    // no need to render pending quads: the
+    // color is stored in each queued vertex
     MultiplyColor = NewMultiplyColor;
-    
-    // send our multiply color to the GPU
-    glUniform4f
-    (
-        MultiplyColorLocation,      // location (0-based index) within the shader program
-        MultiplyColor.R / 255.0,    // the 4 color components (RGBA) in range [0.0-1.0]
-        MultiplyColor.G / 255.0,
-        MultiplyColor.B / 255.0,
-        MultiplyColor.A / 255.0
-    );
 }
 
 // -----------------------------------------------------------------------------
@@ -804,12 +859,12 @@ void VideoOutput::SetBlendingMode( IOPortValues NewBlendingMode )
             glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
             glBlendEquation( GL_FUNC_ADD );
             break;
-            
+        
         case IOPortValues::GPUBlendingMode_Add:
             glBlendFunc( GL_SRC_ALPHA, GL_ONE );
             glBlendEquation( GL_FUNC_ADD );
             break;
-            
+        
         case IOPortValues::GPUBlendingMode_Subtract:
             glBlendFunc( GL_SRC_ALPHA, GL_ONE );
             glBlendEquation( GL_FUNC_REVERSE_SUBTRACT );
@@ -836,11 +891,40 @@ IOPortValues VideoOutput::GetBlendingMode()
 // =============================================================================
 
 
-void VideoOutput::AddQuadToQueue( const GPUQuad& Quad )
+// finds the slot for a texture within the current
+// quad group, or adds it if there is still room
+int VideoOutput::GetTextureSlot( GLuint OpenGLTextureID )
+{
+    for( int i = 0; i < UsedSlots; i++ )
+      if( SlotTextureIDs[ i ] == OpenGLTextureID )
+        return i;
+    
+    // when all texture units are in use
+    // the current group has to be rendered
+    if( UsedSlots >= TEXTURE_SLOTS )
+      RenderQuadQueue();
+    
+    SlotTextureIDs[ UsedSlots ] = OpenGLTextureID;
+    return UsedSlots++;
+}
+
+// -----------------------------------------------------------------------------
+
+void VideoOutput::QueueQuad( const GPUQuad& Quad, int Slot, GPUColor Color, GLfloat ScaleX, GLfloat ScaleY )
 {
-    // copy information from the received GPU quad
-    const int SizePerQuad = 16 * sizeof( float );
-    memcpy( &QuadVerticesInfo[ QueuedQuads * 16 ], &Quad.Vertices, SizePerQuad );
+    // copy information from the received GPU quad,
+    // adding the render state that applies to it
+    QueuedVertex* Vertices = &QueuedVertices[ QueuedQuads * 4 ];
+    
+    for( int i = 0; i < 4; i++ )
+    {
+        Vertices[ i ].x = Quad.Vertices[ i ].x;
+        Vertices[ i ].y = Quad.Vertices[ i ].y;
+        Vertices[ i ].texture_x = Quad.Vertices[ i ].texture_x * ScaleX;
+        Vertices[ i ].texture_y = Quad.Vertices[ i ].texture_y * ScaleY;
+        Vertices[ i ].MultiplyColor = Color;
+        Vertices[ i ].TextureSlot = Slot;
+    }
     
     // update the queue
     QueuedQuads++;
@@ -852,27 +936,127 @@ void VideoOutput::AddQuadToQueue( const GPUQuad& Quad )
 
 // -----------------------------------------------------------------------------
 
+void VideoOutput::AddQuadToQueue( const GPUQuad& Quad )
+{
+    ConsoleTexture& Texture = GetConsoleTexture( SelectedTexture );
+    
+    // the slot is only searched for the
+    // first quad after a texture change
+    if( SelectedSlot < 0 )
+      SelectedSlot = GetTextureSlot( Texture.ID );
+    
+    QueueQuad( Quad, SelectedSlot, MultiplyColor, Texture.ScaleX, Texture.ScaleY );
+}
+
+// -----------------------------------------------------------------------------
+
+// used to draw textures not belonging to the console
+void VideoOutput::AddQuadToQueue( const GPUQuad& Quad, GLuint OpenGLTextureID )
+{
+    int Slot = GetTextureSlot( OpenGLTextureID );
+    QueueQuad( Quad, Slot, MultiplyColor );
+}
+
+// -----------------------------------------------------------------------------
+
 void VideoOutput::RenderQuadQueue()
 {
     if( QueuedQuads == 0 ) return;
     
+    // bind each used texture to its texture unit,
+    // leaving unit 0 active for other texture uses
+    for( int i = UsedSlots - 1; i >= 0; i-- )
+    {
+        glActiveTexture( GL_TEXTURE0 + i );
+        glBindTexture( GL_TEXTURE_2D, SlotTextureIDs[ i ] );
+    }
+    
+    // choose the cheapest shader variant that can
+    // read from all textures used in this group
+    int Variant = 0;
+    
+    while( (1 << Variant) < UsedSlots )
+      Variant++;
+    
+    glUseProgram( ShaderProgramIDs[ Variant ] );
+    
     // send attributes (i.e. shader input variables)
     glBindBuffer( GL_ARRAY_BUFFER, VBOVertexInfo );
-
-    // send updated vertex info to the GPU; note that
-    // we would normally not update the whole buffer
-    // every time, but some mobile GPUs have a bug
-    // which causes very low performance on partial
-    // GPU buffer updates
-    glBufferSubData
+    int GroupBytes = QueuedQuads * 4 * sizeof( QueuedVertex );
+    int GroupOffset = 0;
+    
+    #ifdef __arm__
+      // some mobile GPUs have a bug which causes
+      // very low performance on partial GPU buffer
+      // updates, so we replace the whole buffer
+      glBufferData( GL_ARRAY_BUFFER, GroupBytes, QueuedVertices, GL_STREAM_DRAW );
+    #else
+      // when the buffer is full, reallocate it so that
+      // the GPU can keep using the old storage for the
+      // groups that it has not drawn yet
+      const int RingBytes = QUAD_RING_SIZE * 4 * sizeof( QueuedVertex );
+      
+      if( RingOffset + GroupBytes > RingBytes )
+      {
+          glBufferData( GL_ARRAY_BUFFER, RingBytes, nullptr, GL_STREAM_DRAW );
+          RingOffset = 0;
+      }
+      
+      // the written range is never used by previous groups,
+      // so there is no need to wait for the GPU to finish
+      void* BufferRange = glMapBufferRange
+      (
+          GL_ARRAY_BUFFER,
+          RingOffset,
+          GroupBytes,
+          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+      );
+      
+      if( BufferRange )
+      {
+          memcpy( BufferRange, QueuedVertices, GroupBytes );
+          glUnmapBuffer( GL_ARRAY_BUFFER );
+      }
+      
+      else
+        glBufferSubData( GL_ARRAY_BUFFER, RingOffset, GroupBytes, QueuedVertices );
+      
+      GroupOffset = RingOffset;
+      RingOffset += GroupBytes;
+    #endif
+    
+    // define format for vertex info, starting at this group
+    glVertexAttribPointer
     (
-        GL_ARRAY_BUFFER,
-        0,
-        sizeof( QuadVerticesInfo ),
-        QuadVerticesInfo
+        VertexInfoLocation,                             // location (0-based index) within the shader program
+        4,                                              // 4 components per vertex (x,y,tex_x,tex_y)
+        GL_FLOAT,                                       // each component is of type GLfloat
+        GL_FALSE,                                       // do not normalize values (convert directly to fixed-point)
+        sizeof( QueuedVertex ),                         // distance between consecutive vertices
+        (void*)(intptr_t)GroupOffset                    // starts at the group's first vertex
+    );
+    
+    glVertexAttribPointer
+    (
+        VertexColorLocation,                            // location (0-based index) within the shader program
+        4,                                              // 4 components per vertex (RGBA)
+        GL_UNSIGNED_BYTE,                               // each component is a byte
+        GL_TRUE,                                        // normalize values to range [0.0-1.0]
+        sizeof( QueuedVertex ),                         // distance between consecutive vertices
+        (void*)(intptr_t)(GroupOffset + 16)             // after the 4 floats
     );
     
-    // draw the quad as 2 triangles
+    glVertexAttribPointer
+    (
+        TextureSlotLocation,                            // location (0-based index) within the shader program
+        1,                                              // 1 component per vertex
+        GL_UNSIGNED_BYTE,                               // the slot is a byte
+        GL_FALSE,                                       // do not normalize values (keep slot number)
+        sizeof( QueuedVertex ),                         // distance between consecutive vertices
+        (void*)(intptr_t)(GroupOffset + 20)             // after the multiply color
+    );
+    
+    // draw the quads as 2 triangles each
     glDrawElements
     (
         GL_TRIANGLES,         // independent triangles
@@ -881,21 +1065,22 @@ void VideoOutput::RenderQuadQueue()
         (void*)0              // starts at offset 0
     );
     
-    // reset the queue
+    // update statistics
+    DrawCalls++;
+    UploadedBytes += GroupBytes;
+    TotalDrawCalls++;
+    TotalUploadedBytes += GroupBytes;
+    
+    // reset the queue and its texture slots
     QueuedQuads = 0;
+    UsedSlots = 0;
+    SelectedSlot = -1;
 }
 
 // -----------------------------------------------------------------------------
 
 void VideoOutput::ClearScreen( GPUColor ClearColor )
 {
-    // temporarily replace multiply color with clear color
-    GPUColor PreviousMultiplyColor = MultiplyColor;
-    SetMultiplyColor( ClearColor );
-    
-    // bind white texture
-    glBindTexture( GL_TEXTURE_2D, WhiteTextureID );
-    
     // set a full-screen quad with the same texture pixel
     const GPUQuad ScreenQuad =
     {
@@ -908,14 +1093,24 @@ void VideoOutput::ClearScreen( GPUColor ClearColor )
         }
     };
     
-    // draw this quad separately, since we are
-    // using different render configurations
-    AddQuadToQueue( ScreenQuad );
-    RenderQuadQueue();
-    
-    // restore previous multiply color and texture
-    SetMultiplyColor( PreviousMultiplyColor );
-    SelectTexture( SelectedTexture );
+    // the quad is queued like any other, using the
+    // white texture and clear color as its state
+    int Slot = GetTextureSlot( WhiteTextureID );
+    QueueQuad( ScreenQuad, Slot, ClearColor );
+}
+
+// -----------------------------------------------------------------------------
+
+int VideoOutput::GetDrawCalls()
+{
+    return DrawCalls;
+}
+
+// -----------------------------------------------------------------------------
+
+int VideoOutput::GetUploadedBytes()
+{
+    return UploadedBytes;
 }
 
 
@@ -924,19 +1119,93 @@ void VideoOutput::ClearScreen( GPUColor ClearColor )
 // =============================================================================
 
 
-void VideoOutput::LoadTexture( int GPUTextureID, void* Pixels )
+ConsoleTexture& VideoOutput::GetConsoleTexture( int GPUTextureID )
 {
-    GLuint* OpenGLTextureID = &BiosTextureID;
-    
     if( GPUTextureID >= 0 )
-      OpenGLTextureID = &CartridgeTextureIDs[ GPUTextureID ];
+      return CartridgeTextures[ GPUTextureID ];
+    
+    return BiosTexture;
+}
+
+// -----------------------------------------------------------------------------
+
+// the OpenGL texture is only as large as the image
+// (rounded to a power of 2, so that scaled texture
+// coordinates are exact); pixels outside the image
+// must still be transparent, so on OpenGL ES where
+// border clamping is not available we leave at least
+// 1 transparent row and column for clamping
+void GetTextureSize( int Width, int Height, int& TextureWidth, int& TextureHeight )
+{
+    #ifdef __arm__
+      TextureWidth  = min( NextPowerOf2( Width  + 1 ), (unsigned)Constants::GPUTextureSize );
+      TextureHeight = min( NextPowerOf2( Height + 1 ), (unsigned)Constants::GPUTextureSize );
+    #else
+      TextureWidth  = NextPowerOf2( Width  );
+      TextureHeight = NextPowerOf2( Height );
+    #endif
+}
+
+// -----------------------------------------------------------------------------
+
+void PadTexturePixels( const void* Pixels, int Width, int Height, int TextureWidth, int TextureHeight, vector< GPUColor >& PaddedPixels )
+{
+    PaddedPixels.assign( TextureWidth * TextureHeight, GPUColor{ 0, 0, 0, 0 } );
+    const GPUColor* ImagePixels = (const GPUColor*)Pixels;
+    
+    for( int y = 0; y < Height; y++ )
+      memcpy( &PaddedPixels[ y * TextureWidth ], &ImagePixels[ y * Width ], Width * sizeof( GPUColor ) );
+}
+
+// -----------------------------------------------------------------------------
+
+// this does not use OpenGL, and only writes to this
+// texture's padded pixels, so it can be called from
+// any thread while other textures are being loaded
+void VideoOutput::PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+{
+    int TextureWidth, TextureHeight;
+    GetTextureSize( Width, Height, TextureWidth, TextureHeight );
+    
+    // other textures are uploaded directly
+    if( TextureWidth != Width || TextureHeight != Height )
+      PadTexturePixels( Pixels, Width, Height, TextureWidth, TextureHeight, PreparedPixels[ GPUTextureID ] );
+}
+
+// -----------------------------------------------------------------------------
+
+void VideoOutput::LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+{
+    // queued quads may use the previous texture
+    RenderQuadQueue();
+    
+    ConsoleTexture& Texture = GetConsoleTexture( GPUTextureID );
+    
+    int TextureWidth, TextureHeight;
+    GetTextureSize( Width, Height, TextureWidth, TextureHeight );
+    
+    // add the transparent area when needed,
+    // unless it was already prepared before
+    vector< GPUColor > PaddedPixels;
+    
+    if( GPUTextureID >= 0 && !PreparedPixels[ GPUTextureID ].empty() )
+    {
+        PaddedPixels.swap( PreparedPixels[ GPUTextureID ] );
+        Pixels = &PaddedPixels[ 0 ];
+    }
+    
+    else if( TextureWidth != Width || TextureHeight != Height )
+    {
+        PadTexturePixels( Pixels, Width, Height, TextureWidth, TextureHeight, PaddedPixels );
+        Pixels = &PaddedPixels[ 0 ];
+    }
     
     // create a new OpenGL texture and select it
-    glGenTextures( 1, OpenGLTextureID );
-    glBindTexture( GL_TEXTURE_2D, *OpenGLTextureID );
+    glGenTextures( 1, &Texture.ID );
+    glBindTexture( GL_TEXTURE_2D, Texture.ID );
     
     // check correct texture ID
-    if( !OpenGLTextureID )
+    if( !Texture.ID )
       THROW( "OpenGL failed to generate a new texture" );
     
     // clear OpenGL errors
@@ -948,8 +1217,8 @@ void VideoOutput::LoadTexture( int GPUTextureID, void* Pixels )
         GL_TEXTURE_2D,              // texture is a 2D rectangle
         0,                          // level of detail (0 = normal size)
         GL_RGBA,                    // color components in the texture
-        Constants::GPUTextureSize,  // texture width in pixels
-        Constants::GPUTextureSize,  // texture height in pixels
+        TextureWidth,               // texture width in pixels
+        TextureHeight,              // texture height in pixels
         0,                          // border width (must be 0 or 1)
         GL_RGBA,                    // color components in the source
         GL_UNSIGNED_BYTE,           // each color component is a byte
@@ -964,39 +1233,51 @@ void VideoOutput::LoadTexture( int GPUTextureID, void* Pixels )
     glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );         
     glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
     
-    // out-of-texture coordinates must clamp, not wrap
-    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    // out-of-texture coordinates must clamp, not wrap; but
+    // a smaller texture must clamp to transparent pixels
+    // as the rest of the full 1024x1024 texture would
+    #ifdef __arm__
+      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    #else
+      const GLfloat TransparentColor[ 4 ] = { 0, 0, 0, 0 };
+      glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, TransparentColor );
+      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (TextureWidth  < Constants::GPUTextureSize)? GL_CLAMP_TO_BORDER : GL_CLAMP_TO_EDGE );
+      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (TextureHeight < Constants::GPUTextureSize)? GL_CLAMP_TO_BORDER : GL_CLAMP_TO_EDGE );
+    #endif
+    
+    // texture coordinates from the console are
+    // relative to the full 1024x1024 texture
+    Texture.ScaleX = (GLfloat)Constants::GPUTextureSize / TextureWidth;
+    Texture.ScaleY = (GLfloat)Constants::GPUTextureSize / TextureHeight;
+    Texture.VideoMemory = TextureWidth * TextureHeight * 4;
 }
 
 // -----------------------------------------------------------------------------
 
 void VideoOutput::UnloadTexture( int GPUTextureID )
 {
-    GLuint* OpenGLTextureID = &BiosTextureID;
+    // queued quads may use this texture
+    RenderQuadQueue();
     
-    if( GPUTextureID >= 0 )
-      OpenGLTextureID = &CartridgeTextureIDs[ GPUTextureID ];
+    ConsoleTexture& Texture = GetConsoleTexture( GPUTextureID );
+    glDeleteTextures( 1, &Texture.ID );
+    Texture = ConsoleTexture{ 0, 1, 1, 0 };
     
-    glDeleteTextures( 1, OpenGLTextureID );
-    *OpenGLTextureID = 0;
+    // discard pixels prepared for a load that failed
+    if( GPUTextureID >= 0 )
+      vector< GPUColor >().swap( PreparedPixels[ GPUTextureID ] );
 }
 
 // -----------------------------------------------------------------------------
 
 void VideoOutput::SelectTexture( int GPUTextureID )
 {
-    // we must render any pending quads before
-    // applying any new render configurations
-    RenderQuadQueue();
-    
+    // no need to render pending quads: the
+    // texture slot is stored in each queued
+    // vertex, and found when a quad is added
     SelectedTexture = GPUTextureID;
-    GLuint* OpenGLTextureID = &BiosTextureID;
-    
-    if( GPUTextureID >= 0 )
-      OpenGLTextureID = &CartridgeTextureIDs[ GPUTextureID ];
-    
-    glBindTexture( GL_TEXTURE_2D, *OpenGLTextureID );
+    SelectedSlot = -1;
 }
 
 // -----------------------------------------------------------------------------
@@ -1005,3 +1286,27 @@ int32_t VideoOutput::GetSelectedTexture()
 {
     return SelectedTexture;
 }
+
+// -----------------------------------------------------------------------------
+
+// logs the video memory used by cartridge textures,
+// compared to uploading all of them at full size
+void VideoOutput::ReportTextureMemory()
+{
+    unsigned UsedMemory = 0;
+    unsigned FullSizeMemory = 0;
+    
+    for( int i = 0; i < Constants::GPUMaximumCartridgeTextures; i++ )
+      if( CartridgeTextures[ i ].ID != 0 )
+      {
+          UsedMemory += CartridgeTextures[ i ].VideoMemory;
+          FullSizeMemory += Constants::GPUTextureSize * Constants::GPUTextureSize * 4;
+      }
+    
+    LOG( "Cartridge textures use " + to_string( UsedMemory / 1024 ) + " KB of video memory ("
+       + to_string( FullSizeMemory / 1024 ) + " KB at full size)" );
+    
+    if( BiosTexture.ID != 0 )
+      LOG( "BIOS texture uses " + to_string( BiosTexture.VideoMemory / 1024 ) + " KB of video memory ("
+         + to_string( Constants::GPUTextureSize * Constants::GPUTextureSize * 4 / 1024 ) + " KB at full size)" );
+}
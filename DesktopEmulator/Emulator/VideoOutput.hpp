@@ -16,13 +16,67 @@
     
     // include OpenGL headers
     #include <glad/glad.h>      // [ OpenGL ] GLAD Loader (already includes <GL/gl.h>)
+    
+    // include C/C++ headers
+    #include <vector>           // [ C++ STL ] Vectors
 // *****************************************************************************
 
 
 // we will render our quads in groups using a
 // fixed size queue; this parameter sets the
 // queue size and acts as group size limit
-#define QUAD_QUEUE_SIZE 20
+#define QUAD_QUEUE_SIZE 2048
+
+// queued groups are streamed to a vertex buffer
+// with space for this many quads; when it is full
+// the buffer is reallocated and filled again
+#define QUAD_RING_SIZE 16384
+
+// number of textures that can be used within a
+// single group (OpenGL ES 2.0 guarantees at least
+// 8 texture units for fragment shaders)
+#define TEXTURE_SLOTS 8
+
+// shaders are compiled for 1, 2, 4 and 8 slots,
+// since reading from more textures is slower
+#define SHADER_VARIANTS 4
+
+
+// =============================================================================
+//      FORMAT OF QUEUED VERTICES
+// =============================================================================
+
+
+// each vertex carries all render state except for
+// the blending mode, so that quads with different
+// textures or colors can still be drawn together
+typedef struct
+{
+    GLfloat x, y, texture_x, texture_y;
+    V32::GPUColor MultiplyColor;
+    GLubyte TextureSlot;
+    GLubyte Padding[ 3 ];
+}
+QueuedVertex;
+
+static_assert( sizeof(QueuedVertex) == 24, "Wrong size for structure QueuedVertex" );
+
+
+// =============================================================================
+//      TEXTURES LOADED FROM THE CONSOLE
+// =============================================================================
+
+
+// each console texture is uploaded with only the size
+// needed for its image, so texture coordinates given
+// for a 1024x1024 texture have to be scaled for it
+typedef struct
+{
+    GLuint ID;
+    GLfloat ScaleX, ScaleY;
+    unsigned VideoMemory;   // in bytes
+}
+ConsoleTexture;
 
 
 // =============================================================================
@@ -45,18 +99,22 @@ class VideoOutput
         bool FullScreen;
         
         // arrays to hold buffer info
-        GLfloat QuadVerticesInfo[ 16 * QUAD_QUEUE_SIZE ];
+        QueuedVertex QueuedVertices[ 4 * QUAD_QUEUE_SIZE ];
         GLushort VertexIndices[ 6 * QUAD_QUEUE_SIZE ];
         
         // current color modifiers
         V32::GPUColor MultiplyColor;
         V32::IOPortValues BlendingMode;
         
-        // OpenGL IDs of loaded textures
-        GLuint BiosTextureID;
-        GLuint CartridgeTextureIDs[ V32::Constants::GPUMaximumCartridgeTextures ];
+        // OpenGL textures loaded from the console
+        ConsoleTexture BiosTexture;
+        ConsoleTexture CartridgeTextures[ V32::Constants::GPUMaximumCartridgeTextures ];
         int32_t SelectedTexture;
         
+        // padded pixels for cartridge textures that
+        // were prepared in advance, before loading
+        std::vector< V32::GPUColor > PreparedPixels[ V32::Constants::GPUMaximumCartridgeTextures ];
+        
         // white texture used to draw solid colors
         GLuint WhiteTextureID;
         
@@ -70,15 +128,35 @@ class VideoOutput
         GLuint VAO;
         GLuint VBOVertexInfo;
         GLuint VBOIndices;
-        GLuint ShaderProgramID;
+        GLuint ShaderProgramIDs[ SHADER_VARIANTS ];
         
         // rendering control for quad groups
         int QueuedQuads;
+        int RingOffset;
+        
+        // textures bound to each unit for the current
+        // group, and slot used by the selected texture
+        GLuint SlotTextureIDs[ TEXTURE_SLOTS ];
+        int UsedSlots;
+        int SelectedSlot;
+        
+        // render statistics, for the current
+        // frame and for the whole session
+        int DrawCalls;
+        int UploadedBytes;
+        uint64_t TotalDrawCalls;
+        uint64_t TotalUploadedBytes;
+        uint64_t TotalFrames;
         
         // positions of shader parameters
         GLuint VertexInfoLocation;
-        GLuint TextureUnitLocation;
-        GLuint MultiplyColorLocation;
+        GLuint VertexColorLocation;
+        GLuint TextureSlotLocation;
+        
+        // internal functions
+        ConsoleTexture& GetConsoleTexture( int GPUTextureID );
+        int GetTextureSlot( GLuint OpenGLTextureID );
+        void QueueQuad( const V32::GPUQuad& Quad, int Slot, V32::GPUColor Color, GLfloat ScaleX = 1, GLfloat ScaleY = 1 );
         
     public:
         
@@ -89,7 +167,7 @@ class VideoOutput
         // init functions
         void CreateOpenGLWindow();
         void CreateFramebuffer();
-        bool CompileShaderProgram();
+        bool CompileShaderProgram( int Variant );
         void CreateWhiteTexture();
         void InitRendering();
         
@@ -123,13 +201,20 @@ class VideoOutput
         // render functions
         void ClearScreen( V32::GPUColor ClearColor );
         void AddQuadToQueue( const V32::GPUQuad& Quad );
+        void AddQuadToQueue( const V32::GPUQuad& Quad, GLuint OpenGLTextureID );
         void RenderQuadQueue();
         
+        // render statistics
+        int GetDrawCalls();
+        int GetUploadedBytes();
+        
         // texture handling
-        void LoadTexture( int GPUTextureID, void* Pixels );
+        void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height );
+        void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height );
         void UnloadTexture( int GPUTextureID );
         void SelectTexture( int GPUTextureID );
         int32_t GetSelectedTexture();
+        void ReportTextureMemory();
 };
 
 
@@ -0,0 +1,514 @@
+// *****************************************************************************
+    // include console logic headers
+    #include "ConsoleLogic/V32Console.hpp"
+    #include "ConsoleLogic/ExternalInterfaces.hpp"
+    #include "ConsoleLogic/GPURecording.hpp"
+    
+    // include infrastructure headers
+    #include "DesktopInfrastructure/FilePaths.hpp"
+    #include "DesktopInfrastructure/Hashing.hpp"
+    #include "DesktopInfrastructure/Logger.hpp"
+    
+    // include project headers
+    #include "Emulator/VideoOutput.hpp"
+    #include "HeadlessEmulator/SoftwareRenderer.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <stdexcept>        // [ C++ STL ] Exceptions
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstdlib>          // [ ANSI C ] Standard library
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      GLOBAL VARIABLES
+// =============================================================================
+
+
+// both renderers are declared first so that
+// the console can still use them on destruction
+VideoOutput Video;
+SoftwareRenderer Renderer;
+
+// the console only loads textures: its CPU never runs
+V32Console Console;
+
+// program options
+bool VerboseMode = false;
+
+
+// =============================================================================
+//      CALLBACKS FOR CONSOLE LOGIC
+// =============================================================================
+
+
+namespace ReplayCallbacks
+{
+    // GPU commands come from the recording instead
+    void ClearScreen( GPUColor ClearColor ) {}
+    void DrawQuad( GPUQuad& Quad ) {}
+    void SetMultiplyColor( GPUColor MultiplyColor ) {}
+    void SetBlendingMode( int BlendingMode ) {}
+    void SelectTexture( int GPUTextureID ) {}
+    
+    // -----------------------------------------------------------------------------
+    
+    // textures are loaded in both renderers
+    void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+    {
+        Video.PrepareTexture( GPUTextureID, Pixels, Width, Height );
+        Renderer.PrepareTexture( GPUTextureID, Pixels, Width, Height );
+    }
+    
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+    {
+        Video.LoadTexture( GPUTextureID, Pixels, Width, Height );
+        Renderer.LoadTexture( GPUTextureID, Pixels, Width, Height );
+    }
+    
+    void UnloadCartridgeTextures()
+    {
+        for( int i = 0; i < Constants::GPUMaximumCartridgeTextures; i++ )
+          Video.UnloadTexture( i );
+        
+        Renderer.UnloadCartridgeTextures();
+    }
+    
+    void UnloadBiosTexture()
+    {
+        Video.UnloadTexture( -1 );
+        Renderer.UnloadBiosTexture();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void LogLine( const string& Message )
+    {
+        if( VerboseMode )
+          cout << Message << endl;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void ThrowException( const string& Message )
+    {
+        throw runtime_error( Message );
+    }
+}
+
+
+// =============================================================================
+//      REPLAY OF RECORDED FRAMES ON VIDEO OUTPUT
+// =============================================================================
+
+
+// same as the one used by the emulator, so that
+// quad groups are broken in the same places
+class VideoOutputReceiver: public GPUCommandReceiver
+{
+    public:
+        
+        void ClearScreen( GPUColor ClearColor )
+        {
+            Video.ClearScreen( ClearColor );
+        }
+        
+        void DrawQuad( const GPUQuad& DrawnQuad )
+        {
+            Video.AddQuadToQueue( DrawnQuad );
+        }
+        
+        void SetMultiplyColor( GPUColor NewMultiplyColor )
+        {
+            Video.SetMultiplyColor( NewMultiplyColor );
+        }
+        
+        void SetBlendingMode( int NewBlendingMode )
+        {
+            if( NewBlendingMode != (int)Video.GetBlendingMode() )
+              Video.SetBlendingMode( (IOPortValues)NewBlendingMode );
+        }
+        
+        void SelectTexture( int GPUTextureID )
+        {
+            Video.SelectTexture( GPUTextureID );
+        }
+};
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+void PrintUsage()
+{
+    cout << "USAGE: Vircon32GLReplay [options] file" << endl;
+    cout << "Draws the frames of a GPU recording (made with Vircon32Headless -record)" << endl;
+    cout << "with OpenGL, as the emulator does, and compares every frame with the" << endl;
+    cout << "software renderer used by Vircon32Headless and Vircon32GPUReplay" << endl;
+    cout << "Options:" << endl;
+    cout << "  --help             Displays this information" << endl;
+    cout << "  -bios <file>       BIOS to take textures from, default is Bios/StandardBios.v32" << endl;
+    cout << "  -cartridge <file>  Cartridge to take textures from (needed if one was recorded)" << endl;
+    cout << "  -loops <n>         Number of times to draw all frames, default is 1" << endl;
+    cout << "  -threads <n>       Number of threads used by the software renderer" << endl;
+    cout << "  -tolerance <n>     Largest accepted difference in a color component, default is 0" << endl;
+    cout << "  -first <n>         First frame included in measurements and comparisons, default is 0" << endl;
+    cout << "  -no-compare        Only draws with OpenGL (for time measurements)" << endl;
+    cout << "  -hashes            Reports a hash of all frames drawn by each renderer" << endl;
+    cout << "  -v                 Displays additional information (verbose)" << endl;
+    cout << "Exit code is 2 when some frame differs more than the tolerance" << endl;
+    cout << "Limits: even with -tolerance 0, OpenGL computes texture coordinates and" << endl;
+    cout << "coverage with float precision. So in scaled or rotated quads, pixels whose" << endl;
+    cout << "texture coordinate is within about 1/100 of a texel from a texel edge may" << endl;
+    cout << "take the neighbor texel, and pixels at the quad edges may differ" << endl;
+}
+
+// -----------------------------------------------------------------------------
+
+string ColorToString( GPUColor Color )
+{
+    return "(" + to_string( Color.R ) + "," + to_string( Color.G ) + "," + to_string( Color.B ) + ")";
+}
+
+// -----------------------------------------------------------------------------
+
+int ParseCount( const vector< string >& Arguments, int& Position, int MinimumValue = 1 )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing number after '" + Option + "'" );
+    
+    // the whole argument must be a number
+    const char* Text = Arguments[ Position ].c_str();
+    char* TextEnd = nullptr;
+    long Value = strtol( Text, &TextEnd, 10 );
+    
+    if( TextEnd == Text || *TextEnd || Value < MinimumValue || Value > INT32_MAX )
+      throw runtime_error( "invalid number after '" + Option + "'" );
+    
+    return (int)Value;
+}
+
+// -----------------------------------------------------------------------------
+
+string ParsePath( const vector< string >& Arguments, int& Position )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing filename after '" + Option + "'" );
+    
+    return Arguments[ Position ];
+}
+
+// -----------------------------------------------------------------------------
+
+// GL framebuffer rows go from bottom to top
+void ReadFramebuffer( vector< GPUColor >& Pixels )
+{
+    static vector< GPUColor > Rows( Constants::ScreenPixels );
+    glReadPixels( 0, 0, Constants::ScreenWidth, Constants::ScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, &Rows[ 0 ] );
+    
+    Pixels.resize( Constants::ScreenPixels );
+    
+    for( int y = 0; y < Constants::ScreenHeight; y++ )
+      copy_n( &Rows[ (Constants::ScreenHeight - 1 - y) * Constants::ScreenWidth ], Constants::ScreenWidth, &Pixels[ y * Constants::ScreenWidth ] );
+}
+
+
+// =============================================================================
+//      MAIN FUNCTION
+// =============================================================================
+
+
+int main( int NumberOfArguments, char* Arguments[] )
+{
+    // 2 is returned when renderers do not match
+    int ExitCode = 0;
+    
+    try
+    {
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Process command line arguments
+        
+        vector< string > ArgumentList( Arguments, Arguments + NumberOfArguments );
+        
+        // by default the BIOS is searched in the program folder
+        string ProgramFolder = GetPathDirectory( ArgumentList[ 0 ] );
+        string BiosPath = ProgramFolder + "Bios" + PathSeparator + "StandardBios.v32";
+        
+        // variables to capture input parameters
+        string RecordingPath, CartridgePath;
+        int Loops = 1;
+        int RenderThreads = 0;
+        int Tolerance = 0;
+        int FirstFrame = 0;
+        bool ReportHashes = false;
+        bool Compare = true;
+        
+        for( int i = 1; i < NumberOfArguments; i++ )
+        {
+            const string& Argument = ArgumentList[ i ];
+            
+            if( Argument == "--help" )
+            {
+                PrintUsage();
+                return 0;
+            }
+            
+            if( Argument == "-bios" )         { BiosPath = ParsePath( ArgumentList, i );         continue; }
+            if( Argument == "-cartridge" )    { CartridgePath = ParsePath( ArgumentList, i );    continue; }
+            if( Argument == "-loops" )        { Loops = ParseCount( ArgumentList, i );           continue; }
+            if( Argument == "-threads" )      { RenderThreads = ParseCount( ArgumentList, i );   continue; }
+            if( Argument == "-tolerance" )    { Tolerance = ParseCount( ArgumentList, i, 0 );    continue; }
+            if( Argument == "-first" )        { FirstFrame = ParseCount( ArgumentList, i, 0 );   continue; }
+            if( Argument == "-hashes" )       { ReportHashes = true;  continue; }
+            if( Argument == "-no-compare" )   { Compare = false;      continue; }
+            if( Argument == "-v" )            { VerboseMode = true;   continue; }
+            
+            // discard any other parameters starting with '-'
+            if( Argument[ 0 ] == '-' )
+              throw runtime_error( "unrecognized command line option '" + Argument + "'" );
+            
+            // any non-option parameter is taken as the recording
+            if( !RecordingPath.empty() )
+              throw runtime_error( "too many input files, only 1 is supported" );
+            
+            RecordingPath = Argument;
+        }
+        
+        if( RecordingPath.empty() )
+          throw runtime_error( "no input file" );
+        
+        // video output logs every step, so unless
+        // requested it is sent to a file instead
+        if( !VerboseMode )
+          LOG_TO_FILE( ProgramFolder + "GLReplayLog" );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Create the OpenGL context as the emulator does
+        
+        if( SDL_Init( SDL_INIT_VIDEO ) != 0 )
+          throw runtime_error( string("cannot initialize SDL: ") + SDL_GetError() );
+        
+        // the window is needed for the context, but
+        // all frames are drawn to the framebuffer
+        Video.CreateOpenGLWindow();
+        Video.InitRendering();
+        Video.CreateFramebuffer();
+        Video.RenderToFramebuffer();
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Load textures and the recorded frames
+        
+        Callbacks::ClearScreen             = ReplayCallbacks::ClearScreen;
+        Callbacks::DrawQuad                = ReplayCallbacks::DrawQuad;
+        Callbacks::SetMultiplyColor        = ReplayCallbacks::SetMultiplyColor;
+        Callbacks::SetBlendingMode         = ReplayCallbacks::SetBlendingMode;
+        Callbacks::SelectTexture           = ReplayCallbacks::SelectTexture;
+        Callbacks::PrepareTexture          = ReplayCallbacks::PrepareTexture;
+        Callbacks::LoadTexture             = ReplayCallbacks::LoadTexture;
+        Callbacks::UnloadCartridgeTextures = ReplayCallbacks::UnloadCartridgeTextures;
+        Callbacks::UnloadBiosTexture       = ReplayCallbacks::UnloadBiosTexture;
+        Callbacks::LogLine                 = ReplayCallbacks::LogLine;
+        Callbacks::ThrowException          = ReplayCallbacks::ThrowException;
+        
+        GPURecordingReader Recording;
+        Recording.Open( RecordingPath );
+        
+        // textures are taken from the original ROMs
+        Console.LoadBios( BiosPath );
+        
+        if( !CartridgePath.empty() )
+          Console.LoadCartridge( CartridgePath );
+        
+        else if( !Recording.GetCartridgeTitle().empty() )
+          throw runtime_error( "recording is from cartridge \"" + Recording.GetCartridgeTitle() + "\", use -cartridge" );
+        
+        Video.ReportTextureMemory();
+        
+        if( Console.GetCartridgeTitle() != Recording.GetCartridgeTitle() )
+          cerr << "Vircon32GLReplay: warning: recording is from cartridge \"" << Recording.GetCartridgeTitle() << "\"" << endl;
+        
+        // keep all frames in memory so that file
+        // reading is not included in measurements
+        vector< GPUCommandList > Frames( Recording.GetNumberOfFrames() );
+        
+        for( GPUCommandList& Frame: Frames )
+          Recording.ReadFrame( Frame );
+        
+        Recording.Close();
+        
+        if( FirstFrame >= (int)Frames.size() )
+          throw runtime_error( "recording has no frames from frame " + to_string( FirstFrame ) );
+        
+        if( RenderThreads > 0 )
+          Renderer.SetNumberOfThreads( RenderThreads );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Draw all frames with both renderers
+        
+        VideoOutputReceiver Receiver;
+        vector< GPUColor > OpenGLPixels;
+        uint64_t OpenGLHash = HashBytes( nullptr, 0 );
+        uint64_t SoftwareHash = HashBytes( nullptr, 0 );
+        
+        vector< double > FrameMilliseconds;
+        double TotalDrawCalls = 0, TotalUploadedBytes = 0;
+        
+        int DifferentFrames = 0;
+        int64_t DifferentPixels = 0;
+        int MaximumDifference = 0;
+        string FirstDifference;
+        
+        for( int Loop = 0; Loop < Loops; Loop++ )
+          for( int Frame = 0; Frame < (int)Frames.size(); Frame++ )
+          {
+              // earlier frames are still drawn by both
+              // renderers, since later ones may build on them
+              bool Measured = (Frame >= FirstFrame);
+            
+              // time includes waiting for the GPU to finish,
+              // but not reading the framebuffer back
+              auto RenderStart = chrono::steady_clock::now();
+              Video.BeginFrame();
+              Frames[ Frame ].Replay( Receiver );
+              Video.RenderQuadQueue();
+              glFinish();
+            
+              if( Measured )
+              {
+                  FrameMilliseconds.push_back( chrono::duration< double, milli >( chrono::steady_clock::now() - RenderStart ).count() );
+                  TotalDrawCalls += Video.GetDrawCalls();
+                  TotalUploadedBytes += Video.GetUploadedBytes();
+              }
+            
+              // frames from next loops don't start in the same state
+              bool Hashed = (ReportHashes && Measured && Loop == 0);
+            
+              // the OpenGL hash is also available without comparing,
+              // to check that changes to VideoOutput keep its output
+              if( Compare || Hashed )
+                ReadFramebuffer( OpenGLPixels );
+                
+              if( Hashed )
+                OpenGLHash = HashBytes( &OpenGLPixels[ 0 ], OpenGLPixels.size() * sizeof(GPUColor), OpenGLHash );
+                
+              if( !Compare )
+                continue;
+                
+              Frames[ Frame ].Replay( Renderer );
+              Renderer.RenderFrame();
+            
+              if( Hashed )
+                SoftwareHash = HashBytes( &Renderer.Framebuffer[ 0 ], Renderer.Framebuffer.size() * sizeof(GPUColor), SoftwareHash );
+                
+              if( !Measured )
+                continue;
+                
+              // the GL framebuffer has no alpha channel
+              int FramePixels = 0, FrameDifference = 0;
+            
+              for( int i = 0; i < Constants::ScreenPixels; i++ )
+              {
+                  GPUColor OpenGLColor = OpenGLPixels[ i ];
+                  GPUColor SoftwareColor = Renderer.Framebuffer[ i ];
+                
+                  int Difference = max( { abs( OpenGLColor.R - SoftwareColor.R ),
+                                          abs( OpenGLColor.G - SoftwareColor.G ),
+                                          abs( OpenGLColor.B - SoftwareColor.B ) } );
+                                        
+                  if( Difference <= Tolerance )
+                    continue;
+                    
+                  if( FirstDifference.empty() )
+                    FirstDifference = "frame " + to_string( Frame ) + ", pixel (" + to_string( i % Constants::ScreenWidth ) + ","
+                                    + to_string( i / Constants::ScreenWidth ) + "), OpenGL " + ColorToString( OpenGLColor )
+                                    + ", software " + ColorToString( SoftwareColor );
+                                    
+                  FrameDifference = max( FrameDifference, Difference );
+                  FramePixels++;
+              }
+            
+              if( FramePixels > 0 )
+              {
+                  DifferentFrames++;
+                  DifferentPixels += FramePixels;
+                  MaximumDifference = max( MaximumDifference, FrameDifference );
+                
+                  if( VerboseMode )
+                    cout << "frame " << Frame << " differs: " << FramePixels << " pixels, maximum difference " << FrameDifference << endl;
+              }
+          }
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Report results
+        
+        int DrawnFrames = FrameMilliseconds.size();
+        double TotalMilliseconds = 0;
+        
+        for( double Milliseconds: FrameMilliseconds )
+          TotalMilliseconds += Milliseconds;
+        
+        // sort to get the median and worst frames
+        sort( FrameMilliseconds.begin(), FrameMilliseconds.end() );
+        
+        cout << fixed << setprecision( 1 );
+        cout << "frames: " << (Frames.size() - FirstFrame) << endl;
+        cout << "OpenGL renderer: " << (const char*)glGetString( GL_RENDERER ) << endl;
+        cout << "draw calls: " << (TotalDrawCalls / DrawnFrames) << " per frame" << endl;
+        cout << "vertex data uploaded: " << (TotalUploadedBytes / DrawnFrames / 1024) << " KB per frame" << endl;
+        cout << setprecision( 3 );
+        cout << "OpenGL rendering: average " << (TotalMilliseconds / DrawnFrames) << " ms per frame, median "
+             << FrameMilliseconds[ DrawnFrames / 2 ] << " ms, maximum " << FrameMilliseconds.back() << " ms" << endl;
+            
+        if( ReportHashes )
+          cout << "video hash (OpenGL): " << HashToString( OpenGLHash ) << endl;
+        
+        if( ReportHashes && Compare )
+          cout << "video hash (software): " << HashToString( SoftwareHash ) << endl;
+        
+        if( Compare )
+        {
+            cout << "different frames: " << DifferentFrames << " of " << DrawnFrames << endl;
+            cout << "different pixels: " << DifferentPixels << " ("
+                 << (100.0 * DifferentPixels / ((double)DrawnFrames * Constants::ScreenPixels)) << "%)" << endl;
+                
+            if( DifferentFrames > 0 )
+            {
+                cout << "maximum difference: " << MaximumDifference << endl;
+                cout << "first difference: " << FirstDifference << endl;
+                ExitCode = 2;
+            }
+        }
+        
+        // clean-up in reverse order, while the
+        // OpenGL context and the log still exist
+        Console.UnloadCartridge();
+        Console.UnloadBios();
+        Video.Destroy();
+        SDL_Quit();
+    }
+    
+    catch( const exception& e )
+    {
+        cerr << "Vircon32GLReplay: error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return ExitCode;
+}
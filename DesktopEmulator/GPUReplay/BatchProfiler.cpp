@@ -0,0 +1,176 @@
+// *****************************************************************************
+    // include common Vircon headers
+    #include "../VirconDefinitions/Enumerations.hpp"
+    
+    // include project headers
+    #include "BatchProfiler.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      BATCH PROFILER: INSTANCE HANDLING
+// =============================================================================
+
+
+BatchProfiler::BatchProfiler()
+{
+    // same initial state as the emulator
+    MultiplyColor = GPUColor{ 255, 255, 255, 255 };
+    BlendingMode = (int)IOPortValues::GPUBlendingMode_Alpha;
+    SelectedTexture = -1;
+    QueuedQuads = 0;
+    UsedSlots = 0;
+    
+    BeginFrame();
+}
+
+
+// =============================================================================
+//      BATCH PROFILER: FRAME HANDLING
+// =============================================================================
+
+
+void BatchProfiler::BeginFrame()
+{
+    Commands = 0;
+    Quads = 0;
+    StateChanges = 0;
+    DrawCalls = 0;
+    UploadedBytes = 0;
+    
+    for( int i = 0; i < NUMBER_OF_FLUSH_CAUSES; i++ )
+      Flushes[ i ] = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+// the emulator renders all remaining quads after each frame
+void BatchProfiler::EndFrame()
+{
+    RenderQuadQueue( FlushCauses::EndOfFrame );
+}
+
+// -----------------------------------------------------------------------------
+
+// GPU texture IDs can be -1 for the BIOS texture,
+// so the white texture is given an unused value
+#define WHITE_TEXTURE_ID -2
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::UseTexture( int TextureID )
+{
+    for( int i = 0; i < UsedSlots; i++ )
+      if( SlotTextures[ i ] == TextureID )
+        return;
+    
+    if( UsedSlots >= PROFILED_TEXTURE_SLOTS )
+      RenderQuadQueue( FlushCauses::TextureSlots );
+    
+    SlotTextures[ UsedSlots++ ] = TextureID;
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::QueueQuad()
+{
+    QueuedQuads++;
+    
+    if( QueuedQuads >= PROFILED_QUAD_QUEUE_SIZE )
+      RenderQuadQueue( FlushCauses::QueueFull );
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::RenderQuadQueue( FlushCauses Cause )
+{
+    if( QueuedQuads == 0 ) return;
+    
+    DrawCalls++;
+    UploadedBytes += QueuedQuads * PROFILED_BYTES_PER_QUAD;
+    Flushes[ (int)Cause ]++;
+    QueuedQuads = 0;
+    UsedSlots = 0;
+}
+
+
+// =============================================================================
+//      BATCH PROFILER: GPU COMMANDS
+// =============================================================================
+
+
+void BatchProfiler::ClearScreen( GPUColor ClearColor )
+{
+    Commands++;
+    
+    // the screen is cleared by queueing
+    // a quad with the white texture
+    UseTexture( WHITE_TEXTURE_ID );
+    QueueQuad();
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::DrawQuad( const GPUQuad& Quad )
+{
+    Commands++;
+    Quads++;
+    UseTexture( SelectedTexture );
+    QueueQuad();
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::SetMultiplyColor( GPUColor NewMultiplyColor )
+{
+    Commands++;
+    
+    // GPU colors are not directly comparable so use words
+    V32Word New, Old;
+    New.AsColor = NewMultiplyColor;
+    Old.AsColor = MultiplyColor;
+    
+    // the color is stored in each vertex,
+    // so changing it does not break groups
+    if( New.AsInteger != Old.AsInteger )
+      StateChanges++;
+    
+    MultiplyColor = NewMultiplyColor;
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::SetBlendingMode( int NewBlendingMode )
+{
+    Commands++;
+    
+    if( NewBlendingMode == BlendingMode )
+      return;
+    
+    // even invalid values make VideoOutput render
+    // its queue, but they are then ignored
+    StateChanges++;
+    RenderQuadQueue( FlushCauses::BlendingMode );
+    
+    if( NewBlendingMode >= (int)IOPortValues::GPUBlendingMode_Alpha
+    &&  NewBlendingMode <= (int)IOPortValues::GPUBlendingMode_Subtract )
+      BlendingMode = NewBlendingMode;
+}
+
+// -----------------------------------------------------------------------------
+
+void BatchProfiler::SelectTexture( int GPUTextureID )
+{
+    Commands++;
+    
+    // textures only break groups when all
+    // slots are in use (see UseTexture)
+    if( GPUTextureID != SelectedTexture )
+      StateChanges++;
+    
+    SelectedTexture = GPUTextureID;
+}
@@ -0,0 +1,90 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef BATCHPROFILER_HPP
+    #define BATCHPROFILER_HPP
+    
+    // include console logic headers
+    #include "ConsoleLogic/GPUCommandList.hpp"
+// *****************************************************************************
+
+
+// must be the same as in VideoOutput.hpp
+#define PROFILED_QUAD_QUEUE_SIZE 2048
+#define PROFILED_TEXTURE_SLOTS 8
+
+// 4 vertices per quad, each a 24 byte QueuedVertex
+#define PROFILED_BYTES_PER_QUAD 96
+
+
+// =============================================================================
+//      PROFILING OF OPENGL DRAW CALLS
+// =============================================================================
+
+
+// what made VideoOutput render its queued quads
+enum class FlushCauses
+{
+    TextureSlots = 0,
+    BlendingMode,
+    QueueFull,
+    EndOfFrame
+};
+
+#define NUMBER_OF_FLUSH_CAUSES 4
+
+// -----------------------------------------------------------------------------
+
+// follows the same steps as VideoOutput (with the state filtering
+// done by the emulator) to count the draw calls that a frame needs,
+// and what caused each RenderQuadQueue flush
+class BatchProfiler: public V32::GPUCommandReceiver
+{
+    private:
+    
+        // render state, like in VideoOutput
+        V32::GPUColor MultiplyColor;
+        int BlendingMode;
+        int SelectedTexture;
+        int QueuedQuads;
+        
+        // textures used by the queued quads
+        int SlotTextures[ PROFILED_TEXTURE_SLOTS ];
+        int UsedSlots;
+        
+        // internal functions
+        void UseTexture( int TextureID );
+        void QueueQuad();
+        void RenderQuadQueue( FlushCauses Cause );
+    
+    public:
+    
+        // counters for the current frame
+        int Commands;
+        int Quads;
+        int StateChanges;
+        int DrawCalls;
+        int UploadedBytes;
+        int Flushes[ NUMBER_OF_FLUSH_CAUSES ];
+    
+    public:
+    
+        // instance handling
+        BatchProfiler();
+        
+        // frame handling
+        void BeginFrame();
+        void EndFrame();
+        
+        // GPU commands
+        void ClearScreen( V32::GPUColor ClearColor );
+        void DrawQuad( const V32::GPUQuad& Quad );
+        void SetMultiplyColor( V32::GPUColor NewMultiplyColor );
+        void SetBlendingMode( int NewBlendingMode );
+        void SelectTexture( int GPUTextureID );
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -0,0 +1,381 @@
+// *****************************************************************************
+    // include console logic headers
+    #include "ConsoleLogic/V32Console.hpp"
+    #include "ConsoleLogic/ExternalInterfaces.hpp"
+    #include "ConsoleLogic/GPURecording.hpp"
+    
+    // include infrastructure headers
+    #include "DesktopInfrastructure/FilePaths.hpp"
+    #include "DesktopInfrastructure/Hashing.hpp"
+    
+    // include project headers
+    #include "HeadlessEmulator/SoftwareRenderer.hpp"
+    #include "BatchProfiler.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <fstream>          // [ C++ STL ] File streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <stdexcept>        // [ C++ STL ] Exceptions
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      GLOBAL VARIABLES
+// =============================================================================
+
+
+// it is declared first so that the console
+// can still use it on destruction
+SoftwareRenderer Renderer;
+
+// the console only loads textures: its CPU never runs
+V32Console Console;
+
+// program options
+bool VerboseMode = false;
+
+
+// =============================================================================
+//      CALLBACKS FOR CONSOLE LOGIC
+// =============================================================================
+
+
+namespace ReplayCallbacks
+{
+    // GPU commands come from the recording instead
+    void ClearScreen( GPUColor ClearColor ) {}
+    void DrawQuad( GPUQuad& Quad ) {}
+    void SetMultiplyColor( GPUColor MultiplyColor ) {}
+    void SetBlendingMode( int BlendingMode ) {}
+    void SelectTexture( int GPUTextureID ) {}
+    
+    // -----------------------------------------------------------------------------
+    
+    void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height ) { Renderer.PrepareTexture( GPUTextureID, Pixels, Width, Height ); }
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )  { Renderer.LoadTexture( GPUTextureID, Pixels, Width, Height ); }
+    void UnloadCartridgeTextures()                                             { Renderer.UnloadCartridgeTextures(); }
+    void UnloadBiosTexture()                                                   { Renderer.UnloadBiosTexture(); }
+    
+    // -----------------------------------------------------------------------------
+    
+    void LogLine( const string& Message )
+    {
+        if( VerboseMode )
+          cout << Message << endl;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void ThrowException( const string& Message )
+    {
+        throw runtime_error( Message );
+    }
+}
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+void PrintUsage()
+{
+    cout << "USAGE: Vircon32GPUReplay [options] file" << endl;
+    cout << "Draws the frames of a GPU recording (made with Vircon32Headless -record)" << endl;
+    cout << "with the software renderer, without running the console CPU" << endl;
+    cout << "Options:" << endl;
+    cout << "  --help             Displays this information" << endl;
+    cout << "  -bios <file>       BIOS to take textures from, default is Bios/StandardBios.v32" << endl;
+    cout << "  -cartridge <file>  Cartridge to take textures from (needed if one was recorded)" << endl;
+    cout << "  -loops <n>         Number of times to draw all frames, default is 1" << endl;
+    cout << "  -threads <n>       Number of threads used to render, default is all cores" << endl;
+    cout << "  -no-render         Only reports the draw call profile" << endl;
+    cout << "  -stats <file>      Saves the draw call profile for each frame as CSV" << endl;
+    cout << "  -hashes            Reports a hash of all rendered frames (same as Vircon32Headless)" << endl;
+    cout << "  -screenshot <file> Saves the last frame as PNG" << endl;
+    cout << "  -v                 Displays additional information (verbose)" << endl;
+}
+
+// -----------------------------------------------------------------------------
+
+int ParseCount( const vector< string >& Arguments, int& Position )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing number after '" + Option + "'" );
+    
+    int Value = atoi( Arguments[ Position ].c_str() );
+    
+    if( Value <= 0 )
+      throw runtime_error( "invalid number after '" + Option + "'" );
+    
+    return Value;
+}
+
+// -----------------------------------------------------------------------------
+
+string ParsePath( const vector< string >& Arguments, int& Position )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing filename after '" + Option + "'" );
+    
+    return Arguments[ Position ];
+}
+
+
+// =============================================================================
+//      MAIN FUNCTION
+// =============================================================================
+
+
+int main( int NumberOfArguments, char* Arguments[] )
+{
+    try
+    {
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Process command line arguments
+        
+        vector< string > ArgumentList( Arguments, Arguments + NumberOfArguments );
+        
+        // by default the BIOS is searched in the program folder
+        string ProgramFolder = GetPathDirectory( ArgumentList[ 0 ] );
+        string BiosPath = ProgramFolder + "Bios" + PathSeparator + "StandardBios.v32";
+        
+        // variables to capture input parameters
+        string RecordingPath, CartridgePath, StatsPath, ScreenshotPath;
+        int Loops = 1;
+        int RenderThreads = 0;
+        bool ReportHashes = false;
+        bool UseRenderer = true;
+        
+        for( int i = 1; i < NumberOfArguments; i++ )
+        {
+            const string& Argument = ArgumentList[ i ];
+            
+            if( Argument == "--help" )
+            {
+                PrintUsage();
+                return 0;
+            }
+            
+            if( Argument == "-bios" )         { BiosPath = ParsePath( ArgumentList, i );         continue; }
+            if( Argument == "-cartridge" )    { CartridgePath = ParsePath( ArgumentList, i );    continue; }
+            if( Argument == "-stats" )        { StatsPath = ParsePath( ArgumentList, i );        continue; }
+            if( Argument == "-screenshot" )   { ScreenshotPath = ParsePath( ArgumentList, i );   continue; }
+            if( Argument == "-loops" )        { Loops = ParseCount( ArgumentList, i );           continue; }
+            if( Argument == "-threads" )      { RenderThreads = ParseCount( ArgumentList, i );   continue; }
+            if( Argument == "-hashes" )       { ReportHashes = true;  continue; }
+            if( Argument == "-no-render" )    { UseRenderer = false;  continue; }
+            if( Argument == "-v" )            { VerboseMode = true;   continue; }
+            
+            // discard any other parameters starting with '-'
+            if( Argument[ 0 ] == '-' )
+              throw runtime_error( "unrecognized command line option '" + Argument + "'" );
+            
+            // any non-option parameter is taken as the recording
+            if( !RecordingPath.empty() )
+              throw runtime_error( "too many input files, only 1 is supported" );
+            
+            RecordingPath = Argument;
+        }
+        
+        if( RecordingPath.empty() )
+          throw runtime_error( "no input file" );
+        
+        if( !UseRenderer && (ReportHashes || !ScreenshotPath.empty()) )
+          throw runtime_error( "-hashes and -screenshot cannot be used with -no-render" );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Load textures and the recorded frames
+        
+        Callbacks::ClearScreen             = ReplayCallbacks::ClearScreen;
+        Callbacks::DrawQuad                = ReplayCallbacks::DrawQuad;
+        Callbacks::SetMultiplyColor        = ReplayCallbacks::SetMultiplyColor;
+        Callbacks::SetBlendingMode         = ReplayCallbacks::SetBlendingMode;
+        Callbacks::SelectTexture           = ReplayCallbacks::SelectTexture;
+        Callbacks::PrepareTexture          = ReplayCallbacks::PrepareTexture;
+        Callbacks::LoadTexture             = ReplayCallbacks::LoadTexture;
+        Callbacks::UnloadCartridgeTextures = ReplayCallbacks::UnloadCartridgeTextures;
+        Callbacks::UnloadBiosTexture       = ReplayCallbacks::UnloadBiosTexture;
+        Callbacks::LogLine                 = ReplayCallbacks::LogLine;
+        Callbacks::ThrowException          = ReplayCallbacks::ThrowException;
+        
+        GPURecordingReader Recording;
+        Recording.Open( RecordingPath );
+        
+        // textures are taken from the original ROMs
+        Console.LoadBios( BiosPath );
+        
+        if( !CartridgePath.empty() )
+          Console.LoadCartridge( CartridgePath );
+        
+        else if( !Recording.GetCartridgeTitle().empty() )
+          throw runtime_error( "recording is from cartridge \"" + Recording.GetCartridgeTitle() + "\", use -cartridge" );
+        
+        if( Console.GetCartridgeTitle() != Recording.GetCartridgeTitle() )
+          cerr << "Vircon32GPUReplay: warning: recording is from cartridge \"" << Recording.GetCartridgeTitle() << "\"" << endl;
+        
+        // keep all frames in memory so that file
+        // reading is not included in measurements
+        vector< GPUCommandList > Frames( Recording.GetNumberOfFrames() );
+        
+        for( GPUCommandList& Frame: Frames )
+          Recording.ReadFrame( Frame );
+        
+        Recording.Close();
+        
+        if( Frames.empty() )
+          throw runtime_error( "recording has no frames" );
+        
+        if( RenderThreads > 0 )
+          Renderer.SetNumberOfThreads( RenderThreads );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Profile draw calls
+        
+        int NumberOfFrames = Frames.size();
+        BatchProfiler Profiler;
+        vector< BatchProfiler > FrameProfiles;
+        
+        for( const GPUCommandList& Frame: Frames )
+        {
+            Profiler.BeginFrame();
+            Frame.Replay( Profiler );
+            Profiler.EndFrame();
+            FrameProfiles.push_back( Profiler );
+        }
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Render all frames
+        
+        uint64_t VideoHash = HashBytes( nullptr, 0 );
+        vector< double > FrameMilliseconds;
+        
+        if( UseRenderer )
+          for( int Loop = 0; Loop < Loops; Loop++ )
+            for( const GPUCommandList& Frame: Frames )
+            {
+                auto RenderStart = chrono::steady_clock::now();
+                Frame.Replay( Renderer );
+                Renderer.RenderFrame();
+                FrameMilliseconds.push_back( chrono::duration< double, milli >( chrono::steady_clock::now() - RenderStart ).count() );
+                
+                // frames from next loops don't start in the same state
+                if( ReportHashes && Loop == 0 )
+                  VideoHash = HashBytes( &Renderer.Framebuffer[ 0 ], Renderer.Framebuffer.size() * sizeof(GPUColor), VideoHash );
+            }
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Report results
+        
+        double TotalCommands = 0, TotalQuads = 0, TotalStateChanges = 0, TotalDrawCalls = 0, TotalUploadedBytes = 0;
+        int MaximumDrawCalls = 0;
+        double TotalFlushes[ NUMBER_OF_FLUSH_CAUSES ] = { 0 };
+        
+        for( const BatchProfiler& Profile: FrameProfiles )
+        {
+            TotalCommands += Profile.Commands;
+            TotalQuads += Profile.Quads;
+            TotalStateChanges += Profile.StateChanges;
+            TotalDrawCalls += Profile.DrawCalls;
+            TotalUploadedBytes += Profile.UploadedBytes;
+            MaximumDrawCalls = max( MaximumDrawCalls, Profile.DrawCalls );
+            
+            for( int i = 0; i < NUMBER_OF_FLUSH_CAUSES; i++ )
+              TotalFlushes[ i ] += Profile.Flushes[ i ];
+        }
+        
+        const char* FlushCauseNames[ NUMBER_OF_FLUSH_CAUSES ] =
+        {
+            "texture slots", "blending", "queue full", "end of frame"
+        };
+        
+        cout << fixed << setprecision( 1 );
+        cout << "frames: " << NumberOfFrames << endl;
+        cout << "commands: " << (TotalCommands / NumberOfFrames) << " per frame" << endl;
+        cout << "quads: " << (TotalQuads / NumberOfFrames) << " per frame" << endl;
+        cout << "state changes: " << (TotalStateChanges / NumberOfFrames) << " per frame" << endl;
+        cout << "draw calls: average " << (TotalDrawCalls / NumberOfFrames) << " per frame, maximum " << MaximumDrawCalls << endl;
+        cout << "quads per draw call: " << (TotalQuads / max( TotalDrawCalls, 1.0 )) << endl;
+        cout << "vertex data uploaded: " << (TotalUploadedBytes / NumberOfFrames / 1024) << " KB per frame" << endl;
+        cout << "quad queue flushes:";
+        
+        for( int i = 0; i < NUMBER_OF_FLUSH_CAUSES; i++ )
+          cout << (i? ", " : " ") << FlushCauseNames[ i ] << " " << (TotalFlushes[ i ] / NumberOfFrames);
+        
+        cout << " (per frame)" << endl;
+        
+        if( UseRenderer )
+        {
+            // sort to get the median and worst frames
+            double TotalMilliseconds = 0;
+            
+            for( double Milliseconds: FrameMilliseconds )
+              TotalMilliseconds += Milliseconds;
+            
+            int RenderedFrames = FrameMilliseconds.size();
+            sort( FrameMilliseconds.begin(), FrameMilliseconds.end() );
+            
+            cout << setprecision( 3 );
+            cout << "rendering: average " << (TotalMilliseconds / RenderedFrames) << " ms per frame, median "
+                 << FrameMilliseconds[ RenderedFrames / 2 ] << " ms, maximum " << FrameMilliseconds.back() << " ms ("
+                 << Renderer.GetNumberOfThreads() << " threads)" << endl;
+            cout << setprecision( 1 );
+        }
+        
+        if( ReportHashes )
+          cout << "video hash: " << HashToString( VideoHash ) << endl;
+        
+        // save the per-frame profile when requested
+        if( !StatsPath.empty() )
+        {
+            ofstream StatsFile( StatsPath );
+            
+            if( !StatsFile.good() )
+              throw runtime_error( "cannot create stats file \"" + StatsPath + "\"" );
+            
+            StatsFile << "Frame,Commands,Quads,StateChanges,DrawCalls,UploadedBytes";
+            
+            for( int i = 0; i < NUMBER_OF_FLUSH_CAUSES; i++ )
+              StatsFile << ",Flushes(" << FlushCauseNames[ i ] << ")";
+            
+            StatsFile << endl;
+            
+            for( int Frame = 0; Frame < NumberOfFrames; Frame++ )
+            {
+                const BatchProfiler& Profile = FrameProfiles[ Frame ];
+                StatsFile << Frame << "," << Profile.Commands << "," << Profile.Quads << "," << Profile.StateChanges << "," << Profile.DrawCalls << "," << Profile.UploadedBytes;
+                
+                for( int i = 0; i < NUMBER_OF_FLUSH_CAUSES; i++ )
+                  StatsFile << "," << Profile.Flushes[ i ];
+                
+                StatsFile << endl;
+            }
+        }
+        
+        if( !ScreenshotPath.empty() )
+          Renderer.SaveScreenshot( ScreenshotPath );
+    }
+    
+    catch( const exception& e )
+    {
+        cerr << "Vircon32GPUReplay: error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
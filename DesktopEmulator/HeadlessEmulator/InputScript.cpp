@@ -0,0 +1,129 @@
+// *****************************************************************************
+    // include project headers
+    #include "InputScript.hpp"
+    
+    // include C/C++ headers
+    #include <fstream>          // [ C++ STL ] File streams
+    #include <sstream>          // [ C++ STL ] String streams
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <stdexcept>        // [ C++ STL ] Exceptions
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+GamepadControls ParseControlName( const string& Name )
+{
+    if( Name == "Left"        ) return GamepadControls::Left;
+    if( Name == "Right"       ) return GamepadControls::Right;
+    if( Name == "Up"          ) return GamepadControls::Up;
+    if( Name == "Down"        ) return GamepadControls::Down;
+    if( Name == "ButtonStart" ) return GamepadControls::ButtonStart;
+    if( Name == "ButtonA"     ) return GamepadControls::ButtonA;
+    if( Name == "ButtonB"     ) return GamepadControls::ButtonB;
+    if( Name == "ButtonX"     ) return GamepadControls::ButtonX;
+    if( Name == "ButtonY"     ) return GamepadControls::ButtonY;
+    if( Name == "ButtonL"     ) return GamepadControls::ButtonL;
+    if( Name == "ButtonR"     ) return GamepadControls::ButtonR;
+    
+    throw runtime_error( "unrecognized gamepad control '" + Name + "'" );
+}
+
+
+// =============================================================================
+//      INPUT SCRIPT CLASS
+// =============================================================================
+
+
+InputScript::InputScript()
+{
+    NextEvent = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void InputScript::LoadFile( const string& FilePath )
+{
+    ifstream InputFile( FilePath );
+    
+    if( !InputFile.good() )
+      throw runtime_error( "cannot open input script \"" + FilePath + "\"" );
+    
+    Events.clear();
+    NextEvent = 0;
+    
+    string Line;
+    int LineNumber = 0;
+    
+    while( getline( InputFile, Line ) )
+    {
+        LineNumber++;
+        
+        // skip empty lines and comments
+        size_t FirstCharacter = Line.find_first_not_of( " \t\r" );
+        
+        if( FirstCharacter == string::npos || Line[ FirstCharacter ] == '#' )
+          continue;
+        
+        // read all fields
+        istringstream LineStream( Line );
+        string ControlName, Action;
+        InputEvent NewEvent;
+        
+        if( !(LineStream >> NewEvent.Frame >> NewEvent.GamepadPort >> ControlName >> Action) )
+          throw runtime_error( "input script line " + to_string( LineNumber ) + ": expected <frame> <gamepad> <control> <press/release>" );
+        
+        // check each field
+        if( NewEvent.Frame < 0 )
+          throw runtime_error( "input script line " + to_string( LineNumber ) + ": frame cannot be negative" );
+        
+        if( NewEvent.GamepadPort < 1 || NewEvent.GamepadPort > Constants::GamepadPorts )
+          throw runtime_error( "input script line " + to_string( LineNumber ) + ": gamepad must be in range 1-4" );
+        
+        if( Action != "press" && Action != "release" )
+          throw runtime_error( "input script line " + to_string( LineNumber ) + ": action must be press or release" );
+        
+        // gamepads are numbered from 0 internally
+        NewEvent.GamepadPort--;
+        NewEvent.Control = ParseControlName( ControlName );
+        NewEvent.Pressed = (Action == "press");
+        Events.push_back( NewEvent );
+    }
+    
+    // keep the order within the same frame
+    stable_sort
+    (
+        Events.begin(), Events.end(),
+        []( const InputEvent& E1, const InputEvent& E2 ){ return E1.Frame < E2.Frame; }
+    );
+}
+
+// -----------------------------------------------------------------------------
+
+bool InputScript::UsesGamepad( int GamepadPort )
+{
+    for( const InputEvent& Event: Events )
+      if( Event.GamepadPort == GamepadPort )
+        return true;
+    
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+void InputScript::ApplyFrameEvents( V32Console& Console, int Frame )
+{
+    while( NextEvent < Events.size() && Events[ NextEvent ].Frame <= Frame )
+    {
+        const InputEvent& Event = Events[ NextEvent ];
+        Console.SetGamepadControl( Event.GamepadPort, Event.Control, Event.Pressed );
+        NextEvent++;
+    }
+}
@@ -0,0 +1,60 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef INPUTSCRIPT_HPP
+    #define INPUTSCRIPT_HPP
+    
+    // include console logic headers
+    #include "ConsoleLogic/V32Console.hpp"
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+// *****************************************************************************
+
+
+// =============================================================================
+//      SCRIPTED GAMEPAD INPUT
+// =============================================================================
+
+
+// a single change in a gamepad control
+struct InputEvent
+{
+    int Frame;
+    int GamepadPort;
+    V32::GamepadControls Control;
+    bool Pressed;
+};
+
+// -----------------------------------------------------------------------------
+
+// scripts are text files with one event per line, in the form
+// "<frame> <gamepad 1-4> <control> <press/release>", where the
+// control names are the same used in GamepadControls; empty
+// lines and lines starting with '#' are ignored
+class InputScript
+{
+    private:
+    
+        // events sorted by frame
+        std::vector< InputEvent > Events;
+        unsigned NextEvent;
+    
+    public:
+    
+        // instance handling
+        InputScript();
+        
+        // script loading
+        void LoadFile( const std::string& FilePath );
+        bool UsesGamepad( int GamepadPort );
+        
+        // applies all events for the given frame
+        void ApplyFrameEvents( V32::V32Console& Console, int Frame );
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -0,0 +1,476 @@
+// *****************************************************************************
+    // include console logic headers
+    #include "ConsoleLogic/V32Console.hpp"
+    #include "ConsoleLogic/ExternalInterfaces.hpp"
+    #include "ConsoleLogic/GPURecording.hpp"
+    
+    // include infrastructure headers
+    #include "DesktopInfrastructure/FilePaths.hpp"
+    #include "DesktopInfrastructure/Hashing.hpp"
+    
+    // include project headers
+    #include "InputScript.hpp"
+    #include "SoftwareRenderer.hpp"
+    #include "SPUBenchmark.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <fstream>          // [ C++ STL ] File streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <stdexcept>        // [ C++ STL ] Exceptions
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      GLOBAL VARIABLES
+// =============================================================================
+
+
+// only used when rendering is enabled; it is declared
+// first so that the console can still use it on destruction
+SoftwareRenderer Renderer;
+
+// the console is big, so don't place it on the stack
+V32Console Console;
+
+// GPU commands of the current frame, when recording
+GPUCommandList RecordedFrame;
+
+// program options
+bool VerboseMode = false;
+
+
+// =============================================================================
+//      NULL CALLBACKS FOR CONSOLE LOGIC
+// =============================================================================
+
+
+namespace NullCallbacks
+{
+    // without a video library, drawing does nothing
+    void ClearScreen( GPUColor ClearColor ) {}
+    void DrawQuad( GPUQuad& Quad ) {}
+    void SetMultiplyColor( GPUColor MultiplyColor ) {}
+    void SetBlendingMode( int BlendingMode ) {}
+    void SelectTexture( int GPUTextureID ) {}
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height ) {}
+    void UnloadCartridgeTextures() {}
+    void UnloadBiosTexture() {}
+    
+    // -----------------------------------------------------------------------------
+    
+    void LogLine( const string& Message )
+    {
+        if( VerboseMode )
+          cout << Message << endl;
+    }
+    
+    // -----------------------------------------------------------------------------
+    
+    void ThrowException( const string& Message )
+    {
+        throw runtime_error( Message );
+    }
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER CALLBACKS FOR CONSOLE LOGIC
+// =============================================================================
+
+
+namespace RendererCallbacks
+{
+    void ClearScreen( GPUColor ClearColor )                                    { Renderer.ClearScreen( ClearColor ); }
+    void DrawQuad( GPUQuad& Quad )                                             { Renderer.DrawQuad( Quad ); }
+    void SetMultiplyColor( GPUColor MultiplyColor )                            { Renderer.SetMultiplyColor( MultiplyColor ); }
+    void SetBlendingMode( int BlendingMode )                                   { Renderer.SetBlendingMode( BlendingMode ); }
+    void SelectTexture( int GPUTextureID )                                     { Renderer.SelectTexture( GPUTextureID ); }
+    void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height ) { Renderer.PrepareTexture( GPUTextureID, Pixels, Width, Height ); }
+    void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )  { Renderer.LoadTexture( GPUTextureID, Pixels, Width, Height ); }
+    void UnloadCartridgeTextures()                                             { Renderer.UnloadCartridgeTextures(); }
+    void UnloadBiosTexture()                                                   { Renderer.UnloadBiosTexture(); }
+}
+
+
+// =============================================================================
+//      RECORDING CALLBACKS FOR CONSOLE LOGIC
+// =============================================================================
+
+
+// only GPU commands used while running are recorded;
+// textures are still loaded by the other callbacks
+namespace RecorderCallbacks
+{
+    void ClearScreen( GPUColor ClearColor )             { RecordedFrame.AddClearScreen( ClearColor ); }
+    void DrawQuad( GPUQuad& Quad )                      { RecordedFrame.AddDrawQuad( Quad ); }
+    void SetMultiplyColor( GPUColor MultiplyColor )     { RecordedFrame.AddSetMultiplyColor( MultiplyColor ); }
+    void SetBlendingMode( int BlendingMode )            { RecordedFrame.AddSetBlendingMode( BlendingMode ); }
+    void SelectTexture( int GPUTextureID )              { RecordedFrame.AddSelectTexture( GPUTextureID ); }
+}
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+void PrintUsage()
+{
+    cout << "USAGE: Vircon32Headless [options] file" << endl;
+    cout << "Runs a cartridge with no audio output, and optional software video" << endl;
+    cout << "Options:" << endl;
+    cout << "  --help             Displays this information" << endl;
+    cout << "  -bios <file>       BIOS to load, default is Bios/StandardBios.v32" << endl;
+    cout << "  -frames <n>        Number of frames to run, default is 600" << endl;
+    cout << "  -input <file>      Script with gamepad input events" << endl;
+    cout << "  -loads <file>      Saves CPU and GPU loads for each frame as CSV" << endl;
+    cout << "  -hashes            Reports hashes of final RAM and all audio output" << endl;
+    cout << "  -render            Draws all frames with the software renderer" << endl;
+    cout << "  -threads <n>       Number of threads used to render, default is all cores" << endl;
+    cout << "  -screenshot <file> Renders and saves the last frame as PNG" << endl;
+    cout << "  -record <file>     Saves the GPU commands of all frames, for Vircon32GPUReplay" << endl;
+    cout << "  -no-blocks         Runs the CPU one instruction at a time" << endl;
+    cout << "  -no-bulk           Runs string instructions one word at a time" << endl;
+    cout << "  -spu-thread        Mixes sound in a separate thread while the CPU runs" << endl;
+    cout << "  -check-blocks <n>  Checks 1 of every n CPU blocks with the interpreter" << endl;
+    cout << "  -spu-benchmark     Only times the SPU mixer for the given frames, no file is run" << endl;
+    cout << "  -v                 Displays additional information (verbose)" << endl;
+    cout << "Input scripts have one event per line: <frame> <gamepad> <control> <press/release>" << endl;
+}
+
+// -----------------------------------------------------------------------------
+
+int ParseCount( const vector< string >& Arguments, int& Position )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing number after '" + Option + "'" );
+    
+    int Value = atoi( Arguments[ Position ].c_str() );
+    
+    if( Value <= 0 )
+      throw runtime_error( "invalid number after '" + Option + "'" );
+    
+    return Value;
+}
+
+// -----------------------------------------------------------------------------
+
+string ParsePath( const vector< string >& Arguments, int& Position )
+{
+    string Option = Arguments[ Position ];
+    Position++;
+    
+    if( Position >= (int)Arguments.size() )
+      throw runtime_error( "missing filename after '" + Option + "'" );
+    
+    return Arguments[ Position ];
+}
+
+
+// =============================================================================
+//      MAIN FUNCTION
+// =============================================================================
+
+
+int main( int NumberOfArguments, char* Arguments[] )
+{
+    try
+    {
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Process command line arguments
+        
+        vector< string > ArgumentList( Arguments, Arguments + NumberOfArguments );
+        
+        // by default the BIOS is searched in the program folder
+        string ProgramFolder = GetPathDirectory( ArgumentList[ 0 ] );
+        string BiosPath = ProgramFolder + "Bios" + PathSeparator + "StandardBios.v32";
+        
+        // variables to capture input parameters
+        string CartridgePath, InputScriptPath, LoadsPath, ScreenshotPath, RecordingPath;
+        int FramesToRun = 600;
+        int BlocksPerCheck = 0;
+        int RenderThreads = 0;
+        bool ReportHashes = false;
+        bool UseBlocks = true;
+        bool UseBulk = true;
+        bool UseSPUThread = false;
+        bool UseRenderer = false;
+        bool SPUBenchmark = false;
+        
+        for( int i = 1; i < NumberOfArguments; i++ )
+        {
+            const string& Argument = ArgumentList[ i ];
+            
+            if( Argument == "--help" )
+            {
+                PrintUsage();
+                return 0;
+            }
+            
+            if( Argument == "-bios" )         { BiosPath = ParsePath( ArgumentList, i );         continue; }
+            if( Argument == "-input" )        { InputScriptPath = ParsePath( ArgumentList, i );  continue; }
+            if( Argument == "-loads" )        { LoadsPath = ParsePath( ArgumentList, i );        continue; }
+            if( Argument == "-screenshot" )   { ScreenshotPath = ParsePath( ArgumentList, i );   continue; }
+            if( Argument == "-record" )       { RecordingPath = ParsePath( ArgumentList, i );    continue; }
+            if( Argument == "-frames" )       { FramesToRun = ParseCount( ArgumentList, i );     continue; }
+            if( Argument == "-check-blocks" ) { BlocksPerCheck = ParseCount( ArgumentList, i );  continue; }
+            if( Argument == "-threads" )      { RenderThreads = ParseCount( ArgumentList, i );   continue; }
+            if( Argument == "-hashes" )       { ReportHashes = true;  continue; }
+            if( Argument == "-no-blocks" )    { UseBlocks = false;    continue; }
+            if( Argument == "-no-bulk" )      { UseBulk = false;      continue; }
+            if( Argument == "-spu-thread" )   { UseSPUThread = true;  continue; }
+            if( Argument == "-render" )       { UseRenderer = true;   continue; }
+            if( Argument == "-spu-benchmark" ) { SPUBenchmark = true;  continue; }
+            if( Argument == "-v" )            { VerboseMode = true;   continue; }
+            
+            // discard any other parameters starting with '-'
+            if( Argument[ 0 ] == '-' )
+              throw runtime_error( "unrecognized command line option '" + Argument + "'" );
+            
+            // any non-option parameter is taken as the cartridge
+            if( !CartridgePath.empty() )
+              throw runtime_error( "too many input files, only 1 is supported" );
+            
+            CartridgePath = Argument;
+        }
+        
+        // the mixer benchmark needs no console
+        if( SPUBenchmark )
+          return RunSPUBenchmark( FramesToRun )? 0 : 1;
+        
+        // screenshots need rendering
+        if( !ScreenshotPath.empty() )
+          UseRenderer = true;
+        
+        // running just the BIOS is allowed
+        if( CartridgePath.empty() && VerboseMode )
+          cout << "no cartridge given, only the BIOS will run" << endl;
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Prepare the console
+        
+        Callbacks::ClearScreen             = NullCallbacks::ClearScreen;
+        Callbacks::DrawQuad                = NullCallbacks::DrawQuad;
+        Callbacks::SetMultiplyColor        = NullCallbacks::SetMultiplyColor;
+        Callbacks::SetBlendingMode         = NullCallbacks::SetBlendingMode;
+        Callbacks::SelectTexture           = NullCallbacks::SelectTexture;
+        Callbacks::LoadTexture             = NullCallbacks::LoadTexture;
+        Callbacks::UnloadCartridgeTextures = NullCallbacks::UnloadCartridgeTextures;
+        Callbacks::UnloadBiosTexture       = NullCallbacks::UnloadBiosTexture;
+        Callbacks::LogLine                 = NullCallbacks::LogLine;
+        Callbacks::ThrowException          = NullCallbacks::ThrowException;
+        
+        if( UseRenderer )
+        {
+            Callbacks::ClearScreen             = RendererCallbacks::ClearScreen;
+            Callbacks::DrawQuad                = RendererCallbacks::DrawQuad;
+            Callbacks::SetMultiplyColor        = RendererCallbacks::SetMultiplyColor;
+            Callbacks::SetBlendingMode         = RendererCallbacks::SetBlendingMode;
+            Callbacks::SelectTexture           = RendererCallbacks::SelectTexture;
+            Callbacks::PrepareTexture          = RendererCallbacks::PrepareTexture;
+            Callbacks::LoadTexture             = RendererCallbacks::LoadTexture;
+            Callbacks::UnloadCartridgeTextures = RendererCallbacks::UnloadCartridgeTextures;
+            Callbacks::UnloadBiosTexture       = RendererCallbacks::UnloadBiosTexture;
+            
+            if( RenderThreads > 0 )
+              Renderer.SetNumberOfThreads( RenderThreads );
+        }
+        
+        // when recording, the renderer (if used) will
+        // receive each frame's commands from the recording
+        if( !RecordingPath.empty() )
+        {
+            Callbacks::ClearScreen             = RecorderCallbacks::ClearScreen;
+            Callbacks::DrawQuad                = RecorderCallbacks::DrawQuad;
+            Callbacks::SetMultiplyColor        = RecorderCallbacks::SetMultiplyColor;
+            Callbacks::SetBlendingMode         = RecorderCallbacks::SetBlendingMode;
+            Callbacks::SelectTexture           = RecorderCallbacks::SelectTexture;
+        }
+        
+        // configure the CPU execution
+        Console.CPU.BlockExecution = UseBlocks;
+        Console.CPU.BulkStringInstructions = UseBulk;
+        Console.CPU.DifferentialCheckPeriod = BlocksPerCheck;
+        
+        // configure the SPU mixing
+        Console.SPU.ConcurrentMixing = UseSPUThread;
+        
+        // load media
+        Console.LoadBios( BiosPath );
+        
+        if( !CartridgePath.empty() )
+          Console.LoadCartridge( CartridgePath );
+        
+        // use a fixed date so that runs are repeatable
+        Console.SetCurrentDate( 2000, 0 );
+        Console.SetCurrentTime( 0, 0, 0 );
+        
+        // connect gamepad 1 always, and any
+        // other ones only when used in the script
+        InputScript Script;
+        
+        if( !InputScriptPath.empty() )
+          Script.LoadFile( InputScriptPath );
+        
+        for( int Gamepad = 0; Gamepad < Constants::GamepadPorts; Gamepad++ )
+          Console.SetGamepadConnection( Gamepad, Gamepad == 0 || Script.UsesGamepad( Gamepad ) );
+        
+        GPURecordingWriter Recording;
+        
+        if( !RecordingPath.empty() )
+          Recording.Open( RecordingPath, Console.GetCartridgeTitle() );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Run all frames as fast as possible
+        
+        vector< float > CPULoads, GPULoads;
+        uint64_t AudioHash = HashBytes( nullptr, 0 );
+        uint64_t VideoHash = HashBytes( nullptr, 0 );
+        uint64_t TotalCycles = 0;
+        double RenderSeconds = 0;
+        
+        Console.SetPower( true );
+        auto StartTime = chrono::steady_clock::now();
+        
+        for( int Frame = 0; Frame < FramesToRun; Frame++ )
+        {
+            Script.ApplyFrameEvents( Console, Frame );
+            Console.RunNextFrame();
+            
+            if( Recording.IsOpen() )
+            {
+                Recording.WriteFrame( RecordedFrame );
+                
+                if( UseRenderer )
+                  RecordedFrame.Replay( Renderer );
+                
+                RecordedFrame.Clear();
+            }
+            
+            // the image is drawn at the end of each frame
+            if( UseRenderer )
+            {
+                auto RenderStart = chrono::steady_clock::now();
+                Renderer.RenderFrame();
+                RenderSeconds += chrono::duration< double >( chrono::steady_clock::now() - RenderStart ).count();
+                
+                if( ReportHashes )
+                  VideoHash = HashBytes( &Renderer.Framebuffer[ 0 ], Renderer.Framebuffer.size() * sizeof(GPUColor), VideoHash );
+            }
+            
+            // each cycle runs 1 instruction
+            TotalCycles += Console.Timer.CycleCounter;
+            CPULoads.push_back( Console.GetCPULoad() );
+            GPULoads.push_back( Console.GetGPULoad() );
+            
+            // audio is always generated, even if not heard
+            if( ReportHashes )
+            {
+                SPUOutputBuffer FrameAudio;
+                Console.GetFrameSoundOutput( FrameAudio );
+                AudioHash = HashBytes( FrameAudio.Samples, sizeof(FrameAudio.Samples), AudioHash );
+            }
+            
+            if( Console.IsCPUHalted() )
+            {
+                if( VerboseMode )
+                  cout << "CPU halted at frame " << Frame << endl;
+                
+                FramesToRun = Frame + 1;
+                break;
+            }
+        }
+        
+        double ElapsedSeconds = chrono::duration< double >( chrono::steady_clock::now() - StartTime ).count();
+        ElapsedSeconds = max( ElapsedSeconds, 1e-6 );
+        
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // Report results
+        
+        double AverageCPULoad = 0, MaximumCPULoad = 0;
+        double AverageGPULoad = 0, MaximumGPULoad = 0;
+        
+        for( int Frame = 0; Frame < FramesToRun; Frame++ )
+        {
+            AverageCPULoad += CPULoads[ Frame ] / FramesToRun;
+            AverageGPULoad += GPULoads[ Frame ] / FramesToRun;
+            MaximumCPULoad = max< double >( MaximumCPULoad, CPULoads[ Frame ] );
+            MaximumGPULoad = max< double >( MaximumGPULoad, GPULoads[ Frame ] );
+        }
+        
+        double FramesPerSecond = FramesToRun / ElapsedSeconds;
+        
+        cout << fixed << setprecision( 1 );
+        cout << "frames run: " << FramesToRun << endl;
+        cout << "time: " << setprecision( 3 ) << ElapsedSeconds << " s" << setprecision( 1 ) << endl;
+        cout << "speed: " << FramesPerSecond << " fps (" << (FramesPerSecond / 60) << "x real time)" << endl;
+        cout << "emulated CPU: " << (TotalCycles / ElapsedSeconds / 1000000) << " MIPS" << endl;
+        cout << "CPU load: average " << AverageCPULoad << "%, maximum " << MaximumCPULoad << "%" << endl;
+        cout << "GPU load: average " << AverageGPULoad << "%, maximum " << MaximumGPULoad << "%" << endl;
+        
+        if( UseRenderer )
+          cout << "rendering: " << setprecision( 3 ) << (RenderSeconds * 1000 / FramesToRun) << " ms per frame ("
+               << Renderer.GetNumberOfThreads() << " threads)" << setprecision( 1 ) << endl;
+        
+        if( BlocksPerCheck > 0 )
+          cout << "checked CPU blocks: " << Console.CPU.CheckedBlocks
+               << (Console.CPU.BlockExecution? "" : " (mismatch found, blocks disabled)") << endl;
+        
+        if( Recording.IsOpen() )
+        {
+            cout << "GPU recording: " << Recording.GetWrittenFrames() << " frames, "
+                 << setprecision( 3 ) << (Recording.GetWrittenBytes() / 1024.0 / FramesToRun) << " KB per frame" << setprecision( 1 ) << endl;
+            
+            Recording.Close();
+        }
+        
+        if( ReportHashes )
+        {
+            uint64_t RAMHash = HashBytes( &Console.RAM.Memory[ 0 ], Console.RAM.Memory.size() * sizeof(V32Word) );
+            cout << "RAM hash: " << HashToString( RAMHash ) << endl;
+            cout << "audio hash: " << HashToString( AudioHash ) << endl;
+            
+            if( UseRenderer )
+              cout << "video hash: " << HashToString( VideoHash ) << endl;
+        }
+        
+        // save the full load curves when requested
+        if( !LoadsPath.empty() )
+        {
+            ofstream LoadsFile( LoadsPath );
+            
+            if( !LoadsFile.good() )
+              throw runtime_error( "cannot create loads file \"" + LoadsPath + "\"" );
+            
+            LoadsFile << "Frame,CPULoad,GPULoad" << endl;
+            
+            for( int Frame = 0; Frame < FramesToRun; Frame++ )
+              LoadsFile << Frame << "," << CPULoads[ Frame ] << "," << GPULoads[ Frame ] << endl;
+        }
+        
+        if( !ScreenshotPath.empty() )
+          Renderer.SaveScreenshot( ScreenshotPath );
+        
+        Console.SetPower( false );
+    }
+    
+    catch( const exception& e )
+    {
+        cerr << "Vircon32Headless: error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
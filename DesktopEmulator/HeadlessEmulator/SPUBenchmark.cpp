@@ -0,0 +1,211 @@
+// *****************************************************************************
+    // include project headers
+    #include "SPUBenchmark.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <cstring>          // [ ANSI C ] Strings
+    #include <cmath>            // [ ANSI C ] Math
+    #include <chrono>           // [ C++ STL ] Time measurement
+    #include <memory>           // [ C++ STL ] Memory
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      REFERENCE MIXER
+// =============================================================================
+
+
+void MixFrameByReference( V32SPU& SPU )
+{
+    // assign the next sequence number to the buffer
+    SPU.OutputBuffer.SequenceNumber++;
+    
+    // determine the value for each sample in the buffer
+    for( int s = 0; s < Constants::SPUSamplesPerFrame; s++ )
+    {
+        // use a local variable for speed
+        SPUSample ThisSample = {0,0};
+        
+        // generate sound for all channels
+        for( int c = 0; c < Constants::SPUSoundChannels; c++ )
+        {
+            // process only playing channels
+            SPUChannel* ThisChannel = &SPU.Channels[ c ];
+            
+            if( ThisChannel->State != IOPortValues::SPUChannelState_Playing )
+              continue;
+            
+            // pick sample at this position
+            SPUSound* ChannelSound = SPU.GetChannelSound( ThisChannel );
+            SPUSample PickedSample = ChannelSound->Samples[ (int)ThisChannel->Position ];
+            
+            // mix the sample
+            float TotalVolume = SPU.GlobalVolume * ThisChannel->Volume;
+            ThisSample.LeftSample  += TotalVolume * PickedSample.LeftSample;
+            ThisSample.RightSample += TotalVolume * PickedSample.RightSample;
+            
+            // advance at current speed
+            double PreviousPosition = ThisChannel->Position;
+            ThisChannel->Position += ThisChannel->Speed;
+            
+            // if loop is enabled, check for loop boundary
+            if( ThisChannel->LoopEnabled )
+            {
+                int32_t LoopStart = ChannelSound->LoopStart;
+                int32_t LoopEnd   = ChannelSound->LoopEnd;
+                
+                if( LoopEnd > LoopStart )
+                  if( PreviousPosition <= LoopEnd && ThisChannel->Position > LoopEnd )
+                  {
+                      double PartialAdvance = fmod( ThisChannel->Position - LoopStart, LoopEnd - LoopStart );
+                      ThisChannel->Position = LoopStart + PartialAdvance;
+                  }
+            }
+            
+            // if the sound ends, stop the channel
+            if( ThisChannel->Position > (ChannelSound->Length - 1) )
+              SPU.StopChannel( *ThisChannel );
+        }
+        
+        SPU.OutputBuffer.Samples[ s ] = ThisSample;
+    }
+}
+
+
+// =============================================================================
+//      BENCHMARK SETUP
+// =============================================================================
+
+
+// each channel plays its own sound with these settings;
+// samples are small enough that the sums never overflow,
+// and one channel at normal speed has a fractional position
+struct BenchmarkChannel
+{
+    int SoundLength;
+    double StartPosition;
+    float Speed;
+    float Volume;
+    bool Loop;
+};
+
+const BenchmarkChannel BenchmarkChannels[ Constants::SPUSoundChannels ] =
+{
+    {  44100, 0.0, 1.00f, 0.50f, false },
+    { 200000, 0.0, 1.00f, 1.00f, true  },
+    {   3000, 0.0, 1.00f, 0.25f, true  },
+    {    500, 0.0, 1.00f, 0.75f, false },
+    {  44100, 0.0, 0.50f, 0.50f, true  },
+    {  88200, 0.0, 2.00f, 0.50f, false },
+    {  30000, 0.0, 1.50f, 1.00f, true  },
+    {  10000, 0.0, 0.75f, 0.60f, false },
+    {  44100, 0.0, 1.00f, 0.40f, true  },
+    {  60000, 0.0, 3.25f, 0.50f, true  },
+    {  20000, 0.0, 0.33f, 0.90f, false },
+    {   1000, 0.0, 1.00f, 1.00f, true  },
+    {  50000, 0.0, 1.25f, 0.30f, false },
+    { 100000, 0.0, 8.00f, 0.50f, true  },
+    {   7000, 0.5, 1.00f, 0.80f, false },
+    {  15000, 0.0, 0.90f, 0.50f, true  }
+};
+
+// -----------------------------------------------------------------------------
+
+void PrepareBenchmarkSPU( V32SPU& SPU )
+{
+    SPU.BiosSound.Length = 0;
+    SPU.Reset();
+    
+    // pseudo-random, but the same in every run
+    uint32_t RandomState = 12345;
+    
+    for( int c = 0; c < Constants::SPUSoundChannels; c++ )
+    {
+        const BenchmarkChannel& Settings = BenchmarkChannels[ c ];
+        vector< SPUSample > Samples( Settings.SoundLength );
+        
+        for( SPUSample& Sample: Samples )
+        {
+            RandomState = RandomState * 1103515245 + 12345;
+            Sample.LeftSample  = (int16_t)((RandomState >> 8) % 4001) - 2000;
+            Sample.RightSample = (int16_t)((RandomState >> 20) % 4001) - 2000;
+        }
+        
+        SPUSound& Sound = SPU.CartridgeSounds[ c ];
+        SPU.LoadSound( Sound, &Samples[ 0 ], Samples.size() );
+        
+        // loop over the second half of the sound
+        Sound.PlayWithLoop = Settings.Loop;
+        Sound.LoopStart = Sound.Length / 2;
+        
+        SPUChannel& Channel = SPU.Channels[ c ];
+        Channel.AssignedSound = c;
+        Channel.Position = Settings.StartPosition;
+        Channel.Speed = Settings.Speed;
+        Channel.Volume = Settings.Volume;
+        Channel.LoopEnabled = Settings.Loop;
+        Channel.State = IOPortValues::SPUChannelState_Playing;
+    }
+    
+    SPU.LoadedCartridgeSounds = Constants::SPUSoundChannels;
+}
+
+// -----------------------------------------------------------------------------
+
+// sounds without loop are started again when they end
+void RestartStoppedChannels( V32SPU& SPU )
+{
+    for( SPUChannel& Channel: SPU.Channels )
+      if( Channel.State == IOPortValues::SPUChannelState_Stopped )
+        Channel.State = IOPortValues::SPUChannelState_Playing;
+}
+
+
+// =============================================================================
+//      RUNNING THE BENCHMARK
+// =============================================================================
+
+
+bool RunSPUBenchmark( int NumberOfFrames )
+{
+    // the SPU is big, so don't place it on the stack
+    unique_ptr< V32SPU > SPU( new V32SPU );
+    unique_ptr< V32SPU > ReferenceSPU( new V32SPU );
+    PrepareBenchmarkSPU( *SPU );
+    PrepareBenchmarkSPU( *ReferenceSPU );
+    
+    double Seconds = 0, ReferenceSeconds = 0;
+    int DifferentFrames = 0;
+    
+    for( int Frame = 0; Frame < NumberOfFrames; Frame++ )
+    {
+        auto StartTime = chrono::steady_clock::now();
+        SPU->UpdateOutputBuffer();
+        auto MiddleTime = chrono::steady_clock::now();
+        MixFrameByReference( *ReferenceSPU );
+        auto EndTime = chrono::steady_clock::now();
+        
+        Seconds += chrono::duration< double >( MiddleTime - StartTime ).count();
+        ReferenceSeconds += chrono::duration< double >( EndTime - MiddleTime ).count();
+        
+        if( memcmp( SPU->OutputBuffer.Samples, ReferenceSPU->OutputBuffer.Samples, sizeof(SPU->OutputBuffer.Samples) ) )
+          DifferentFrames++;
+        
+        RestartStoppedChannels( *SPU );
+        RestartStoppedChannels( *ReferenceSPU );
+    }
+    
+    cout << fixed << setprecision( 2 );
+    cout << "frames mixed: " << NumberOfFrames << " (" << Constants::SPUSoundChannels << " channels)" << endl;
+    cout << "mixer: " << (Seconds * 1000000 / NumberOfFrames) << " us per frame" << endl;
+    cout << "reference mixer: " << (ReferenceSeconds * 1000000 / NumberOfFrames) << " us per frame" << endl;
+    cout << "frames with different output: " << DifferentFrames << endl;
+    
+    return (DifferentFrames == 0);
+}
@@ -0,0 +1,33 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef SPUBENCHMARK_HPP
+    #define SPUBENCHMARK_HPP
+    
+    // include console logic headers
+    #include "ConsoleLogic/V32SPU.hpp"
+// *****************************************************************************
+
+
+// =============================================================================
+//      BENCHMARK FOR THE SPU MIXER
+// =============================================================================
+
+
+// the sample-major mixer that the SPU used before mixing
+// by channels; it is kept to check that both give the
+// same output and to compare their speed
+void MixFrameByReference( V32::V32SPU& SPU );
+
+// -----------------------------------------------------------------------------
+
+// mixes the given number of frames with all 16 channels
+// playing synthetic sounds at varied speeds and loops,
+// using both mixers; reports their times and any
+// differences in output, and returns false if any
+bool RunSPUBenchmark( int NumberOfFrames );
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
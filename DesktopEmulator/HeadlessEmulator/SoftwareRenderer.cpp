@@ -0,0 +1,817 @@
+// *****************************************************************************
+    // include project headers
+    #include "SoftwareRenderer.hpp"
+    
+    // include libpng headers
+    #include <png.h>                // [ libpng ] Main header
+    
+    // include C/C++ headers
+    #include <cmath>            // [ ANSI C ] Mathematics
+    #include <cstring>          // [ ANSI C ] Strings
+    #include <cstdio>           // [ ANSI C ] Standard I/O
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <stdexcept>        // [ C++ STL ] Exceptions
+    
+    // include SIMD intrinsics when available
+    #if defined( __SSE2__ )
+      #include <emmintrin.h>    // [ SSE2 ] Intrinsics
+    #endif
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+// positions are snapped to this fraction of a pixel
+const double SubpixelsPerPixel = 256;
+
+// to match llvmpipe, texel components are multiplied by the
+// multiply color as its shaders do for mediump values: both
+// are converted to half precision (texels truncating, the
+// multiply color rounding to nearest) and so is the product,
+// which is then rounded to 8 bits. All results only depend
+// on two 8-bit components, so we precalculate all of them
+uint8_t ComponentProducts[ 256 ][ 256 ];
+
+// -----------------------------------------------------------------------------
+
+// reduces a value in [0,1] to the 11 significant bits of a
+// half precision float (fewer for subnormal half floats)
+float ToHalfPrecision( float Value, bool Truncate )
+{
+    if( Value == 0 )
+      return 0;
+    
+    int Exponent;
+    frexp( Value, &Exponent );
+    float Step = ldexp( 1.0f, max( Exponent, -13 ) - 11 );
+    float Steps = Value / Step;
+    return (Truncate? trunc( Steps ) : nearbyint( Steps )) * Step;
+}
+
+// -----------------------------------------------------------------------------
+
+void InitComponentTable()
+{
+    for( int Multiply = 0; Multiply < 256; Multiply++ )
+    {
+        float HalfMultiply = ToHalfPrecision( Multiply / 255.0f, false );
+        
+        for( int Texel = 0; Texel < 256; Texel++ )
+        {
+            float HalfTexel = ToHalfPrecision( Texel / 255.0f, true );
+            float Product = ToHalfPrecision( HalfMultiply * HalfTexel, false );
+            ComponentProducts[ Multiply ][ Texel ] = (uint8_t)nearbyint( Product * 255.0f );
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// returns false for triangles with no area, that OpenGL would not draw
+bool PrepareTriangle( RasterTriangle& Triangle, const GPUPoint& P0, const GPUPoint& P1, const GPUPoint& P2 )
+{
+    const GPUPoint* Points[ 3 ] = { &P0, &P1, &P2 };
+    double X[ 3 ], Y[ 3 ];
+    
+    for( int i = 0; i < 3; i++ )
+    {
+        X[ i ] = floor( Points[ i ]->x * SubpixelsPerPixel + 0.5 );
+        Y[ i ] = floor( Points[ i ]->y * SubpixelsPerPixel + 0.5 );
+    }
+    
+    double Area = (X[ 1 ] - X[ 0 ]) * (Y[ 2 ] - Y[ 0 ]) - (X[ 2 ] - X[ 0 ]) * (Y[ 1 ] - Y[ 0 ]);
+    
+    if( Area == 0 )
+      return false;
+    
+    // build edge functions, oriented to be positive inside
+    for( int i = 0; i < 3; i++ )
+    {
+        int Next = (i + 1) % 3;
+        int Opposite = (i + 2) % 3;
+        
+        double A = -(Y[ Next ] - Y[ i ]);
+        double B = X[ Next ] - X[ i ];
+        double C = -(A * X[ i ] + B * Y[ i ]);
+        
+        if( A * X[ Opposite ] + B * Y[ Opposite ] + C < 0 )
+        {
+            A = -A;
+            B = -B;
+            C = -C;
+        }
+        
+        Triangle.EdgeA[ i ] = A;
+        Triangle.EdgeB[ i ] = B;
+        Triangle.EdgeC[ i ] = C;
+        
+        // left edges have the inside to their right; OpenGL
+        // stores the framebuffer bottom-up, so its top-left rule
+        // takes horizontal edges that have the inside above here
+        Triangle.EdgeIncludesTies[ i ] = (A > 0) || (A == 0 && B < 0);
+    }
+    
+    // determine the affected rows (with some margin,
+    // since spans are determined exactly for each row)
+    double MinY = min( min( Y[ 0 ], Y[ 1 ] ), Y[ 2 ] ) / SubpixelsPerPixel;
+    double MaxY = max( max( Y[ 0 ], Y[ 1 ] ), Y[ 2 ] ) / SubpixelsPerPixel;
+    Triangle.MinY = (int)min( max( floor( MinY ), 0.0 ), (double)Constants::ScreenHeight );
+    Triangle.MaxY = (int)min( max( ceil( MaxY ) + 1, 0.0 ), (double)Constants::ScreenHeight );
+    
+    // interpolate texture coordinates as a plane,
+    // using the snapped positions (now in pixels)
+    double DX1 = (X[ 1 ] - X[ 0 ]) / SubpixelsPerPixel;
+    double DY1 = (Y[ 1 ] - Y[ 0 ]) / SubpixelsPerPixel;
+    double DX2 = (X[ 2 ] - X[ 0 ]) / SubpixelsPerPixel;
+    double DY2 = (Y[ 2 ] - Y[ 0 ]) / SubpixelsPerPixel;
+    double Determinant = DX1 * DY2 - DX2 * DY1;
+    double X0 = X[ 0 ] / SubpixelsPerPixel;
+    double Y0 = Y[ 0 ] / SubpixelsPerPixel;
+    
+    double DTX1 = (double)P1.texture_x - P0.texture_x;
+    double DTX2 = (double)P2.texture_x - P0.texture_x;
+    Triangle.TextureXPerX = (DTX1 * DY2 - DTX2 * DY1) / Determinant;
+    Triangle.TextureXPerY = (DX1 * DTX2 - DX2 * DTX1) / Determinant;
+    Triangle.TextureX0 = P0.texture_x - Triangle.TextureXPerX * X0 - Triangle.TextureXPerY * Y0;
+    
+    double DTY1 = (double)P1.texture_y - P0.texture_y;
+    double DTY2 = (double)P2.texture_y - P0.texture_y;
+    Triangle.TextureYPerX = (DTY1 * DY2 - DTY2 * DY1) / Determinant;
+    Triangle.TextureYPerY = (DX1 * DTY2 - DX2 * DTY1) / Determinant;
+    Triangle.TextureY0 = P0.texture_y - Triangle.TextureYPerX * X0 - Triangle.TextureYPerY * Y0;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+inline bool IsInsideEdge( const RasterTriangle& Triangle, int Edge, int x, double RowTerm )
+{
+    double Value = Triangle.EdgeA[ Edge ] * (x * SubpixelsPerPixel + SubpixelsPerPixel / 2) + RowTerm;
+    return (Value > 0) || (Value == 0 && Triangle.EdgeIncludesTies[ Edge ]);
+}
+
+// -----------------------------------------------------------------------------
+
+// finds the pixels in row y whose centers are inside the triangle;
+// returns false if there are none
+bool GetTriangleSpan( const RasterTriangle& Triangle, int y, int& MinX, int& MaxX )
+{
+    double RowY = y * SubpixelsPerPixel + SubpixelsPerPixel / 2;
+    MinX = 0;
+    MaxX = Constants::ScreenWidth - 1;
+    
+    for( int Edge = 0; Edge < 3; Edge++ )
+    {
+        double A = Triangle.EdgeA[ Edge ];
+        double RowTerm = Triangle.EdgeB[ Edge ] * RowY + Triangle.EdgeC[ Edge ];
+        
+        // horizontal edges accept or reject whole rows
+        if( A == 0 )
+        {
+            if( !IsInsideEdge( Triangle, Edge, 0, RowTerm ) )
+              return false;
+            
+            continue;
+        }
+        
+        // estimate the crossing point, then correct it with
+        // exact tests (they are exact with snapped positions)
+        double Crossing = (-RowTerm / A - SubpixelsPerPixel / 2) / SubpixelsPerPixel;
+        Crossing = min( max( Crossing, -2.0 ), (double)Constants::ScreenWidth + 1 );
+        
+        if( A > 0 )
+        {
+            int x = (int)ceil( Crossing );
+            
+            while( x < Constants::ScreenWidth && !IsInsideEdge( Triangle, Edge, x, RowTerm ) )
+              x++;
+            
+            while( x > 0 && IsInsideEdge( Triangle, Edge, x - 1, RowTerm ) )
+              x--;
+            
+            MinX = max( MinX, x );
+        }
+        
+        else
+        {
+            int x = (int)floor( Crossing );
+            
+            while( x >= 0 && !IsInsideEdge( Triangle, Edge, x, RowTerm ) )
+              x--;
+            
+            while( x < Constants::ScreenWidth - 1 && IsInsideEdge( Triangle, Edge, x + 1, RowTerm ) )
+              x++;
+            
+            MaxX = min( MaxX, x );
+        }
+    }
+    
+    return (MinX <= MaxX);
+}
+
+// -----------------------------------------------------------------------------
+
+// multiplies 8-bit components as if they were normalized to
+// [0,1], rounding the result to 8 bits (with the same integer
+// approximation of the division by 255 that llvmpipe uses)
+inline int MultiplyComponents( int Component1, int Component2 )
+{
+    int Product = Component1 * Component2;
+    return (Product + (Product >> 8) + 128) >> 8;
+}
+
+// -----------------------------------------------------------------------------
+
+#if defined( __SSE2__ )
+
+// same as MultiplyComponents, for 4 values at once; since
+// all values fit in 16 bits, 16-bit multiplications are used
+inline __m128i MultiplyComponents( __m128i Components1, __m128i Components2 )
+{
+    __m128i Products = _mm_mullo_epi16( Components1, Components2 );
+    Products = _mm_add_epi32( Products, _mm_srli_epi32( Products, 8 ) );
+    Products = _mm_add_epi32( Products, _mm_set1_epi32( 128 ) );
+    return _mm_srli_epi32( Products, 8 );
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+
+// blends a span of source colors with the framebuffer, as the GL
+// blend equations do for 8-bit framebuffers: each term of the
+// equation is rounded to 8 bits, and terms are added with
+// saturation. The vector and scalar paths do the same integer
+// operations, so they produce the same pixels
+void BlendSpan( GPUColor* Destination, const GPUColor* Source, int SpanLength, IOPortValues BlendingMode )
+{
+    int i = 0;
+    
+    // blend 4 pixels at a time
+    #if defined( __SSE2__ )
+      const __m128i ComponentMask = _mm_set1_epi32( 0xFF );
+      const __m128i AlphaMask = _mm_set1_epi32( (int)0xFF000000 );
+      
+      for( ; i + 4 <= SpanLength; i += 4 )
+      {
+          // separate the destination components
+          __m128i Pixels = _mm_loadu_si128( (const __m128i*)(Destination + i) );
+          __m128i DestinationR = _mm_and_si128( Pixels, ComponentMask );
+          __m128i DestinationG = _mm_and_si128( _mm_srli_epi32( Pixels, 8 ), ComponentMask );
+          __m128i DestinationB = _mm_and_si128( _mm_srli_epi32( Pixels, 16 ), ComponentMask );
+          
+          // source colors weighted by their alpha
+          __m128i SourcePixels = _mm_loadu_si128( (const __m128i*)(Source + i) );
+          __m128i Alpha = _mm_srli_epi32( SourcePixels, 24 );
+          __m128i ResultR = MultiplyComponents( _mm_and_si128( SourcePixels, ComponentMask ), Alpha );
+          __m128i ResultG = MultiplyComponents( _mm_and_si128( _mm_srli_epi32( SourcePixels, 8 ), ComponentMask ), Alpha );
+          __m128i ResultB = MultiplyComponents( _mm_and_si128( _mm_srli_epi32( SourcePixels, 16 ), ComponentMask ), Alpha );
+          
+          // (values are kept within 16 bits, so saturation
+          // can be done with the 16-bit min and max)
+          if( BlendingMode == IOPortValues::GPUBlendingMode_Alpha )
+          {
+              __m128i Remaining = _mm_sub_epi32( ComponentMask, Alpha );
+              ResultR = _mm_min_epi16( _mm_add_epi32( ResultR, MultiplyComponents( DestinationR, Remaining ) ), ComponentMask );
+              ResultG = _mm_min_epi16( _mm_add_epi32( ResultG, MultiplyComponents( DestinationG, Remaining ) ), ComponentMask );
+              ResultB = _mm_min_epi16( _mm_add_epi32( ResultB, MultiplyComponents( DestinationB, Remaining ) ), ComponentMask );
+          }
+          
+          else if( BlendingMode == IOPortValues::GPUBlendingMode_Add )
+          {
+              ResultR = _mm_min_epi16( _mm_add_epi32( ResultR, DestinationR ), ComponentMask );
+              ResultG = _mm_min_epi16( _mm_add_epi32( ResultG, DestinationG ), ComponentMask );
+              ResultB = _mm_min_epi16( _mm_add_epi32( ResultB, DestinationB ), ComponentMask );
+          }
+          
+          else
+          {
+              ResultR = _mm_max_epi16( _mm_sub_epi32( DestinationR, ResultR ), _mm_setzero_si128() );
+              ResultG = _mm_max_epi16( _mm_sub_epi32( DestinationG, ResultG ), _mm_setzero_si128() );
+              ResultB = _mm_max_epi16( _mm_sub_epi32( DestinationB, ResultB ), _mm_setzero_si128() );
+          }
+        
+          // join the components again; alpha is kept unchanged
+          __m128i Result = _mm_and_si128( Pixels, AlphaMask );
+          Result = _mm_or_si128( Result, ResultR );
+          Result = _mm_or_si128( Result, _mm_slli_epi32( ResultG, 8 ) );
+          Result = _mm_or_si128( Result, _mm_slli_epi32( ResultB, 16 ) );
+          _mm_storeu_si128( (__m128i*)(Destination + i), Result );
+      }
+    #endif
+    
+    // blend any remaining pixels one by one
+    for( ; i < SpanLength; i++ )
+    {
+        int Alpha = Source[ i ].A;
+        int ResultR = MultiplyComponents( Source[ i ].R, Alpha );
+        int ResultG = MultiplyComponents( Source[ i ].G, Alpha );
+        int ResultB = MultiplyComponents( Source[ i ].B, Alpha );
+        
+        if( BlendingMode == IOPortValues::GPUBlendingMode_Alpha )
+        {
+            int Remaining = 255 - Alpha;
+            ResultR = min( ResultR + MultiplyComponents( Destination[ i ].R, Remaining ), 255 );
+            ResultG = min( ResultG + MultiplyComponents( Destination[ i ].G, Remaining ), 255 );
+            ResultB = min( ResultB + MultiplyComponents( Destination[ i ].B, Remaining ), 255 );
+        }
+        
+        else if( BlendingMode == IOPortValues::GPUBlendingMode_Add )
+        {
+            ResultR = min( ResultR + Destination[ i ].R, 255 );
+            ResultG = min( ResultG + Destination[ i ].G, 255 );
+            ResultB = min( ResultB + Destination[ i ].B, 255 );
+        }
+        
+        else
+        {
+            ResultR = max( Destination[ i ].R - ResultR, 0 );
+            ResultG = max( Destination[ i ].G - ResultG, 0 );
+            ResultB = max( Destination[ i ].B - ResultB, 0 );
+        }
+        
+        Destination[ i ].R = ResultR;
+        Destination[ i ].G = ResultG;
+        Destination[ i ].B = ResultB;
+    }
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER: INSTANCE HANDLING
+// =============================================================================
+
+
+SoftwareRenderer::SoftwareRenderer()
+{
+    InitComponentTable();
+    
+    // same initial state as VideoOutput
+    MultiplyColor = GPUColor{ 255, 255, 255, 255 };
+    BlendingMode = IOPortValues::GPUBlendingMode_Alpha;
+    SelectedTexture = -1;
+    
+    // use as many threads as the host has
+    // (they are only created on first render)
+    RequestedFrames = 0;
+    PendingBands = 0;
+    WorkersActive = false;
+    SetNumberOfThreads( thread::hardware_concurrency() );
+    
+    // framebuffer starts black
+    Framebuffer.resize( Constants::ScreenPixels, GPUColor{ 0, 0, 0, 255 } );
+}
+
+// -----------------------------------------------------------------------------
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    StopWorkers();
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER: CONFIGURATION
+// =============================================================================
+
+
+void SoftwareRenderer::SetNumberOfThreads( int Threads )
+{
+    // workers for the previous bands are not valid anymore
+    StopWorkers();
+    
+    // each thread needs at least 1 row
+    NumberOfThreads = min( max( Threads, 1 ), Constants::ScreenHeight );
+    RowsPerBand = (Constants::ScreenHeight + NumberOfThreads - 1) / NumberOfThreads;
+}
+
+// -----------------------------------------------------------------------------
+
+int SoftwareRenderer::GetNumberOfThreads()
+{
+    return NumberOfThreads;
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER: GPU CALLBACKS
+// =============================================================================
+
+
+void SoftwareRenderer::ClearScreen( GPUColor ClearColor )
+{
+    // like VideoOutput, draw a full-screen quad
+    // with the white texture and the clear color
+    const GPUQuad ScreenQuad =
+    {
+        {
+            { 0, 0, 0.5, 0.5 },
+            { Constants::ScreenWidth, 0, 0.5, 0.5 },
+            { 0, Constants::ScreenHeight, 0.5, 0.5 },
+            { Constants::ScreenWidth, Constants::ScreenHeight, 0.5, 0.5 }
+        }
+    };
+    
+    AddQuadCommand( ScreenQuad, nullptr, ClearColor );
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::DrawQuad( const GPUQuad& Quad )
+{
+    AddQuadCommand( Quad, GetTexture( SelectedTexture ), MultiplyColor );
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::SetMultiplyColor( GPUColor NewMultiplyColor )
+{
+    MultiplyColor = NewMultiplyColor;
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::SetBlendingMode( int NewBlendingMode )
+{
+    // ignore invalid values, like VideoOutput
+    if( NewBlendingMode < (int)IOPortValues::GPUBlendingMode_Alpha
+    ||  NewBlendingMode > (int)IOPortValues::GPUBlendingMode_Subtract )
+      return;
+    
+    BlendingMode = (IOPortValues)NewBlendingMode;
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::SelectTexture( int GPUTextureID )
+{
+    SelectedTexture = GPUTextureID;
+}
+
+// -----------------------------------------------------------------------------
+
+// this can be called from any thread, since it
+// only writes to this texture's prepared copy
+void SoftwareRenderer::PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+{
+    RendererTexture& Texture = PreparedTextures[ GPUTextureID ];
+    const GPUColor* TexturePixels = (const GPUColor*)Pixels;
+    Texture.Pixels.assign( TexturePixels, TexturePixels + Width * Height );
+    Texture.Width = Width;
+    Texture.Height = Height;
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height )
+{
+    // pending commands may use the previous texture
+    RenderFrame();
+    
+    RendererTexture& Texture = (GPUTextureID >= 0? CartridgeTextures[ GPUTextureID ] : BiosTexture);
+    
+    // use the prepared copy, when there is one
+    if( GPUTextureID >= 0 && !PreparedTextures[ GPUTextureID ].Pixels.empty() )
+    {
+        Texture.Pixels.swap( PreparedTextures[ GPUTextureID ].Pixels );
+        vector< GPUColor >().swap( PreparedTextures[ GPUTextureID ].Pixels );
+    }
+    
+    else
+    {
+        const GPUColor* TexturePixels = (const GPUColor*)Pixels;
+        Texture.Pixels.assign( TexturePixels, TexturePixels + Width * Height );
+    }
+    
+    Texture.Width = Width;
+    Texture.Height = Height;
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::UnloadCartridgeTextures()
+{
+    RenderFrame();
+    
+    // also discard copies prepared for a load that failed
+    for( int i = 0; i < Constants::GPUMaximumCartridgeTextures; i++ )
+    {
+        vector< GPUColor >().swap( CartridgeTextures[ i ].Pixels );
+        vector< GPUColor >().swap( PreparedTextures[ i ].Pixels );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::UnloadBiosTexture()
+{
+    RenderFrame();
+    vector< GPUColor >().swap( BiosTexture.Pixels );
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER: INTERNAL FUNCTIONS
+// =============================================================================
+
+
+const RendererTexture* SoftwareRenderer::GetTexture( int GPUTextureID )
+{
+    RendererTexture* Texture = &BiosTexture;
+    
+    if( GPUTextureID >= 0 && GPUTextureID < Constants::GPUMaximumCartridgeTextures )
+      Texture = &CartridgeTextures[ GPUTextureID ];
+    
+    // OpenGL samples unloaded textures as black
+    static const RendererTexture NoTexture =
+    {
+        vector< GPUColor >( Constants::GPUTextureSize * Constants::GPUTextureSize, GPUColor{ 0, 0, 0, 255 } ),
+        Constants::GPUTextureSize,
+        Constants::GPUTextureSize
+    };
+    
+    if( Texture->Pixels.empty() )
+      return &NoTexture;
+    
+    return Texture;
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::AddQuadCommand( const GPUQuad& Quad, const RendererTexture* Texture, GPUColor CommandColor )
+{
+    RenderCommand NewCommand;
+    NewCommand.Texture = Texture;
+    NewCommand.MultiplyColor = CommandColor;
+    NewCommand.BlendingMode = BlendingMode;
+    NewCommand.NumberOfTriangles = 0;
+    
+    // same 2 triangles as VideoOutput: vertices 0-1-2 and 1-2-3
+    const GPUPoint* V = Quad.Vertices;
+    
+    if( PrepareTriangle( NewCommand.Triangles[ NewCommand.NumberOfTriangles ], V[ 0 ], V[ 1 ], V[ 2 ] ) )
+      NewCommand.NumberOfTriangles++;
+    
+    if( PrepareTriangle( NewCommand.Triangles[ NewCommand.NumberOfTriangles ], V[ 1 ], V[ 2 ], V[ 3 ] ) )
+      NewCommand.NumberOfTriangles++;
+    
+    if( NewCommand.NumberOfTriangles > 0 )
+      Commands.push_back( NewCommand );
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::RenderBand( int Band )
+{
+    int MinY = Band * RowsPerBand;
+    int MaxY = min( MinY + RowsPerBand, Constants::ScreenHeight );
+    
+    // source colors for the current span, already multiplied
+    GPUColor Source[ Constants::ScreenWidth ];
+    
+    const GPUColor White = { 255, 255, 255, 255 };
+    const GPUColor Transparent = { 0, 0, 0, 0 };
+    const int TextureSize = Constants::GPUTextureSize;
+    
+    for( const RenderCommand& Command: Commands )
+    {
+        const uint8_t* MultiplyR = ComponentProducts[ Command.MultiplyColor.R ];
+        const uint8_t* MultiplyG = ComponentProducts[ Command.MultiplyColor.G ];
+        const uint8_t* MultiplyB = ComponentProducts[ Command.MultiplyColor.B ];
+        const uint8_t* MultiplyA = ComponentProducts[ Command.MultiplyColor.A ];
+        
+        // opaque solid colors can just be copied
+        bool IsOpaqueFill = !Command.Texture && Command.MultiplyColor.A == 255
+                         && Command.BlendingMode == IOPortValues::GPUBlendingMode_Alpha;
+                        
+        for( int t = 0; t < Command.NumberOfTriangles; t++ )
+        {
+            const RasterTriangle& Triangle = Command.Triangles[ t ];
+            int FirstY = max( Triangle.MinY, MinY );
+            int LastY = min( Triangle.MaxY, MaxY );
+            
+            for( int y = FirstY; y < LastY; y++ )
+            {
+                int MinX, MaxX;
+                
+                if( !GetTriangleSpan( Triangle, y, MinX, MaxX ) )
+                  continue;
+                
+                GPUColor* Destination = &Framebuffer[ y * Constants::ScreenWidth + MinX ];
+                int SpanLength = MaxX - MinX + 1;
+                
+                if( IsOpaqueFill )
+                {
+                    GPUColor FillColor = Command.MultiplyColor;
+                    fill( Destination, Destination + SpanLength, FillColor );
+                    continue;
+                }
+                
+                // PASS 1: sample the texture at pixel centers
+                double PixelY = y + 0.5;
+                double RowTextureX = Triangle.TextureXPerY * PixelY + Triangle.TextureX0;
+                double RowTextureY = Triangle.TextureYPerY * PixelY + Triangle.TextureY0;
+                
+                for( int i = 0; i < SpanLength; i++ )
+                {
+                    GPUColor Texel = White;
+                    
+                    if( Command.Texture )
+                    {
+                        double PixelX = MinX + i + 0.5;
+                        double TextureX = (Triangle.TextureXPerX * PixelX + RowTextureX) * TextureSize;
+                        double TextureY = (Triangle.TextureYPerX * PixelX + RowTextureY) * TextureSize;
+                        
+                        // nearest sampling, with clamp to edge
+                        int TexelX = (int)min( max( floor( TextureX ), 0.0 ), TextureSize - 1.0 );
+                        int TexelY = (int)min( max( floor( TextureY ), 0.0 ), TextureSize - 1.0 );
+                        
+                        // outside of the image everything is transparent
+                        const RendererTexture& Texture = *Command.Texture;
+                        
+                        if( TexelX < Texture.Width && TexelY < Texture.Height )
+                          Texel = Texture.Pixels[ TexelY * Texture.Width + TexelX ];
+                        else
+                          Texel = Transparent;
+                    }
+                    
+                    Source[ i ].R = MultiplyR[ Texel.R ];
+                    Source[ i ].G = MultiplyG[ Texel.G ];
+                    Source[ i ].B = MultiplyB[ Texel.B ];
+                    Source[ i ].A = MultiplyA[ Texel.A ];
+                }
+                
+                // PASS 2: blend with the framebuffer
+                BlendSpan( Destination, Source, SpanLength, Command.BlendingMode );
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::StartWorkers()
+{
+    if( WorkersActive )
+      return;
+    
+    // band 0 is always left for the calling thread
+    int NumberOfBands = (Constants::ScreenHeight + RowsPerBand - 1) / RowsPerBand;
+    WorkersActive = true;
+    
+    for( int Band = 1; Band < NumberOfBands; Band++ )
+      Workers.push_back( thread( &SoftwareRenderer::WorkerLoop, this, Band, RequestedFrames ) );
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::StopWorkers()
+{
+    if( !WorkersActive )
+      return;
+    
+    {
+        lock_guard< mutex > Lock( WorkersMutex );
+        WorkersActive = false;
+    }
+    
+    WorkersCondition.notify_all();
+    
+    for( thread& Worker: Workers )
+      Worker.join();
+    
+    Workers.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::WorkerLoop( int Band, uint64_t RenderedFrames )
+{
+    // frames requested before this thread was created are
+    // not counted: the thread may start after a new request
+    unique_lock< mutex > Lock( WorkersMutex );
+    
+    while( true )
+    {
+        WorkersCondition.wait( Lock, [ & ]{ return RequestedFrames != RenderedFrames || !WorkersActive; } );
+        
+        if( !WorkersActive )
+          return;
+        
+        // render without the lock so bands run in parallel
+        RenderedFrames = RequestedFrames;
+        Lock.unlock();
+        RenderBand( Band );
+        Lock.lock();
+        
+        PendingBands--;
+        
+        if( PendingBands == 0 )
+          WorkersCondition.notify_all();
+    }
+}
+
+
+// =============================================================================
+//      SOFTWARE RENDERER: FRAME RENDERING
+// =============================================================================
+
+
+void SoftwareRenderer::RenderFrame()
+{
+    if( Commands.empty() )
+      return;
+    
+    // the screen is split in bands of consecutive rows;
+    // since each thread only writes to its own band, all
+    // of them can process the whole command list in order
+    StartWorkers();
+    
+    {
+        lock_guard< mutex > Lock( WorkersMutex );
+        RequestedFrames++;
+        PendingBands = Workers.size();
+    }
+    
+    WorkersCondition.notify_all();
+    
+    // the first band is done by this thread
+    RenderBand( 0 );
+    
+    // commands can only be removed when all bands are done
+    {
+        unique_lock< mutex > Lock( WorkersMutex );
+        WorkersCondition.wait( Lock, [ this ]{ return PendingBands == 0; } );
+    }
+    
+    Commands.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+void SoftwareRenderer::SaveScreenshot( const string& FilePath )
+{
+    // framebuffer rows are already in top to bottom order
+    vector< png_byte* > RowPointers( Constants::ScreenHeight );
+    
+    for( int y = 0; y < Constants::ScreenHeight; y++ )
+      RowPointers[ y ] = (png_byte*)&Framebuffer[ y * Constants::ScreenWidth ];
+    
+    // open output file
+    FILE *PNGFile = fopen( FilePath.c_str(), "wb" );
+    
+    if( !PNGFile )
+      throw runtime_error( "cannot open screenshot file \"" + FilePath + "\"" );
+    
+    // initialize PNG functions
+    png_struct* PNGHandler = png_create_write_struct( PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr );
+    png_info* PNGInfo = (PNGHandler? png_create_info_struct( PNGHandler ) : nullptr);
+    
+    if( !PNGInfo )
+    {
+        fclose( PNGFile );
+        png_destroy_write_struct( &PNGHandler, nullptr );
+        throw runtime_error( "cannot create PNG handler" );
+    }
+    
+    // define a callback function expected by libpng for error handling
+    if( setjmp( png_jmpbuf(PNGHandler) ) )
+    {
+        fclose( PNGFile );
+        png_destroy_write_struct( &PNGHandler, &PNGInfo );
+        throw runtime_error( "cannot write PNG file \"" + FilePath + "\"" );
+    }
+    
+    // define output as 8bit depth in RGBA format
+    png_init_io( PNGHandler, PNGFile );
+    
+    png_set_IHDR
+    (
+        PNGHandler,
+        PNGInfo,
+        Constants::ScreenWidth,
+        Constants::ScreenHeight,
+        8,
+        PNG_COLOR_TYPE_RGBA,
+        PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_DEFAULT,
+        PNG_FILTER_TYPE_DEFAULT
+    );
+    
+    // write the image
+    png_write_info( PNGHandler, PNGInfo );
+    png_write_image( PNGHandler, &RowPointers[ 0 ] );
+    png_write_end( PNGHandler, nullptr );
+    
+    // clean-up
+    fclose( PNGFile );
+    png_destroy_write_struct( &PNGHandler, &PNGInfo );
+}
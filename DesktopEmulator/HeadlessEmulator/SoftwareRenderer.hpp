@@ -0,0 +1,157 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef SOFTWARERENDERER_HPP
+    #define SOFTWARERENDERER_HPP
+    
+    // include common Vircon headers
+    #include "../VirconDefinitions/DataStructures.hpp"
+    #include "../VirconDefinitions/Constants.hpp"
+    #include "../VirconDefinitions/Enumerations.hpp"
+    
+    // include console logic headers
+    #include "ConsoleLogic/ExternalInterfaces.hpp"
+    #include "ConsoleLogic/GPUCommandList.hpp"
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <thread>           // [ C++ STL ] Threads
+    #include <mutex>            // [ C++ STL ] Mutexes
+    #include <condition_variable>  // [ C++ STL ] Condition variables
+// *****************************************************************************
+
+
+// =============================================================================
+//      SOFTWARE RENDERING OF GPU COMMANDS
+// =============================================================================
+
+
+// one of the 2 triangles that OpenGL draws for each quad,
+// already prepared for rasterization: positions are snapped
+// to 1/256 of a pixel (as GPUs usually do) and all values
+// are given as linear functions of the pixel center position
+struct RasterTriangle
+{
+    // rows covered (first included, last excluded)
+    int MinY, MaxY;
+    
+    // inside when A*x + B*y + C >= 0, in subpixel units;
+    // ties are only accepted for top and left edges
+    double EdgeA[ 3 ], EdgeB[ 3 ], EdgeC[ 3 ];
+    bool EdgeIncludesTies[ 3 ];
+    
+    // texture coordinates as functions of position (in pixels)
+    double TextureXPerX, TextureXPerY, TextureX0;
+    double TextureYPerX, TextureYPerY, TextureY0;
+};
+
+// -----------------------------------------------------------------------------
+
+// textures are kept with the size of their images; the
+// rest of the 1024x1024 texture area is transparent
+struct RendererTexture
+{
+    std::vector< V32::GPUColor > Pixels;
+    int Width, Height;
+};
+
+// -----------------------------------------------------------------------------
+
+// draw commands are recorded with all the state they use,
+// so that the whole frame can be rendered later at once
+struct RenderCommand
+{
+    RasterTriangle Triangles[ 2 ];
+    int NumberOfTriangles;
+    
+    // a null texture is a solid white texture
+    const RendererTexture* Texture;
+    V32::GPUColor MultiplyColor;
+    V32::IOPortValues BlendingMode;
+};
+
+// -----------------------------------------------------------------------------
+
+// reproduces what VideoOutput does with OpenGL: nearest
+// texture sampling, multiply color and the 3 blending modes;
+// the screen is split in horizontal bands that are rendered
+// in parallel, each by its own thread (threads are created
+// once and then kept waiting for the next frame)
+class SoftwareRenderer: public V32::GPUCommandReceiver
+{
+    private:
+        
+        // copies of all loaded textures
+        RendererTexture BiosTexture;
+        RendererTexture CartridgeTextures[ V32::Constants::GPUMaximumCartridgeTextures ];
+        
+        // copies made in advance by worker threads, that
+        // are moved to the ones above when they are loaded
+        RendererTexture PreparedTextures[ V32::Constants::GPUMaximumCartridgeTextures ];
+        
+        // current render state
+        V32::GPUColor MultiplyColor;
+        V32::IOPortValues BlendingMode;
+        int SelectedTexture;
+        
+        // commands pending for the current frame
+        std::vector< RenderCommand > Commands;
+        int NumberOfThreads;
+        int RowsPerBand;
+        
+        // worker threads render all bands except the
+        // first one, that is done by the calling thread
+        std::vector< std::thread > Workers;
+        std::mutex WorkersMutex;
+        std::condition_variable WorkersCondition;
+        uint64_t RequestedFrames;
+        int PendingBands;
+        bool WorkersActive;
+        
+        // internal functions
+        const RendererTexture* GetTexture( int GPUTextureID );
+        void AddQuadCommand( const V32::GPUQuad& Quad, const RendererTexture* Texture, V32::GPUColor CommandColor );
+        void RenderBand( int Band );
+        void StartWorkers();
+        void StopWorkers();
+        void WorkerLoop( int Band, uint64_t RenderedFrames );
+
+    public:
+        
+        // rendered image, rows from top to bottom
+        // (like the OpenGL framebuffer, it has no alpha)
+        std::vector< V32::GPUColor > Framebuffer;
+
+    public:
+        
+        // instance handling
+        SoftwareRenderer();
+       ~SoftwareRenderer();
+        
+        // configuration
+        void SetNumberOfThreads( int Threads );
+        int GetNumberOfThreads();
+        
+        // GPU callbacks
+        void ClearScreen( V32::GPUColor ClearColor );
+        void DrawQuad( const V32::GPUQuad& Quad );
+        void SetMultiplyColor( V32::GPUColor NewMultiplyColor );
+        void SetBlendingMode( int NewBlendingMode );
+        void SelectTexture( int GPUTextureID );
+        void PrepareTexture( int GPUTextureID, void* Pixels, int Width, int Height );
+        void LoadTexture( int GPUTextureID, void* Pixels, int Width, int Height );
+        void UnloadCartridgeTextures();
+        void UnloadBiosTexture();
+        
+        // draws all commands recorded since the last call
+        void RenderFrame();
+        
+        // output of the rendered image
+        void SaveScreenshot( const std::string& FilePath );
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -25,3 +25,9 @@ bool DisableWarnings = false;
 string AssemblerFolder;
 int InitialROMAddress = Constants::CartridgeProgramROMFirstAddress;
 bool CreateDebugVersion = false;
+
+// optimization of the source code (it applies
+// to every file, so it is shared by all of them)
+bool EnablePeephole = false;
+bool ReportPeephole = false;
+PeepholeOptimizer Peephole;
@@ -3,6 +3,9 @@
     #ifndef GLOBALS_HPP
     #define GLOBALS_HPP
     
+    // include infrastructure headers
+    #include "../DevToolsInfrastructure/PeepholeOptimizer.hpp"
+    
     // include C/C++ headers
     #include <string>           // [ C++ STL ] Strings
 // *****************************************************************************
@@ -23,6 +26,12 @@ extern std::string AssemblerFolder;
 extern int InitialROMAddress;
 extern bool CreateDebugVersion;
 
+// optimization of the source code (it applies
+// to every file, so it is shared by all of them)
+extern bool EnablePeephole;
+extern bool ReportPeephole;
+extern PeepholeOptimizer Peephole;
+
 
 // *****************************************************************************
     // end include guard
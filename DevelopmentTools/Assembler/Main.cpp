@@ -54,6 +54,10 @@ void PrintUsage()
     cout << "  -v           Displays additional information (verbose)" << endl;
     cout << "  -w           Inhibit all warnings" << endl;
     cout << "  -g <ref>     Outputs an additional file with debug info" << endl;
+    cout << "  --peephole   Optimizes short sequences of instructions" << endl;
+    cout << "  --peephole-stats" << endl;
+    cout << "               Shows how many times each peephole rule" << endl;
+    cout << "               was applied" << endl;
     cout << "The possible reference modes for -g are the following:" << endl;
     cout << "  program --> '-g' addresses in words relative to program start" << endl;
     cout << "  vbin    --> '-g' addresses in bytes relative to VBIN file" << endl;
@@ -209,6 +213,18 @@ int main( int NumberOfArguments, char* Arguments[] )
                 continue;
             }
             
+            if( ArgumentsUTF8[i] == string("--peephole") )
+            {
+                EnablePeephole = true;
+                continue;
+            }
+            
+            if( ArgumentsUTF8[i] == string("--peephole-stats") )
+            {
+                ReportPeephole = true;
+                continue;
+            }
+            
             // these options are accepted but have no effect
             if( ArgumentsUTF8[i] == string("-s")  )  continue;
             
@@ -303,6 +319,10 @@ int main( int NumberOfArguments, char* Arguments[] )
         if( DebugMode )
           SaveEmitterLog( OutputPath + ".emitter.log", Parser );
         
+        // the optimizer was applied by the lexer to every file
+        if( EnablePeephole && ReportPeephole )
+          Peephole.PrintStatistics();
+        
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         // open output file, in binary!
         // otherwise it replaces bytes '\n' with '\r\n', breaking the ROM
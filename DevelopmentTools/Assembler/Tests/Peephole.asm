@@ -0,0 +1,52 @@
+  ; each section below contains one pattern
+  ; rewritten when assembling with --peephole
+  jmp __main
+  ; -------------------------------
+  
+__jump_to_next_label:
+  mov R0, 1
+  jmp __jump_to_next_label_end
+  
+__jump_to_next_label_end:
+  hlt
+  
+__jump_over_jump:
+  in R0, INP_GamepadButtonA
+  jt R0, __jump_over_jump_skip
+  jmp __jump_over_jump_end
+  
+__jump_over_jump_skip:
+  mov R0, 2
+  
+__jump_over_jump_end:
+  hlt
+  
+__inverted_comparison:
+  in R0, INP_GamepadButtonB
+  ieq R0, 0
+  bnot R0
+  jf R0, __inverted_comparison_end
+  mov R0, 3
+  
+__inverted_comparison_end:
+  hlt
+  
+__reload_after_store:
+  in R0, INP_GamepadLeft
+  mov [0x100], R0
+  mov R1, [0x100]
+  iadd R1, 1
+  out GPU_DrawingPointX, R1
+  hlt
+  
+__copies:
+  in R0, INP_GamepadRight
+  mov R1, R0
+  mov R0, R1
+  iadd R0, 4
+  mov R2, R0
+  out GPU_DrawingPointY, R2
+  hlt
+  
+__main:
+  hlt
@@ -8,6 +8,7 @@
     
     // include project headers
     #include "VirconASMLexer.hpp"
+    #include "Globals.hpp"
     
     // include C/C++ headers
     #include <cstring>      // [ ANSI C ] Stringds
@@ -111,18 +112,31 @@ VirconASMLexer::~VirconASMLexer()
 
 void VirconASMLexer::OpenFile( const string& FilePath )
 {
-    // reset any previous state
-    Input.close();
-    Input.clear();
-    
     // open the file as binary, not as text!
     // (otherwise there can be bugs using tellg/seekg and unget)
-    OpenInputFile( Input, FilePath, ios_base::in | ios_base::binary );
-    Input.seekg( 0, ios::beg );
+    ifstream InputFile;
+    OpenInputFile( InputFile, FilePath, ios_base::in | ios_base::binary );
     
-    if( Input.fail() )
+    if( InputFile.fail() )
       throw runtime_error( "cannot open input file \"" + FilePath + "\"" );
     
+    // read all of its contents
+    stringstream FileContents;
+    FileContents << InputFile.rdbuf();
+    InputFile.close();
+    
+    string ProgramText = FileContents.str();
+    
+    // when enabled, apply the peephole optimizer to the text
+    // (removed lines are left empty, so line numbers are kept)
+    if( EnablePeephole )
+      ProgramText = Peephole.OptimizeText( ProgramText );
+    
+    // reset any previous state
+    Input.str( ProgramText );
+    Input.clear();
+    Input.seekg( 0, ios::beg );
+    
     // capture the input file directory
     InputDirectory = GetPathDirectory( FilePath );
     
@@ -147,7 +161,7 @@ void VirconASMLexer::OpenFile( const string& FilePath )
     FirstToken->Location = ReadLocation;
     
     TokenLines.emplace_back();
-    TokenLines.back().push_back( FirstToken );    
+    TokenLines.back().push_back( FirstToken );
 }
 
 // -----------------------------------------------------------------------------
@@ -155,7 +169,7 @@ void VirconASMLexer::OpenFile( const string& FilePath )
 void VirconASMLexer::CloseFile()
 {
     // we are finished with the input file
-    Input.close();
+    Input.str( "" );
     
     // complete the list with an end-of-file indicator
     EndOfFileToken* LastToken = new EndOfFileToken;
@@ -183,7 +197,7 @@ char VirconASMLexer::GetChar()
     if( IsInvalidAscii( c ) )
       EmitError( "character is not valid (non-printable ASCII)" );
     
-    // line break type 1: CR    
+    // line break type 1: CR
     if( c == '\r' )
       ReadLocation.Line++;
     
@@ -9,6 +9,7 @@
     // include C/C++ headers
     #include <iostream>     // [ C++ STL ] I/O Streams
     #include <fstream>      // [ C++ STL ] File streams
+    #include <sstream>      // [ C++ STL ] String streams
     #include <vector>       // [ C++ STL ] Vectors
 // *****************************************************************************
 
@@ -36,8 +37,9 @@ class VirconASMLexer
 {
     public:
         
-        // source input file
-        std::ifstream Input;
+        // source input file (read in full, so
+        // that it can be optimized beforehand)
+        std::stringstream Input;
         std::string InputDirectory;
         
         // lexing state
@@ -80,7 +82,7 @@ class VirconASMLexer
         std::string ReadString();
         
         // partial lexing functions
-        Token* ReadNextToken();        
+        Token* ReadNextToken();
         TokenList TokenizeNextLine();
         
     public:
@@ -262,6 +262,10 @@ void ScopeNode::DeclareNewIdentifier( string Name, CNode* NewDeclaration )
         // carry over reference flags to new declarations
         if( OldFunction->IsReferenced )
           NewFunction->IsReferenced = true;
+        
+        // any declaration can ask for inlining
+        if( OldFunction->IsInline )
+          NewFunction->IsInline = true;
     }
     
     // for variable declarations we require that their types match
@@ -712,6 +716,7 @@ FunctionNode::FunctionNode( CNode* Parent_ )
     SizeOfArguments = 0;
     HasBody = false;
     IsReferenced = false;
+    IsInline = false;
 }
 
 // -----------------------------------------------------------------------------
@@ -449,6 +449,10 @@ class FunctionNode: public StackFrameNode
         // external references
         bool IsReferenced;
         
+        // declared with "inline" to ask for
+        // its calls to be replaced by its body
+        bool IsInline;
+        
     public:
         
         // instance handling
@@ -48,7 +48,8 @@ const map< KeywordTypes, string > KeywordNames =
     { KeywordTypes::Asm,      "asm"      },
     { KeywordTypes::Embedded, "embedded" },
     { KeywordTypes::Extern,   "extern"   },
-    { KeywordTypes::Const,    "const"    }
+    { KeywordTypes::Const,    "const"    },
+    { KeywordTypes::Inline,   "inline"   }
 };
 
 // -----------------------------------------------------------------------------
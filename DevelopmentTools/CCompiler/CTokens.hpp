@@ -72,7 +72,8 @@ enum class KeywordTypes
     Asm,
     Embedded,
     Extern,
-    Const
+    Const,
+    Inline
 };
 
 // -----------------------------------------------------------------------------
@@ -7,6 +7,9 @@
     #include "CheckNodes.hpp"
     #include "CompilerInfrastructure.hpp"
     
+    // include C/C++ headers
+    #include <climits>          // [ ANSI C ] Numeric limits
+    
     // declare used namespaces
     using namespace std;
     using namespace V32;
@@ -110,6 +113,14 @@ int VirconCEmitter::EmitFunction( FunctionNode* Function )
     string FunctionLabel = "__function_" + Function->Name;
     string ReturnLabel = "__function_" + Function->Name + "_return";
     
+    // keep track of where the function starts
+    EmittedFunction FunctionRange;
+    FunctionRange.Name = Function->Name;
+    FunctionRange.FirstLine = ProgramLines.size();
+    FunctionRange.CallAreaSize = Function->StackSizeForFunctionCalls;
+    FunctionRange.IsInline = Function->IsInline;
+    FunctionJumpTables.clear();
+    
     // (1) function call label
     EmitLabel( FunctionLabel );
     
@@ -135,6 +146,7 @@ int VirconCEmitter::EmitFunction( FunctionNode* Function )
     // so that it can safely be used inside expressions
     bool FunctionReturnsValue = (Function->ReturnType->Type() != DataTypes::Void);
     bool PreserveRegisters = (FunctionReturnsValue && (HighestRegister > 0));
+    FunctionRange.PreservesRegisters = FunctionReturnsValue;
     
     // CASE 1: when some registers need to be preserved,
     // they have to be positioned in the stack frame so
@@ -207,6 +219,11 @@ int VirconCEmitter::EmitFunction( FunctionNode* Function )
     ProgramLines.push_back( "ret" );
     ProgramLines.push_back( "" );
     
+    // register the full function range
+    FunctionRange.EndLine = ProgramLines.size();
+    FunctionRange.JumpTables = FunctionJumpTables;
+    EmittedFunctions.push_back( FunctionRange );
+    
     return HighestRegister;
 }
 
@@ -234,7 +251,7 @@ int VirconCEmitter::EmitInitialization( MemoryPlacement LeftPlacement, DataType*
     // add info to determine line correspondence
     AddDebugInfo( InitialValue );
     
-    // CASE 1: For a string, if the variable is an array, 
+    // CASE 1: For a string, if the variable is an array,
     // interpret the assignment as a char-by-char assignment
     if( InitialValue->Type() == CNodeTypes::LiteralString
     &&  LeftType->Type() == DataTypes::Array
@@ -276,7 +293,7 @@ int VirconCEmitter::EmitInitialization( MemoryPlacement LeftPlacement, DataType*
             ProgramLines.push_back( "mov CR, " + to_string( OperandSize ) );
             ProgramLines.push_back( "movs" );
             
-            return Registers.HighestUsedRegister;            
+            return Registers.HighestUsedRegister;
         }
     }
     
@@ -694,6 +711,179 @@ int VirconCEmitter::EmitContinue( ContinueNode* Continue )
 
 // -----------------------------------------------------------------------------
 
+// negative values would break the label
+// so for them just add a "minus" text
+static string SwitchValueLabel( SwitchNode* Switch, const string& Name, int Value )
+{
+    string ValueText = to_string( Value );
+    
+    if( Value < 0 )
+      ValueText = "minus_" + ValueText.substr( 1 );
+    
+    return Switch->NodeLabel() + "_" + Name + "_" + ValueText;
+}
+
+// -----------------------------------------------------------------------------
+
+// each way to find the case is rated by the total number of
+// instructions (and so, cycles) it needs to reach every case
+enum class SwitchStrategies
+{
+    CaseChain,
+    BinarySearch,
+    JumpTable
+};
+
+// a binary search compares with each case in
+// a chain when there are this many cases left
+static const int64_t SearchChainLength = 3;
+
+// tables need an entry for every value in the range
+// of cases, so they need to be dense enough
+static const int64_t TableEntriesPerCase = 4;
+static const int64_t MaximumTableEntries = 1024;
+
+// -----------------------------------------------------------------------------
+
+// comparing with each value in order takes 3 instructions per case
+static int64_t CaseChainCost( int64_t Cases )
+{
+    return 3 * Cases * (Cases + 1) / 2;
+}
+
+// -----------------------------------------------------------------------------
+
+// each 3-instruction comparison discards half of the cases
+static int64_t BinarySearchCost( int64_t Cases )
+{
+    if( Cases <= SearchChainLength )
+      return CaseChainCost( Cases );
+    
+    int64_t LowerCases = Cases / 2;
+    return 3 * Cases + BinarySearchCost( LowerCases ) + BinarySearchCost( Cases - LowerCases );
+}
+
+// -----------------------------------------------------------------------------
+
+// checking the range and jumping takes 10 instructions for any case
+static int64_t JumpTableCost( int64_t Cases )
+{
+    return 10 * Cases;
+}
+
+// -----------------------------------------------------------------------------
+
+// values must be sorted
+static SwitchStrategies ChooseSwitchStrategy( const vector< int >& Values )
+{
+    int64_t Cases = Values.size();
+    SwitchStrategies BestStrategy = SwitchStrategies::CaseChain;
+    int64_t BestCost = CaseChainCost( Cases );
+    
+    if( BinarySearchCost( Cases ) < BestCost )
+    {
+        BestStrategy = SwitchStrategies::BinarySearch;
+        BestCost = BinarySearchCost( Cases );
+    }
+    
+    if( Cases > 0 && Values.front() != INT_MIN )
+    {
+        int64_t TableEntries = (int64_t)Values.back() - Values.front() + 1;
+        bool IsDense = (TableEntries <= TableEntriesPerCase * Cases) && (TableEntries <= MaximumTableEntries);
+        
+        if( IsDense && JumpTableCost( Cases ) < BestCost )
+          BestStrategy = SwitchStrategies::JumpTable;
+    }
+    
+    return BestStrategy;
+}
+
+// -----------------------------------------------------------------------------
+
+// the condition is in R0; values in [First, End) are compared in order
+void VirconCEmitter::EmitSwitchCaseChain( SwitchNode* Switch, const vector< int >& Values, int First, int End, const string& NoMatchLabel )
+{
+    for( int i = First; i < End; i++ )
+    {
+        ProgramLines.push_back( "mov R1, " + to_string( Values[ i ] ) );
+        ProgramLines.push_back( "ieq R1, R0" );
+        ProgramLines.push_back( "jt R1, " + SwitchValueLabel( Switch, "case", Values[ i ] ) );
+    }
+    
+    ProgramLines.push_back( "jmp " + NoMatchLabel );
+}
+
+// -----------------------------------------------------------------------------
+
+// the condition is in R0; values in [First, End) must be sorted
+void VirconCEmitter::EmitSwitchBinarySearch( SwitchNode* Switch, const vector< int >& Values, int First, int End, const string& NoMatchLabel )
+{
+    if( End - First <= SearchChainLength )
+    {
+        EmitSwitchCaseChain( Switch, Values, First, End, NoMatchLabel );
+        return;
+    }
+    
+    // split the values at the middle one
+    int Middle = First + (End - First) / 2;
+    string LowerLabel = SwitchValueLabel( Switch, "below", Values[ Middle ] );
+    
+    ProgramLines.push_back( "mov R1, R0" );
+    ProgramLines.push_back( "ilt R1, " + to_string( Values[ Middle ] ) );
+    ProgramLines.push_back( "jt R1, " + LowerLabel );
+    
+    // search in the upper half, then in the lower half
+    EmitSwitchBinarySearch( Switch, Values, Middle, End, NoMatchLabel );
+    EmitLabel( LowerLabel );
+    EmitSwitchBinarySearch( Switch, Values, First, Middle, NoMatchLabel );
+}
+
+// -----------------------------------------------------------------------------
+
+// the condition is in R0; values must be sorted
+void VirconCEmitter::EmitSwitchJumpTable( SwitchNode* Switch, const vector< int >& Values, const string& NoMatchLabel )
+{
+    int Minimum = Values.front();
+    int Maximum = Values.back();
+    string TableLabel = Switch->NodeLabel() + "_table";
+    
+    // values outside the table match no case
+    ProgramLines.push_back( "mov R1, R0" );
+    ProgramLines.push_back( "ilt R1, " + to_string( Minimum ) );
+    ProgramLines.push_back( "jt R1, " + NoMatchLabel );
+    ProgramLines.push_back( "mov R1, R0" );
+    ProgramLines.push_back( "igt R1, " + to_string( Maximum ) );
+    ProgramLines.push_back( "jt R1, " + NoMatchLabel );
+    
+    // read the address from the table entry for this value
+    string EntryOffset = "";
+    
+    if( Minimum > 0 ) EntryOffset = "-" + to_string( Minimum );
+    if( Minimum < 0 ) EntryOffset = "+" + to_string( -(int64_t)Minimum );
+    
+    ProgramLines.push_back( "mov R1, " + TableLabel );
+    ProgramLines.push_back( "iadd R0, R1" );
+    ProgramLines.push_back( "mov R0, [R0" + EntryOffset + "]" );
+    ProgramLines.push_back( "jmp R0" );
+    
+    // the table has an entry for every value in the range
+    vector< string >& Targets = FunctionJumpTables[ TableLabel ];
+    DataLines.push_back( TableLabel + ":" );
+    
+    for( int64_t Value = Minimum; Value <= Maximum; Value++ )
+    {
+        string Target = NoMatchLabel;
+        
+        if( Switch->HandledCases.count( (int)Value ) )
+          Target = SwitchValueLabel( Switch, "case", (int)Value );
+        
+        DataLines.push_back( "pointer " + Target );
+        Targets.push_back( Target );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
 int VirconCEmitter::EmitSwitch( SwitchNode* Switch )
 {
     // add info to determine line correspondence
@@ -718,29 +908,36 @@ int VirconCEmitter::EmitSwitch( SwitchNode* Switch )
     EmitRegisterTypeConversion( 0, Switch->Condition->ReturnedType, &IntegerType );
     
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    // emit all handled cases
-    for( auto Pair: Switch->HandledCases )
-    {
-        int Value = Pair.first;
-        string ValueText = string(Value < 0? "minus_" : "") + to_string( abs(Value) );
-        string CaseLabel = Switch->NodeLabel() + "_case_" + ValueText;
-        
-        ProgramLines.push_back( "mov R1, " + to_string(Value) );
-        ProgramLines.push_back( "ieq R1, R0" );
-        ProgramLines.push_back( "jt R1, " + CaseLabel );
-    }
+    // when there is no default, if no
+    // case is matched no code will run
+    string NoMatchLabel = EndLabel;
     
-    // emit default behavior
     if( Switch->DefaultCase )
+      NoMatchLabel = Switch->NodeLabel() + "_default";
+    
+    // OPTIMIZATION: find the handled case in the
+    // fastest way for the number of cases and
+    // how close their values are to each other
+    vector< int > Values;
+    
+    for( auto Pair: Switch->HandledCases )
+      Values.push_back( Pair.first );
+    
+    switch( ChooseSwitchStrategy( Values ) )
     {
-        string DefaultLabel = Switch->NodeLabel() + "_default";
-        ProgramLines.push_back( "jmp " + DefaultLabel );
+        case SwitchStrategies::JumpTable:
+          EmitSwitchJumpTable( Switch, Values, NoMatchLabel );
+          break;
+        
+        case SwitchStrategies::BinarySearch:
+          EmitSwitchBinarySearch( Switch, Values, 0, Values.size(), NoMatchLabel );
+          break;
+        
+        default:
+          EmitSwitchCaseChain( Switch, Values, 0, Values.size(), NoMatchLabel );
+          break;
     }
     
-    // when there is no default, if no
-    // case is matched no code will run
-    else ProgramLines.push_back( "jmp " + EndLabel );
-    
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     // now we can emit every statement in the block
     for( CNode* S: Switch->Statements )
@@ -764,10 +961,7 @@ int VirconCEmitter::EmitCase( CaseNode* Case )
     if( !Case->SwitchContext )
       RaiseFatalError( Case->Location, "switch context has not been resolved for \"case\"" );
     
-    // negative values would break the label
-    // so for them just add a "minus" text
-    string ValueText = string(Case->Value < 0? "minus_" : "") + to_string( abs(Case->Value) );
-    string CaseLabel = Case->SwitchContext->NodeLabel() + "_case_" + ValueText;
+    string CaseLabel = SwitchValueLabel( Case->SwitchContext, "case", Case->Value );
     EmitLabel( CaseLabel );
     
     return 0;
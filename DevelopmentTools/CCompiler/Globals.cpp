@@ -17,6 +17,11 @@ bool CompileOnly = false;
 bool DisableWarnings = false;
 bool EnableAllWarnings = false;
 
+// optimization of the generated code
+int OptimizationLevel = 0;
+bool ReportOptimization = false;
+bool ReportPeephole = false;
+
 
 // =============================================================================
 //      DEBUG
@@ -18,6 +18,11 @@ extern bool CompileOnly;
 extern bool DisableWarnings;
 extern bool EnableAllWarnings;
 
+// optimization of the generated code
+extern int OptimizationLevel;
+extern bool ReportOptimization;
+extern bool ReportPeephole;
+
 
 // =============================================================================
 //      DEBUG
@@ -12,6 +12,7 @@
     #include "VirconCParser.hpp"
     #include "VirconCAnalyzer.hpp"
     #include "VirconCEmitter.hpp"
+    #include "VirconCOptimizer.hpp"
     #include "CompilerInfrastructure.hpp"
     #include "Globals.hpp"
     #include "DebugInfo.hpp"
@@ -57,8 +58,19 @@ void PrintUsage()
     cout << "  -g           Outputs an additional file with debug info" << endl;
     cout << "  -w           Inhibit all warnings" << endl;
     cout << "  -Wall        Enable all warnings" << endl;
+    cout << "  -O0          Disables optimization (default)" << endl;
+    cout << "  -O1          Optimizes each block of code separately" << endl;
+    cout << "  -O2          Also optimizes across blocks of code, and" << endl;
+    cout << "               keeps variables in registers and" << endl;
+    cout << "               inlines small or inline functions" << endl;
+    cout << "  -O3          Repeats optimizations until no more are found" << endl;
+    cout << "  --opt-report Shows instruction counts for each function" << endl;
+    cout << "               before and after optimization" << endl;
+    cout << "  --peephole-stats" << endl;
+    cout << "               Shows how many times each peephole rule" << endl;
+    cout << "               was applied when optimizing" << endl;
     cout << "Also, the following options are accepted for compatibility" << endl;
-    cout << "but have no effect: -c,-s,-O1,-O2,-O3" << endl;
+    cout << "but have no effect: -c,-s" << endl;
 }
 
 // -----------------------------------------------------------------------------
@@ -206,11 +218,26 @@ int main( int NumberOfArguments, char* Arguments[] )
                 continue;
             }
             
+            if( ArgumentsUTF8[i] == string("--opt-report") )
+            {
+                ReportOptimization = true;
+                continue;
+            }
+            
+            if( ArgumentsUTF8[i] == string("--peephole-stats") )
+            {
+                ReportPeephole = true;
+                continue;
+            }
+            
+            // optimization levels
+            if( ArgumentsUTF8[i] == string("-O0") )  { OptimizationLevel = 0; continue; }
+            if( ArgumentsUTF8[i] == string("-O1") )  { OptimizationLevel = 1; continue; }
+            if( ArgumentsUTF8[i] == string("-O2") )  { OptimizationLevel = 2; continue; }
+            if( ArgumentsUTF8[i] == string("-O3") )  { OptimizationLevel = 3; continue; }
+            
             // these options are accepted but have no effect
             if( ArgumentsUTF8[i] == string("-s")  )  continue;
-            if( ArgumentsUTF8[i] == string("-O1") )  continue;
-            if( ArgumentsUTF8[i] == string("-O2") )  continue;
-            if( ArgumentsUTF8[i] == string("-O3") )  continue;
             
             // discard any other parameters starting with '-'
             if( ArgumentsUTF8[i][0] == '-' )
@@ -319,6 +346,24 @@ int main( int NumberOfArguments, char* Arguments[] )
         if( CompilationErrors != 0 )
           throw runtime_error( "emitter finished with errors" );
         
+        // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        // STAGE 6: Run optimizer, if enabled
+        // (ASM lines --> ASM lines)
+        if( OptimizationLevel > 0 )
+        {
+            if( VerboseMode )
+              cout << "stage 6: running optimizer" << endl;
+            
+            VirconCOptimizer Optimizer;
+            Optimizer.Optimize( Emitter, OptimizationLevel );
+            
+            if( ReportOptimization )
+              Optimizer.PrintReport();
+            
+            if( ReportPeephole )
+              Optimizer.Peephole.PrintStatistics();
+        }
+        
         // no need for debug output here (result is final)
         if( VerboseMode )
           cout << "saving output file" << endl;
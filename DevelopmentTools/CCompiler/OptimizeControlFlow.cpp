@@ -0,0 +1,157 @@
+// *****************************************************************************
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: CONTROL FLOW CLEANUP
+// =============================================================================
+
+
+// jumps to a place that just jumps again can go to the final
+// destination; this also applies to a conditional jump landing
+// on an identical condition check
+void VirconCOptimizer::ThreadJumps()
+{
+    BuildBlocks();
+    vector< AssemblyLine >& Lines = Function->Lines;
+    
+    for( AssemblyLine& Line: Lines )
+    {
+        if( !Line.IsJump() )
+          continue;
+        
+        string OriginalTarget = Line.JumpTarget();
+        string Target = OriginalTarget;
+        
+        // limit the search to avoid endless cycles
+        for( int Step = 0; Step < 8 && !Target.empty(); Step++ )
+        {
+            int Next = InstructionAfterLabel( Target );
+            
+            if( Next < 0 )
+              break;
+            
+            const AssemblyLine& NextLine = Lines[ Next ];
+            string NewTarget;
+            
+            if( NextLine.IsInstruction( InstructionOpCodes::JMP ) )
+              NewTarget = NextLine.JumpTarget();
+            
+            else if( Line.IsConditionalJump() && NextLine.OpCode == Line.OpCode && NextLine.Operands[0] == Line.Operands[0] )
+              NewTarget = NextLine.JumpTarget();
+            
+            if( NewTarget.empty() || NewTarget == Target )
+              break;
+            
+            Target = NewTarget;
+        }
+        
+        if( Target != OriginalTarget )
+        {
+            Line.SetOperand( Line.Operands.size() - 1, AssemblyOperand::FromValue( Target ) );
+            ChangesMade = true;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// jumps to the label that comes next are not needed
+void VirconCOptimizer::RemoveRedundantJumps()
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    
+    for( unsigned i = 0; i < Lines.size(); i++ )
+    {
+        string Target = Lines[ i ].JumpTarget();
+        
+        if( Target.empty() )
+          continue;
+        
+        for( unsigned j = i + 1; j < Lines.size(); j++ )
+        {
+            if( Lines[ j ].IsInstruction() )
+              break;
+            
+            if( Lines[ j ].IsLabel() && Lines[ j ].LabelName == Target )
+            {
+                RemoveLine( i );
+                break;
+            }
+        }
+    }
+    
+    CompactLines();
+}
+
+// -----------------------------------------------------------------------------
+
+// comments are kept, since they can be separators; labels
+// in jump tables are also kept, since the data refers to them
+void VirconCOptimizer::RemoveUnreachableCode()
+{
+    BuildBlocks();
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< bool > IsReachable( Blocks.size(), false );
+    
+    for( int BlockIndex: ReversePostorder() )
+      IsReachable[ BlockIndex ] = true;
+    
+    for( unsigned b = 0; b < Blocks.size(); b++ )
+    {
+        if( IsReachable[ b ] )
+          continue;
+        
+        for( int i = Blocks[ b ].FirstLine; i < Blocks[ b ].EndLine; i++ )
+        {
+            const AssemblyLine& Line = Function->Lines[ i ];
+            
+            if( Line.IsComment() || (Line.IsLabel() && IsJumpTableTarget( Line.LabelName )) )
+              continue;
+            
+            RemoveLine( i );
+        }
+    }
+    
+    CompactLines();
+}
+
+// -----------------------------------------------------------------------------
+
+// labels that are not used anywhere split blocks for no reason
+void VirconCOptimizer::RemoveUnusedLabels()
+{
+    map< string, int > JumpReferences, OtherReferences;
+    CountReferences( JumpReferences, OtherReferences );
+    
+    vector< AssemblyLine >& Lines = Function->Lines;
+    
+    for( unsigned i = 0; i < Lines.size(); i++ )
+    {
+        if( !Lines[ i ].IsLabel() || Lines[ i ].LabelName == Function->EntryLabel )
+          continue;
+        
+        const string& Name = Lines[ i ].LabelName;
+        
+        if( !JumpReferences[ Name ] && !OtherReferences[ Name ] )
+          RemoveLine( i );
+    }
+    
+    CompactLines();
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::CleanControlFlow()
+{
+    ThreadJumps();
+    RemoveRedundantJumps();
+    RemoveUnreachableCode();
+    RemoveUnusedLabels();
+}
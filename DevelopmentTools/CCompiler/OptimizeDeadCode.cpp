@@ -0,0 +1,495 @@
+// *****************************************************************************
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+static const uint32_t AllRegisters = 0xFFFF;
+
+// -----------------------------------------------------------------------------
+
+// C functions take their arguments from the stack and preserve
+// the registers their callers use, but any other called code
+// (such as assembly routines) may take inputs in registers
+static bool CallsCFunction( const AssemblyLine& Line )
+{
+    const AssemblyOperand& Target = Line.Operands[0];
+    
+    if( Target.IsRegister )
+      return true;
+    
+    return (Target.Value.rfind( "__function_", 0 ) == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+static void RegisterEffects( const AssemblyLine& Line, uint32_t& Read, uint32_t& Written )
+{
+    Read = Line.ReadRegisters();
+    Written = Line.WrittenRegisters();
+    
+    if( Line.IsInstruction( InstructionOpCodes::CALL ) )
+      if( !CallsCFunction( Line ) )
+        Read = AllRegisters;
+        
+    // values are returned in R0, and the caller's
+    // registers may be expected to be preserved
+    if( Line.IsInstruction( InstructionOpCodes::RET ) )
+      Read = AllRegisters;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: ANALYSIS OF THE STACK FRAME
+// =============================================================================
+
+
+// Checks that the function sets up its stack frame only at the
+// start, and restores it only at its exits. Then BP and SP always
+// hold the same position in the body, and stack variables can be
+// identified from any block by their offset
+bool VirconCOptimizer::CheckStandardFrame()
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    
+    if( Blocks.empty() || !Blocks[ 0 ].Predecessors.empty() )
+      return false;
+    
+    // only the function label can be used from outside
+    for( unsigned b = 1; b < Blocks.size(); b++ )
+      if( Blocks[ b ].IsEntry )
+        return false;
+        
+    // read the prologue
+    BasicBlock& FirstBlock = Blocks[ 0 ];
+    int Position = FirstBlock.FirstLine;
+    int32_t StackOffset = 0;
+    int Step = 0;
+    
+    Function->BodyFirstLine = Position;
+    Function->PushedRegisters = 0;
+    
+    const AssemblyOperand BP = AssemblyOperand::FromRegister( (int)CPURegisters::BasePointer );
+    const AssemblyOperand SP = AssemblyOperand::FromRegister( (int)CPURegisters::StackPointer );
+    
+    for( ; Position < FirstBlock.EndLine; Position++ )
+    {
+        AssemblyLine& Line = Lines[ Position ];
+        
+        if( !Line.IsInstruction() )
+          continue;
+        
+        // first save the caller's frame
+        if( Step == 0 )
+        {
+            if( !Line.IsInstruction( InstructionOpCodes::PUSH ) || Line.Operands[0] != BP )
+              return false;
+            
+            StackOffset--;
+            Step++;
+            Function->BodyFirstLine = Position + 1;
+            continue;
+        }
+        
+        if( Step == 1 )
+        {
+            if( !Line.IsInstruction( InstructionOpCodes::MOV ) || Line.Operands[0] != BP || Line.Operands[1] != SP )
+              return false;
+            
+            Function->FramePointerOffset = StackOffset;
+            Step++;
+            Function->BodyFirstLine = Position + 1;
+            continue;
+        }
+        
+        // then allocate space and save registers
+        int32_t Size;
+        
+        if( Line.IsInstruction( InstructionOpCodes::ISUB ) && Line.Operands[0] == SP )
+          if( !Line.Operands[1].IsRegister && ParseIntegerValue( Line.Operands[1].Value, Size ) )
+          {
+              StackOffset -= Size;
+              Function->BodyFirstLine = Position + 1;
+              continue;
+          }
+        
+        if( Line.IsInstruction( InstructionOpCodes::PUSH ) && Line.Operands[0].IsRegister && Line.Operands[0].Register <= 13 )
+        {
+            StackOffset--;
+            Function->PushedRegisters |= (1u << Line.Operands[0].Register);
+            Function->BodyFirstLine = Position + 1;
+            continue;
+        }
+        
+        break;
+    }
+    
+    if( Step < 2 )
+      return false;
+    
+    Function->BodyStackOffset = StackOffset;
+    
+    // after that, BP and SP can only change when returning
+    const uint32_t StackRegisters = (1u << (int)CPURegisters::BasePointer) | (1u << (int)CPURegisters::StackPointer);
+    
+    for( unsigned b = 0; b < Blocks.size(); b++ )
+    {
+        int First = (b == 0? Position : Blocks[ b ].FirstLine);
+        
+        if( Blocks[ b ].Returns )
+          continue;
+        
+        for( int i = First; i < Blocks[ b ].EndLine; i++ )
+          if( Lines[ i ].WrittenRegisters() & StackRegisters )
+            return false;
+    }
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// determines if an instruction uses an address within the stack
+// frame as data, so that it could later be used through pointers
+static bool UsesFrameAddress( const AssemblyLine& Line, const vector< bool >& IsFrameRegister )
+{
+    auto IsFrame = [ & ]( const AssemblyOperand& Operand )
+    {
+        return Operand.IsRegister && !Operand.IsMemoryAddress && IsFrameRegister[ Operand.Register ];
+    };
+    
+    switch( Line.OpCode )
+    {
+        // copies only move addresses to other registers
+        case InstructionOpCodes::MOV:
+          return Line.Operands[0].IsMemoryAddress && IsFrame( Line.Operands[1] );
+        
+        case InstructionOpCodes::PUSH:
+          return IsFrame( Line.Operands[0] );
+        
+        case InstructionOpCodes::LEA:
+        case InstructionOpCodes::POP:
+        case InstructionOpCodes::JMP:
+        case InstructionOpCodes::JT:
+        case InstructionOpCodes::JF:
+        case InstructionOpCodes::RET:
+        case InstructionOpCodes::HLT:
+        case InstructionOpCodes::WAIT:
+        case InstructionOpCodes::IN:
+          return false;
+        
+        // constant offsets keep the addresses trackable
+        case InstructionOpCodes::IADD:
+        case InstructionOpCodes::ISUB:
+          if( !Line.Operands[1].IsRegister )
+            return false;
+            
+          return IsFrame( Line.Operands[0] ) || IsFrame( Line.Operands[1] );
+        
+        // called functions can't see registers
+        case InstructionOpCodes::CALL:
+        {
+            if( CallsCFunction( Line ) )
+              return false;
+            
+            for( int i = 0; i <= 13; i++ )
+              if( IsFrameRegister[ i ] )
+                return true;
+                
+            return false;
+        }
+        
+        default:
+        {
+            uint32_t Read = Line.ReadRegisters();
+            
+            for( int i = 0; i <= 15; i++ )
+              if( (Read & (1u << i)) && IsFrameRegister[ i ] )
+                return true;
+                
+            return false;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// Finds out where each instruction accesses the stack frame,
+// and whether frame addresses are used in untrackable ways
+void VirconCOptimizer::AnalyzeStackFrame()
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    
+    Function->HasStandardFrame = false;
+    Function->FrameEscapes = false;
+    Function->AccessesSlot.assign( Lines.size(), false );
+    Function->AccessedSlots.assign( Lines.size(), 0 );
+    Function->KnowsStackOffset.assign( Lines.size(), false );
+    Function->StackOffsets.assign( Lines.size(), 0 );
+    
+    if( !CheckStandardFrame() )
+      return;
+    
+    Function->HasStandardFrame = true;
+    
+    // frame addresses can't stay in registers between blocks,
+    // since each block is analyzed without knowing the others
+    vector< LiveSet > LiveAtBlockEnd;
+    ComputeLiveness( LiveAtBlockEnd, false );
+    
+    ResetValues();
+    int SP = (int)CPURegisters::StackPointer;
+    
+    for( unsigned b = 0; b < Blocks.size(); b++ )
+    {
+        ValueState State;
+        InitializeState( State, b );
+        
+        for( int i = Blocks[ b ].FirstLine; i < Blocks[ b ].EndLine; i++ )
+        {
+            AssemblyLine& Line = Lines[ i ];
+            
+            if( !Line.IsInstruction() )
+              continue;
+            
+            // position of SP
+            int StackValue = State.RegisterValues[ SP ];
+            
+            if( IsFrameValue( StackValue ) )
+            {
+                Function->KnowsStackOffset[ i ] = true;
+                Function->StackOffsets[ i ] = Values[ StackValue ].Offset;
+            }
+            
+            // accessed stack position
+            int MemoryPosition = Line.MemoryOperandPosition();
+            
+            if( MemoryPosition >= 0 )
+            {
+                pair< int, int32_t > Address = OperandAddress( State, Line.Operands[ MemoryPosition ] );
+                
+                if( Address.first == FrameRoot )
+                {
+                    Function->AccessesSlot[ i ] = true;
+                    Function->AccessedSlots[ i ] = Address.second;
+                }
+            }
+            
+            else if( Function->KnowsStackOffset[ i ] )
+            {
+                if( Line.IsInstruction( InstructionOpCodes::PUSH ) )
+                {
+                    Function->AccessesSlot[ i ] = true;
+                    Function->AccessedSlots[ i ] = Function->StackOffsets[ i ] - 1;
+                }
+                
+                if( Line.IsInstruction( InstructionOpCodes::POP ) )
+                {
+                    Function->AccessesSlot[ i ] = true;
+                    Function->AccessedSlots[ i ] = Function->StackOffsets[ i ];
+                }
+            }
+            
+            // uses of frame addresses
+            vector< bool > IsFrameRegister( 16 );
+            
+            for( int r = 0; r < 16; r++ )
+              IsFrameRegister[ r ] = IsFrameValue( State.RegisterValues[ r ] );
+            
+            if( UsesFrameAddress( Line, IsFrameRegister ) )
+              Function->FrameEscapes = true;
+            
+            ProcessInstruction( i, State, false );
+        }
+        
+        // frame addresses passed to other blocks
+        for( int r = 0; r <= 13; r++ )
+          if( (LiveAtBlockEnd[ b ].Registers & (1u << r)) && IsFrameValue( State.RegisterValues[ r ] ) )
+            Function->FrameEscapes = true;
+    }
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: LIVENESS ANALYSIS
+// =============================================================================
+
+
+// updates liveness backwards, from after an instruction to before it;
+// stack slots are only tracked for local variables (negative offsets)
+void VirconCOptimizer::UpdateLiveness( int Position, LiveSet& Live, bool TrackSlots )
+{
+    const AssemblyLine& Line = Function->Lines[ Position ];
+    
+    if( !Line.IsInstruction() )
+      return;
+    
+    uint32_t Read, Written;
+    RegisterEffects( Line, Read, Written );
+    
+    // callers don't expect the registers the
+    // function may modify to be preserved
+    if( Line.IsInstruction( InstructionOpCodes::RET ) )
+    {
+        auto Modifiable = ModifiableRegisters.find( Function->EntryLabel );
+        
+        if( Modifiable != ModifiableRegisters.end() )
+          Read &= ~(Modifiable->second & ~1u);
+    }
+    
+    Live.Registers = (Live.Registers & ~Written) | Read;
+    
+    if( !TrackSlots )
+      return;
+    
+    // accesses to stack variables
+    if( Function->AccessesSlot[ Position ] )
+    {
+        int32_t Slot = Function->AccessedSlots[ Position ];
+        bool IsStore = Line.WritesMemoryOperand() || Line.IsInstruction( InstructionOpCodes::PUSH );
+        
+        if( Slot < 0 )
+        {
+            if( IsStore ) Live.Slots.erase( Slot );
+            else Live.Slots.insert( Slot );
+        }
+    }
+    
+    // called functions read their parameters
+    if( Line.IsInstruction( InstructionOpCodes::CALL ) )
+    {
+        if( Function->CallAreaSize < 0 || !Function->KnowsStackOffset[ Position ] )
+          Live.AllSlots = true;
+        
+        else for( int32_t Slot = Function->StackOffsets[ Position ]; Slot < Function->StackOffsets[ Position ] + Function->CallAreaSize; Slot++ )
+          if( Slot < 0 )
+            Live.Slots.insert( Slot );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::ComputeLiveness( vector< LiveSet >& LiveAtBlockEnd, bool TrackSlots )
+{
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< LiveSet > LiveAtBlockStart( Blocks.size() );
+    LiveAtBlockEnd.assign( Blocks.size(), LiveSet() );
+    
+    // iterate until no changes are found
+    bool Changed = true;
+    
+    while( Changed )
+    {
+        Changed = false;
+        
+        for( int b = Blocks.size() - 1; b >= 0; b-- )
+        {
+            BasicBlock& Block = Blocks[ b ];
+            LiveSet Live;
+            
+            // leaving the function in unusual ways
+            // may need any registers and variables
+            if( Block.LeavesFunction )
+            {
+                Live.Registers = AllRegisters;
+                Live.AllSlots = true;
+            }
+            
+            for( int Successor: Block.Successors )
+              Live.Add( LiveAtBlockStart[ Successor ] );
+            
+            LiveAtBlockEnd[ b ] = Live;
+            
+            for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+              UpdateLiveness( i, Live, TrackSlots );
+            
+            if( !(Live == LiveAtBlockStart[ b ]) )
+            {
+                LiveAtBlockStart[ b ] = Live;
+                Changed = true;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// an instruction is dead when all its effects are on registers
+// or local variables that are never read before being replaced
+bool VirconCOptimizer::IsDeadInstruction( int Position, const LiveSet& Live, bool TrackSlots )
+{
+    const AssemblyLine& Line = Function->Lines[ Position ];
+    
+    if( !Line.IsInstruction() )
+      return false;
+    
+    uint32_t Read, Written;
+    RegisterEffects( Line, Read, Written );
+    bool WritesLiveRegisters = (Written & Live.Registers) != 0;
+    
+    // pure operations
+    if( !Line.HasSideEffects() )
+      return (Written != 0) && !WritesLiveRegisters;
+    
+    // stores to local variables
+    if( Line.WritesMemoryOperand() )
+    {
+        if( !TrackSlots || !Function->AccessesSlot[ Position ] || Live.AllSlots )
+          return false;
+        
+        int32_t Slot = Function->AccessedSlots[ Position ];
+        return (Slot < 0) && !Live.Slots.count( Slot );
+    }
+    
+    // loads that can't cause errors
+    if( Line.ReadsMemoryOperand() && !WritesLiveRegisters )
+      return Function->AccessesSlot[ Position ] || !Line.Operands[1].IsRegister;
+    
+    return false;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: DEAD CODE ELIMINATION
+// =============================================================================
+
+
+void VirconCOptimizer::RemoveDeadCode()
+{
+    BuildBlocks();
+    AnalyzeStackFrame();
+    
+    // stack variables are only tracked when
+    // they can't be accessed through pointers
+    bool TrackSlots = Function->HasStandardFrame && !Function->FrameEscapes;
+    
+    vector< LiveSet > LiveAtBlockEnd;
+    ComputeLiveness( LiveAtBlockEnd, TrackSlots );
+    
+    for( unsigned b = 0; b < Function->Blocks.size(); b++ )
+    {
+        BasicBlock& Block = Function->Blocks[ b ];
+        LiveSet Live = LiveAtBlockEnd[ b ];
+        
+        for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+        {
+            if( IsDeadInstruction( i, Live, TrackSlots ) )
+              RemoveLine( i );
+            else
+              UpdateLiveness( i, Live, TrackSlots );
+        }
+    }
+    
+    CompactLines();
+}
@@ -0,0 +1,388 @@
+// *****************************************************************************
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+// registers R0 to R13; R0 is never renamed
+// since it holds the returned value
+static const uint32_t GeneralRegisters = 0x3FFF;
+
+static const int BasePointer = (int)CPURegisters::BasePointer;
+static const int StackPointer = (int)CPURegisters::StackPointer;
+
+// largest bodies (in instructions) that replace calls
+// to a function; functions declared as inline are
+// only limited to avoid growing the program too much
+static const int InlineSizeLimit = 8;
+static const int InlineKeywordSizeLimit = 48;
+
+// -----------------------------------------------------------------------------
+
+// the instruction "push Register" or "pop Register"
+static bool IsStackOperation( const AssemblyLine& Line, InstructionOpCodes OpCode, int& Register )
+{
+    if( !Line.IsInstruction( OpCode ) )
+      return false;
+    
+    const AssemblyOperand& Operand = Line.Operands[0];
+    
+    if( !Operand.IsRegister || Operand.IsMemoryAddress )
+      return false;
+    
+    Register = Operand.Register;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// the copy instruction "mov Destination, Source" between registers
+static bool IsRegisterCopy( const AssemblyLine& Line, int Destination, int Source )
+{
+    if( !Line.IsInstruction( InstructionOpCodes::MOV ) )
+      return false;
+    
+    const AssemblyOperand& Operand1 = Line.Operands[0];
+    const AssemblyOperand& Operand2 = Line.Operands[1];
+    
+    if( !Operand1.IsRegister || Operand1.IsMemoryAddress || !Operand2.IsRegister || Operand2.IsMemoryAddress )
+      return false;
+    
+    return (Operand1.Register == Destination && Operand2.Register == Source);
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: FUNCTION INLINING
+// =============================================================================
+
+
+// A function can be inlined when its body is small, it calls
+// no other functions, and it only uses its stack frame to read
+// its arguments. The body can then run with the caller's SP:
+// arguments at [BP+2+N] are found at [SP+N] before the call.
+// The caller's registers that the body can't modify are saved
+// by the function's prologue, so when inlining the body's
+// registers are renamed to ones the caller does not need
+void VirconCOptimizer::FindInlinableBody( const EmittedFunction& Range )
+{
+    if( !Function->JumpTables.empty() )
+      return;
+    
+    vector< AssemblyLine > Lines;
+    
+    for( const AssemblyLine& Line: Function->Lines )
+      if( Line.IsInstruction() || Line.IsLabel() )
+        Lines.push_back( Line );
+        
+    // prologue: function label, frame setup and saved registers
+    int First = 0;
+    int Last = Lines.size() - 1;
+    int Register;
+    
+    if( Last < 4 || !Lines[ 0 ].IsLabel() || Lines[ 0 ].LabelName != Function->EntryLabel )
+      return;
+    
+    if( !IsStackOperation( Lines[ 1 ], InstructionOpCodes::PUSH, Register ) || Register != BasePointer )
+      return;
+    
+    if( !IsRegisterCopy( Lines[ 2 ], BasePointer, StackPointer ) )
+      return;
+    
+    First = 3;
+    
+    // space for local variables is allowed, as long as
+    // the body does not use it (they are in registers)
+    if( Lines[ First ].IsInstruction( InstructionOpCodes::ISUB ) && Lines[ First ].Operands[0] == AssemblyOperand::FromRegister( StackPointer ) )
+      if( !Lines[ First ].Operands[1].IsRegister )
+        First++;
+        
+    vector< int > PushedRegisters;
+    
+    while( First <= Last && IsStackOperation( Lines[ First ], InstructionOpCodes::PUSH, Register ) )
+    {
+        PushedRegisters.push_back( Register );
+        First++;
+    }
+    
+    // epilogue: restore everything, in reverse order
+    if( !Lines[ Last ].IsInstruction( InstructionOpCodes::RET ) )
+      return;
+    
+    Last--;
+    
+    if( !IsStackOperation( Lines[ Last ], InstructionOpCodes::POP, Register ) || Register != BasePointer )
+      return;
+    
+    Last--;
+    
+    if( Last >= First && IsRegisterCopy( Lines[ Last ], StackPointer, BasePointer ) )
+      Last--;
+    
+    for( int Pushed: PushedRegisters )
+    {
+        if( Last < First || !IsStackOperation( Lines[ Last ], InstructionOpCodes::POP, Register ) || Register != Pushed )
+          return;
+        
+        Last--;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // now check the body
+    InlinedBody Body;
+    Body.UsedRegisters = 0;
+    set< string > BodyLabels;
+    map< string, int > BodyJumps;
+    int Instructions = 0;
+    
+    for( int i = First; i <= Last; i++ )
+      if( Lines[ i ].IsLabel() )
+        BodyLabels.insert( Lines[ i ].LabelName );
+        
+    for( int i = First; i <= Last; i++ )
+    {
+        const AssemblyLine& Line = Lines[ i ];
+        Body.Lines.push_back( Line );
+        
+        if( Line.IsLabel() )
+          continue;
+        
+        Instructions++;
+        
+        // the body has to keep the same stack
+        // position, and can't leave by itself
+        switch( Line.OpCode )
+        {
+            case InstructionOpCodes::CALL:
+            case InstructionOpCodes::RET:
+            case InstructionOpCodes::PUSH:
+            case InstructionOpCodes::POP:
+              return;
+            
+            default:
+              break;
+        }
+        
+        // jumps can only go to places within the body
+        if( Line.IsJump() )
+        {
+            string Target = Line.JumpTarget();
+            
+            if( !BodyLabels.count( Target ) )
+              return;
+            
+            BodyJumps[ Target ]++;
+        }
+        
+        uint32_t OperandRegisters = 0;
+        
+        for( unsigned o = 0; o < Line.Operands.size(); o++ )
+        {
+            const AssemblyOperand& Operand = Line.Operands[ o ];
+            
+            if( !Operand.IsRegister )
+            {
+                bool IsJumpTarget = Line.IsJump() && (o == Line.Operands.size() - 1);
+                
+                if( !IsJumpTarget && BodyLabels.count( Operand.Value ) )
+                  return;
+                
+                continue;
+            }
+            
+            // only arguments can be accessed through BP
+            if( Operand.Register == BasePointer )
+            {
+                if( !Operand.IsMemoryAddress || Operand.Offset < 2 )
+                  return;
+                
+                continue;
+            }
+            
+            OperandRegisters |= (1u << Operand.Register);
+        }
+        
+        // registers used implicitly (in string instructions,
+        // or SP) can't be renamed, so they are not allowed
+        uint32_t AllRegisters = Line.ReadRegisters() | Line.WrittenRegisters();
+        
+        if( (AllRegisters & ~OperandRegisters) & ~(1u << BasePointer) )
+          return;
+        
+        if( OperandRegisters & ~GeneralRegisters )
+          return;
+        
+        Body.UsedRegisters |= OperandRegisters & ~1u;
+    }
+    
+    // labels in the body must not be used from anywhere else
+    for( const string& Label: BodyLabels )
+      if( LabelReferences[ Label ] != BodyJumps[ Label ] )
+        return;
+        
+    int SizeLimit = (Range.IsInline? InlineKeywordSizeLimit : InlineSizeLimit);
+    
+    if( Instructions > SizeLimit )
+      return;
+    
+    InlinableFunctions[ Function->EntryLabel ] = Body;
+}
+
+// -----------------------------------------------------------------------------
+
+// the body's lines are placed where the call was, using SP
+// to access the arguments; labels are made unique by adding
+// a number, and registers are renamed to available ones
+bool VirconCOptimizer::InlineBody( const InlinedBody& Body, uint32_t AvailableRegisters, vector< AssemblyLine >& InlinedLines )
+{
+    int NewRegisters[ 16 ];
+    uint32_t TakenRegisters = 0;
+    
+    for( int Register = 0; Register < 16; Register++ )
+      NewRegisters[ Register ] = Register;
+    
+    // keep the same registers if possible
+    for( int Register = 1; Register <= 13; Register++ )
+    {
+        uint32_t Mask = (1u << Register);
+        
+        if( (Body.UsedRegisters & Mask) && (AvailableRegisters & Mask) )
+          TakenRegisters |= Mask;
+    }
+    
+    // any others need an available register not in use
+    for( int Register = 1; Register <= 13; Register++ )
+    {
+        uint32_t Mask = (1u << Register);
+        
+        if( !(Body.UsedRegisters & Mask) || (TakenRegisters & Mask) )
+          continue;
+        
+        int NewRegister = -1;
+        
+        for( int Candidate = 1; Candidate <= 13 && NewRegister < 0; Candidate++ )
+        {
+            uint32_t CandidateMask = (1u << Candidate);
+            
+            if( (AvailableRegisters & CandidateMask) && !((Body.UsedRegisters | TakenRegisters) & CandidateMask) )
+              NewRegister = Candidate;
+        }
+        
+        if( NewRegister < 0 )
+          return false;
+        
+        NewRegisters[ Register ] = NewRegister;
+        TakenRegisters |= (1u << NewRegister);
+    }
+    
+    // now write the lines
+    InlinedBodies++;
+    string LabelSuffix = "_inline_" + to_string( InlinedBodies );
+    InlinedLines.clear();
+    
+    for( const AssemblyLine& Line: Body.Lines )
+    {
+        if( Line.IsLabel() )
+        {
+            InlinedLines.push_back( AssemblyLine::FromLabel( Line.LabelName + LabelSuffix ) );
+            continue;
+        }
+        
+        AssemblyLine NewLine = Line;
+        
+        for( unsigned o = 0; o < Line.Operands.size(); o++ )
+        {
+            const AssemblyOperand& Operand = Line.Operands[ o ];
+            
+            if( !Operand.IsRegister )
+            {
+                if( Line.IsJump() && o == Line.Operands.size() - 1 )
+                  NewLine.SetOperand( o, AssemblyOperand::FromValue( Operand.Value + LabelSuffix ) );
+                
+                continue;
+            }
+            
+            if( Operand.Register == BasePointer )
+              NewLine.SetOperand( o, AssemblyOperand::FromAddress( StackPointer, Operand.Offset - 2 ) );
+            
+            else if( NewRegisters[ Operand.Register ] != Operand.Register )
+            {
+                AssemblyOperand Renamed = Operand;
+                Renamed.Register = NewRegisters[ Operand.Register ];
+                NewLine.SetOperand( o, Renamed );
+            }
+        }
+        
+        InlinedLines.push_back( NewLine );
+    }
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// The body can modify registers the function is already allowed
+// to modify (same as when allocating registers), as long as they
+// are not needed after the call. The caller is optimized after
+// this, so values are propagated into the inlined body
+void VirconCOptimizer::InlineCalls()
+{
+    if( InlinableFunctions.empty() )
+      return;
+    
+    BuildBlocks();
+    AnalyzeStackFrame();
+    
+    vector< uint32_t > LiveBefore, LiveAfter;
+    ComputeRegisterLiveness( LiveBefore, LiveAfter );
+    
+    uint32_t FreeRegisters = FunctionModifiableRegisters();
+    
+    if( Function->HasStandardFrame )
+      FreeRegisters |= Function->PushedRegisters;
+    
+    // replace the calls
+    vector< AssemblyLine > NewLines;
+    vector< int > NewOrigins;
+    vector< AssemblyLine > InlinedLines;
+    
+    for( unsigned i = 0; i < Function->Lines.size(); i++ )
+    {
+        const AssemblyLine& Line = Function->Lines[ i ];
+        bool IsDirectCall = Line.IsInstruction( InstructionOpCodes::CALL ) && !Line.Operands[0].IsRegister && !Line.Operands[0].IsMemoryAddress;
+        
+        if( IsDirectCall )
+        {
+            auto Inlinable = InlinableFunctions.find( Line.Operands[0].Value );
+            uint32_t AvailableRegisters = FreeRegisters & ~LiveAfter[ i ] & GeneralRegisters;
+            
+            if( Inlinable != InlinableFunctions.end() && InlineBody( Inlinable->second, AvailableRegisters, InlinedLines ) )
+            {
+                for( const AssemblyLine& InlinedLine: InlinedLines )
+                {
+                    NewLines.push_back( InlinedLine );
+                    NewOrigins.push_back( Function->LineOrigins[ i ] );
+                }
+                
+                Function->InlinedCalls++;
+                continue;
+            }
+        }
+        
+        NewLines.push_back( Line );
+        NewOrigins.push_back( Function->LineOrigins[ i ] );
+    }
+    
+    Function->Lines = NewLines;
+    Function->LineOrigins = NewOrigins;
+    Function->RemovedLines.assign( NewLines.size(), false );
+}
@@ -0,0 +1,791 @@
+// *****************************************************************************
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // include C/C++ headers
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <climits>          // [ ANSI C ] Numeric limits
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+// registers R0 to R13; R0 is never given to variables
+// since it holds results and returned values
+static const uint32_t GeneralRegisters = 0x3FFF;
+
+static const int BasePointer = (int)CPURegisters::BasePointer;
+static const int StackPointer = (int)CPURegisters::StackPointer;
+
+// -----------------------------------------------------------------------------
+
+// label of the C function called directly by this line, if any
+static string CalledFunctionLabel( const AssemblyLine& Line )
+{
+    if( !Line.IsInstruction( InstructionOpCodes::CALL ) )
+      return "";
+    
+    const AssemblyOperand& Target = Line.Operands[0];
+    
+    if( Target.IsRegister || Target.IsMemoryAddress )
+      return "";
+    
+    if( Target.Value.rfind( "__function_", 0 ) != 0 )
+      return "";
+    
+    return Target.Value;
+}
+
+// -----------------------------------------------------------------------------
+
+// unlike the effects used to remove dead code, a return only
+// needs R0: preserving the caller's registers is handled
+// separately when giving registers to variables
+static void AllocationEffects( const AssemblyLine& Line, uint32_t& Read, uint32_t& Written )
+{
+    Read = Line.ReadRegisters();
+    Written = Line.WrittenRegisters();
+    
+    if( Line.IsInstruction( InstructionOpCodes::CALL ) )
+      if( CalledFunctionLabel( Line ).empty() && !Line.Operands[0].IsRegister )
+        Read = 0xFFFF;
+        
+    if( Line.IsInstruction( InstructionOpCodes::RET ) )
+      Read = 1 | (1u << BasePointer) | (1u << StackPointer);
+}
+
+// -----------------------------------------------------------------------------
+
+// the copy instruction "mov Destination, Source" between registers
+static bool IsRegisterCopy( const AssemblyLine& Line, int& Destination, int& Source )
+{
+    if( !Line.IsInstruction( InstructionOpCodes::MOV ) )
+      return false;
+    
+    const AssemblyOperand& Operand1 = Line.Operands[0];
+    const AssemblyOperand& Operand2 = Line.Operands[1];
+    
+    if( !Operand1.IsRegister || Operand1.IsMemoryAddress || !Operand2.IsRegister || Operand2.IsMemoryAddress )
+      return false;
+    
+    Destination = Operand1.Register;
+    Source = Operand2.Register;
+    return true;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: REGISTER CONVENTION
+// =============================================================================
+
+
+// Variables kept in registers follow this convention:
+// - Each C function may modify a known set of registers (its
+//   clobbered set): the ones it writes and the ones modified by
+//   its callees, except those saved by its prologue. R0 is always
+//   included. Calls through pointers or to assembly routines may
+//   modify any register from R0 to R13.
+// - All other registers are preserved (callee-saved). A function
+//   can give to its variables any registers it saves, and the ones
+//   it is allowed to modify. If it uses another one, the caller's
+//   value is kept in the variable's own stack slot and restored
+//   before returning.
+// - Functions that return a value are only allowed to modify R0,
+//   even if their clobbered set is larger (for instance, because
+//   of asm blocks that save registers with push and pop): callers
+//   built by the emitter keep temporary values in R1 and up while
+//   calling them within expressions. Other functions are allowed
+//   to modify their whole clobbered set.
+// - Around calls that can modify its register, a variable that
+//   is still needed is stored in its stack slot and reloaded.
+// Since giving registers to variables never extends the clobbered
+// sets, they can be determined from the program before optimizing
+void VirconCOptimizer::ComputeClobberedRegisters()
+{
+    ClobberedRegisters.clear();
+    ModifiableRegisters.clear();
+    map< string, uint32_t > SavedRegisters;
+    map< string, vector< string > > CalledFunctions;
+    
+    for( const EmittedFunction& Range: Emitter->EmittedFunctions )
+    {
+        string FunctionLabel = "__function_" + Range.Name;
+        uint32_t Written = 1;
+        uint32_t Saved = 0;
+        bool InPrologue = true;
+        
+        for( int i = Range.FirstLine; i < Range.EndLine; i++ )
+        {
+            AssemblyLine Line = AssemblyLine::FromText( Emitter->ProgramLines[ i ] );
+            
+            // lines not understood could modify anything
+            if( Line.Type == AssemblyLineTypes::Other && !Line.IsComment() )
+              Written = GeneralRegisters;
+            
+            if( !Line.IsInstruction() )
+              continue;
+            
+            // registers pushed by the prologue are restored on exit
+            if( InPrologue )
+            {
+                bool IsPush = Line.IsInstruction( InstructionOpCodes::PUSH ) && Line.Operands[0].IsRegister;
+                bool SetsFrame = Line.IsInstruction( InstructionOpCodes::MOV ) && (Line.WrittenRegisters() == (1u << BasePointer));
+                bool AllocatesFrame = Line.IsInstruction( InstructionOpCodes::ISUB ) && (Line.WrittenRegisters() == (1u << StackPointer));
+                
+                if( IsPush )
+                  Saved |= (1u << Line.Operands[0].Register) & GeneralRegisters;
+                
+                else if( !SetsFrame && !AllocatesFrame )
+                  InPrologue = false;
+            }
+            
+            Written |= Line.WrittenRegisters() & GeneralRegisters;
+            
+            if( Line.IsInstruction( InstructionOpCodes::CALL ) )
+            {
+                string Called = CalledFunctionLabel( Line );
+                
+                if( Called.empty() )
+                  Written = GeneralRegisters;
+                else
+                  CalledFunctions[ FunctionLabel ].push_back( Called );
+            }
+        }
+        
+        ClobberedRegisters[ FunctionLabel ] = Written & ~Saved;
+        SavedRegisters[ FunctionLabel ] = Saved;
+        
+        if( Range.PreservesRegisters )
+          ModifiableRegisters[ FunctionLabel ] = 1;
+    }
+    
+    // add the registers modified by called functions
+    // (repeated until recursive calls are resolved)
+    bool Changed = true;
+    
+    while( Changed )
+    {
+        Changed = false;
+        
+        for( auto& FunctionPair: CalledFunctions )
+        {
+            uint32_t& Clobbered = ClobberedRegisters[ FunctionPair.first ];
+            uint32_t NewClobbered = Clobbered;
+            
+            for( const string& Called: FunctionPair.second )
+            {
+                auto CalledClobbers = ClobberedRegisters.find( Called );
+                
+                if( CalledClobbers == ClobberedRegisters.end() )
+                  NewClobbered |= GeneralRegisters;
+                else
+                  NewClobbered |= CalledClobbers->second;
+            }
+            
+            NewClobbered &= ~SavedRegisters[ FunctionPair.first ];
+            
+            if( NewClobbered != Clobbered )
+            {
+                Clobbered = NewClobbered;
+                Changed = true;
+            }
+        }
+    }
+    
+    // the rest are allowed to modify all of them
+    for( auto& ClobbersPair: ClobberedRegisters )
+      if( !ModifiableRegisters.count( ClobbersPair.first ) )
+        ModifiableRegisters[ ClobbersPair.first ] = ClobbersPair.second;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t VirconCOptimizer::FunctionModifiableRegisters()
+{
+    auto Modifiable = ModifiableRegisters.find( Function->EntryLabel );
+    
+    if( Modifiable == ModifiableRegisters.end() )
+      return GeneralRegisters;
+    
+    return Modifiable->second;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t VirconCOptimizer::CallClobbers( const AssemblyLine& Line )
+{
+    auto Clobbers = ClobberedRegisters.find( CalledFunctionLabel( Line ) );
+    
+    if( Clobbers == ClobberedRegisters.end() )
+      return GeneralRegisters;
+    
+    return Clobbers->second;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: ANALYSIS FOR REGISTER ALLOCATION
+// =============================================================================
+
+
+// Gives each line an estimate of how many times it runs,
+// relative to the function's start. Loops are detected as
+// jumps backwards, and each nesting level counts 8 times
+void VirconCOptimizer::EstimateLineWeights( vector< int >& LineWeights )
+{
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< int > LoopDepths( Blocks.size(), 0 );
+    
+    for( int b = 0; b < (int)Blocks.size(); b++ )
+      for( int Successor: Blocks[ b ].Successors )
+        if( Successor <= b )
+          for( int Inner = Successor; Inner <= b; Inner++ )
+            LoopDepths[ Inner ]++;
+            
+    LineWeights.assign( Function->Lines.size(), 1 );
+    
+    for( unsigned b = 0; b < Blocks.size(); b++ )
+    {
+        int Weight = 1;
+        
+        for( int Depth = 0; Depth < min( LoopDepths[ b ], 4 ); Depth++ )
+          Weight *= 8;
+        
+        for( int i = Blocks[ b ].FirstLine; i < Blocks[ b ].EndLine; i++ )
+          LineWeights[ i ] = Weight;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::ComputeRegisterLiveness( vector< uint32_t >& LiveBefore, vector< uint32_t >& LiveAfter )
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< uint32_t > LiveAtBlockStart( Blocks.size(), 0 );
+    LiveBefore.assign( Lines.size(), 0 );
+    LiveAfter.assign( Lines.size(), 0 );
+    
+    // iterate until no changes are found
+    bool Changed = true;
+    
+    while( Changed )
+    {
+        Changed = false;
+        
+        for( int b = Blocks.size() - 1; b >= 0; b-- )
+        {
+            BasicBlock& Block = Blocks[ b ];
+            uint32_t Live = (Block.LeavesFunction? 0xFFFF : 0);
+            
+            for( int Successor: Block.Successors )
+              Live |= LiveAtBlockStart[ Successor ];
+            
+            for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+            {
+                LiveAfter[ i ] = Live;
+                
+                uint32_t Read, Written;
+                AllocationEffects( Lines[ i ], Read, Written );
+                Live = (Live & ~Written) | Read;
+                
+                LiveBefore[ i ] = Live;
+            }
+            
+            if( Live != LiveAtBlockStart[ b ] )
+            {
+                LiveAtBlockStart[ b ] = Live;
+                Changed = true;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// liveness of a single stack slot, which can only
+// be accessed by loads and stores (it is not part of
+// the call area, and the frame does not escape)
+void VirconCOptimizer::ComputeSlotLiveness( int32_t Slot, vector< bool >& LiveBefore, vector< bool >& LiveAfter )
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< bool > LiveAtBlockStart( Blocks.size(), false );
+    LiveBefore.assign( Lines.size(), false );
+    LiveAfter.assign( Lines.size(), false );
+    
+    bool Changed = true;
+    
+    while( Changed )
+    {
+        Changed = false;
+        
+        for( int b = Blocks.size() - 1; b >= 0; b-- )
+        {
+            BasicBlock& Block = Blocks[ b ];
+            bool Live = Block.LeavesFunction;
+            
+            for( int Successor: Block.Successors )
+              Live = Live || LiveAtBlockStart[ Successor ];
+            
+            for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+            {
+                LiveAfter[ i ] = Live;
+                
+                if( Function->AccessesSlot[ i ] && Function->AccessedSlots[ i ] == Slot )
+                {
+                    if( Lines[ i ].WritesMemoryOperand() ) Live = false;
+                    if( Lines[ i ].ReadsMemoryOperand() ) Live = true;
+                }
+                
+                LiveBefore[ i ] = Live;
+            }
+            
+            if( Live != LiveAtBlockStart[ b ] )
+            {
+                LiveAtBlockStart[ b ] = Live;
+                Changed = true;
+            }
+        }
+    }
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: REGISTER ALLOCATION
+// =============================================================================
+
+
+// Scalar variables and parameters (any stack slot only accessed
+// by loads and stores) are moved to registers, one at a time,
+// starting from the most used. Each one takes the register with
+// the lowest cost that does not interfere with the registers
+// and variables already in use; when none is left, or keeping
+// the variable in the stack is cheaper, it stays in the stack
+bool VirconCOptimizer::AllocateRegisters()
+{
+    Function->RegistersSavedInSlots = 0;
+    
+    BuildBlocks();
+    AnalyzeStackFrame();
+    
+    if( !Function->HasStandardFrame || Function->FrameEscapes || Function->CallAreaSize < 0 )
+      return false;
+    
+    // all exits have to be known
+    for( int b: ReversePostorder() )
+      if( Function->Blocks[ b ].LeavesFunction )
+        return false;
+        
+    // find the candidate slots and estimate their uses
+    vector< int > LineWeights;
+    EstimateLineWeights( LineWeights );
+    
+    map< int32_t, int > SlotUses;
+    set< int32_t > ExcludedSlots;
+    int32_t CallAreaStart = Function->BodyStackOffset;
+    int32_t CallAreaEnd = CallAreaStart + Function->CallAreaSize;
+    
+    for( unsigned i = 0; i < Function->Lines.size(); i++ )
+    {
+        if( !Function->AccessesSlot[ i ] )
+          continue;
+        
+        int32_t Slot = Function->AccessedSlots[ i ];
+        
+        // exclude the return address, saved registers
+        // and arguments passed to called functions
+        bool IsCallArea = (Slot >= CallAreaStart && Slot < CallAreaEnd);
+        
+        if( IsCallArea || Slot == 0 || !Function->Lines[ i ].IsInstruction( InstructionOpCodes::MOV ) )
+          ExcludedSlots.insert( Slot );
+        else
+          SlotUses[ Slot ] += LineWeights[ i ];
+    }
+    
+    vector< pair< int, int32_t > > Candidates;
+    
+    for( auto& SlotPair: SlotUses )
+      if( !ExcludedSlots.count( SlotPair.first ) )
+        Candidates.push_back( make_pair( -SlotPair.second, SlotPair.first ) );
+        
+    sort( Candidates.begin(), Candidates.end() );
+    
+    // now try to place them in registers
+    for( auto& Candidate: Candidates )
+      if( AllocateVariable( Candidate.second ) )
+        Function->VariablesInRegisters++;
+        
+    return (Function->VariablesInRegisters > 0);
+}
+
+// -----------------------------------------------------------------------------
+
+bool VirconCOptimizer::AllocateVariable( int32_t Slot )
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    
+    // previous allocations have changed the lines
+    BuildBlocks();
+    AnalyzeStackFrame();
+    
+    if( !Function->HasStandardFrame || Function->FrameEscapes )
+      return false;
+    
+    vector< int > LineWeights;
+    EstimateLineWeights( LineWeights );
+    
+    vector< uint32_t > RegistersLiveBefore, RegistersLiveAfter;
+    ComputeRegisterLiveness( RegistersLiveBefore, RegistersLiveAfter );
+    
+    vector< bool > SlotLiveBefore, SlotLiveAfter;
+    ComputeSlotLiveness( Slot, SlotLiveBefore, SlotLiveAfter );
+    
+    // find all accesses to the variable
+    vector< int > Accesses;
+    int Benefit = 0;
+    
+    for( unsigned i = 0; i < Lines.size(); i++ )
+      if( Function->AccessesSlot[ i ] && Function->AccessedSlots[ i ] == Slot )
+      {
+          if( !Lines[ i ].IsInstruction( InstructionOpCodes::MOV ) )
+            return false;
+            
+          Accesses.push_back( i );
+          Benefit += LineWeights[ i ];
+      }
+    
+    if( Accesses.empty() )
+      return false;
+    
+    // parameters have to be loaded at the start
+    bool IsParameter = (Slot > 0);
+    int BodyStart = Function->BodyFirstLine;
+    bool LiveAtStart = SlotLiveBefore[ BodyStart ];
+    bool NeedsLoad = IsParameter && LiveAtStart;
+    
+    // registers that can be used without saving them
+    uint32_t FreeRegisters = Function->PushedRegisters | Function->RegistersSavedInSlots;
+    FreeRegisters |= FunctionModifiableRegisters();
+    
+    // evaluate each register
+    int BestRegister = -1;
+    int BestCost = INT_MAX;
+    vector< int > BestSpills;
+    
+    for( int Register = 1; Register <= 13; Register++ )
+    {
+        uint32_t Mask = (1u << Register);
+        bool NeedsSaving = !(FreeRegisters & Mask);
+        int Cost = (NeedsLoad? 1 : 0) + (NeedsSaving? 2 : 0);
+        vector< int > Spills;
+        
+        // to save the caller's value in a parameter's slot,
+        // the parameter is first moved through R0
+        if( NeedsLoad && NeedsSaving )
+        {
+            if( RegistersLiveBefore[ BodyStart ] & 1 )
+              continue;
+            
+            Cost += 2;
+        }
+        
+        if( LiveAtStart && (RegistersLiveBefore[ BodyStart ] & Mask) )
+          continue;
+        
+        bool Interferes = false;
+        
+        for( int i = 0; i < (int)Lines.size() && !Interferes; i++ )
+        {
+            const AssemblyLine& Line = Lines[ i ];
+            
+            if( !Line.IsInstruction() )
+              continue;
+            
+            bool IsAccess = Function->AccessesSlot[ i ] && Function->AccessedSlots[ i ] == Slot;
+            
+            // the register can't change while the variable is
+            // needed, unless the variable is loaded to it
+            if( (Line.WrittenRegisters() & Mask) && SlotLiveAfter[ i ] )
+              if( !IsAccess || !Line.ReadsMemoryOperand() || Line.Operands[0].Register != Register )
+                Interferes = true;
+                
+            // nor can the variable be written while the
+            // register is needed, unless copied from it
+            if( IsAccess && Line.WritesMemoryOperand() && (RegistersLiveAfter[ i ] & Mask) )
+            {
+                const AssemblyOperand& Source = Line.Operands[1];
+                
+                if( !Source.IsRegister || Source.Register != Register )
+                  Interferes = true;
+            }
+            
+            // calls that modify the register
+            if( Line.IsInstruction( InstructionOpCodes::CALL ) && SlotLiveAfter[ i ] && (CallClobbers( Line ) & Mask) )
+            {
+                if( NeedsSaving )
+                  Interferes = true;
+                
+                Spills.push_back( i );
+                Cost += 2 * LineWeights[ i ];
+            }
+        }
+        
+        if( Interferes || Cost >= BestCost )
+          continue;
+        
+        BestRegister = Register;
+        BestCost = Cost;
+        BestSpills = Spills;
+    }
+    
+    if( BestRegister < 0 || BestCost >= Benefit )
+      return false;
+    
+    // replace all accesses with the register
+    AssemblyOperand RegisterOperand = AssemblyOperand::FromRegister( BestRegister );
+    AssemblyOperand SlotOperand = AssemblyOperand::FromAddress( BasePointer, Slot - Function->FramePointerOffset );
+    
+    for( int i: Accesses )
+    {
+        if( Lines[ i ].WritesMemoryOperand() )
+          Lines[ i ].SetOperand( 0, RegisterOperand );
+        else
+          Lines[ i ].SetOperand( 1, RegisterOperand );
+    }
+    
+    // new lines to insert before and after existing ones
+    map< int, vector< AssemblyLine > > LinesBefore, LinesAfter;
+    AssemblyLine Load = AssemblyLine::FromInstruction( InstructionOpCodes::MOV, { RegisterOperand, SlotOperand } );
+    AssemblyLine Store = AssemblyLine::FromInstruction( InstructionOpCodes::MOV, { SlotOperand, RegisterOperand } );
+    
+    bool NeedsSaving = !(FreeRegisters & (1u << BestRegister));
+    
+    if( NeedsLoad && !NeedsSaving )
+      LinesBefore[ BodyStart ].push_back( Load );
+    
+    // preserve the caller's value in the variable's slot
+    if( NeedsSaving )
+    {
+        AssemblyOperand R0 = AssemblyOperand::FromRegister( 0 );
+        
+        if( NeedsLoad )
+          LinesBefore[ BodyStart ].push_back( AssemblyLine::FromInstruction( InstructionOpCodes::MOV, { R0, SlotOperand } ) );
+        
+        LinesBefore[ BodyStart ].push_back( Store );
+        
+        if( NeedsLoad )
+          LinesBefore[ BodyStart ].push_back( AssemblyLine::FromInstruction( InstructionOpCodes::MOV, { RegisterOperand, R0 } ) );
+        
+        Function->RegistersSavedInSlots |= (1u << BestRegister);
+        
+        // restore it before the epilogue
+        for( const BasicBlock& Block: Function->Blocks )
+        {
+            if( !Block.Returns )
+              continue;
+            
+            int Position = Block.EndLine;
+            
+            for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+            {
+                if( Lines[ i ].IsInstruction() && !(Lines[ i ].WrittenRegisters() & (1u << StackPointer)) )
+                  if( !Lines[ i ].IsInstruction( InstructionOpCodes::HLT ) )
+                    break;
+                    
+                if( Lines[ i ].IsInstruction() )
+                  Position = i;
+            }
+            
+            LinesBefore[ Position ].push_back( Load );
+        }
+    }
+    
+    // spill the variable around calls
+    for( int i: BestSpills )
+    {
+        LinesBefore[ i ].push_back( Store );
+        LinesAfter[ i ].push_back( Load );
+    }
+    
+    // build the new list of lines
+    vector< AssemblyLine > NewLines;
+    vector< int > NewOrigins;
+    
+    for( unsigned i = 0; i < Lines.size(); i++ )
+    {
+        for( const AssemblyLine& Inserted: LinesBefore[ i ] )
+        {
+            NewLines.push_back( Inserted );
+            NewOrigins.push_back( Function->LineOrigins[ i ] );
+        }
+        
+        NewLines.push_back( Lines[ i ] );
+        NewOrigins.push_back( Function->LineOrigins[ i ] );
+        
+        for( const AssemblyLine& Inserted: LinesAfter[ i ] )
+        {
+            NewLines.push_back( Inserted );
+            NewOrigins.push_back( Function->LineOrigins[ i ] );
+        }
+    }
+    
+    Function->Lines = NewLines;
+    Function->LineOrigins = NewOrigins;
+    Function->RemovedLines.assign( NewLines.size(), false );
+    ChangesMade = true;
+    return true;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: COPY COALESCING
+// =============================================================================
+
+
+// The emitter computes in temporary registers, so a variable
+// in a register is usually updated with copies, as in
+// "mov R0, R5 / iadd R0, 1 / mov R5, R0". When the temporary
+// is not needed later, it is replaced by the final register
+// from its definition on, and the copies become unnecessary
+bool VirconCOptimizer::CoalesceCopy( int Position, const vector< uint32_t >& LiveAfter )
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    int Final, Temporary;
+    
+    if( !IsRegisterCopy( Lines[ Position ], Final, Temporary ) )
+      return false;
+    
+    if( Final == Temporary || Final > 13 || Temporary > 13 )
+      return false;
+    
+    if( LiveAfter[ Position ] & (1u << Temporary) )
+      return false;
+    
+    // find where the temporary gets its value in this block;
+    // the final register can't be used meanwhile, unless it is
+    // read while the temporary is still an unchanged copy of it
+    int Definition = -1;
+    int LastFinalRead = -1;
+    int FirstTemporaryWrite = Position;
+    
+    for( int i = Position - 1; i >= 0 && Definition < 0; i-- )
+    {
+        const AssemblyLine& Line = Lines[ i ];
+        
+        if( Line.IsLabel() || Line.IsJump() || Line.EndsControlFlow() )
+          return false;
+        
+        if( !Line.IsInstruction() )
+          continue;
+        
+        // avoid any implicit uses of registers
+        switch( Line.OpCode )
+        {
+            case InstructionOpCodes::CALL:
+            case InstructionOpCodes::PUSH:
+            case InstructionOpCodes::POP:
+            case InstructionOpCodes::MOVS:
+            case InstructionOpCodes::SETS:
+            case InstructionOpCodes::CMPS:
+              return false;
+            
+            default:
+              break;
+        }
+        
+        uint32_t Read = Line.ReadRegisters();
+        uint32_t Written = Line.WrittenRegisters();
+        bool DefinesTemporary = (Written == (1u << Temporary)) && !(Read & (1u << Temporary));
+        
+        if( DefinesTemporary )
+        {
+            bool IsPureDefinition = Line.IsInstruction( InstructionOpCodes::MOV )
+                                 || Line.IsInstruction( InstructionOpCodes::LEA )
+                                 || Line.IsInstruction( InstructionOpCodes::IN );
+                                
+            if( !IsPureDefinition )
+              return false;
+            
+            Definition = i;
+            continue;
+        }
+        
+        if( Written & (1u << Final) )
+          return false;
+        
+        if( (Read & (1u << Final)) && LastFinalRead < 0 )
+          LastFinalRead = i;
+        
+        if( Written & (1u << Temporary) )
+          FirstTemporaryWrite = i;
+    }
+    
+    if( Definition < 0 )
+      return false;
+    
+    if( LastFinalRead >= 0 )
+    {
+        int Destination, Source;
+        
+        if( !IsRegisterCopy( Lines[ Definition ], Destination, Source ) || Source != Final )
+          return false;
+        
+        if( LastFinalRead >= FirstTemporaryWrite )
+          return false;
+    }
+    
+    // rename the temporary
+    for( int i = Definition; i <= Position; i++ )
+    {
+        AssemblyLine& Line = Lines[ i ];
+        
+        if( !Line.IsInstruction() )
+          continue;
+        
+        for( unsigned o = 0; o < Line.Operands.size(); o++ )
+          if( Line.Operands[ o ].IsRegister && Line.Operands[ o ].Register == Temporary )
+          {
+              AssemblyOperand Renamed = Line.Operands[ o ];
+              Renamed.Register = Final;
+              Line.SetOperand( o, Renamed );
+          }
+    }
+    
+    // now remove the copies
+    int Destination, Source;
+    RemoveLine( Position );
+    
+    if( IsRegisterCopy( Lines[ Definition ], Destination, Source ) && Destination == Source )
+      RemoveLine( Definition );
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::CoalesceCopies()
+{
+    bool Coalesced = true;
+    
+    while( Coalesced )
+    {
+        Coalesced = false;
+        BuildBlocks();
+        
+        vector< uint32_t > LiveBefore, LiveAfter;
+        ComputeRegisterLiveness( LiveBefore, LiveAfter );
+        
+        for( int i = 0; i < (int)Function->Lines.size() && !Coalesced; i++ )
+          Coalesced = CoalesceCopy( i, LiveAfter );
+        
+        CompactLines();
+    }
+}
@@ -0,0 +1,900 @@
+// *****************************************************************************
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // include C/C++ headers
+    #include <climits>          // [ ANSI C ] Numeric limits
+    #include <cctype>           // [ ANSI C ] Character classification
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      VALUE NUMBERING: TABLE OF VALUES
+// =============================================================================
+
+
+void VirconCOptimizer::ResetValues()
+{
+    Values.clear();
+    OffsetValues.clear();
+    TextValues.clear();
+    ExpressionValues.clear();
+    Clock = 0;
+    
+    // value 0 is integer 0, which is also used as root for
+    // all integers (they are taken as offsets from zero)
+    OptimizerValue Zero;
+    Zero.IsConstant = true;
+    Zero.IsInteger = true;
+    Zero.IntegerValue = 0;
+    Zero.Text = "0";
+    Zero.Root = 0;
+    Zero.Offset = 0;
+    Values.push_back( Zero );
+    
+    // the stack position at function entry
+    // is the root for the whole stack frame
+    FrameRoot = NewValue();
+}
+
+// -----------------------------------------------------------------------------
+
+int VirconCOptimizer::NewValue()
+{
+    OptimizerValue Value;
+    Value.IsConstant = false;
+    Value.IsInteger = false;
+    Value.IntegerValue = 0;
+    Value.Root = Values.size();
+    Value.Offset = 0;
+    
+    Values.push_back( Value );
+    return Value.Root;
+}
+
+// -----------------------------------------------------------------------------
+
+// offsets wrap around like the CPU's integer additions
+int VirconCOptimizer::OffsetValue( int Root, int32_t Offset )
+{
+    if( Offset == 0 )
+      return Root;
+    
+    auto Existing = OffsetValues.find( make_pair( Root, Offset ) );
+    
+    if( Existing != OffsetValues.end() )
+      return Existing->second;
+    
+    OptimizerValue Value;
+    Value.IsConstant = (Root == 0);
+    Value.IsInteger = (Root == 0);
+    Value.IntegerValue = Offset;
+    Value.Root = Root;
+    Value.Offset = Offset;
+    
+    if( Value.IsConstant )
+      Value.Text = IntegerValueToString( Offset );
+    
+    Values.push_back( Value );
+    OffsetValues[ make_pair( Root, Offset ) ] = Values.size() - 1;
+    return Values.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+
+int VirconCOptimizer::IntegerValue( int32_t Number )
+{
+    return OffsetValue( 0, Number );
+}
+
+// -----------------------------------------------------------------------------
+
+int VirconCOptimizer::ConstantValue( const string& Text )
+{
+    int32_t Number;
+    
+    if( ParseIntegerValue( Text, Definitions, Number ) )
+      return IntegerValue( Number );
+    
+    // names with several definitions can't be identified
+    if( RedefinedNames.count( Text ) )
+      return NewValue();
+    
+    // other constants (labels, floats...) are
+    // identified by the text they are written with
+    auto Existing = TextValues.find( Text );
+    
+    if( Existing != TextValues.end() )
+      return Existing->second;
+    
+    int Value = NewValue();
+    Values[ Value ].IsConstant = true;
+    Values[ Value ].Text = Text;
+    TextValues[ Text ] = Value;
+    return Value;
+}
+
+// -----------------------------------------------------------------------------
+
+bool VirconCOptimizer::IsFrameValue( int Value )
+{
+    return Function->HasStandardFrame && (Values[ Value ].Root == FrameRoot);
+}
+
+
+// =============================================================================
+//      VALUE NUMBERING: STATE HANDLING
+// =============================================================================
+
+
+void VirconCOptimizer::InitializeState( ValueState& State, int BlockIndex )
+{
+    for( int i = 0; i < 16; i++ )
+    {
+        State.RegisterValues[ i ] = NewValue();
+        State.RegisterAges[ i ] = 0;
+    }
+    
+    State.MemoryValues.clear();
+    
+    // with a standard frame, BP and SP are known everywhere
+    if( Function->HasStandardFrame )
+    {
+        int BP = (int)CPURegisters::BasePointer;
+        int SP = (int)CPURegisters::StackPointer;
+        
+        if( BlockIndex == 0 )
+          State.RegisterValues[ SP ] = FrameRoot;
+        
+        else
+        {
+            State.RegisterValues[ BP ] = OffsetValue( FrameRoot, Function->FramePointerOffset );
+            State.RegisterValues[ SP ] = OffsetValue( FrameRoot, Function->BodyStackOffset );
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::AssignRegister( ValueState& State, int Register, int Value )
+{
+    State.RegisterValues[ Register ] = Value;
+    State.RegisterAges[ Register ] = ++Clock;
+}
+
+// -----------------------------------------------------------------------------
+
+// finds the register that has held a value for
+// the longest time, or -1 if none of them has it
+int VirconCOptimizer::FindHolder( const ValueState& State, int Value, bool AllowStackRegisters )
+{
+    int LastRegister = (AllowStackRegisters? 15 : 13);
+    int Holder = -1;
+    
+    for( int i = 0; i <= LastRegister; i++ )
+      if( State.RegisterValues[ i ] == Value )
+        if( Holder < 0 || State.RegisterAges[ i ] < State.RegisterAges[ Holder ] )
+          Holder = i;
+        
+    return Holder;
+}
+
+// -----------------------------------------------------------------------------
+
+pair< int, int32_t > VirconCOptimizer::OperandAddress( const ValueState& State, const AssemblyOperand& Operand )
+{
+    int Base = Operand.IsRegister? State.RegisterValues[ Operand.Register ] : ConstantValue( Operand.Value );
+    uint32_t Offset = (uint32_t)Values[ Base ].Offset + (uint32_t)Operand.Offset;
+    return make_pair( Values[ Base ].Root, (int32_t)Offset );
+}
+
+// -----------------------------------------------------------------------------
+
+int VirconCOptimizer::OperandValue( const ValueState& State, const AssemblyOperand& Operand )
+{
+    if( Operand.IsRegister )
+      return State.RegisterValues[ Operand.Register ];
+    
+    return ConstantValue( Operand.Value );
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyOperand VirconCOptimizer::ValueToOperand( int Value )
+{
+    return AssemblyOperand::FromValue( Values[ Value ].Text );
+}
+
+// -----------------------------------------------------------------------------
+
+// memory is never accessed partially, so different words
+// cannot overlap; addresses are only assumed to be different
+// when they are known to point to different variables
+bool VirconCOptimizer::MayAlias( pair< int, int32_t > Address1, pair< int, int32_t > Address2 )
+{
+    if( Address1 == Address2 )
+      return true;
+    
+    int Root1 = Address1.first;
+    int Root2 = Address2.first;
+    
+    // same base at different offsets
+    if( Root1 == Root2 )
+      return false;
+    
+    // global variables and constant data are all different
+    bool IsGlobal1 = Values[ Root1 ].IsConstant;
+    bool IsGlobal2 = Values[ Root2 ].IsConstant;
+    
+    if( IsGlobal1 && IsGlobal2 )
+      return false;
+    
+    // the stack frame can only be reached through
+    // pointers when its addresses have escaped
+    bool IsFrame1 = IsFrameValue( Root1 );
+    bool IsFrame2 = IsFrameValue( Root2 );
+    
+    if( (IsFrame1 && IsGlobal2) || (IsFrame2 && IsGlobal1) )
+      return false;
+    
+    if( IsFrame1 || IsFrame2 )
+      return Function->FrameEscapes;
+    
+    // any other pointers may point anywhere
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::StoreToMemory( ValueState& State, pair< int, int32_t > Address, int Value )
+{
+    for( auto Position = State.MemoryValues.begin(); Position != State.MemoryValues.end(); )
+    {
+        if( MayAlias( Position->first, Address ) )
+          Position = State.MemoryValues.erase( Position );
+        else
+          Position++;
+    }
+    
+    State.MemoryValues[ Address ] = Value;
+}
+
+// -----------------------------------------------------------------------------
+
+// called functions can modify any memory except our stack
+// frame, where they only reach their own parameters
+void VirconCOptimizer::ForgetMemoryOnCall( ValueState& State )
+{
+    int StackValue = State.RegisterValues[ (int)CPURegisters::StackPointer ];
+    bool CanKeepFrame = IsFrameValue( StackValue ) && !Function->FrameEscapes && (Function->CallAreaSize >= 0);
+    int32_t CallAreaEnd = Values[ StackValue ].Offset + Function->CallAreaSize;
+    
+    for( auto Position = State.MemoryValues.begin(); Position != State.MemoryValues.end(); )
+    {
+        bool Keep = CanKeepFrame
+                 && (Position->first.first == FrameRoot)
+                 && (Position->first.second >= CallAreaEnd);
+                
+        if( Keep )
+          Position++;
+        else
+          Position = State.MemoryValues.erase( Position );
+    }
+}
+
+
+// =============================================================================
+//      VALUE NUMBERING: REWRITING INSTRUCTIONS
+// =============================================================================
+
+
+// expresses a memory address in its simplest form: fixed
+// addresses as numbers, and stack variables relative to BP
+void VirconCOptimizer::SimplifyAddress( AssemblyLine& Line, unsigned Position, const ValueState& State )
+{
+    const AssemblyOperand& Operand = Line.Operands[ Position ];
+    
+    if( !Operand.IsMemoryAddress || !Operand.IsRegister )
+      return;
+    
+    pair< int, int32_t > Address = OperandAddress( State, Operand );
+    AssemblyOperand NewOperand = Operand;
+    int BP = (int)CPURegisters::BasePointer;
+    
+    // fixed addresses
+    if( Address.first == 0 && Address.second >= 0 )
+      NewOperand = AssemblyOperand::FromAddress( IntegerValueToString( Address.second ) );
+    
+    else if( Values[ Address.first ].IsConstant && Address.second == 0 )
+      NewOperand = AssemblyOperand::FromAddress( Values[ Address.first ].Text );
+    
+    // stack frame addresses
+    else if( IsFrameValue( Address.first ) && IsFrameValue( State.RegisterValues[ BP ] ) )
+    {
+        uint32_t Offset = (uint32_t)Address.second - (uint32_t)Values[ State.RegisterValues[ BP ] ].Offset;
+        NewOperand = AssemblyOperand::FromAddress( BP, (int32_t)Offset );
+    }
+    
+    // otherwise use the oldest register with the same root
+    else
+    {
+        int Holder = -1;
+        
+        for( int i = 0; i < 16; i++ )
+          if( Values[ State.RegisterValues[ i ] ].Root == Address.first )
+            if( Holder < 0 || State.RegisterAges[ i ] < State.RegisterAges[ Holder ] )
+              Holder = i;
+            
+        uint32_t Offset = (uint32_t)Address.second - (uint32_t)Values[ State.RegisterValues[ Holder ] ].Offset;
+        NewOperand = AssemblyOperand::FromAddress( Holder, (int32_t)Offset );
+    }
+    
+    if( NewOperand != Operand )
+    {
+        Line.SetOperand( Position, NewOperand );
+        ChangesMade = true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// replaces registers that are only read: constants become
+// immediates when allowed, and copies of a value are replaced
+// by its oldest holder so that newer copies become unneeded
+void VirconCOptimizer::SimplifySources( AssemblyLine& Line, const ValueState& State )
+{
+    InstructionOpCodes OpCode = Line.OpCode;
+    int SourcePosition = -1;
+    bool AllowsImmediate = false;
+    
+    if( OpCode == InstructionOpCodes::MOV )
+    {
+        if( Line.Operands[0].IsMemoryAddress )
+          SimplifyAddress( Line, 0, State );
+        
+        if( Line.Operands[1].IsMemoryAddress )
+          SimplifyAddress( Line, 1, State );
+        
+        SourcePosition = 1;
+        AllowsImmediate = !Line.Operands[0].IsMemoryAddress;
+    }
+    
+    else if( OpCode == InstructionOpCodes::LEA )
+      SimplifyAddress( Line, 1, State );
+    
+    else if( IsBinaryOperation( OpCode ) || OpCode == InstructionOpCodes::OUT )
+    {
+        SourcePosition = 1;
+        AllowsImmediate = AcceptsImmediateSource( OpCode );
+    }
+    
+    if( SourcePosition < 0 )
+      return;
+    
+    // BP and SP are left as they are
+    AssemblyOperand& Source = Line.Operands[ SourcePosition ];
+    
+    if( !Source.IsRegister || Source.IsMemoryAddress || Source.Register > 13 )
+      return;
+    
+    int Value = State.RegisterValues[ Source.Register ];
+    
+    // operations can't take labels as immediates
+    const string& ValueText = Values[ Value ].Text;
+    bool IsName = !ValueText.empty() && (isalpha( ValueText[ 0 ] ) || ValueText[ 0 ] == '_');
+    
+    if( IsName && IsBinaryOperation( OpCode ) )
+      AllowsImmediate = false;
+    
+    if( AllowsImmediate && Values[ Value ].IsConstant )
+    {
+        Line.SetOperand( SourcePosition, ValueToOperand( Value ) );
+        ChangesMade = true;
+        return;
+    }
+    
+    int Holder = FindHolder( State, Value, false );
+    
+    if( Holder >= 0 && Holder != Source.Register )
+    {
+        Line.SetOperand( SourcePosition, AssemblyOperand::FromRegister( Holder ) );
+        ChangesMade = true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static bool IsCommutative( InstructionOpCodes OpCode )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::IADD:
+        case InstructionOpCodes::IMUL:
+        case InstructionOpCodes::AND:
+        case InstructionOpCodes::OR:
+        case InstructionOpCodes::XOR:
+        case InstructionOpCodes::IMIN:
+        case InstructionOpCodes::IMAX:
+        case InstructionOpCodes::IEQ:
+        case InstructionOpCodes::INE:
+        case InstructionOpCodes::FADD:
+        case InstructionOpCodes::FMUL:
+        case InstructionOpCodes::FMIN:
+        case InstructionOpCodes::FMAX:
+        case InstructionOpCodes::FEQ:
+        case InstructionOpCodes::FNE:
+          return true;
+        
+        default:
+          return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// Determines the result of an integer operation when it can
+// be known without running it. Value2 is -1 for unary operations.
+// Float operations are never folded, since results could differ
+// from the ones obtained in the console
+bool VirconCOptimizer::FoldOperation( AssemblyLine& Line, ValueState& State, int Value1, int Value2, int& Result )
+{
+    OptimizerValue Operand1 = Values[ Value1 ];
+    bool IsInteger1 = Operand1.IsConstant && Operand1.IsInteger;
+    int32_t A = Operand1.IntegerValue;
+    uint32_t UA = (uint32_t)A;
+    
+    // unary operations
+    if( Value2 < 0 )
+    {
+        if( !IsInteger1 )
+          return false;
+        
+        switch( Line.OpCode )
+        {
+            case InstructionOpCodes::NOT:   Result = IntegerValue( (int32_t)~UA );         return true;
+            case InstructionOpCodes::BNOT:  Result = IntegerValue( A? 0 : 1 );             return true;
+            case InstructionOpCodes::CIB:   Result = IntegerValue( A? 1 : 0 );             return true;
+            case InstructionOpCodes::ISGN:  Result = IntegerValue( (int32_t)(0u - UA) );   return true;
+            
+            case InstructionOpCodes::IABS:
+              if( A == INT_MIN ) return false;
+              Result = IntegerValue( A < 0? -A : A );
+              return true;
+            
+            default:
+              return false;
+        }
+    }
+    
+    OptimizerValue Operand2 = Values[ Value2 ];
+    bool IsInteger2 = Operand2.IsConstant && Operand2.IsInteger;
+    int32_t B = Operand2.IntegerValue;
+    uint32_t UB = (uint32_t)B;
+    
+    // additions and subtractions keep track of addresses
+    if( Line.OpCode == InstructionOpCodes::IADD )
+    {
+        if( IsInteger2 )
+        {
+            Result = OffsetValue( Operand1.Root, (int32_t)((uint32_t)Operand1.Offset + UB) );
+            return true;
+        }
+        
+        if( IsInteger1 )
+        {
+            Result = OffsetValue( Operand2.Root, (int32_t)((uint32_t)Operand2.Offset + UA) );
+            return true;
+        }
+        
+        return false;
+    }
+    
+    if( Line.OpCode == InstructionOpCodes::ISUB )
+    {
+        if( IsInteger2 )
+        {
+            Result = OffsetValue( Operand1.Root, (int32_t)((uint32_t)Operand1.Offset - UB) );
+            return true;
+        }
+        
+        // (the difference of 2 addresses is also known)
+        if( Operand1.Root == Operand2.Root )
+        {
+            Result = IntegerValue( (int32_t)((uint32_t)Operand1.Offset - (uint32_t)Operand2.Offset) );
+            return true;
+        }
+        
+        return false;
+    }
+    
+    // operations where one operand is enough to know the result
+    if( IsInteger2 )
+    {
+        bool IsNeutral = (B == 0 && (Line.OpCode == InstructionOpCodes::OR || Line.OpCode == InstructionOpCodes::XOR || Line.OpCode == InstructionOpCodes::SHL))
+                      || (B == 1 && (Line.OpCode == InstructionOpCodes::IMUL || Line.OpCode == InstructionOpCodes::IDIV));
+                    
+        bool IsAbsorbing = (B == 0 && (Line.OpCode == InstructionOpCodes::AND || Line.OpCode == InstructionOpCodes::IMUL));
+        
+        if( IsNeutral )
+        {
+            Result = Value1;
+            return true;
+        }
+        
+        if( IsAbsorbing )
+        {
+            Result = IntegerValue( 0 );
+            return true;
+        }
+    }
+    
+    if( !IsInteger1 || !IsInteger2 )
+      return false;
+    
+    // operations on 2 integers
+    switch( Line.OpCode )
+    {
+        case InstructionOpCodes::IMUL:  Result = IntegerValue( (int32_t)(UA * UB) );  return true;
+        case InstructionOpCodes::AND:   Result = IntegerValue( (int32_t)(UA & UB) );  return true;
+        case InstructionOpCodes::OR:    Result = IntegerValue( (int32_t)(UA | UB) );  return true;
+        case InstructionOpCodes::XOR:   Result = IntegerValue( (int32_t)(UA ^ UB) );  return true;
+        case InstructionOpCodes::IMIN:  Result = IntegerValue( min( A, B ) );         return true;
+        case InstructionOpCodes::IMAX:  Result = IntegerValue( max( A, B ) );         return true;
+        case InstructionOpCodes::IEQ:   Result = IntegerValue( A == B );              return true;
+        case InstructionOpCodes::INE:   Result = IntegerValue( A != B );              return true;
+        case InstructionOpCodes::IGT:   Result = IntegerValue( A >  B );              return true;
+        case InstructionOpCodes::IGE:   Result = IntegerValue( A >= B );              return true;
+        case InstructionOpCodes::ILT:   Result = IntegerValue( A <  B );              return true;
+        case InstructionOpCodes::ILE:   Result = IntegerValue( A <= B );              return true;
+        
+        // divisions that would cause errors are left to the CPU
+        case InstructionOpCodes::IDIV:
+        case InstructionOpCodes::IMOD:
+          if( B == 0 || (A == INT_MIN && B == -1) ) return false;
+          Result = IntegerValue( Line.OpCode == InstructionOpCodes::IDIV? A / B : A % B );
+          return true;
+        
+        // negative shifts go right
+        case InstructionOpCodes::SHL:
+          if( B > 31 || B < -31 ) return false;
+          Result = IntegerValue( (int32_t)(B > 0? (UA << B) : (UA >> -B)) );
+          return true;
+        
+        default:
+          return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::ProcessInstruction( int Position, ValueState& State, bool Rewrite )
+{
+    AssemblyLine& Line = Function->Lines[ Position ];
+    
+    if( !Line.IsInstruction() )
+      return;
+    
+    if( Rewrite )
+      SimplifySources( Line, State );
+    
+    int* Registers = State.RegisterValues;
+    int SP = (int)CPURegisters::StackPointer;
+    InstructionOpCodes OpCode = Line.OpCode;
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // data movements
+    if( OpCode == InstructionOpCodes::MOV )
+    {
+        AssemblyOperand Destination = Line.Operands[0];
+        AssemblyOperand Source = Line.Operands[1];
+        
+        // stores are not needed if memory already has that value
+        if( Destination.IsMemoryAddress )
+        {
+            pair< int, int32_t > Address = OperandAddress( State, Destination );
+            int Value = OperandValue( State, Source );
+            auto Known = State.MemoryValues.find( Address );
+            
+            if( Rewrite && Known != State.MemoryValues.end() && Known->second == Value )
+            {
+                RemoveLine( Position );
+                return;
+            }
+            
+            StoreToMemory( State, Address, Value );
+            return;
+        }
+        
+        int Target = Destination.Register;
+        int Value;
+        
+        // loads are replaced when memory contents are known
+        if( Source.IsMemoryAddress )
+        {
+            pair< int, int32_t > Address = OperandAddress( State, Source );
+            auto Known = State.MemoryValues.find( Address );
+            
+            if( Known == State.MemoryValues.end() )
+            {
+                Value = NewValue();
+                AssignRegister( State, Target, Value );
+                State.MemoryValues[ Address ] = Value;
+                return;
+            }
+            
+            Value = Known->second;
+            
+            if( Rewrite && Registers[ Target ] != Value )
+            {
+                int Holder = FindHolder( State, Value, false );
+                
+                if( Values[ Value ].IsConstant )
+                {
+                    Line.SetInstruction( InstructionOpCodes::MOV, { Destination, ValueToOperand( Value ) } );
+                    ChangesMade = true;
+                }
+                
+                else if( Holder >= 0 )
+                {
+                    Line.SetInstruction( InstructionOpCodes::MOV, { Destination, AssemblyOperand::FromRegister( Holder ) } );
+                    ChangesMade = true;
+                }
+            }
+        }
+        
+        else Value = OperandValue( State, Source );
+        
+        // assigning the same value again is not needed
+        if( Rewrite && Registers[ Target ] == Value )
+        {
+            RemoveLine( Position );
+            return;
+        }
+        
+        AssignRegister( State, Target, Value );
+        return;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // address calculations
+    if( OpCode == InstructionOpCodes::LEA )
+    {
+        pair< int, int32_t > Address = OperandAddress( State, Line.Operands[1] );
+        int Value = OffsetValue( Address.first, Address.second );
+        int Target = Line.Operands[0].Register;
+        
+        if( Rewrite && Registers[ Target ] == Value )
+        {
+            RemoveLine( Position );
+            return;
+        }
+        
+        if( Rewrite && Values[ Value ].IsConstant )
+        {
+            Line.SetInstruction( InstructionOpCodes::MOV, { Line.Operands[0], ValueToOperand( Value ) } );
+            ChangesMade = true;
+        }
+        
+        AssignRegister( State, Target, Value );
+        return;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // stack operations
+    if( OpCode == InstructionOpCodes::PUSH )
+    {
+        int Value = OperandValue( State, Line.Operands[0] );
+        OptimizerValue StackValue = Values[ Registers[ SP ] ];
+        int NewStackValue = OffsetValue( StackValue.Root, (int32_t)((uint32_t)StackValue.Offset - 1) );
+        
+        StoreToMemory( State, make_pair( StackValue.Root, Values[ NewStackValue ].Offset ), Value );
+        AssignRegister( State, SP, NewStackValue );
+        return;
+    }
+    
+    if( OpCode == InstructionOpCodes::POP )
+    {
+        OptimizerValue StackValue = Values[ Registers[ SP ] ];
+        pair< int, int32_t > Address = make_pair( StackValue.Root, StackValue.Offset );
+        int NewStackValue = OffsetValue( StackValue.Root, (int32_t)((uint32_t)StackValue.Offset + 1) );
+        
+        auto Known = State.MemoryValues.find( Address );
+        int Value = (Known != State.MemoryValues.end())? Known->second : NewValue();
+        State.MemoryValues[ Address ] = Value;
+        
+        AssignRegister( State, Line.Operands[0].Register, Value );
+        AssignRegister( State, SP, (Line.Operands[0].Register == SP)? NewValue() : NewStackValue );
+        return;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // calls: registers are not kept, except for BP and SP
+    if( OpCode == InstructionOpCodes::CALL )
+    {
+        for( int i = 0; i <= 13; i++ )
+          AssignRegister( State, i, NewValue() );
+        
+        ForgetMemoryOnCall( State );
+        return;
+    }
+    
+    // string operations use any memory
+    if( OpCode == InstructionOpCodes::MOVS || OpCode == InstructionOpCodes::SETS )
+      State.MemoryValues.clear();
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // conditional jumps on known conditions
+    if( Line.IsConditionalJump() )
+    {
+        OptimizerValue Condition = Values[ OperandValue( State, Line.Operands[0] ) ];
+        
+        if( Rewrite && Condition.IsConstant && Condition.IsInteger )
+        {
+            bool IsTaken = (Condition.IntegerValue != 0) == (OpCode == InstructionOpCodes::JT);
+            
+            if( IsTaken )
+            {
+                Line.SetInstruction( InstructionOpCodes::JMP, { Line.Operands[1] } );
+                ChangesMade = true;
+            }
+            
+            else RemoveLine( Position );
+        }
+        
+        return;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // operations: folding and common subexpressions
+    bool IsBinary = IsBinaryOperation( OpCode );
+    
+    if( IsBinary || IsUnaryOperation( OpCode ) )
+    {
+        int Target = Line.Operands[0].Register;
+        int Value1 = Registers[ Target ];
+        int Value2 = IsBinary? OperandValue( State, Line.Operands[1] ) : -1;
+        int Result;
+        
+        // BP and SP are only modified by folded operations
+        bool CanReplace = Rewrite && (Target <= 13);
+        
+        if( FoldOperation( Line, State, Value1, Value2, Result ) )
+        {
+            int Holder = FindHolder( State, Result, false );
+            
+            if( Rewrite && Registers[ Target ] == Result )
+            {
+                RemoveLine( Position );
+                return;
+            }
+            
+            if( CanReplace && Values[ Result ].IsConstant )
+            {
+                Line.SetInstruction( InstructionOpCodes::MOV, { Line.Operands[0], ValueToOperand( Result ) } );
+                ChangesMade = true;
+            }
+            
+            else if( CanReplace && Holder >= 0 )
+            {
+                Line.SetInstruction( InstructionOpCodes::MOV, { Line.Operands[0], AssemblyOperand::FromRegister( Holder ) } );
+                ChangesMade = true;
+            }
+            
+            AssignRegister( State, Target, Result );
+            return;
+        }
+        
+        // the same operation on the same values gives the same result
+        if( IsCommutative( OpCode ) && Value2 < Value1 )
+          swap( Value1, Value2 );
+        
+        auto Expression = make_tuple( (int)OpCode, Value1, Value2 );
+        auto Known = ExpressionValues.find( Expression );
+        
+        if( Known != ExpressionValues.end() )
+        {
+            Result = Known->second;
+            int Holder = FindHolder( State, Result, false );
+            
+            if( Rewrite && Registers[ Target ] == Result )
+            {
+                RemoveLine( Position );
+                return;
+            }
+            
+            if( CanReplace && Holder >= 0 )
+            {
+                Line.SetInstruction( InstructionOpCodes::MOV, { Line.Operands[0], AssemblyOperand::FromRegister( Holder ) } );
+                ChangesMade = true;
+            }
+        }
+        
+        else
+        {
+            Result = NewValue();
+            ExpressionValues[ Expression ] = Result;
+        }
+        
+        AssignRegister( State, Target, Result );
+        return;
+    }
+    
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // any other instruction: written registers get unknown values
+    uint32_t Written = Line.WrittenRegisters();
+    
+    for( int i = 0; i < 16; i++ )
+      if( Written & (1u << i) )
+        AssignRegister( State, i, NewValue() );
+}
+
+
+// =============================================================================
+//      VALUE NUMBERING: PASS
+// =============================================================================
+
+
+// Propagates copies and constants, and removes repeated operations,
+// memory accesses and redundant assignments. Within blocks it is
+// always done; across blocks, the state at the start of a block is
+// what all its predecessors agree on (loops start with no knowledge)
+void VirconCOptimizer::PropagateValues( bool AcrossBlocks )
+{
+    BuildBlocks();
+    AnalyzeStackFrame();
+    ResetValues();
+    
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< ValueState > FinalStates( Blocks.size() );
+    vector< bool > Processed( Blocks.size(), false );
+    
+    for( int BlockIndex: ReversePostorder() )
+    {
+        BasicBlock& Block = Blocks[ BlockIndex ];
+        ValueState State;
+        InitializeState( State, BlockIndex );
+        
+        // merge the states from all predecessors
+        bool CanMerge = AcrossBlocks && !Block.IsEntry && !Block.Predecessors.empty();
+        
+        for( int Predecessor: Block.Predecessors )
+          if( !Processed[ Predecessor ] )
+            CanMerge = false;
+            
+        if( CanMerge )
+        {
+            State = FinalStates[ Block.Predecessors[ 0 ] ];
+            
+            for( int Predecessor: Block.Predecessors )
+            {
+                ValueState& Other = FinalStates[ Predecessor ];
+                
+                for( int i = 0; i < 16; i++ )
+                  if( State.RegisterValues[ i ] != Other.RegisterValues[ i ] )
+                    AssignRegister( State, i, NewValue() );
+                    
+                for( auto Position = State.MemoryValues.begin(); Position != State.MemoryValues.end(); )
+                {
+                    auto OtherPosition = Other.MemoryValues.find( Position->first );
+                    
+                    if( OtherPosition == Other.MemoryValues.end() || OtherPosition->second != Position->second )
+                      Position = State.MemoryValues.erase( Position );
+                    else
+                      Position++;
+                }
+            }
+        }
+        
+        for( int i = Block.FirstLine; i < Block.EndLine; i++ )
+          ProcessInstruction( i, State, true );
+        
+        FinalStates[ BlockIndex ] = State;
+        Processed[ BlockIndex ] = true;
+    }
+    
+    CompactLines();
+}
@@ -0,0 +1,69 @@
+#include "video.h"
+
+// results are kept in memory to check them
+int[ 30 ] results;
+int count;
+
+void save( int value )
+{
+    results[ count ] = value;
+    count++;
+}
+
+// small functions are inlined
+int add3( int a, int b, int c )
+{
+    return a + b + c;
+}
+
+int square( int x )
+{
+    int y = x * x;
+    return y;
+}
+
+// larger functions only when declared as inline
+inline int clamp( int x, int min_x, int max_x )
+{
+    if( x < min_x ) return min_x;
+    if( x > max_x ) return max_x;
+    return x;
+}
+
+inline int sign( int x );
+
+int sign( int x )
+{
+    if( x < 0 ) return -1;
+    if( x > 0 ) return 1;
+    return 0;
+}
+
+// not inlined: calls other functions
+int sum_of_squares( int a, int b )
+{
+    return square( a ) + square( b );
+}
+
+void main( void )
+{
+    // port accesses from the headers
+    select_texture( -1 );
+    select_region( 'A' );
+    save( get_selected_texture() );
+    
+    // values kept in registers while
+    // the inlined bodies use their own
+    int total = 0;
+    
+    for( int i = -5; i <= 5; i++ )
+    {
+        int value = add3( i, total, 1 );
+        total += clamp( square( value ), 0, 50 ) * sign( value );
+        save( total );
+    }
+    
+    save( sum_of_squares( 3, 4 ) );
+    save( clamp( 100, -10, 10 ) + clamp( -100, -10, 10 ) + clamp( 7, -10, 10 ) );
+    save( sign( total ) + 10 * sign( -total ) + 100 * sign( 0 ) );
+}
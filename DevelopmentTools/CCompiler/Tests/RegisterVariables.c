@@ -0,0 +1,93 @@
+int[ 16 ] results;
+int[ 4 ] buffer;
+
+// uses several registers and does not preserve them
+void scramble( int* values, int count )
+{
+    for( int i = 0; i < count; i++ )
+      values[ i ] = values[ i ] * 3 + i;
+}
+
+int add_one( int x )
+{
+    return x + 1;
+}
+
+int sum_down( int n )
+{
+    if( n <= 0 ) return 0;
+    int here = n * 2;
+    int rest = sum_down( n - 1 );
+    return here + rest;
+}
+
+// registers saved within an asm block are still
+// expected by callers to keep their values
+int add_asm( int a, int b )
+{
+    int r;
+    int t = a * 3;
+    
+    asm
+    {
+        "push R0"
+        "mov R0, {t}"
+        "push R1"
+        "mov R1, {b}"
+        "iadd R0, R1"
+        "pop R1"
+        "mov {r}, R0"
+        "pop R0"
+    }
+    
+    return r + 1;
+}
+
+void main()
+{
+    int total = 0;
+    
+    // variables live across calls to functions
+    // that modify registers, and to returning ones
+    for( int i = 0; i < 10; i++ )
+    {
+        buffer[ 0 ] = i;
+        scramble( buffer, 1 );
+        total += buffer[ 0 ];
+        total = add_one( total );
+    }
+    
+    results[ 0 ] = total;
+    results[ 1 ] = sum_down( 12 );
+    
+    // calls through pointers may modify anything
+    int( int )* function = &add_one;
+    int counter = 0;
+    
+    for( int j = 0; j < 20; j++ )
+      counter = function( counter ) + j;
+    
+    results[ 2 ] = counter;
+    
+    // more variables than registers
+    int a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7;
+    int h = 8, k = 9, l = 10, m = 11, n = 12, o = 13, p = 14;
+    
+    for( int r = 0; r < 5; r++ )
+    {
+        a += b; b += c; c += d; d += e; e += f; f += g; g += h;
+        h += k; k += l; l += m; m += n; n += o; o += p; p += a;
+    }
+    
+    results[ 3 ] = a + b + c + d + e + f + g + h + k + l + m + n + o + p;
+    
+    for( int s = 0; s < 4; s++ )
+      results[ 4 + s ] = add_one( results[ s ] );
+    
+    int asm_total = 0;
+    
+    for( int t = 0; t < 5; t++ )
+      asm_total += add_asm( t, t );
+    
+    results[ 8 ] = asm_total;
+}
@@ -1,3 +1,64 @@
+// results are kept in memory to check them
+int[ 40 ] results;
+int count;
+
+void save( int value )
+{
+    results[ count ] = value;
+    count++;
+}
+
+// few cases: compared one by one
+int few_cases( int x )
+{
+    switch( x )
+    {
+        case 1: return 10;
+        case 7: return 70;
+        case -7: return -70;
+    }
+    
+    return 0;
+}
+
+// sparse values: binary search
+int sparse_cases( int x )
+{
+    int result = 0;
+    
+    switch( x )
+    {
+        case -50:   result = 1; break;
+        case 3:     result = 2; break;
+        case 100:   result = 3; break;
+        case 1000:  result = 4;
+        case 2000:  result = 5; break;
+        case 30000: result = 6; break;
+        default:    result = -1;
+    }
+    
+    return result;
+}
+
+// dense values: jump table
+int dense_cases( int x )
+{
+    int result = 100;
+    
+    switch( x )
+    {
+        case -3: result = 1; break;
+        case -1: result = 2; break;
+        case 0:  result = 3; break;
+        case 1:
+        case 2:  result = 4; break;
+        case 4:  result = 5;
+        case 5:  result += 6; break;
+        case 8:  result = 7; break;
+    }
+    
+    return result;
+}
 
 void main( void )
 {
@@ -16,4 +77,15 @@ void main( void )
         case -7:
         //default:
     }
+    
+    for( int i = -8; i <= 8; i++ )
+      save( few_cases( i ) + sparse_cases( i ) + dense_cases( i ) );
+    
+    save( sparse_cases( -50 ) );
+    save( sparse_cases( 1000 ) );
+    save( sparse_cases( 2000 ) );
+    save( sparse_cases( 30000 ) );
+    save( sparse_cases( 29999 ) );
+    save( dense_cases( 1000 ) );
+    save( dense_cases( -1000 ) );
 }
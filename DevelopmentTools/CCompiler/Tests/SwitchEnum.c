@@ -1,13 +1,37 @@
+enum Colors
+{
+    Red,
+    Green,
+    Blue,
+    Cyan,
+    Magenta,
+    Yellow,
+    White,
+    Black
+};
 
-void main( void )
+int[ 10 ] results;
+
+// every enum value is handled: jump table
+int brightness( Colors C )
 {
-    enum Colors
+    switch( C )
     {
-        Red,
-        Green,
-        Blue
-    };
+        case Black:   return 0;
+        case Red:
+        case Green:
+        case Blue:    return 1;
+        case Cyan:
+        case Magenta:
+        case Yellow:  return 2;
+        case White:   return 3;
+    }
     
+    return -1;
+}
+
+void main( void )
+{
     Colors R = Red;
     
     switch( R )
@@ -17,4 +41,7 @@ void main( void )
         case Blue:
         //default:
     }
+    
+    for( int i = 0; i < 10; i++ )
+      results[ i ] = brightness( (Colors)i );
 }
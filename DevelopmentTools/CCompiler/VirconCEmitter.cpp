@@ -347,6 +347,14 @@ void VirconCEmitter::EmitGlobalScopeFunction()
     int NeededStackSize = ProgramAST->StackSizeForFunctionCalls
                         + ProgramAST->StackSizeForTemporaries;
     
+    // keep track of where the function starts
+    EmittedFunction FunctionRange;
+    FunctionRange.Name = "__global_scope_initialization";
+    FunctionRange.FirstLine = ProgramLines.size();
+    FunctionRange.CallAreaSize = ProgramAST->StackSizeForFunctionCalls;
+    FunctionRange.IsInline = false;
+    FunctionRange.PreservesRegisters = false;
+    
     // (1) function call label
     EmitLabel( "__global_scope_initialization" );
     
@@ -370,6 +378,10 @@ void VirconCEmitter::EmitGlobalScopeFunction()
     // (6) return to caller
     ProgramLines.push_back( "ret" );
     ProgramLines.push_back( "" );
+    
+    // register the full function range
+    FunctionRange.EndLine = ProgramLines.size();
+    EmittedFunctions.push_back( FunctionRange );
 }
 
 // -----------------------------------------------------------------------------
@@ -614,6 +626,7 @@ void VirconCEmitter::Emit( TopLevelNode& ProgramAST_, bool IsBios )
     
     // delete any previous results
     ProgramLines.clear();
+    EmittedFunctions.clear();
     
     // if this is a BIOS program, we need to emit a very
     // specific initial structure for handling hardware errors
@@ -9,6 +9,38 @@
 // *****************************************************************************
 
 
+// =============================================================================
+//      LINES EMITTED FOR EACH FUNCTION
+// =============================================================================
+
+
+// lets later stages process each function separately
+class EmittedFunction
+{
+    public:
+        
+        std::string Name;
+        
+        // range of program lines (the end is not included)
+        int FirstLine;
+        int EndLine;
+        
+        // stack space reserved for arguments of called functions
+        int CallAreaSize;
+        
+        // the function was declared as inline
+        bool IsInline;
+        
+        // callers expect registers R1 and up to keep their
+        // values (true for functions that return a value)
+        bool PreservesRegisters;
+        
+        // jump tables used by the function, as the list
+        // of target labels (one per entry) for each table
+        std::map< std::string, std::vector< std::string > > JumpTables;
+};
+
+
 // =============================================================================
 //      VIRCON C EMITTER
 // =============================================================================
@@ -30,6 +62,14 @@ class VirconCEmitter
         // debug info: C->ASM line correspondence
         std::map< int, CNode* > LineMapping;
         
+        // position of the lines for each function
+        std::vector< EmittedFunction > EmittedFunctions;
+        
+    protected:
+        
+        // jump tables for the function being emitted
+        std::map< std::string, std::vector< std::string > > FunctionJumpTables;
+        
     public:
         
         // called when emitting ASM to keep track of
@@ -70,6 +110,11 @@ class VirconCEmitter
         int EmitBlock              ( BlockNode* Block );
         int EmitAssemblyBlock      ( AssemblyBlockNode* AssemblyBlock );
         
+        // ways to find the case to run in a switch
+        void EmitSwitchCaseChain   ( SwitchNode* Switch, const std::vector< int >& Values, int First, int End, const std::string& NoMatchLabel );
+        void EmitSwitchBinarySearch( SwitchNode* Switch, const std::vector< int >& Values, int First, int End, const std::string& NoMatchLabel );
+        void EmitSwitchJumpTable   ( SwitchNode* Switch, const std::vector< int >& Values, const std::string& NoMatchLabel );
+        
         // emit functions for specific expressions
         // (sizeof is not needed: it is always static)
         void EmitExpressionAtom     ( ExpressionAtomNode* ExpressionAtom          , RegisterAllocation& Registers, int ResultRegister );
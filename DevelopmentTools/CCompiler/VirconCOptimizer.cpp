@@ -0,0 +1,732 @@
+// *****************************************************************************
+    // include infrastructure headers
+    #include "../DevToolsInfrastructure/StringFunctions.hpp"
+    
+    // include project headers
+    #include "VirconCOptimizer.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      LIVE SET
+// =============================================================================
+
+
+LiveSet::LiveSet()
+{
+    Registers = 0;
+    AllSlots = false;
+}
+
+// -----------------------------------------------------------------------------
+
+void LiveSet::Add( const LiveSet& Other )
+{
+    Registers |= Other.Registers;
+    AllSlots |= Other.AllSlots;
+    Slots.insert( Other.Slots.begin(), Other.Slots.end() );
+}
+
+// -----------------------------------------------------------------------------
+
+bool LiveSet::operator==( const LiveSet& Other ) const
+{
+    return (Registers == Other.Registers)
+        && (AllSlots == Other.AllSlots)
+        && (Slots == Other.Slots);
+}
+
+
+// =============================================================================
+//      OPTIMIZED FUNCTION
+// =============================================================================
+
+
+int OptimizedFunction::CountInstructions() const
+{
+    int Count = 0;
+    
+    for( const AssemblyLine& Line: Lines )
+      if( Line.IsInstruction() )
+        Count++;
+        
+    return Count;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: INSTANCE HANDLING
+// =============================================================================
+
+
+VirconCOptimizer::VirconCOptimizer()
+{
+    Emitter = nullptr;
+    Function = nullptr;
+    OptimizationLevel = 0;
+    FrameRoot = -1;
+    Clock = 0;
+    ChangesMade = false;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: LOWERING AND WRITING BACK
+// =============================================================================
+
+
+// integer names are resolved so that they can be
+// identified with the numbers they stand for
+void VirconCOptimizer::ReadDefinitions()
+{
+    Definitions.clear();
+    RedefinedNames.clear();
+    
+    for( const string& Line: Emitter->ProgramLines )
+    {
+        vector< string > Words = SplitString( Line, ' ' );
+        Words.erase( remove( Words.begin(), Words.end(), "" ), Words.end() );
+        
+        if( Words.size() != 3 || Words[0] != "%define" )
+          continue;
+        
+        // names defined more than once are never resolved
+        if( Definitions.count( Words[1] ) || RedefinedNames.count( Words[1] ) )
+        {
+            Definitions.erase( Words[1] );
+            RedefinedNames.insert( Words[1] );
+            continue;
+        }
+        
+        int32_t Value;
+        
+        if( ParseIntegerValue( Words[2], Value ) )
+          Definitions[ Words[1] ] = Value;
+        else
+          RedefinedNames.insert( Words[1] );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+bool VirconCOptimizer::LowerFunction( const EmittedFunction& Range, OptimizedFunction& Lowered )
+{
+    Lowered.Name = Range.Name;
+    Lowered.EntryLabel = "";
+    Lowered.CallAreaSize = Range.CallAreaSize;
+    Lowered.JumpTables = Range.JumpTables;
+    Lowered.Lines.clear();
+    Lowered.LineOrigins.clear();
+    Lowered.RemovedLines.clear();
+    Lowered.IsOptimized = false;
+    Lowered.VariablesInRegisters = 0;
+    Lowered.InlinedCalls = 0;
+    Lowered.RegistersSavedInSlots = 0;
+    
+    bool AllLinesUnderstood = true;
+    
+    for( int i = Range.FirstLine; i < Range.EndLine; i++ )
+    {
+        AssemblyLine Line = AssemblyLine::FromText( Emitter->ProgramLines[ i ] );
+        
+        // the first label is the one used to call the function
+        if( Line.IsLabel() && Lowered.EntryLabel.empty() )
+          Lowered.EntryLabel = Line.LabelName;
+        
+        // data or directives within the code, or instructions
+        // not fully understood, cannot be analyzed safely
+        if( Line.Type == AssemblyLineTypes::Other && !Line.IsComment() )
+          AllLinesUnderstood = false;
+        
+        Lowered.Lines.push_back( Line );
+        Lowered.LineOrigins.push_back( i );
+        Lowered.RemovedLines.push_back( false );
+    }
+    
+    Lowered.InstructionsBefore = Lowered.CountInstructions();
+    Lowered.InstructionsAfter = Lowered.InstructionsBefore;
+    
+    if( Lowered.EntryLabel.empty() )
+      return false;
+    
+    return AllLinesUnderstood;
+}
+
+// -----------------------------------------------------------------------------
+
+// builds the new program lines from the optimized functions,
+// then relocates the debug info to the lines that remain
+void VirconCOptimizer::WriteBackProgram()
+{
+    vector< string > NewLines;
+    vector< int > NewOrigins;
+    int OldLine = 0;
+    
+    for( OptimizedFunction& Processed: Functions )
+    {
+        if( Processed.LineOrigins.empty() )
+          continue;
+        
+        // lines before the function are copied as they are
+        int FunctionStart = Processed.LineOrigins[ 0 ];
+        
+        for( ; OldLine < FunctionStart; OldLine++ )
+        {
+            NewLines.push_back( Emitter->ProgramLines[ OldLine ] );
+            NewOrigins.push_back( OldLine );
+        }
+        
+        // lines within the function come from its lowered form
+        int FunctionEnd = Processed.LineOrigins.back() + 1;
+        
+        for( unsigned i = 0; i < Processed.Lines.size(); i++ )
+        {
+            NewLines.push_back( Processed.Lines[ i ].ToString() );
+            NewOrigins.push_back( Processed.LineOrigins[ i ] );
+        }
+        
+        OldLine = max( OldLine, FunctionEnd );
+    }
+    
+    // copy any lines after the last function
+    for( ; OldLine < (int)Emitter->ProgramLines.size(); OldLine++ )
+    {
+        NewLines.push_back( Emitter->ProgramLines[ OldLine ] );
+        NewOrigins.push_back( OldLine );
+    }
+    
+    ReplaceProgramLines( NewLines, NewOrigins );
+}
+
+// -----------------------------------------------------------------------------
+
+// the new lines come with the position each of them had
+// in the emitter's program, so that debug info is kept
+void VirconCOptimizer::ReplaceProgramLines( const vector< string >& NewLines, const vector< int >& NewOrigins )
+{
+    // each removed line is mapped to the next remaining one
+    // (line numbers in the mapping are offset by 2)
+    map< int, CNode* > NewMapping;
+    
+    for( auto& MapPair: Emitter->LineMapping )
+    {
+        int OldPosition = MapPair.first - 2;
+        int NewPosition = lower_bound( NewOrigins.begin(), NewOrigins.end(), OldPosition ) - NewOrigins.begin();
+        NewMapping[ NewPosition + 2 ] = MapPair.second;
+    }
+    
+    Emitter->ProgramLines = NewLines;
+    Emitter->LineMapping = NewMapping;
+}
+
+// -----------------------------------------------------------------------------
+
+// the peephole optimizer works on the whole program,
+// since it does not need to know about functions
+void VirconCOptimizer::ApplyPeepholeRules()
+{
+    vector< AssemblyLine > ProgramLines;
+    
+    for( const string& Line: Emitter->ProgramLines )
+      ProgramLines.push_back( AssemblyLine::FromText( Line ) );
+    
+    Peephole.IsCompilerOutput = true;
+    Peephole.Optimize( ProgramLines );
+    
+    // now discard the removed lines
+    vector< string > NewLines;
+    vector< int > NewOrigins;
+    
+    for( unsigned i = 0; i < ProgramLines.size(); i++ )
+    {
+        if( Peephole.RemovedLines[ i ] )
+          continue;
+        
+        NewLines.push_back( ProgramLines[ i ].ToString() );
+        NewOrigins.push_back( i );
+    }
+    
+    ReplaceProgramLines( NewLines, NewOrigins );
+}
+
+// -----------------------------------------------------------------------------
+
+// lines are only marked for removal here, so that
+// positions stay valid until the pass is completed;
+// meanwhile they are left as empty lines
+void VirconCOptimizer::RemoveLine( int Position )
+{
+    if( Function->RemovedLines[ Position ] )
+      return;
+    
+    Function->Lines[ Position ] = AssemblyLine();
+    Function->RemovedLines[ Position ] = true;
+    ChangesMade = true;
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::CompactLines()
+{
+    vector< AssemblyLine > NewLines;
+    vector< int > NewOrigins;
+    
+    for( unsigned i = 0; i < Function->Lines.size(); i++ )
+    {
+        if( Function->RemovedLines[ i ] )
+          continue;
+        
+        NewLines.push_back( Function->Lines[ i ] );
+        NewOrigins.push_back( Function->LineOrigins[ i ] );
+    }
+    
+    Function->Lines = NewLines;
+    Function->LineOrigins = NewOrigins;
+    Function->RemovedLines.assign( NewLines.size(), false );
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: CONTROL FLOW GRAPH
+// =============================================================================
+
+
+// references to labels are split into jumps within the function,
+// and any others (calls, addresses, data, or other functions)
+void VirconCOptimizer::CountReferences( map< string, int >& JumpReferences, map< string, int >& OtherReferences )
+{
+    JumpReferences.clear();
+    OtherReferences = LabelReferences;
+    
+    // references from outside the function
+    for( auto& LabelPair: OriginalFunctionReferences )
+      OtherReferences[ LabelPair.first ] -= LabelPair.second;
+    
+    // references from the function itself
+    for( const AssemblyLine& Line: Function->Lines )
+    {
+        if( !Line.IsInstruction() )
+          continue;
+        
+        if( Line.IsJump() )
+        {
+            string Target = Line.JumpTarget();
+            
+            if( !Target.empty() )
+              JumpReferences[ Target ]++;
+            
+            continue;
+        }
+        
+        for( const AssemblyOperand& Operand: Line.Operands )
+          if( !Operand.IsRegister )
+            OtherReferences[ Operand.Value ]++;
+    }
+    
+    // entries in the function's jump tables are
+    // only reached through its indirect jumps
+    for( auto& TablePair: Function->JumpTables )
+      for( const string& Target: TablePair.second )
+      {
+          OtherReferences[ Target ]--;
+          JumpReferences[ Target ]++;
+      }
+}
+
+// -----------------------------------------------------------------------------
+
+// position of the first instruction placed after a label,
+// skipping other labels and comments (-1 if there is none)
+int VirconCOptimizer::InstructionAfterLabel( const string& LabelName )
+{
+    auto Block = Function->LabelBlocks.find( LabelName );
+    
+    if( Block == Function->LabelBlocks.end() )
+      return -1;
+    
+    for( int i = Function->Blocks[ Block->second ].FirstLine; i < (int)Function->Lines.size(); i++ )
+      if( Function->Lines[ i ].IsInstruction() )
+        return i;
+        
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+// indirect jumps through a jump table get the address
+// from the table within the same block ("" if none)
+string VirconCOptimizer::JumpTableUsed( const BasicBlock& Block )
+{
+    for( int i = Block.EndLine - 1; i >= Block.FirstLine; i-- )
+    {
+        const AssemblyLine& Line = Function->Lines[ i ];
+        
+        if( !Line.IsInstruction() )
+          continue;
+        
+        for( const AssemblyOperand& Operand: Line.Operands )
+          if( !Operand.IsRegister && Function->JumpTables.count( Operand.Value ) )
+            return Operand.Value;
+    }
+    
+    return "";
+}
+
+// -----------------------------------------------------------------------------
+
+bool VirconCOptimizer::IsJumpTableTarget( const string& LabelName )
+{
+    for( auto& TablePair: Function->JumpTables )
+      for( const string& Target: TablePair.second )
+        if( Target == LabelName )
+          return true;
+        
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::BuildBlocks()
+{
+    vector< AssemblyLine >& Lines = Function->Lines;
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    Blocks.clear();
+    Function->LabelBlocks.clear();
+    
+    // blocks start at labels and after any jumps
+    bool StartNewBlock = true;
+    
+    for( int i = 0; i < (int)Lines.size(); i++ )
+    {
+        if( Lines[ i ].IsLabel() )
+          StartNewBlock = true;
+        
+        if( StartNewBlock )
+        {
+            BasicBlock NewBlock;
+            NewBlock.FirstLine = i;
+            NewBlock.EndLine = i;
+            NewBlock.IsEntry = false;
+            NewBlock.Returns = false;
+            NewBlock.LeavesFunction = false;
+            Blocks.push_back( NewBlock );
+            StartNewBlock = false;
+        }
+        
+        Blocks.back().EndLine = i + 1;
+        
+        if( Lines[ i ].IsLabel() )
+          Function->LabelBlocks[ Lines[ i ].LabelName ] = Blocks.size() - 1;
+        
+        if( Lines[ i ].IsJump() || Lines[ i ].EndsControlFlow() )
+          StartNewBlock = true;
+    }
+    
+    // now connect the blocks
+    for( int b = 0; b < (int)Blocks.size(); b++ )
+    {
+        BasicBlock& Block = Blocks[ b ];
+        
+        // find the last instruction
+        int Last = Block.EndLine - 1;
+        
+        while( Last >= Block.FirstLine && !Lines[ Last ].IsInstruction() )
+          Last--;
+        
+        bool FallsThrough = true;
+        
+        if( Last >= Block.FirstLine )
+        {
+            const AssemblyLine& Line = Lines[ Last ];
+            
+            if( Line.IsInstruction( InstructionOpCodes::RET ) || Line.IsInstruction( InstructionOpCodes::HLT ) )
+            {
+                Block.Returns = true;
+                FallsThrough = false;
+            }
+            
+            else if( Line.IsJump() )
+            {
+                string Target = Line.JumpTarget();
+                auto TargetBlock = Function->LabelBlocks.find( Target );
+                string JumpTable = (Target.empty()? JumpTableUsed( Block ) : "");
+                
+                if( TargetBlock != Function->LabelBlocks.end() )
+                  Block.Successors.push_back( TargetBlock->second );
+                
+                // an indirect jump through a table can
+                // go to any of the labels in the table
+                else if( !JumpTable.empty() )
+                {
+                    set< int > TableBlocks;
+                    
+                    for( const string& TableTarget: Function->JumpTables[ JumpTable ] )
+                    {
+                        auto TableBlock = Function->LabelBlocks.find( TableTarget );
+                        
+                        if( TableBlock == Function->LabelBlocks.end() )
+                          Block.LeavesFunction = true;
+                        else
+                          TableBlocks.insert( TableBlock->second );
+                    }
+                    
+                    Block.Successors.insert( Block.Successors.end(), TableBlocks.begin(), TableBlocks.end() );
+                }
+                
+                else
+                  Block.LeavesFunction = true;
+                
+                FallsThrough = Line.IsConditionalJump();
+            }
+        }
+        
+        if( FallsThrough )
+        {
+            if( b + 1 < (int)Blocks.size() )
+              Block.Successors.push_back( b + 1 );
+            else
+              Block.LeavesFunction = true;
+        }
+        
+        for( int Successor: Block.Successors )
+          Blocks[ Successor ].Predecessors.push_back( b );
+    }
+    
+    // determine which blocks can be reached from outside
+    if( !Blocks.empty() )
+      Blocks[ 0 ].IsEntry = true;
+    
+    map< string, int > JumpReferences, OtherReferences;
+    CountReferences( JumpReferences, OtherReferences );
+    
+    for( auto& LabelPair: Function->LabelBlocks )
+      if( OtherReferences[ LabelPair.first ] > 0 )
+        Blocks[ LabelPair.second ].IsEntry = true;
+}
+
+// -----------------------------------------------------------------------------
+
+// only blocks reachable from an entry are included
+vector< int > VirconCOptimizer::ReversePostorder()
+{
+    vector< BasicBlock >& Blocks = Function->Blocks;
+    vector< bool > Visited( Blocks.size(), false );
+    vector< int > Postorder;
+    
+    for( int Entry = 0; Entry < (int)Blocks.size(); Entry++ )
+    {
+        if( !Blocks[ Entry ].IsEntry || Visited[ Entry ] )
+          continue;
+        
+        // iterative depth-first search
+        vector< pair< int, unsigned > > Stack;
+        Stack.push_back( make_pair( Entry, 0u ) );
+        Visited[ Entry ] = true;
+        
+        while( !Stack.empty() )
+        {
+            int Current = Stack.back().first;
+            unsigned& NextSuccessor = Stack.back().second;
+            
+            if( NextSuccessor < Blocks[ Current ].Successors.size() )
+            {
+                int Successor = Blocks[ Current ].Successors[ NextSuccessor++ ];
+                
+                if( !Visited[ Successor ] )
+                {
+                    Visited[ Successor ] = true;
+                    Stack.push_back( make_pair( Successor, 0u ) );
+                }
+            }
+            
+            else
+            {
+                Postorder.push_back( Current );
+                Stack.pop_back();
+            }
+        }
+    }
+    
+    reverse( Postorder.begin(), Postorder.end() );
+    return Postorder;
+}
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER: MAIN FUNCTIONS
+// =============================================================================
+
+
+void VirconCOptimizer::OptimizeFunction()
+{
+    // each level repeats the passes more times, since
+    // every pass creates new chances for the others
+    int MaximumRounds = 1;
+    if( OptimizationLevel == 2 ) MaximumRounds = 2;
+    if( OptimizationLevel >= 3 ) MaximumRounds = 8;
+    
+    for( int Round = 1; Round <= MaximumRounds; Round++ )
+    {
+        ChangesMade = false;
+        
+        CleanControlFlow();
+        PropagateValues( OptimizationLevel >= 2 );
+        RemoveDeadCode();
+        CleanControlFlow();
+        
+        if( !ChangesMade )
+          break;
+    }
+    
+    // from -O2 variables are kept in registers; the
+    // code is then cleaned up from the added copies
+    if( OptimizationLevel < 2 || !AllocateRegisters() )
+      return;
+    
+    for( int Round = 1; Round <= MaximumRounds; Round++ )
+    {
+        ChangesMade = false;
+        
+        PropagateValues( true );
+        CoalesceCopies();
+        RemoveDeadCode();
+        CleanControlFlow();
+        
+        if( !ChangesMade )
+          break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::ProcessFunction( const EmittedFunction& Range, OptimizedFunction& Lowered )
+{
+    if( !LowerFunction( Range, Lowered ) )
+      return;
+    
+    // the function's own references are counted apart,
+    // since they will change during the optimization
+    vector< string > OriginalLines( Emitter->ProgramLines.begin() + Range.FirstLine, Emitter->ProgramLines.begin() + Range.EndLine );
+    OriginalFunctionReferences.clear();
+    CollectReferencedLabels( OriginalLines, OriginalFunctionReferences );
+    
+    Function = &Lowered;
+    
+    // inlined bodies are then optimized as part of the function
+    if( OptimizationLevel >= 2 )
+      InlineCalls();
+    
+    OptimizeFunction();
+    
+    Lowered.IsOptimized = true;
+    Lowered.InstructionsAfter = Lowered.CountInstructions();
+    
+    // update references with the optimized version
+    vector< string > NewLines;
+    
+    for( const AssemblyLine& Line: Lowered.Lines )
+      NewLines.push_back( Line.ToString() );
+    
+    map< string, int > NewFunctionReferences;
+    CollectReferencedLabels( NewLines, NewFunctionReferences );
+    
+    for( auto& LabelPair: OriginalFunctionReferences )
+      LabelReferences[ LabelPair.first ] -= LabelPair.second;
+    
+    for( auto& LabelPair: NewFunctionReferences )
+      LabelReferences[ LabelPair.first ] += LabelPair.second;
+    
+    if( OptimizationLevel >= 2 )
+      FindInlinableBody( Range );
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::Optimize( VirconCEmitter& Emitter_, int OptimizationLevel_ )
+{
+    Emitter = &Emitter_;
+    OptimizationLevel = OptimizationLevel_;
+    Functions.clear();
+    
+    // gather information from the whole program
+    ReadDefinitions();
+    ComputeClobberedRegisters();
+    LabelReferences.clear();
+    CollectReferencedLabels( Emitter->ProgramLines, LabelReferences );
+    CollectReferencedLabels( Emitter->DataLines, LabelReferences );
+    
+    // process every function separately; the ones that
+    // call no other functions go first, so that from -O2
+    // they can be inlined when processing the rest
+    Functions.assign( Emitter->EmittedFunctions.size(), OptimizedFunction() );
+    InlinableFunctions.clear();
+    InlinedBodies = 0;
+        
+    for( int Pass = 1; Pass <= 2; Pass++ )
+      for( unsigned f = 0; f < Functions.size(); f++ )
+      {
+          const EmittedFunction& Range = Emitter->EmittedFunctions[ f ];
+          bool CallsFunctions = false;
+        
+          for( int i = Range.FirstLine; i < Range.EndLine && !CallsFunctions; i++ )
+            CallsFunctions = AssemblyLine::FromText( Emitter->ProgramLines[ i ] ).IsInstruction( InstructionOpCodes::CALL );
+        
+          if( CallsFunctions == (Pass == 2) )
+            ProcessFunction( Range, Functions[ f ] );
+      }
+    
+    Function = nullptr;
+    WriteBackProgram();
+    
+    // finally clean up what is left
+    // between and around instructions
+    ApplyPeepholeRules();
+}
+
+// -----------------------------------------------------------------------------
+
+void VirconCOptimizer::PrintReport()
+{
+    cout << "optimization report (-O" << OptimizationLevel << "): instructions per function" << endl;
+    cout << "  " << left << setw( 40 ) << "function" << right << setw( 8 ) << "before" << setw( 8 ) << "after" << setw( 8 ) << "change" << endl;
+    
+    int TotalBefore = 0, TotalAfter = 0;
+    
+    for( const OptimizedFunction& Processed: Functions )
+    {
+        TotalBefore += Processed.InstructionsBefore;
+        TotalAfter += Processed.InstructionsAfter;
+        
+        cout << "  " << left << setw( 40 ) << Processed.Name << right << setw( 8 ) << Processed.InstructionsBefore << setw( 8 ) << Processed.InstructionsAfter;
+        
+        if( !Processed.IsOptimized )
+          cout << "  (not optimized: contains data or directives)" << endl;
+        
+        else if( Processed.InstructionsBefore > 0 )
+        {
+            int Change = (100 * (Processed.InstructionsAfter - Processed.InstructionsBefore)) / Processed.InstructionsBefore;
+            cout << setw( 7 ) << Change << "%";
+            
+            if( Processed.VariablesInRegisters > 0 )
+              cout << "  (" << Processed.VariablesInRegisters << " variables in registers)";
+            
+            if( Processed.InlinedCalls > 0 )
+              cout << "  (" << Processed.InlinedCalls << " calls inlined)";
+            
+            cout << endl;
+        }
+        
+        else cout << endl;
+    }
+    
+    cout << "  " << left << setw( 40 ) << "total" << right << setw( 8 ) << TotalBefore << setw( 8 ) << TotalAfter << endl;
+}
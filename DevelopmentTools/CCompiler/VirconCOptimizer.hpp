@@ -0,0 +1,338 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef VIRCONCOPTIMIZER_HPP
+    #define VIRCONCOPTIMIZER_HPP
+    
+    // include infrastructure headers
+    #include "../DevToolsInfrastructure/AssemblyLines.hpp"
+    #include "../DevToolsInfrastructure/PeepholeOptimizer.hpp"
+    
+    // include project headers
+    #include "VirconCEmitter.hpp"
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <map>              // [ C++ STL ] Maps
+    #include <set>              // [ C++ STL ] Sets
+    #include <tuple>            // [ C++ STL ] Tuples
+// *****************************************************************************
+
+
+// =============================================================================
+//      OPTIMIZER DATA STRUCTURES
+// =============================================================================
+
+
+// a sequence of lines that always runs from its
+// start, and can only jump away at its end
+class BasicBlock
+{
+    public:
+        
+        // range of lines (the end is not included)
+        int FirstLine;
+        int EndLine;
+        
+        // control flow within the function
+        std::vector< int > Successors;
+        std::vector< int > Predecessors;
+        
+        // can be reached from outside the function
+        // (function label, or labels used elsewhere)
+        bool IsEntry;
+        
+        // how control leaves the function from here
+        bool Returns;           // ret or hlt
+        bool LeavesFunction;    // any other exit
+};
+
+// -----------------------------------------------------------------------------
+
+// Values are identified by numbers. Integers and addresses
+// are tracked as a root value plus an offset, so that related
+// values (BP, BP-3, BP-3+1...) can be identified as such
+class OptimizerValue
+{
+    public:
+        
+        // constants keep their text to write them as immediates
+        bool IsConstant;
+        bool IsInteger;
+        int32_t IntegerValue;
+        std::string Text;
+        
+        // for values not derived from any other, Root
+        // is the value itself and Offset is zero
+        int Root;
+        int32_t Offset;
+};
+
+// -----------------------------------------------------------------------------
+
+// what is known at a point of the program during value numbering
+class ValueState
+{
+    public:
+        
+        // value contained in each register, and when it
+        // was assigned (older copies are preferred)
+        int RegisterValues[ 16 ];
+        int RegisterAges[ 16 ];
+        
+        // memory words with known contents,
+        // indexed by address as (root, offset)
+        std::map< std::pair< int, int32_t >, int > MemoryValues;
+};
+
+// -----------------------------------------------------------------------------
+
+// liveness information for dead code elimination
+class LiveSet
+{
+    public:
+        
+        uint32_t Registers;
+        
+        // local variables in the stack frame, by their offset
+        // from the function's entry SP; when AllSlots is set
+        // every slot has to be considered live
+        std::set< int32_t > Slots;
+        bool AllSlots;
+        
+        LiveSet();
+        void Add( const LiveSet& Other );
+        bool operator==( const LiveSet& Other ) const;
+};
+
+// -----------------------------------------------------------------------------
+
+// the body of a small function, that can replace calls to it
+class InlinedBody
+{
+    public:
+        
+        // lines between the prologue and the epilogue; they
+        // access arguments as in the function, through BP
+        std::vector< AssemblyLine > Lines;
+        
+        // registers R1 to R13 used in the body
+        uint32_t UsedRegisters;
+};
+
+// -----------------------------------------------------------------------------
+
+// the lowered form of a function, as processed by the optimizer
+class OptimizedFunction
+{
+    public:
+        
+        std::string Name;
+        std::string EntryLabel;
+        int CallAreaSize;       // negative if unknown
+        
+        // structured version of the function's lines, along
+        // with the position each of them had in the emitter
+        std::vector< AssemblyLine > Lines;
+        std::vector< int > LineOrigins;
+        std::vector< bool > RemovedLines;
+        
+        // control flow graph
+        std::vector< BasicBlock > Blocks;
+        std::map< std::string, int > LabelBlocks;
+        
+        // target labels for each jump table used by
+        // the function (tables are in the data lines)
+        std::map< std::string, std::vector< std::string > > JumpTables;
+        
+        // the function keeps BP and SP fixed in its body,
+        // so stack frame positions can be known everywhere
+        bool HasStandardFrame;
+        int32_t FramePointerOffset;     // BP relative to entry SP
+        int32_t BodyStackOffset;        // SP relative to entry SP
+        int BodyFirstLine;              // first line after the prologue
+        uint32_t PushedRegisters;       // saved by the prologue
+        
+        // addresses within the stack frame are used in ways
+        // that cannot be tracked (pointers to local variables)
+        bool FrameEscapes;
+        
+        // for each line, the stack frame slot it accesses
+        // and the value of SP at that point, when known
+        std::vector< bool > AccessesSlot;
+        std::vector< int32_t > AccessedSlots;
+        std::vector< bool > KnowsStackOffset;
+        std::vector< int32_t > StackOffsets;
+        
+        // registers given to variables that had to be saved
+        // in the variable's stack slot to preserve the caller's
+        uint32_t RegistersSavedInSlots;
+        
+        // statistics for the optimization report
+        bool IsOptimized;
+        int InstructionsBefore;
+        int InstructionsAfter;
+        int VariablesInRegisters;
+        int InlinedCalls;
+        
+    public:
+        
+        int CountInstructions() const;
+};
+
+
+// =============================================================================
+//      VIRCON C OPTIMIZER
+// =============================================================================
+
+
+// The emitter produces assembly text straight from the AST, so
+// the optimizer works on the emitted lines: each function is
+// lowered to a list of structured instructions with a control
+// flow graph, the passes are applied to it, and the result is
+// written back into the emitter's lines. Any function containing
+// lines that can't be fully understood is left untouched
+class VirconCOptimizer
+{
+    protected:
+        
+        // link to the processed program
+        VirconCEmitter* Emitter;
+        int OptimizationLevel;
+        
+        // names assigned to integers with %define
+        std::map< std::string, int32_t > Definitions;
+        std::set< std::string > RedefinedNames;
+        
+        // registers that each function may modify, for its
+        // callers (indexed by the label used to call it)
+        std::map< std::string, uint32_t > ClobberedRegisters;
+        
+        // of those, the ones each function is allowed to
+        // modify, so it can use them without saving them
+        std::map< std::string, uint32_t > ModifiableRegisters;
+        
+        // bodies of the functions that can be inlined
+        // (indexed by the label used to call them)
+        std::map< std::string, InlinedBody > InlinableFunctions;
+        int InlinedBodies;      // makes inlined labels unique
+        
+        // references to each label from the whole program,
+        // and the ones made by the original processed function
+        std::map< std::string, int > LabelReferences;
+        std::map< std::string, int > OriginalFunctionReferences;
+        
+        // the function being processed
+        OptimizedFunction* Function;
+        
+        // table of values for value numbering
+        std::vector< OptimizerValue > Values;
+        std::map< std::pair< int, int32_t >, int > OffsetValues;
+        std::map< std::string, int > TextValues;
+        std::map< std::tuple< int, int, int >, int > ExpressionValues;
+        int FrameRoot;
+        int Clock;
+        
+        // tracks changes done by the passes
+        bool ChangesMade;
+        
+    public:
+        
+        // results
+        std::vector< OptimizedFunction > Functions;
+        PeepholeOptimizer Peephole;
+        
+    protected:
+        
+        // lowering the emitted lines to structured form and back
+        void ReadDefinitions();
+        bool LowerFunction( const EmittedFunction& Range, OptimizedFunction& Lowered );
+        void ProcessFunction( const EmittedFunction& Range, OptimizedFunction& Lowered );
+        void WriteBackProgram();
+        void ReplaceProgramLines( const std::vector< std::string >& NewLines, const std::vector< int >& NewOrigins );
+        void RemoveLine( int Position );
+        void CompactLines();
+        
+        // control flow graph
+        void BuildBlocks();
+        std::vector< int > ReversePostorder();
+        void CountReferences( std::map< std::string, int >& JumpReferences, std::map< std::string, int >& OtherReferences );
+        int InstructionAfterLabel( const std::string& LabelName );
+        std::string JumpTableUsed( const BasicBlock& Block );
+        bool IsJumpTableTarget( const std::string& LabelName );
+        
+        // optimization passes
+        void OptimizeFunction();
+        void ApplyPeepholeRules();
+        void PropagateValues( bool AcrossBlocks );
+        void RemoveDeadCode();
+        void CleanControlFlow();
+        void ThreadJumps();
+        void RemoveRedundantJumps();
+        void RemoveUnreachableCode();
+        void RemoveUnusedLabels();
+        
+        // value table handling
+        void ResetValues();
+        int NewValue();
+        int OffsetValue( int Root, int32_t Offset );
+        int ConstantValue( const std::string& Text );
+        int IntegerValue( int32_t Number );
+        bool IsFrameValue( int Value );
+        
+        // value numbering on instructions
+        void InitializeState( ValueState& State, int BlockIndex );
+        void AssignRegister( ValueState& State, int Register, int Value );
+        int FindHolder( const ValueState& State, int Value, bool AllowStackRegisters );
+        std::pair< int, int32_t > OperandAddress( const ValueState& State, const AssemblyOperand& Operand );
+        int OperandValue( const ValueState& State, const AssemblyOperand& Operand );
+        AssemblyOperand ValueToOperand( int Value );
+        bool MayAlias( std::pair< int, int32_t > Address1, std::pair< int, int32_t > Address2 );
+        void StoreToMemory( ValueState& State, std::pair< int, int32_t > Address, int Value );
+        void ForgetMemoryOnCall( ValueState& State );
+        void SimplifySources( AssemblyLine& Line, const ValueState& State );
+        void SimplifyAddress( AssemblyLine& Line, unsigned Position, const ValueState& State );
+        bool FoldOperation( AssemblyLine& Line, ValueState& State, int Value1, int Value2, int& Result );
+        void ProcessInstruction( int Position, ValueState& State, bool Rewrite );
+        
+        // analysis of the stack frame
+        void AnalyzeStackFrame();
+        bool CheckStandardFrame();
+        
+        // liveness analysis
+        void UpdateLiveness( int Position, LiveSet& Live, bool TrackSlots );
+        void ComputeLiveness( std::vector< LiveSet >& LiveAtBlockEnd, bool TrackSlots );
+        bool IsDeadInstruction( int Position, const LiveSet& Live, bool TrackSlots );
+        
+        // register allocation for variables
+        void ComputeClobberedRegisters();
+        uint32_t CallClobbers( const AssemblyLine& Line );
+        uint32_t FunctionModifiableRegisters();
+        void EstimateLineWeights( std::vector< int >& LineWeights );
+        void ComputeRegisterLiveness( std::vector< uint32_t >& LiveBefore, std::vector< uint32_t >& LiveAfter );
+        void ComputeSlotLiveness( int32_t Slot, std::vector< bool >& LiveBefore, std::vector< bool >& LiveAfter );
+        bool AllocateRegisters();
+        bool AllocateVariable( int32_t Slot );
+        bool CoalesceCopy( int Position, const std::vector< uint32_t >& LiveAfter );
+        void CoalesceCopies();
+        
+        // function inlining
+        void FindInlinableBody( const EmittedFunction& Range );
+        bool InlineBody( const InlinedBody& Body, uint32_t AvailableRegisters, std::vector< AssemblyLine >& InlinedLines );
+        void InlineCalls();
+        
+    public:
+        
+        // instance handling
+        VirconCOptimizer();
+        
+        // main optimization function
+        void Optimize( VirconCEmitter& Emitter_, int OptimizationLevel_ );
+        void PrintReport();
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
@@ -137,6 +137,9 @@ CNode* VirconCParser::ParseStatement( CNode* Parent, CTokenIterator& TokenPositi
     if( TokenIsThisKeyword( NextToken, KeywordTypes::Extern ) )
       RaiseFatalError( NextToken->Location, "extern variables can only be declared at the top level" );
     
+    if( TokenIsThisKeyword( NextToken, KeywordTypes::Inline ) )
+      RaiseFatalError( NextToken->Location, "functions cannot be declared inside other functions" );
+    
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     // now choose from all valid cases
     
@@ -1158,6 +1161,28 @@ VariableListNode* VirconCParser::ParseExternVariableList( CNode* Parent, CTokenI
 
 // -----------------------------------------------------------------------------
 
+FunctionNode* VirconCParser::ParseInlineFunction( CNode* Parent, CTokenIterator& TokenPosition )
+{
+    // consume "inline" keyword
+    CToken* InlineToken = *TokenPosition;
+    TokenPosition++;
+    
+    // only functions can be inlined
+    if( !IsValidStartOfType( *TokenPosition, Parent ) )
+      RaiseFatalError( (*TokenPosition)->Location, "expected a function declaration after \"inline\"" );
+    
+    CNode* Declaration = ParseDeclaration( Parent, TokenPosition, true );
+    
+    if( Declaration->Type() != CNodeTypes::Function )
+      RaiseFatalError( InlineToken->Location, "only functions can be declared as inline" );
+    
+    FunctionNode* NewFunction = (FunctionNode*)Declaration;
+    NewFunction->IsInline = true;
+    return NewFunction;
+}
+
+// -----------------------------------------------------------------------------
+
 InitializationListNode* VirconCParser::ParseInitializationList( CNode* Parent, CTokenIterator& TokenPosition )
 {
     // consume open brace
@@ -2224,6 +2249,14 @@ void VirconCParser::ParseTopLevel( CTokenList& Tokens_ )
             continue;
         }
         
+        // recognize inline functions
+        if( TokenIsThisKeyword( NextToken, KeywordTypes::Inline ) )
+        {
+            FunctionNode* NewFunction = ParseInlineFunction( ProgramAST, TokenPosition );
+            ProgramAST->Statements.push_back( NewFunction );
+            continue;
+        }
+        
         // recognize type declarations
         if( TokenIsThisKeyword( NextToken, KeywordTypes::Struct ))
         {
@@ -65,6 +65,7 @@ class VirconCParser
         FunctionNode* ParseFunction( DataType* ReturnType, const std::string& Name, CNode* Parent, CTokenIterator& TokenPosition );
         VariableListNode* ParseVariableList( DataType* DeclaredType, const std::string& Name, bool UsesExtern, CNode* Parent, CTokenIterator& TokenPosition );
         VariableListNode* ParseExternVariableList( CNode* Parent, CTokenIterator& TokenPosition );
+        FunctionNode* ParseInlineFunction( CNode* Parent, CTokenIterator& TokenPosition );
         InitializationListNode* ParseInitializationList( CNode* Parent, CTokenIterator& TokenPosition );
         MemberNode* ParseMember( UnionNode* OwnerUnion, CTokenIterator& TokenPosition );
         MemberListNode* ParseMemberList( StructureNode* OwnerStructure, CTokenIterator& TokenPosition );
@@ -0,0 +1,912 @@
+// *****************************************************************************
+    // include project headers
+    #include "AssemblyLines.hpp"
+    #include "EnumStringConversions.hpp"
+    #include "StringFunctions.hpp"
+    
+    // include C/C++ headers
+    #include <cctype>       // [ ANSI C ] Character classification
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY TEXT FUNCTIONS
+// =============================================================================
+
+
+static string TrimSpaces( const string& Text )
+{
+    size_t First = Text.find_first_not_of( " \t\r\n" );
+    
+    if( First == string::npos )
+      return "";
+    
+    size_t Last = Text.find_last_not_of( " \t\r\n" );
+    return Text.substr( First, Last - First + 1 );
+}
+
+// -----------------------------------------------------------------------------
+
+static bool IsIdentifier( const string& Text )
+{
+    if( Text.empty() )
+      return false;
+    
+    if( !isalpha( (unsigned char)Text[0] ) && Text[0] != '_' )
+      return false;
+    
+    for( char c: Text )
+      if( !isalnum( (unsigned char)c ) && c != '_' )
+        return false;
+        
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// removes a comment at the end of the line, if any
+// (semicolons inside quotes do not start a comment)
+static string RemoveComment( const string& Text )
+{
+    char OpenQuote = 0;
+    
+    for( size_t i = 0; i < Text.size(); i++ )
+    {
+        char c = Text[ i ];
+        
+        if( OpenQuote )
+        {
+            if( c == '\\' ) i++;
+            else if( c == OpenQuote ) OpenQuote = 0;
+        }
+        
+        else if( c == '"' || c == '\'' )
+          OpenQuote = c;
+        
+        else if( c == ';' )
+          return Text.substr( 0, i );
+    }
+    
+    return Text;
+}
+
+// -----------------------------------------------------------------------------
+
+// number of operands taken by each instruction
+static int OperandCount( InstructionOpCodes OpCode )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::HLT:
+        case InstructionOpCodes::WAIT:
+        case InstructionOpCodes::RET:
+        case InstructionOpCodes::MOVS:
+        case InstructionOpCodes::SETS:
+          return 0;
+        
+        case InstructionOpCodes::JMP:
+        case InstructionOpCodes::CALL:
+        case InstructionOpCodes::PUSH:
+        case InstructionOpCodes::POP:
+        case InstructionOpCodes::CMPS:
+          return 1;
+        
+        default:
+          return IsUnaryOperation( OpCode )? 1 : 2;
+    }
+}
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS FOR INSTRUCTIONS
+// =============================================================================
+
+
+// instructions that can take an immediate value
+// as their last operand instead of a register
+bool AcceptsImmediateSource( InstructionOpCodes OpCode )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::JMP:
+        case InstructionOpCodes::CALL:
+        case InstructionOpCodes::JT:
+        case InstructionOpCodes::JF:
+        case InstructionOpCodes::MOV:
+        case InstructionOpCodes::OUT:
+          return true;
+        
+        // these 2 only work with registers
+        case InstructionOpCodes::ATAN2:
+        case InstructionOpCodes::POW:
+          return false;
+        
+        default:
+          return IsBinaryOperation( OpCode );
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// operations in the form "OP Rx, Ry/Imm" (Rx = Rx OP Ry)
+bool IsBinaryOperation( InstructionOpCodes OpCode )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::IEQ:
+        case InstructionOpCodes::INE:
+        case InstructionOpCodes::IGT:
+        case InstructionOpCodes::IGE:
+        case InstructionOpCodes::ILT:
+        case InstructionOpCodes::ILE:
+        case InstructionOpCodes::FEQ:
+        case InstructionOpCodes::FNE:
+        case InstructionOpCodes::FGT:
+        case InstructionOpCodes::FGE:
+        case InstructionOpCodes::FLT:
+        case InstructionOpCodes::FLE:
+        case InstructionOpCodes::AND:
+        case InstructionOpCodes::OR:
+        case InstructionOpCodes::XOR:
+        case InstructionOpCodes::SHL:
+        case InstructionOpCodes::IADD:
+        case InstructionOpCodes::ISUB:
+        case InstructionOpCodes::IMUL:
+        case InstructionOpCodes::IDIV:
+        case InstructionOpCodes::IMOD:
+        case InstructionOpCodes::IMIN:
+        case InstructionOpCodes::IMAX:
+        case InstructionOpCodes::FADD:
+        case InstructionOpCodes::FSUB:
+        case InstructionOpCodes::FMUL:
+        case InstructionOpCodes::FDIV:
+        case InstructionOpCodes::FMOD:
+        case InstructionOpCodes::FMIN:
+        case InstructionOpCodes::FMAX:
+        case InstructionOpCodes::ATAN2:
+        case InstructionOpCodes::POW:
+          return true;
+        
+        default:
+          return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// operations in the form "OP Rx" (Rx = OP Rx)
+bool IsUnaryOperation( InstructionOpCodes OpCode )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::CIF:
+        case InstructionOpCodes::CFI:
+        case InstructionOpCodes::CIB:
+        case InstructionOpCodes::CFB:
+        case InstructionOpCodes::NOT:
+        case InstructionOpCodes::BNOT:
+        case InstructionOpCodes::ISGN:
+        case InstructionOpCodes::IABS:
+        case InstructionOpCodes::FSGN:
+        case InstructionOpCodes::FABS:
+        case InstructionOpCodes::FLR:
+        case InstructionOpCodes::CEIL:
+        case InstructionOpCodes::ROUND:
+        case InstructionOpCodes::SIN:
+        case InstructionOpCodes::ACOS:
+        case InstructionOpCodes::LOG:
+          return true;
+        
+        default:
+          return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+bool ParseIntegerValue( const string& Text, int32_t& Value )
+{
+    if( Text.empty() )
+      return false;
+    
+    // an optional sign is allowed before the number
+    size_t Position = 0;
+    bool Negative = false;
+    
+    if( Text[0] == '-' || Text[0] == '+' )
+    {
+        Negative = (Text[0] == '-');
+        Position = 1;
+    }
+    
+    if( Position >= Text.size() )
+      return false;
+    
+    // hexadecimal numbers
+    uint64_t Result = 0;
+    
+    if( Text.size() > Position+2 && Text[Position] == '0' && tolower( Text[Position+1] ) == 'x' )
+    {
+        for( size_t i = Position+2; i < Text.size(); i++ )
+        {
+            if( !isxdigit( (unsigned char)Text[i] ) )
+              return false;
+            
+            Result = Result * 16 + (isdigit( (unsigned char)Text[i] )? (Text[i] - '0') : (tolower( Text[i] ) - 'a' + 10));
+            
+            if( Result > 0xFFFFFFFFu )
+              return false;
+        }
+    }
+    
+    // decimal numbers
+    else
+    {
+        for( size_t i = Position; i < Text.size(); i++ )
+        {
+            if( !isdigit( (unsigned char)Text[i] ) )
+              return false;
+            
+            Result = Result * 10 + (Text[i] - '0');
+            
+            if( Result > 0xFFFFFFFFu )
+              return false;
+        }
+    }
+    
+    // numbers are 32-bit words
+    uint32_t Word = (uint32_t)Result;
+    if( Negative ) Word = 0u - Word;
+    
+    Value = (int32_t)Word;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ParseIntegerValue( const string& Text, const map< string, int32_t >& Definitions, int32_t& Value )
+{
+    if( ParseIntegerValue( Text, Value ) )
+      return true;
+    
+    auto Definition = Definitions.find( Text );
+    
+    if( Definition == Definitions.end() )
+      return false;
+    
+    Value = Definition->second;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+string IntegerValueToString( int32_t Value )
+{
+    // INT_MIN can only be written in hex notation
+    if( Value == INT32_MIN )
+      return "0x80000000";
+    
+    return to_string( Value );
+}
+
+// -----------------------------------------------------------------------------
+
+void CollectReferencedLabels( const vector< string >& Lines, map< string, int >& ReferenceCounts )
+{
+    for( const string& LineText: Lines )
+    {
+        AssemblyLine Line = AssemblyLine::FromText( LineText );
+        
+        // for instructions, check the operands
+        if( Line.Type == AssemblyLineTypes::Instruction )
+        {
+            for( const AssemblyOperand& Operand: Line.Operands )
+              if( !Operand.IsRegister && IsIdentifier( Operand.Value ) )
+                ReferenceCounts[ Operand.Value ]++;
+                
+            continue;
+        }
+        
+        if( Line.Type == AssemblyLineTypes::Label )
+          continue;
+        
+        // in any other line (data, directives, unparsed
+        // instructions) count any identifiers outside quotes
+        string Word;
+        char OpenQuote = 0;
+        string Text = RemoveComment( Line.Text ) + " ";
+        
+        for( size_t i = 0; i < Text.size(); i++ )
+        {
+            char c = Text[ i ];
+            
+            if( OpenQuote )
+            {
+                if( c == '\\' ) i++;
+                else if( c == OpenQuote ) OpenQuote = 0;
+                continue;
+            }
+            
+            if( isalnum( (unsigned char)c ) || c == '_' )
+            {
+                Word += c;
+                continue;
+            }
+            
+            if( IsIdentifier( Word ) )
+              ReferenceCounts[ Word ]++;
+            
+            Word.clear();
+            
+            if( c == '"' || c == '\'' )
+              OpenQuote = c;
+        }
+    }
+}
+
+
+// =============================================================================
+//      CLASS: ASSEMBLY OPERAND
+// =============================================================================
+
+
+AssemblyOperand::AssemblyOperand()
+{
+    IsMemoryAddress = false;
+    IsRegister = false;
+    Register = 0;
+    Offset = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyOperand AssemblyOperand::FromRegister( int Register )
+{
+    AssemblyOperand Operand;
+    Operand.IsRegister = true;
+    Operand.Register = Register;
+    return Operand;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyOperand AssemblyOperand::FromValue( const string& Value )
+{
+    AssemblyOperand Operand;
+    Operand.Value = Value;
+    return Operand;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyOperand AssemblyOperand::FromAddress( int Register, int32_t Offset )
+{
+    AssemblyOperand Operand;
+    Operand.IsMemoryAddress = true;
+    Operand.IsRegister = true;
+    Operand.Register = Register;
+    Operand.Offset = Offset;
+    return Operand;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyOperand AssemblyOperand::FromAddress( const string& Value )
+{
+    AssemblyOperand Operand;
+    Operand.IsMemoryAddress = true;
+    Operand.Value = Value;
+    return Operand;
+}
+
+// -----------------------------------------------------------------------------
+
+string AssemblyOperand::ToString() const
+{
+    string Base = IsRegister? RegisterToString( (CPURegisters)Register ) : Value;
+    
+    if( !IsMemoryAddress )
+      return Base;
+    
+    if( Offset > 0 ) return "[" + Base + "+" + to_string( Offset ) + "]";
+    if( Offset < 0 ) return "[" + Base + "-" + to_string( -(int64_t)Offset ) + "]";
+    return "[" + Base + "]";
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyOperand::operator==( const AssemblyOperand& Other ) const
+{
+    if( IsMemoryAddress != Other.IsMemoryAddress ) return false;
+    if( IsRegister != Other.IsRegister ) return false;
+    
+    if( IsRegister )
+      return (Register == Other.Register) && (Offset == Other.Offset);
+    
+    return (Value == Other.Value);
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyOperand::operator!=( const AssemblyOperand& Other ) const
+{
+    return !(*this == Other);
+}
+
+
+// =============================================================================
+//      CLASS: ASSEMBLY LINE
+// =============================================================================
+
+
+AssemblyLine::AssemblyLine()
+{
+    Type = AssemblyLineTypes::Other;
+    Modified = false;
+    OpCode = InstructionOpCodes::HLT;
+}
+
+// -----------------------------------------------------------------------------
+
+// parses a single operand; returns false if not understood
+static bool ParseOperand( const string& Text, AssemblyOperand& Operand )
+{
+    string Base = Text;
+    Operand = AssemblyOperand();
+    
+    // memory addresses
+    if( !Text.empty() && Text[0] == '[' )
+    {
+        if( Text.back() != ']' )
+          return false;
+        
+        Operand.IsMemoryAddress = true;
+        Base = TrimSpaces( Text.substr( 1, Text.size()-2 ) );
+        
+        // detect an offset, only valid after a register
+        size_t SignPosition = Base.find_first_of( "+-", 1 );
+        
+        if( SignPosition != string::npos )
+        {
+            string RegisterName = TrimSpaces( Base.substr( 0, SignPosition ) );
+            string OffsetText = TrimSpaces( Base.substr( SignPosition+1 ) );
+            
+            if( !IsRegisterName( RegisterName ) )
+              return false;
+            
+            int32_t OffsetValue;
+            
+            if( !ParseIntegerValue( OffsetText, OffsetValue ) )
+              return false;
+            
+            Operand.IsRegister = true;
+            Operand.Register = (int)StringToRegister( RegisterName );
+            Operand.Offset = (Base[ SignPosition ] == '-'? -OffsetValue : OffsetValue);
+            return true;
+        }
+    }
+    
+    if( Base.empty() )
+      return false;
+    
+    // registers
+    if( IsRegisterName( Base ) )
+    {
+        Operand.IsRegister = true;
+        Operand.Register = (int)StringToRegister( Base );
+        return true;
+    }
+    
+    // any other values are kept as text,
+    // as long as they are a single word
+    for( char c: Base )
+      if( isspace( (unsigned char)c ) || c == '[' || c == ']' || c == ',' )
+        return false;
+        
+    Operand.Value = Base;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyLine AssemblyLine::FromText( const string& LineText )
+{
+    AssemblyLine Line;
+    Line.Text = LineText;
+    
+    string Content = TrimSpaces( RemoveComment( LineText ) );
+    
+    // empty lines, comments and directives
+    if( Content.empty() || Content[0] == '%' )
+      return Line;
+    
+    // labels
+    if( Content.back() == ':' )
+    {
+        string Name = TrimSpaces( Content.substr( 0, Content.size()-1 ) );
+        
+        if( IsIdentifier( Name ) )
+        {
+            Line.Type = AssemblyLineTypes::Label;
+            Line.LabelName = Name;
+        }
+        
+        return Line;
+    }
+    
+    // instructions: first separate the opcode
+    size_t OpCodeEnd = Content.find_first_of( " \t" );
+    string OpCodeName = Content.substr( 0, OpCodeEnd );
+    
+    if( !IsOpCodeName( OpCodeName ) )
+      return Line;
+    
+    InstructionOpCodes OpCode = StringToOpCode( OpCodeName );
+    vector< AssemblyOperand > Operands;
+    
+    // then read all operands
+    if( OpCodeEnd != string::npos )
+    {
+        string OperandsText = TrimSpaces( Content.substr( OpCodeEnd ) );
+        vector< string > OperandTexts = SplitString( OperandsText, ',' );
+        
+        for( const string& OperandText: OperandTexts )
+        {
+            AssemblyOperand Operand;
+            
+            if( !ParseOperand( TrimSpaces( OperandText ), Operand ) )
+              return Line;
+            
+            Operands.push_back( Operand );
+        }
+    }
+    
+    // discard anything with an unexpected form
+    if( (int)Operands.size() != OperandCount( OpCode ) )
+      return Line;
+    
+    Line.Type = AssemblyLineTypes::Instruction;
+    Line.OpCode = OpCode;
+    Line.Operands = Operands;
+    return Line;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyLine AssemblyLine::FromInstruction( InstructionOpCodes OpCode, const vector< AssemblyOperand >& Operands )
+{
+    AssemblyLine Line;
+    Line.SetInstruction( OpCode, Operands );
+    return Line;
+}
+
+// -----------------------------------------------------------------------------
+
+AssemblyLine AssemblyLine::FromLabel( const string& LabelName )
+{
+    AssemblyLine Line;
+    Line.Type = AssemblyLineTypes::Label;
+    Line.LabelName = LabelName;
+    Line.Text = LabelName + ":";
+    return Line;
+}
+
+// -----------------------------------------------------------------------------
+
+string AssemblyLine::ToString() const
+{
+    if( Type != AssemblyLineTypes::Instruction || !Modified )
+      return Text;
+    
+    string Result = ToLowerCase( OpCodeToString( OpCode ) );
+    
+    for( unsigned i = 0; i < Operands.size(); i++ )
+      Result += (i == 0? " " : ", ") + Operands[ i ].ToString();
+    
+    return Result;
+}
+
+// -----------------------------------------------------------------------------
+
+void AssemblyLine::SetInstruction( InstructionOpCodes NewOpCode, const vector< AssemblyOperand >& NewOperands )
+{
+    Type = AssemblyLineTypes::Instruction;
+    OpCode = NewOpCode;
+    Operands = NewOperands;
+    Modified = true;
+}
+
+// -----------------------------------------------------------------------------
+
+void AssemblyLine::SetOperand( unsigned Position, const AssemblyOperand& NewOperand )
+{
+    Operands[ Position ] = NewOperand;
+    Modified = true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::IsInstruction() const
+{
+    return (Type == AssemblyLineTypes::Instruction);
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::IsInstruction( InstructionOpCodes Which ) const
+{
+    return (Type == AssemblyLineTypes::Instruction) && (OpCode == Which);
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::IsLabel() const
+{
+    return (Type == AssemblyLineTypes::Label);
+}
+
+// -----------------------------------------------------------------------------
+
+// empty lines are included here too
+bool AssemblyLine::IsComment() const
+{
+    if( Type != AssemblyLineTypes::Other )
+      return false;
+    
+    string Content = TrimSpaces( Text );
+    return Content.empty() || Content[0] == ';';
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::IsJump() const
+{
+    return IsInstruction( InstructionOpCodes::JMP ) || IsConditionalJump();
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::IsConditionalJump() const
+{
+    return IsInstruction( InstructionOpCodes::JT ) || IsInstruction( InstructionOpCodes::JF );
+}
+
+// -----------------------------------------------------------------------------
+
+// execution never continues to the next line
+bool AssemblyLine::EndsControlFlow() const
+{
+    return IsInstruction( InstructionOpCodes::JMP )
+        || IsInstruction( InstructionOpCodes::RET )
+        || IsInstruction( InstructionOpCodes::HLT );
+}
+
+// -----------------------------------------------------------------------------
+
+string AssemblyLine::JumpTarget() const
+{
+    if( !IsJump() )
+      return "";
+    
+    const AssemblyOperand& Target = Operands.back();
+    
+    if( Target.IsRegister || Target.IsMemoryAddress )
+      return "";
+    
+    return Target.Value;
+}
+
+// -----------------------------------------------------------------------------
+
+// registers used within an operand (registers
+// themselves, or the base of a memory address)
+static uint32_t OperandRegisters( const AssemblyOperand& Operand )
+{
+    if( Operand.IsRegister )
+      return (1u << Operand.Register);
+    
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t AssemblyLine::ReadRegisters() const
+{
+    if( Type != AssemblyLineTypes::Instruction )
+      return 0;
+    
+    const uint32_t StringRegisters = (1u << 11) | (1u << 12) | (1u << 13);
+    const uint32_t StackPointer = (1u << 15);
+    
+    switch( OpCode )
+    {
+        case InstructionOpCodes::HLT:
+        case InstructionOpCodes::WAIT:
+        case InstructionOpCodes::IN:
+          return 0;
+        
+        case InstructionOpCodes::MOV:
+        {
+            // for register destinations, only the source is read
+            if( !Operands[0].IsMemoryAddress )
+              return OperandRegisters( Operands[1] );
+            
+            return OperandRegisters( Operands[0] ) | OperandRegisters( Operands[1] );
+        }
+        
+        case InstructionOpCodes::LEA:
+          return OperandRegisters( Operands[1] );
+        
+        case InstructionOpCodes::PUSH:
+          return OperandRegisters( Operands[0] ) | StackPointer;
+        
+        case InstructionOpCodes::POP:
+        case InstructionOpCodes::RET:
+          return StackPointer;
+        
+        case InstructionOpCodes::CALL:
+        case InstructionOpCodes::JMP:
+          return OperandRegisters( Operands[0] ) | (OpCode == InstructionOpCodes::CALL? StackPointer : 0);
+        
+        case InstructionOpCodes::OUT:
+          return OperandRegisters( Operands[1] );
+        
+        case InstructionOpCodes::MOVS:
+        case InstructionOpCodes::SETS:
+        case InstructionOpCodes::CMPS:
+          return StringRegisters;
+        
+        default:
+        {
+            // jumps, binary and unary operations
+            uint32_t Result = 0;
+            
+            for( const AssemblyOperand& Operand: Operands )
+              Result |= OperandRegisters( Operand );
+            
+            return Result;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t AssemblyLine::WrittenRegisters() const
+{
+    if( Type != AssemblyLineTypes::Instruction )
+      return 0;
+    
+    const uint32_t StringRegisters = (1u << 11) | (1u << 12) | (1u << 13);
+    const uint32_t StackPointer = (1u << 15);
+    
+    switch( OpCode )
+    {
+        case InstructionOpCodes::MOV:
+          return Operands[0].IsMemoryAddress? 0 : (1u << Operands[0].Register);
+        
+        case InstructionOpCodes::LEA:
+        case InstructionOpCodes::IN:
+          return (1u << Operands[0].Register);
+        
+        case InstructionOpCodes::PUSH:
+        case InstructionOpCodes::RET:
+          return StackPointer;
+        
+        case InstructionOpCodes::POP:
+          return (1u << Operands[0].Register) | StackPointer;
+        
+        // by calling convention, results are returned in R0
+        case InstructionOpCodes::CALL:
+          return 1;
+        
+        case InstructionOpCodes::MOVS:
+        case InstructionOpCodes::SETS:
+          return StringRegisters;
+        
+        case InstructionOpCodes::CMPS:
+          return StringRegisters | (1u << Operands[0].Register);
+        
+        default:
+          if( IsBinaryOperation( OpCode ) || IsUnaryOperation( OpCode ) )
+            return (1u << Operands[0].Register);
+            
+          return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::ReadsMemoryOperand() const
+{
+    return IsInstruction( InstructionOpCodes::MOV ) && Operands[1].IsMemoryAddress;
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::WritesMemoryOperand() const
+{
+    return IsInstruction( InstructionOpCodes::MOV ) && Operands[0].IsMemoryAddress;
+}
+
+// -----------------------------------------------------------------------------
+
+int AssemblyLine::MemoryOperandPosition() const
+{
+    if( ReadsMemoryOperand() ) return 1;
+    if( WritesMemoryOperand() ) return 0;
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+bool AssemblyLine::HasSideEffects() const
+{
+    if( Type != AssemblyLineTypes::Instruction )
+      return true;
+    
+    // changing the stack is always an effect
+    const uint32_t StackRegisters = (1u << 14) | (1u << 15);
+    
+    if( WrittenRegisters() & StackRegisters )
+      return true;
+    
+    switch( OpCode )
+    {
+        // memory reads can cause errors
+        case InstructionOpCodes::MOV:
+          return Operands[0].IsMemoryAddress || Operands[1].IsMemoryAddress;
+        
+        case InstructionOpCodes::LEA:
+        case InstructionOpCodes::CIF:
+        case InstructionOpCodes::CFI:
+        case InstructionOpCodes::CIB:
+        case InstructionOpCodes::CFB:
+        case InstructionOpCodes::NOT:
+        case InstructionOpCodes::AND:
+        case InstructionOpCodes::OR:
+        case InstructionOpCodes::XOR:
+        case InstructionOpCodes::BNOT:
+        case InstructionOpCodes::SHL:
+        case InstructionOpCodes::IADD:
+        case InstructionOpCodes::ISUB:
+        case InstructionOpCodes::IMUL:
+        case InstructionOpCodes::ISGN:
+        case InstructionOpCodes::IMIN:
+        case InstructionOpCodes::IMAX:
+        case InstructionOpCodes::IABS:
+        case InstructionOpCodes::FADD:
+        case InstructionOpCodes::FSUB:
+        case InstructionOpCodes::FMUL:
+        case InstructionOpCodes::FSGN:
+        case InstructionOpCodes::FMIN:
+        case InstructionOpCodes::FMAX:
+        case InstructionOpCodes::FABS:
+        case InstructionOpCodes::FLR:
+        case InstructionOpCodes::CEIL:
+        case InstructionOpCodes::ROUND:
+        case InstructionOpCodes::SIN:
+        case InstructionOpCodes::IEQ:
+        case InstructionOpCodes::INE:
+        case InstructionOpCodes::IGT:
+        case InstructionOpCodes::IGE:
+        case InstructionOpCodes::ILT:
+        case InstructionOpCodes::ILE:
+        case InstructionOpCodes::FEQ:
+        case InstructionOpCodes::FNE:
+        case InstructionOpCodes::FGT:
+        case InstructionOpCodes::FGE:
+        case InstructionOpCodes::FLT:
+        case InstructionOpCodes::FLE:
+          return false;
+        
+        // divisions, ACOS, ATAN2, LOG and POW can cause
+        // hardware errors; anything else acts on the
+        // ports, memory or control flow
+        default:
+          return true;
+    }
+}
@@ -0,0 +1,154 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef ASSEMBLYLINES_HPP
+    #define ASSEMBLYLINES_HPP
+    
+    // include common Vircon headers
+    #include "../../VirconDefinitions/Enumerations.hpp"
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <map>              // [ C++ STL ] Maps
+    #include <cstdint>          // [ ANSI C ] Standard integer types
+// *****************************************************************************
+
+
+// =============================================================================
+//      STRUCTURED REPRESENTATION OF ASSEMBLY LINES
+// =============================================================================
+
+
+// These classes give a structured view of the text lines
+// of a Vircon32 assembly program, so that tools can analyze
+// and rewrite instructions without their own parser.
+// Only lines that are fully understood are classified as
+// instructions or labels; anything else is kept as text.
+enum class AssemblyLineTypes
+{
+    Instruction,
+    Label,
+    Other       // comments, empty lines, directives, data
+};
+
+// -----------------------------------------------------------------------------
+
+class AssemblyOperand
+{
+    public:
+        
+        bool IsMemoryAddress;
+        
+        // the base is either a register or a value
+        // (number, label, port name...) kept as text
+        bool IsRegister;
+        int Register;
+        std::string Value;
+        
+        // memory offsets only exist as [register +/- integer]
+        int32_t Offset;
+        
+    public:
+        
+        // instance handling
+        AssemblyOperand();
+        static AssemblyOperand FromRegister( int Register );
+        static AssemblyOperand FromValue( const std::string& Value );
+        static AssemblyOperand FromAddress( int Register, int32_t Offset );
+        static AssemblyOperand FromAddress( const std::string& Value );
+        
+        // conversion to text
+        std::string ToString() const;
+        
+        // comparison
+        bool operator==( const AssemblyOperand& Other ) const;
+        bool operator!=( const AssemblyOperand& Other ) const;
+};
+
+// -----------------------------------------------------------------------------
+
+class AssemblyLine
+{
+    public:
+        
+        AssemblyLineTypes Type;
+        
+        // original text; it is written back unchanged unless
+        // the line is modified (this keeps comments and case)
+        std::string Text;
+        bool Modified;
+        
+        // for labels
+        std::string LabelName;
+        
+        // for instructions
+        V32::InstructionOpCodes OpCode;
+        std::vector< AssemblyOperand > Operands;
+        
+    public:
+        
+        // instance handling
+        AssemblyLine();
+        static AssemblyLine FromText( const std::string& LineText );
+        static AssemblyLine FromInstruction( V32::InstructionOpCodes OpCode, const std::vector< AssemblyOperand >& Operands );
+        static AssemblyLine FromLabel( const std::string& LabelName );
+        
+        // conversion to text
+        std::string ToString() const;
+        
+        // to edit instructions in place
+        void SetInstruction( V32::InstructionOpCodes NewOpCode, const std::vector< AssemblyOperand >& NewOperands );
+        void SetOperand( unsigned Position, const AssemblyOperand& NewOperand );
+        
+        // classification of instructions
+        bool IsInstruction() const;
+        bool IsInstruction( V32::InstructionOpCodes Which ) const;
+        bool IsLabel() const;
+        bool IsComment() const;
+        bool IsJump() const;
+        bool IsConditionalJump() const;
+        bool EndsControlFlow() const;
+        
+        // label used as the jump target, if any
+        std::string JumpTarget() const;
+        
+        // Register sets are bit masks (bit N = register RN).
+        // Implicit uses of CR, SR and DR in string instructions
+        // and of SP in stack instructions are included
+        uint32_t ReadRegisters() const;
+        uint32_t WrittenRegisters() const;
+        
+        // memory accesses through a memory operand (not
+        // counting stack or string instructions)
+        bool ReadsMemoryOperand() const;
+        bool WritesMemoryOperand() const;
+        int MemoryOperandPosition() const;
+        
+        // true when removing the instruction could change anything
+        // other than its written registers (ports, memory, control
+        // flow, stack, or possible hardware errors)
+        bool HasSideEffects() const;
+};
+
+// -----------------------------------------------------------------------------
+
+// auxiliary functions for instructions
+bool AcceptsImmediateSource( V32::InstructionOpCodes OpCode );
+bool IsBinaryOperation( V32::InstructionOpCodes OpCode );
+bool IsUnaryOperation( V32::InstructionOpCodes OpCode );
+
+// numeric immediates: decimal and hexadecimal integers,
+// or names assigned to integers by %define directives
+bool ParseIntegerValue( const std::string& Text, int32_t& Value );
+bool ParseIntegerValue( const std::string& Text, const std::map< std::string, int32_t >& Definitions, int32_t& Value );
+std::string IntegerValueToString( int32_t Value );
+
+// all labels referenced as operands in the given lines
+// (including those in pointer data, but not label definitions)
+void CollectReferencedLabels( const std::vector< std::string >& Lines, std::map< std::string, int >& ReferenceCounts );
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************
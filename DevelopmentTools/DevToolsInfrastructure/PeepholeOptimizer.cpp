@@ -0,0 +1,793 @@
+// *****************************************************************************
+    // include project headers
+    #include "PeepholeOptimizer.hpp"
+    #include "EnumStringConversions.hpp"
+    #include "StringFunctions.hpp"
+    
+    // include C/C++ headers
+    #include <iostream>         // [ C++ STL ] I/O Streams
+    #include <iomanip>          // [ C++ STL ] I/O Manipulation
+    #include <set>              // [ C++ STL ] Sets
+    #include <algorithm>        // [ C++ STL ] Algorithms
+    #include <cstdlib>          // [ ANSI C ] Standard library
+    #include <cctype>           // [ ANSI C ] Character classification
+    
+    // declare used namespaces
+    using namespace std;
+    using namespace V32;
+// *****************************************************************************
+
+
+// =============================================================================
+//      AUXILIARY FUNCTIONS
+// =============================================================================
+
+
+// a register used directly, not as a memory address
+static bool IsRegisterOperand( const AssemblyOperand& Operand )
+{
+    return Operand.IsRegister && !Operand.IsMemoryAddress;
+}
+
+// -----------------------------------------------------------------------------
+
+// integer, float or character literals
+static bool IsNumber( const string& Text )
+{
+    int32_t IntegerValue;
+    
+    if( ParseIntegerValue( Text, IntegerValue ) )
+      return true;
+    
+    if( !Text.empty() && Text[0] == '\'' )
+      return true;
+    
+    char* End = nullptr;
+    strtod( Text.c_str(), &End );
+    return !Text.empty() && (*End == 0) && (isdigit( (unsigned char)Text[0] ) || Text[0] == '-' || Text[0] == '+' || Text[0] == '.');
+}
+
+// -----------------------------------------------------------------------------
+
+static bool InvertedComparison( InstructionOpCodes OpCode, InstructionOpCodes& Inverted )
+{
+    switch( OpCode )
+    {
+        case InstructionOpCodes::IEQ:  Inverted = InstructionOpCodes::INE;  return true;
+        case InstructionOpCodes::INE:  Inverted = InstructionOpCodes::IEQ;  return true;
+        case InstructionOpCodes::IGT:  Inverted = InstructionOpCodes::ILE;  return true;
+        case InstructionOpCodes::ILE:  Inverted = InstructionOpCodes::IGT;  return true;
+        case InstructionOpCodes::ILT:  Inverted = InstructionOpCodes::IGE;  return true;
+        case InstructionOpCodes::IGE:  Inverted = InstructionOpCodes::ILT;  return true;
+        
+        // float comparisons are not inverted: a
+        // comparison with NaN is always false
+        default:
+          return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// compiled C functions are the only ones whose labels
+// start like this; function pointers also point to them
+static bool CallsCFunction( const AssemblyLine& Line )
+{
+    const AssemblyOperand& Target = Line.Operands[0];
+    
+    if( IsRegisterOperand( Target ) )
+      return true;
+    
+    return !Target.IsMemoryAddress && (Target.Value.compare( 0, 11, "__function_" ) == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+// operands where reading a register can be replaced
+// by reading a different one, without other changes
+static bool IsReplaceableSource( const AssemblyLine& Line, unsigned Position )
+{
+    switch( Line.OpCode )
+    {
+        case InstructionOpCodes::MOV:
+          return (Position == 1) || Line.Operands[0].IsMemoryAddress;
+        
+        case InstructionOpCodes::LEA:
+        case InstructionOpCodes::OUT:
+          return (Position == 1);
+        
+        case InstructionOpCodes::PUSH:
+        case InstructionOpCodes::JMP:
+        case InstructionOpCodes::CALL:
+        case InstructionOpCodes::JT:
+        case InstructionOpCodes::JF:
+          return (Position == 0);
+        
+        default:
+          return IsBinaryOperation( Line.OpCode ) && (Position == 1);
+    }
+}
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER: INSTANCE HANDLING
+// =============================================================================
+
+
+PeepholeOptimizer::PeepholeOptimizer()
+{
+    Lines = nullptr;
+    IsCompilerOutput = false;
+    RemovedInstructions = 0;
+    
+    // rules are tried in this order
+    Rules =
+    {
+        { "jump-to-next-label",  "jmp L / L:",                  &PeepholeOptimizer::RemoveJumpToNextLabel },
+        { "jump-over-jump",      "jt R0, A / jmp B / A:",       &PeepholeOptimizer::InvertJumpOverJump },
+        { "inverted-comparison", "ieq R0, X / bnot R0",         &PeepholeOptimizer::InvertComparison },
+        { "branch-on-negation",  "bnot R0 / jf R0, L",          &PeepholeOptimizer::SimplifyBranchCondition },
+        { "reload-after-store",  "mov [A], R0 / mov R1, [A]",   &PeepholeOptimizer::ReplaceReloadAfterStore },
+        { "redundant-copy",      "mov R1, R0 / mov R0, R1",     &PeepholeOptimizer::RemoveRedundantCopy },
+        { "forward-copy",        "mov R0, X / mov R1, R0",      &PeepholeOptimizer::ForwardCopiedValue },
+        { "copy-propagation",    "mov R1, R0 / use of R1",      &PeepholeOptimizer::PropagateCopiedRegister }
+    };
+    
+    RuleApplications.assign( Rules.size(), 0 );
+}
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER: PROGRAM ANALYSIS
+// =============================================================================
+
+
+void PeepholeOptimizer::ReadNames()
+{
+    LabelPositions.clear();
+    Definitions.clear();
+    
+    for( unsigned i = 0; i < Lines->size(); i++ )
+    {
+        const AssemblyLine& Line = (*Lines)[ i ];
+        
+        // labels defined more than once (for instance in
+        // different %ifdef branches) are never followed
+        if( Line.IsLabel() )
+        {
+            if( LabelPositions.count( Line.LabelName ) )
+              LabelPositions[ Line.LabelName ] = -1;
+            else
+              LabelPositions[ Line.LabelName ] = i;
+        }
+        
+        // names defined as integers
+        else if( !Line.IsInstruction() )
+        {
+            string Content = Line.Text;
+            replace( Content.begin(), Content.end(), '\t', ' ' );
+            
+            vector< string > Words = SplitString( Content, ' ' );
+            Words.erase( remove( Words.begin(), Words.end(), "" ), Words.end() );
+            
+            int32_t Value;
+            
+            if( Words.size() >= 3 && Words[0] == "%define" && ParseIntegerValue( Words[2], Value ) )
+              Definitions[ Words[1] ] = Value;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// when a name is defined as a register, instructions using
+// it would access registers that can't be seen in the text
+bool PeepholeOptimizer::DefinesRegisterNames()
+{
+    for( const AssemblyLine& Line: *Lines )
+    {
+        if( Line.IsInstruction() || Line.IsLabel() )
+          continue;
+        
+        string Content = Line.Text;
+        replace( Content.begin(), Content.end(), '\t', ' ' );
+        
+        vector< string > Words = SplitString( Content, ' ' );
+        Words.erase( remove( Words.begin(), Words.end(), "" ), Words.end() );
+        
+        if( Words.size() >= 3 && Words[0] == "%define" && IsRegisterName( Words[2] ) )
+          return true;
+    }
+    
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+// in hand-written programs, operands can use names from other
+// files that could mean anything; instructions using them are
+// left alone (ports are the exception, they can't be registers)
+bool PeepholeOptimizer::IsUnderstood( int Position )
+{
+    const AssemblyLine& Line = (*Lines)[ Position ];
+    
+    if( !Line.IsInstruction() )
+      return false;
+    
+    if( IsCompilerOutput )
+      return true;
+    
+    for( unsigned i = 0; i < Line.Operands.size(); i++ )
+    {
+        const AssemblyOperand& Operand = Line.Operands[ i ];
+        
+        if( Operand.IsRegister || Operand.Value.empty() )
+          continue;
+        
+        bool IsPort = (Line.OpCode == InstructionOpCodes::OUT && i == 0)
+                   || (Line.OpCode == InstructionOpCodes::IN && i == 1);
+                
+        if( IsPort || IsNumber( Operand.Value ) )
+          continue;
+        
+        if( !Definitions.count( Operand.Value ) && !LabelPositions.count( Operand.Value ) )
+          return false;
+    }
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// skips comments and empty lines; returns -1 at the end
+int PeepholeOptimizer::NextLine( int Position )
+{
+    for( int i = Position + 1; i < (int)Lines->size(); i++ )
+      if( !RemovedLines[ i ] && !(*Lines)[ i ].IsComment() )
+        return i;
+        
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+// the instruction executed right after the given one,
+// or -1 if some other line (like a label) is in between
+int PeepholeOptimizer::NextInstruction( int Position )
+{
+    int Next = NextLine( Position );
+    
+    if( Next < 0 || !IsUnderstood( Next ) )
+      return -1;
+    
+    return Next;
+}
+
+// -----------------------------------------------------------------------------
+
+int PeepholeOptimizer::LabelPosition( const string& LabelName )
+{
+    auto Label = LabelPositions.find( LabelName );
+    
+    if( Label == LabelPositions.end() )
+      return -1;
+    
+    return Label->second;
+}
+
+// -----------------------------------------------------------------------------
+
+// checks if the label is among the ones that come
+// right after the given line (comments are skipped)
+bool PeepholeOptimizer::IsFollowedByLabel( int Position, const string& LabelName )
+{
+    for( int Next = NextLine( Position ); Next >= 0; Next = NextLine( Next ) )
+    {
+        const AssemblyLine& Line = (*Lines)[ Next ];
+        
+        if( !Line.IsLabel() )
+          return false;
+        
+        if( Line.LabelName == LabelName )
+          return true;
+    }
+    
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+// Follows all paths from the given line to check that the current
+// value of a register can't be read later. Any line that can't be
+// followed (unknown jump targets, directives, data...) is taken
+// as a possible use, and so is reaching the end of the program
+bool PeepholeOptimizer::IsRegisterDeadAfter( int Register, int Position )
+{
+    uint32_t Mask = (1u << Register);
+    vector< int > Pending;
+    set< int > Visited;
+    
+    // first find where execution continues
+    // (unknown functions could read any register)
+    const AssemblyLine& First = (*Lines)[ Position ];
+    
+    if( First.IsInstruction( InstructionOpCodes::CALL ) )
+      if( !IsCompilerOutput || !CallsCFunction( First ) )
+        return false;
+        
+    if( First.IsJump() )
+    {
+        int Target = LabelPosition( First.JumpTarget() );
+        
+        if( Target < 0 )
+          return false;
+        
+        Pending.push_back( Target );
+    }
+    
+    if( !First.EndsControlFlow() )
+      Pending.push_back( Position + 1 );
+    
+    // now check every path
+    while( !Pending.empty() )
+    {
+        int Current = Pending.back();
+        Pending.pop_back();
+        
+        if( Visited.count( Current ) )
+          continue;
+        
+        // limit the search so that it stays fast
+        if( Visited.size() >= 200 || Current >= (int)Lines->size() )
+          return false;
+        
+        Visited.insert( Current );
+        const AssemblyLine& Line = (*Lines)[ Current ];
+        
+        if( RemovedLines[ Current ] || Line.IsComment() || Line.IsLabel() )
+        {
+            Pending.push_back( Current + 1 );
+            continue;
+        }
+        
+        if( !IsUnderstood( Current ) )
+          return false;
+        
+        uint32_t Read = Line.ReadRegisters();
+        uint32_t Written = Line.WrittenRegisters();
+        
+        // only code from the compiler has known
+        // effects when calling or returning
+        if( Line.IsInstruction( InstructionOpCodes::CALL ) )
+          if( !IsCompilerOutput || !CallsCFunction( Line ) )
+            return false;
+            
+        if( Line.IsInstruction( InstructionOpCodes::RET ) )
+        {
+            if( !IsCompilerOutput )
+              return false;
+            
+            Read = 1;
+        }
+        
+        if( Read & Mask )
+          return false;
+        
+        if( Written & Mask )
+          continue;
+        
+        // continue on each possible path
+        if( Line.IsJump() )
+        {
+            int Target = LabelPosition( Line.JumpTarget() );
+            
+            if( Target < 0 )
+              return false;
+            
+            Pending.push_back( Target );
+        }
+        
+        if( !Line.EndsControlFlow() )
+          Pending.push_back( Current + 1 );
+    }
+    
+    return true;
+}
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER: EDITING THE PROGRAM
+// =============================================================================
+
+
+// lines are not erased, just emptied,
+// so that all positions stay valid
+void PeepholeOptimizer::RemoveLine( int Position )
+{
+    (*Lines)[ Position ] = AssemblyLine();
+    RemovedLines[ Position ] = true;
+    RemovedInstructions++;
+}
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER: REWRITE RULES
+// =============================================================================
+
+
+// jmp L / L:   -->   L:
+bool PeepholeOptimizer::RemoveJumpToNextLabel( int Position )
+{
+    string Target = (*Lines)[ Position ].JumpTarget();
+    
+    if( Target.empty() || !IsFollowedByLabel( Position, Target ) )
+      return false;
+    
+    RemoveLine( Position );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// jt R0, A / jmp B / A:   -->   jf R0, B / A:
+bool PeepholeOptimizer::InvertJumpOverJump( int Position )
+{
+    AssemblyLine& Line = (*Lines)[ Position ];
+    string Target = Line.JumpTarget();
+    
+    if( !Line.IsConditionalJump() || Target.empty() )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    const AssemblyLine& Jump = (*Lines)[ Next ];
+    
+    if( !Jump.IsInstruction( InstructionOpCodes::JMP ) || Jump.JumpTarget().empty() )
+      return false;
+    
+    if( !IsFollowedByLabel( Next, Target ) )
+      return false;
+    
+    InstructionOpCodes Inverted = Line.IsInstruction( InstructionOpCodes::JT )? InstructionOpCodes::JF : InstructionOpCodes::JT;
+    Line.SetInstruction( Inverted, { Line.Operands[0], Jump.Operands[0] } );
+    RemoveLine( Next );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// ieq R0, X / bnot R0   -->   ine R0, X
+bool PeepholeOptimizer::InvertComparison( int Position )
+{
+    AssemblyLine& Line = (*Lines)[ Position ];
+    InstructionOpCodes Inverted;
+    
+    if( !InvertedComparison( Line.OpCode, Inverted ) )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    const AssemblyLine& Negation = (*Lines)[ Next ];
+    
+    if( !Negation.IsInstruction( InstructionOpCodes::BNOT ) || Negation.Operands[0] != Line.Operands[0] )
+      return false;
+    
+    vector< AssemblyOperand > Operands = Line.Operands;
+    Line.SetInstruction( Inverted, Operands );
+    RemoveLine( Next );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// bnot R0 / jf R0, L   -->   jt R0, L
+// cib R0  / jf R0, L   -->   jf R0, L
+// (only when R0 is not used after the jump)
+bool PeepholeOptimizer::SimplifyBranchCondition( int Position )
+{
+    const AssemblyLine& Line = (*Lines)[ Position ];
+    bool IsNegation = Line.IsInstruction( InstructionOpCodes::BNOT );
+    
+    if( !IsNegation && !Line.IsInstruction( InstructionOpCodes::CIB ) )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    AssemblyLine& Jump = (*Lines)[ Next ];
+    
+    if( !Jump.IsConditionalJump() || Jump.Operands[0] != Line.Operands[0] )
+      return false;
+    
+    if( !IsRegisterDeadAfter( Line.Operands[0].Register, Next ) )
+      return false;
+    
+    if( IsNegation )
+    {
+        InstructionOpCodes Inverted = Jump.IsInstruction( InstructionOpCodes::JT )? InstructionOpCodes::JF : InstructionOpCodes::JT;
+        vector< AssemblyOperand > Operands = Jump.Operands;
+        Jump.SetInstruction( Inverted, Operands );
+    }
+    
+    RemoveLine( Position );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// mov [A], R0 / mov R1, [A]   -->   mov [A], R0 / mov R1, R0
+bool PeepholeOptimizer::ReplaceReloadAfterStore( int Position )
+{
+    const AssemblyLine& Store = (*Lines)[ Position ];
+    
+    if( !Store.WritesMemoryOperand() || !IsRegisterOperand( Store.Operands[1] ) )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    AssemblyLine& Load = (*Lines)[ Next ];
+    
+    if( !Load.ReadsMemoryOperand() || Load.Operands[1] != Store.Operands[0] )
+      return false;
+    
+    // the value is already in place
+    if( Load.Operands[0] == Store.Operands[1] )
+      RemoveLine( Next );
+    else
+      Load.SetOperand( 1, Store.Operands[1] );
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// mov R1, R0 / mov R0, R1   -->   mov R1, R0
+// (copying a register to itself is also removed)
+bool PeepholeOptimizer::RemoveRedundantCopy( int Position )
+{
+    const AssemblyLine& Line = (*Lines)[ Position ];
+    
+    if( !Line.IsInstruction( InstructionOpCodes::MOV ) )
+      return false;
+    
+    if( !IsRegisterOperand( Line.Operands[0] ) || !IsRegisterOperand( Line.Operands[1] ) )
+      return false;
+    
+    if( Line.Operands[0] == Line.Operands[1] )
+    {
+        RemoveLine( Position );
+        return true;
+    }
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    const AssemblyLine& Copy = (*Lines)[ Next ];
+    
+    if( !Copy.IsInstruction( InstructionOpCodes::MOV ) )
+      return false;
+    
+    if( Copy.Operands[0] != Line.Operands[1] || Copy.Operands[1] != Line.Operands[0] )
+      return false;
+    
+    RemoveLine( Next );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// mov R0, X / mov R1, R0   -->   mov R1, X
+// (only when R0 is not used later)
+bool PeepholeOptimizer::ForwardCopiedValue( int Position )
+{
+    const AssemblyLine& Line = (*Lines)[ Position ];
+    
+    if( !Line.IsInstruction( InstructionOpCodes::MOV ) || !IsRegisterOperand( Line.Operands[0] ) )
+      return false;
+    
+    // BP and SP are always needed
+    int Register = Line.Operands[0].Register;
+    
+    if( Register > 13 )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    AssemblyLine& Copy = (*Lines)[ Next ];
+    
+    if( !Copy.IsInstruction( InstructionOpCodes::MOV ) || !IsRegisterOperand( Copy.Operands[0] ) )
+      return false;
+    
+    if( Copy.Operands[1] != Line.Operands[0] || Copy.Operands[0] == Line.Operands[0] )
+      return false;
+    
+    if( !IsRegisterDeadAfter( Register, Next ) )
+      return false;
+    
+    Copy.SetOperand( 1, Line.Operands[1] );
+    RemoveLine( Position );
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// mov R1, R0 / mov [BP-2], R1   -->   mov [BP-2], R0
+// (only when R1 is not used later; the copied register
+// can be used by the next instruction in any source
+// operand, including as the base of memory addresses)
+bool PeepholeOptimizer::PropagateCopiedRegister( int Position )
+{
+    const AssemblyLine& Line = (*Lines)[ Position ];
+    
+    if( !Line.IsInstruction( InstructionOpCodes::MOV ) )
+      return false;
+    
+    if( !IsRegisterOperand( Line.Operands[0] ) || !IsRegisterOperand( Line.Operands[1] ) )
+      return false;
+    
+    int Copy = Line.Operands[0].Register;
+    int Original = Line.Operands[1].Register;
+    
+    // (reads of SP by stack instructions are not clear)
+    if( Copy > 13 || Copy == Original || Original == (int)CPURegisters::StackPointer )
+      return false;
+    
+    int Next = NextInstruction( Position );
+    
+    if( Next < 0 )
+      return false;
+    
+    // replace the register in the instruction
+    AssemblyLine User = (*Lines)[ Next ];
+    uint32_t Mask = (1u << Copy);
+    
+    if( !(User.ReadRegisters() & Mask) )
+      return false;
+    
+    for( unsigned i = 0; i < User.Operands.size(); i++ )
+    {
+        AssemblyOperand Operand = User.Operands[ i ];
+        
+        if( !Operand.IsRegister || Operand.Register != Copy || !IsReplaceableSource( User, i ) )
+          continue;
+        
+        Operand.Register = Original;
+        User.SetOperand( i, Operand );
+    }
+    
+    // the copy must not be needed anymore
+    if( User.ReadRegisters() & Mask )
+      return false;
+    
+    if( !(User.WrittenRegisters() & Mask) && !IsRegisterDeadAfter( Copy, Next ) )
+      return false;
+    
+    (*Lines)[ Next ] = User;
+    RemoveLine( Position );
+    return true;
+}
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER: PROCESSING OF PROGRAMS
+// =============================================================================
+
+
+void PeepholeOptimizer::Optimize( vector< AssemblyLine >& ProgramLines )
+{
+    Lines = &ProgramLines;
+    RemovedLines.assign( Lines->size(), false );
+    
+    // names standing for registers would hide register uses
+    ReadNames();
+    
+    if( DefinesRegisterNames() )
+      return;
+    
+    // rules can enable each other, so
+    // repeat until nothing else changes
+    for( int Pass = 0; Pass < 8; Pass++ )
+    {
+        bool Changed = false;
+        
+        for( int Position = 0; Position < (int)Lines->size(); Position++ )
+        {
+            if( RemovedLines[ Position ] || !IsUnderstood( Position ) )
+              continue;
+            
+            for( unsigned r = 0; r < Rules.size(); r++ )
+              if( (this->*Rules[ r ].Apply)( Position ) )
+              {
+                  RuleApplications[ r ]++;
+                  Changed = true;
+                  break;
+              }
+        }
+        
+        if( !Changed )
+          break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// Removed lines are left empty, so that any line numbers
+// reported later still match the ones in the original text
+string PeepholeOptimizer::OptimizeText( const string& ProgramText )
+{
+    vector< AssemblyLine > ProgramLines;
+    vector< bool > EndsWithCR;
+    size_t LineStart = 0;
+    
+    // separate lines, keeping their line breaks
+    while( true )
+    {
+        size_t LineEnd = ProgramText.find( '\n', LineStart );
+        string LineText = ProgramText.substr( LineStart, (LineEnd == string::npos)? string::npos : LineEnd - LineStart );
+        bool HasCR = (!LineText.empty() && LineText.back() == '\r');
+        
+        if( HasCR )
+          LineText.pop_back();
+        
+        ProgramLines.push_back( AssemblyLine::FromText( LineText ) );
+        EndsWithCR.push_back( HasCR );
+        
+        if( LineEnd == string::npos )
+          break;
+        
+        LineStart = LineEnd + 1;
+    }
+    
+    Optimize( ProgramLines );
+    
+    // now join them again
+    string Result;
+    
+    for( unsigned i = 0; i < ProgramLines.size(); i++ )
+    {
+        if( i > 0 )
+          Result += '\n';
+        
+        Result += ProgramLines[ i ].ToString();
+        
+        if( EndsWithCR[ i ] )
+          Result += '\r';
+    }
+    
+    return Result;
+}
+
+// -----------------------------------------------------------------------------
+
+void PeepholeOptimizer::PrintStatistics()
+{
+    cout << "peephole optimizer: uses of each rule" << endl;
+    cout << "  " << left << setw( 22 ) << "rule" << setw( 30 ) << "pattern" << right << setw( 8 ) << "uses" << endl;
+    
+    int TotalUses = 0;
+    
+    for( unsigned r = 0; r < Rules.size(); r++ )
+    {
+        cout << "  " << left << setw( 22 ) << Rules[ r ].Name << setw( 30 ) << Rules[ r ].Pattern << right << setw( 8 ) << RuleApplications[ r ] << endl;
+        TotalUses += RuleApplications[ r ];
+    }
+    
+    cout << "  " << left << setw( 52 ) << "total" << right << setw( 8 ) << TotalUses << endl;
+    cout << "  instructions removed: " << RemovedInstructions << endl;
+}
@@ -0,0 +1,112 @@
+// *****************************************************************************
+    // start include guard
+    #ifndef PEEPHOLEOPTIMIZER_HPP
+    #define PEEPHOLEOPTIMIZER_HPP
+    
+    // include infrastructure headers
+    #include "AssemblyLines.hpp"
+    
+    // include C/C++ headers
+    #include <string>           // [ C++ STL ] Strings
+    #include <vector>           // [ C++ STL ] Vectors
+    #include <map>              // [ C++ STL ] Maps
+// *****************************************************************************
+
+
+// =============================================================================
+//      PEEPHOLE OPTIMIZER
+// =============================================================================
+
+
+class PeepholeOptimizer;
+
+// a rewrite applied to short sequences of instructions;
+// it is tried at every instruction of the program and
+// returns true if the lines were rewritten
+class PeepholeRule
+{
+    public:
+        
+        std::string Name;
+        std::string Pattern;
+        bool (PeepholeOptimizer::*Apply)( int Position );
+};
+
+// -----------------------------------------------------------------------------
+
+// Rewrites small groups of neighbouring instructions into
+// shorter equivalents. It only relies on what can be seen
+// in the given lines: whenever a register could be used by
+// code that is not visible (other files, unknown names or
+// unusual directives) it is considered to be needed there
+class PeepholeOptimizer
+{
+    protected:
+        
+        // the program being processed
+        std::vector< AssemblyLine >* Lines;
+        
+        // names visible in the program (labels defined
+        // more than once have an invalid position)
+        std::map< std::string, int > LabelPositions;
+        std::map< std::string, int32_t > Definitions;
+        
+    public:
+        
+        // the code comes from the C compiler, so it follows its
+        // calling convention: called functions only return a
+        // value in R0 and can't see the caller's registers
+        bool IsCompilerOutput;
+        
+        // table of rules, and how many times each one was used
+        std::vector< PeepholeRule > Rules;
+        std::vector< int > RuleApplications;
+        int RemovedInstructions;
+        
+        // lines removed in the last processed program; they
+        // are left as empty lines so that positions are kept
+        std::vector< bool > RemovedLines;
+        
+    protected:
+        
+        // program analysis
+        void ReadNames();
+        bool DefinesRegisterNames();
+        bool IsUnderstood( int Position );
+        int NextLine( int Position );
+        int NextInstruction( int Position );
+        int LabelPosition( const std::string& LabelName );
+        bool IsFollowedByLabel( int Position, const std::string& LabelName );
+        bool IsRegisterDeadAfter( int Register, int Position );
+        
+        // editing the program
+        void RemoveLine( int Position );
+        
+        // rewrite rules
+        bool RemoveJumpToNextLabel( int Position );
+        bool InvertJumpOverJump( int Position );
+        bool InvertComparison( int Position );
+        bool SimplifyBranchCondition( int Position );
+        bool ReplaceReloadAfterStore( int Position );
+        bool RemoveRedundantCopy( int Position );
+        bool ForwardCopiedValue( int Position );
+        bool PropagateCopiedRegister( int Position );
+        
+    public:
+        
+        // instance handling
+        PeepholeOptimizer();
+        
+        // processing of programs
+        void Optimize( std::vector< AssemblyLine >& ProgramLines );
+        std::string OptimizeText( const std::string& ProgramText );
+        
+        // results
+        void PrintStatistics();
+};
+
+
+// *****************************************************************************
+    // end include guard
+    #endif
+// *****************************************************************************